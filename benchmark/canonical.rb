@@ -0,0 +1,52 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Canonical output / digest benchmark
+#
+# An ETag over a twitter.json-style payload: deep-sorting the Hashes in
+# Ruby before YYJson.dump and Digest::SHA256, against canonical: true
+# (keys sorted in C) with Digest::SHA256, and canonical: true with
+# digest: :sha256 (hashed as it streams, no JSON String).
+#
+# Usage:
+#   ruby benchmark/canonical.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require_relative 'support/corpus'
+require_relative 'support/allocations'
+require 'benchmark/ips'
+require 'digest'
+
+obj = YYJson.load(BenchmarkCorpus.json('twitter'))
+
+deep_sort = lambda do |o|
+  case o
+  when Hash then o.keys.sort.to_h { |k| [k, deep_sort.call(o[k])] }
+  when Array then o.map { |v| deep_sort.call(v) }
+  else o
+  end
+end
+
+etag = Digest::SHA256.hexdigest(YYJson.dump(obj, canonical: true))
+unless YYJson.dump(deep_sort.call(obj)) == YYJson.dump(obj, canonical: true) &&
+       YYJson.dump(obj, canonical: true, digest: :sha256) == etag
+  raise 'canonical output and Ruby sorting disagree'
+end
+
+puts "twitter corpus document, #{BenchmarkHelpers.format_size(YYJson.dump(obj).bytesize)}"
+
+Benchmark.ips do |x|
+  x.config(time: 3, warmup: 1)
+  x.report("YYJson.dump (unsorted)") { YYJson.dump(obj) }
+  x.report("deep sort + dump + SHA256") { Digest::SHA256.hexdigest(YYJson.dump(deep_sort.call(obj))) }
+  x.report("canonical + SHA256") { Digest::SHA256.hexdigest(YYJson.dump(obj, canonical: true)) }
+  x.report("canonical, digest: :sha256") { YYJson.dump(obj, canonical: true, digest: :sha256) }
+  x.compare!
+end
+
+puts
+puts "Allocations per call:"
+puts "  deep sort + dump + SHA256   #{BenchmarkAllocations.per_call { Digest::SHA256.hexdigest(YYJson.dump(deep_sort.call(obj))) }}"
+puts "  canonical + SHA256          #{BenchmarkAllocations.per_call { Digest::SHA256.hexdigest(YYJson.dump(obj, canonical: true)) }}"
+puts "  canonical, digest: :sha256  #{BenchmarkAllocations.per_call { YYJson.dump(obj, canonical: true, digest: :sha256) }}"
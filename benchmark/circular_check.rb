@@ -0,0 +1,34 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Circular-reference tracking benchmark for YYJson.dump
+#
+# Every Array and Hash dumped is checked against its ancestors. This
+# compares the default check with check_circular: false (depth limit only)
+# on deeply nested and very wide structures.
+#
+# Usage:
+#   ruby benchmark/circular_check.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'json'
+require 'benchmark/ips'
+
+def nested(depth)
+  depth.zero? ? { "leaf" => 1 } : { "child" => nested(depth - 1), "items" => [depth] }
+end
+
+datasets = {
+  "Deep (1000 trees of depth 45)" => Array.new(1_000) { nested(45) },
+  "Wide (100k small Hashes)" => Array.new(100_000) { |i| { "id" => i, "tags" => [i] } }
+}
+
+datasets.each do |name, data|
+  BenchmarkHelpers.print_data_info(name, data)
+  BenchmarkHelpers.compare_libraries("Dump #{name}", data) do |x, obj|
+    x.report("YYJson.dump") { YYJson.dump(obj) }
+    x.report("YYJson.dump(check_circular: false)") { YYJson.dump(obj, check_circular: false) }
+    x.report("JSON.generate") { JSON.generate(obj) }
+  end
+end
@@ -0,0 +1,145 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Compare two benchmark suite runs and flag regressions
+#
+# BASE and HEAD are each a results file written by benchmark/suite.rb, a
+# git revision (checked out into a temporary worktree, compiled, and run
+# with this checkout's suite, so both sides measure the same cases), or
+# "." for the working tree as it is compiled.
+#
+# A case regresses when its ops/s drop, or its allocations or RSS grow, by
+# more than the threshold (RSS and allocations only above small absolute
+# floors, so noise in tiny numbers isn't reported). Exits 1 on regressions.
+#
+# Usage:
+#   ruby benchmark/compare.rb BASE HEAD [--threshold PERCENT] [--time SECONDS] [--filter REGEXP]
+#   rake benchmark:compare[v0.1.0,.]
+
+require 'json'
+require 'optparse'
+require 'tmpdir'
+require 'fileutils'
+require 'rbconfig'
+
+module BenchmarkCompare
+  ROOT = File.expand_path('..', __dir__)
+  SUITE = File.join(__dir__, 'suite.rb')
+
+  # Ignore RSS and allocation changes smaller than these
+  RSS_FLOOR_KB = 512
+  ALLOCATIONS_FLOOR = 10
+
+  module_function
+
+  def results_for(spec, time, filter = nil)
+    return JSON.parse(File.read(spec), symbolize_names: true) if File.file?(spec)
+    return run_suite(File.join(ROOT, 'lib'), time, filter) if spec == '.'
+
+    Dir.mktmpdir('yyjson-bench') do |dir|
+      tree = File.join(dir, 'tree')
+      system('git', '-C', ROOT, 'worktree', 'add', '--detach', '--quiet', tree, spec, exception: true)
+      begin
+        compile(tree)
+        run_suite(File.join(tree, 'lib'), time, filter)
+      ensure
+        system('git', '-C', ROOT, 'worktree', 'remove', '--force', tree)
+      end
+    end
+  end
+
+  # Build the extension of a worktree into its lib/yyjson
+  def compile(tree)
+    ext = File.join(tree, 'ext', 'yyjson')
+
+    # Reuse the downloaded yyjson sources
+    vendor = File.join(ROOT, 'ext', 'yyjson', 'vendor')
+    FileUtils.cp_r(vendor, ext) if File.directory?(vendor) && !File.directory?(File.join(ext, 'vendor'))
+
+    build = File.join(tree, 'tmp', 'bench-build')
+    FileUtils.mkdir_p(build)
+    system(RbConfig.ruby, File.join(ext, 'extconf.rb'), chdir: build, out: File::NULL, exception: true)
+    system('make', chdir: build, out: File::NULL, exception: true)
+    so = Dir[File.join(build, "yyjson.#{RbConfig::CONFIG['DLEXT']}")].first or raise "no extension built in #{build}"
+    FileUtils.cp(so, File.join(tree, 'lib', 'yyjson'))
+  end
+
+  def run_suite(lib, time, filter)
+    Dir.mktmpdir('yyjson-bench-out') do |dir|
+      out = File.join(dir, 'results.json')
+      env = { 'YYJSON_LIB' => lib }
+      args = ['--time', time.to_s, '--output', out]
+      args += ['--filter', filter] if filter
+      system(env, RbConfig.ruby, SUITE, *args, exception: true)
+      JSON.parse(File.read(out), symbolize_names: true)
+    end
+  end
+
+  def change(base, head)
+    return 0.0 if base.zero?
+
+    (head - base) * 100.0 / base
+  end
+
+  # Rows of [case, ops change %, allocs change %, rss change %, regressions]
+  def compare(base, head, threshold)
+    rows = []
+    base[:results].each do |name, b|
+      h = head[:results][name]
+      next unless h
+
+      ops = change(b[:ops_per_sec], h[:ops_per_sec])
+      allocs = change(b[:allocations], h[:allocations])
+      rss = change(b[:rss_kb], h[:rss_kb])
+
+      flags = []
+      flags << 'ops/s' if ops < -threshold
+      flags << 'allocations' if allocs > threshold && h[:allocations] - b[:allocations] > ALLOCATIONS_FLOOR
+      flags << 'rss' if rss > threshold && h[:rss_kb] - b[:rss_kb] > RSS_FLOOR_KB
+      rows << [name.to_s, b, h, ops, allocs, rss, flags]
+    end
+    rows
+  end
+
+  def print_report(base, head, rows, threshold)
+    puts "base: #{describe(base)}"
+    puts "head: #{describe(head)}"
+    if base[:meta][:corpus_version] != head[:meta][:corpus_version]
+      puts "warning: corpus versions differ (#{base[:meta][:corpus_version]} vs #{head[:meta][:corpus_version]})"
+    end
+    puts
+    puts format('%-26s %12s %12s %8s %9s %8s', 'case', 'base ops/s', 'head ops/s', 'ops', 'allocs', 'rss')
+    rows.each do |name, b, h, ops, allocs, rss, flags|
+      line = format('%-26s %12.1f %12.1f %+7.1f%% %+8.1f%% %+7.1f%%', name, b[:ops_per_sec], h[:ops_per_sec], ops, allocs, rss)
+      line += "  REGRESSION (#{flags.join(', ')})" unless flags.empty?
+      puts line
+    end
+
+    regressions = rows.count { |row| !row.last.empty? }
+    puts
+    puts regressions.zero? ? "No regressions beyond #{threshold}%" : "#{regressions} case(s) regressed beyond #{threshold}%"
+    regressions
+  end
+
+  def describe(report)
+    meta = report[:meta]
+    [meta[:yyjson_version], meta[:revision], meta[:ruby]].compact.join(' / ')
+  end
+end
+
+if $PROGRAM_NAME == __FILE__
+  options = { threshold: 5.0, time: 2.0, filter: nil }
+  parser = OptionParser.new do |o|
+    o.banner = 'Usage: ruby benchmark/compare.rb BASE HEAD [options]'
+    o.on('--threshold PERCENT', Float, 'Regression threshold (default: 5)') { |v| options[:threshold] = v }
+    o.on('-t', '--time SECONDS', Float, 'Measured time per case when running the suite (default: 2)') { |v| options[:time] = v }
+    o.on('-f', '--filter REGEXP', 'Only run matching cases') { |v| options[:filter] = v }
+  end
+  parser.parse!
+  abort parser.banner unless ARGV.size == 2
+
+  base = BenchmarkCompare.results_for(ARGV[0], options[:time], options[:filter])
+  head = BenchmarkCompare.results_for(ARGV[1], options[:time], options[:filter])
+  rows = BenchmarkCompare.compare(base, head, options[:threshold])
+  exit(BenchmarkCompare.print_report(base, head, rows, options[:threshold]).zero? ? 0 : 1)
+end
@@ -0,0 +1,46 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Custom-object dump benchmark (type-dispatch cache)
+#
+# Dumps arrays of non-core objects: models with as_json, Time/Date values
+# and plain objects serialized with to_s. How each class is serialized is
+# resolved once per class, not once per object.
+#
+# Usage:
+#   ruby benchmark/custom_objects.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'json'
+require 'date'
+require 'benchmark/ips'
+
+class FakeRecord
+  def initialize(id)
+    @id = id
+    @name = "record #{id}"
+  end
+
+  def as_json(*)
+    { "id" => @id, "name" => @name }
+  end
+end
+
+Tag = Struct.new(:label) do
+  def to_s = label
+end
+
+count = 20_000
+datasets = {
+  "as_json models" => Array.new(count) { |i| FakeRecord.new(i) },
+  "Time and Date" => Array.new(count) { |i| i.even? ? Time.at(i).utc : Date.new(2024, 1, 1) + (i % 365) },
+  "to_s objects" => Array.new(count) { |i| Tag.new("tag-#{i % 50}") }
+}
+
+datasets.each do |name, data|
+  puts "#{name}: #{data.size} objects"
+  BenchmarkHelpers.compare_libraries("Dump #{name}", data) do |x, obj|
+    x.report("YYJson.dump") { YYJson.dump(obj) }
+  end
+end
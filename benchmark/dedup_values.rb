@@ -0,0 +1,75 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# String value deduplication benchmark
+#
+# Loads an event log whose records repeat a few short values ("status",
+# "currency", "country") next to unique ones, with and without
+# dedup_values: true, and reports speed, allocations and the heap slots
+# the result keeps alive.
+#
+# Usage:
+#   ruby benchmark/dedup_values.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'json'
+require 'benchmark/ips'
+
+rng = Random.new(42)
+statuses = %w[active pending suspended closed]
+currencies = %w[USD EUR GBP JPY]
+countries = %w[US DE FR GB JP BR IN]
+
+events = Array.new(100_000) do |i|
+  {
+    "id" => "evt_#{i}",
+    "status" => statuses[rng.rand(statuses.size)],
+    "currency" => currencies[rng.rand(currencies.size)],
+    "country" => countries[rng.rand(countries.size)],
+    "amount" => rng.rand(10_000),
+    "source" => "web"
+  }
+end
+json = JSON.generate(events)
+
+puts "#{events.size} events, #{BenchmarkHelpers.format_size(json.bytesize)} of JSON"
+
+Benchmark.ips do |x|
+  x.config(time: 3, warmup: 1)
+  x.report("load") { YYJson.load(json) }
+  x.report("load dedup_values: true") { YYJson.load(json, dedup_values: true) }
+  x.report("load freeze: true") { YYJson.load(json, freeze: true) }
+  x.compare!
+end
+
+# Loads whose results stay alive a while (a cache, a batch being processed)
+retained = lambda do |opts|
+  GC.start
+  gc_before = GC.stat(:time)
+  keep = []
+  t = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+  10.times do
+    keep << YYJson.load(json, **opts)
+    keep.shift if keep.size > 3
+  end
+  elapsed = Process.clock_gettime(Process::CLOCK_MONOTONIC) - t
+  [elapsed, GC.stat(:time) - gc_before]
+end
+
+slots = lambda do |opts|
+  GC.start
+  before = GC.stat(:heap_live_slots)
+  result = YYJson.load(json, **opts)
+  GC.start
+  live = GC.stat(:heap_live_slots) - before
+  result.size
+  live
+end
+
+puts
+[{}, { dedup_values: true }, { freeze: true }].each do |opts|
+  elapsed, gc = retained.(opts)
+  puts format('%-24s %9d heap slots per result, 10 retained loads in %.2fs (GC %d ms)',
+              opts.empty? ? 'load' : opts.inspect, slots.(opts), elapsed, gc)
+end
@@ -0,0 +1,56 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Streaming dump benchmark
+#
+# Writes a ~45MB response to a file with YYJson.dump(obj, io) (64 KB
+# buffered at a time) and with File.write(path, YYJson.dump(obj)), and
+# reports the RSS high-water growth of each. The streaming dump runs first:
+# the high-water mark only ever rises.
+#
+# Usage:
+#   ruby benchmark/dump_io.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/data_generator'
+require_relative 'support/helpers'
+require 'benchmark/ips'
+require 'tmpdir'
+
+# Peak resident set size in KB (Linux only)
+def rss_hwm_kb
+  File.read('/proc/self/status')[/VmHWM:\s+(\d+)/, 1].to_i
+rescue Errno::ENOENT
+  0
+end
+
+data = BenchmarkDataGenerator.activerecord_array(count: 200_000)
+path = File.join(Dir.tmpdir, "yyjson_dump_io_#{Process.pid}.json")
+
+begin
+  GC.start
+  before = rss_hwm_kb
+  File.open(path, 'wb') { |f| YYJson.dump(data, f) }
+  streamed = rss_hwm_kb - before
+  size = File.size(path)
+
+  GC.start
+  before = rss_hwm_kb
+  File.write(path, YYJson.dump(data))
+  buffered = rss_hwm_kb - before
+
+  puts "Output: #{BenchmarkHelpers.format_size(size)}"
+  puts "RSS high-water growth, YYJson.dump(obj, io):      #{BenchmarkHelpers.format_size(streamed * 1024)}"
+  puts "RSS high-water growth, File.write(YYJson.dump):   #{BenchmarkHelpers.format_size(buffered * 1024)}"
+  puts
+
+  Benchmark.ips do |x|
+    x.config(time: 3, warmup: 1)
+    x.report("dump(obj, io)") { File.open(path, 'wb') { |f| YYJson.dump(data, f) } }
+    x.report("dump_file") { YYJson.dump_file(data, path) }
+    x.report("File.write(dump)") { File.write(path, YYJson.dump(data)) }
+    x.compare!
+  end
+ensure
+  File.delete(path) if File.exist?(path)
+end
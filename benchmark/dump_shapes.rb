@@ -0,0 +1,33 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Repeated-key dump benchmark
+#
+# Dumps arrays of Hashes that share their keys (as serialized
+# ActiveRecord relations do), with String and with Symbol keys. Each key
+# object is escaped once per dump and copied from a cache afterwards.
+#
+# Usage:
+#   ruby benchmark/dump_shapes.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'benchmark/ips'
+
+count = 20_000
+string_rows = Array.new(count) do |i|
+  {
+    "id" => i, "first_name" => "first", "last_name" => "last", "email_address" => "x@example.com",
+    "created_at" => "2024-01-01", "updated_at" => "2024-01-02", "account_id" => i % 10, "active" => true
+  }
+end
+symbol_rows = string_rows.map { |row| row.transform_keys(&:to_sym) }
+
+puts "#{count} rows, #{BenchmarkHelpers.format_size(YYJson.dump(string_rows).bytesize)} of JSON"
+
+Benchmark.ips do |x|
+  x.config(time: 3, warmup: 1)
+  x.report("String keys") { YYJson.dump(string_rows) }
+  x.report("Symbol keys") { YYJson.dump(symbol_rows) }
+  x.compare!
+end
@@ -0,0 +1,36 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# escape_html dump benchmark
+#
+# mode: :rails turns escape_html on, so every Rails response pays for it.
+# Escaping happens per string as it is written (vectorized scan for
+# < > & '), instead of a second pass and copy over the whole output.
+#
+# Usage:
+#   ruby benchmark/escape_html.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'json'
+require 'benchmark/ips'
+
+posts = Array.new(2_000) do |i|
+  {
+    "id" => i,
+    "title" => "Post number #{i} about performance",
+    "body" => "Lorem ipsum dolor sit amet, consectetur adipiscing elit. " * 8,
+    "html" => "<p>Tom & Jerry's <b>#{i}</b></p>",
+    "tags" => %w[ruby json performance]
+  }
+end
+
+puts "#{posts.size} posts, #{BenchmarkHelpers.format_size(YYJson.dump(posts).bytesize)} of JSON"
+
+Benchmark.ips do |x|
+  x.config(time: 3, warmup: 1)
+  x.report("YYJson.dump") { YYJson.dump(posts) }
+  x.report("YYJson.dump escape_html: true") { YYJson.dump(posts, escape_html: true) }
+  x.report("YYJson.dump mode: :rails") { YYJson.dump(posts, mode: :rails) }
+  x.compare!
+end
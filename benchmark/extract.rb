@@ -0,0 +1,37 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Message-routing benchmark for YYJson.extract / extract_many
+#
+# Reads two header fields from a message with a large payload. YYJson.load
+# builds the whole Ruby graph; extract_many parses once and converts only
+# the two values the pointers resolve to.
+#
+# Usage:
+#   ruby benchmark/extract.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'json'
+require 'benchmark/ips'
+
+message = JSON.generate(
+  "header" => { "type" => "order.updated", "region" => "eu-west-1", "version" => 3 },
+  "payload" => Array.new(200) { |i| { "id" => i, "sku" => "SKU-#{i}", "qty" => i % 7, "price" => i * 1.25 } }
+)
+paths = ["/header/type", "/header/region"]
+
+puts "Message: #{BenchmarkHelpers.format_size(message.bytesize)}"
+
+BenchmarkHelpers.compare_libraries("Read 2 routing fields", message) do |x, json|
+  x.report("YYJson.load + []") do
+    h = YYJson.load(json)
+    [h["header"]["type"], h["header"]["region"]]
+  end
+  x.report("YYJson.extract_many") { YYJson.extract_many(json, paths) }
+  x.report("YYJson.extract") { YYJson.extract(json, "/header/type") }
+  x.report("JSON.parse + []") do
+    h = JSON.parse(json)
+    [h["header"]["type"], h["header"]["region"]]
+  end
+end
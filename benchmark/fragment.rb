@@ -0,0 +1,67 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Fragment / memoize benchmark
+#
+# Dumps a page of records whose as_json builds a nested Hash, first as is,
+# then with YYJson.memoize (each record serialized once, then spliced from
+# the stored JSON) and from ready-made YYJson::Fragments.
+#
+# Usage:
+#   ruby benchmark/fragment.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'json'
+require 'benchmark/ips'
+
+class Article
+  attr_reader :id, :updated_at
+
+  def initialize(id)
+    @id = id
+    @title = "Article #{id}"
+    @body = "lorem ipsum dolor sit amet " * 20
+    @tags = %w[news tech sports][0, 1 + id % 3]
+    @updated_at = Time.at(1_700_000_000 + id).utc
+  end
+
+  def as_json(*)
+    {
+      "id" => @id, "title" => @title, "body" => @body, "tags" => @tags,
+      "author" => { "id" => @id % 50, "name" => "author #{@id % 50}" },
+      "updated_at" => @updated_at
+    }
+  end
+end
+
+class MemoArticle < Article; end
+
+YYJson.memoize(MemoArticle, &:id)
+
+count = 1_000
+plain = Array.new(count) { |i| Article.new(i) }
+memo = Array.new(count) { |i| MemoArticle.new(i) }
+fragments = plain.map { |a| YYJson::Fragment.new(YYJson.dump(a)) }
+
+raise "output mismatch" unless YYJson.dump(plain) == YYJson.dump(memo) && YYJson.dump(plain) == YYJson.dump(fragments)
+
+puts "#{count} records, #{BenchmarkHelpers.format_size(YYJson.dump(plain).bytesize)} of JSON"
+
+Benchmark.ips do |x|
+  x.config(time: 3, warmup: 1)
+  x.report("as_json") { YYJson.dump(plain) }
+  x.report("memoize") { YYJson.dump(memo) }
+  x.report("Fragment") { YYJson.dump(fragments) }
+  x.compare!
+end
+
+allocs = lambda do |data|
+  GC.disable
+  before = GC.stat(:total_allocated_objects)
+  YYJson.dump(data)
+  GC.stat(:total_allocated_objects) - before
+ensure
+  GC.enable
+end
+puts "Allocations per dump: as_json #{allocs.(plain)}, memoize #{allocs.(memo)}, Fragment #{allocs.(fragments)}"
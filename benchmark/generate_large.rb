@@ -0,0 +1,59 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Throughput and memory benchmark for large API responses (1-10MB)
+#
+# YYJson.dump writes JSON straight into the returned String, so peak memory
+# is roughly the size of the output. This script reports ips for each size
+# and the process RSS high-water mark after a batch of dumps.
+#
+# Usage:
+#   ruby benchmark/generate_large.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/data_generator'
+require_relative 'support/helpers'
+require 'json'
+require 'benchmark/ips'
+
+begin
+  require 'oj'
+  HAS_OJ = true
+rescue LoadError
+  HAS_OJ = false
+end
+
+# Peak resident set size in KB (Linux only)
+def rss_hwm_kb
+  File.read('/proc/self/status')[/VmHWM:\s+(\d+)/, 1].to_i
+rescue Errno::ENOENT
+  0
+end
+
+datasets = {
+  "1MB response" => BenchmarkDataGenerator.activerecord_array(count: 4_500),
+  "10MB response" => BenchmarkDataGenerator.activerecord_array(count: 45_000)
+}
+
+datasets.each do |name, data|
+  BenchmarkHelpers.print_data_info(name, data)
+  BenchmarkHelpers.compare_libraries("Generate #{name}", data) do |x, obj|
+    x.report("YYJson") { YYJson.dump(obj) }
+    x.report("JSON") { JSON.generate(obj) }
+    x.report("Oj") { Oj.dump(obj, mode: :compat) } if HAS_OJ
+  end
+end
+
+puts "\n" + "=" * 60
+puts "Memory: 20 dumps of the 10MB response"
+puts "=" * 60
+
+data = datasets["10MB response"]
+GC.start
+before_rss = rss_hwm_kb
+before_objects = GC.stat(:total_allocated_objects)
+
+20.times { YYJson.dump(data) }
+
+puts "Objects allocated per dump: #{(GC.stat(:total_allocated_objects) - before_objects) / 20}"
+puts "RSS high-water growth:      #{BenchmarkHelpers.format_size((rss_hwm_kb - before_rss) * 1024)}"
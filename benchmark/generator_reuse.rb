@@ -0,0 +1,34 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Small-response generation benchmark for YYJson::Generator
+#
+# Compares YYJson.dump with an options Hash (options extracted and a fresh
+# output String grown on every call) against a reused YYJson::Generator
+# (options resolved once, output written into a pooled scratch buffer).
+#
+# Usage:
+#   ruby benchmark/generator_reuse.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/data_generator'
+require_relative 'support/helpers'
+require 'json'
+require 'benchmark/ips'
+
+datasets = {
+  "Small response" => BenchmarkDataGenerator.simple_hash(size: 10),
+  "Medium response" => BenchmarkDataGenerator.activerecord_array(count: 50)
+}
+
+opts = { escape_slash: true }
+generator = YYJson::Generator.new(opts)
+
+datasets.each do |name, data|
+  BenchmarkHelpers.print_data_info(name, data)
+  BenchmarkHelpers.compare_libraries("Generate #{name}", data) do |x, obj|
+    x.report("YYJson.dump(obj, opts)") { YYJson.dump(obj, opts) }
+    x.report("Generator#generate") { generator.generate(obj) }
+    x.report("JSON.generate") { JSON.generate(obj) }
+  end
+end
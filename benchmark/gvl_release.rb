@@ -0,0 +1,92 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Multi-threaded parse benchmark for :gvl_release_threshold
+#
+# Parses a large payload from several threads at once, with and without
+# releasing the GVL during the raw yyjson read phase. Also reports how long
+# a concurrent "ticker" thread (standing in for other Puma requests) is
+# stalled while the parses run.
+#
+# Usage:
+#   ruby benchmark/gvl_release.rb [threads] [payload_mb]
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'json'
+
+THREADS = (ARGV[0] || 4).to_i
+PAYLOAD_MB = (ARGV[1] || 10).to_i
+ITERATIONS = 5
+
+def build_payload(target_bytes)
+  record = {
+    "id" => 1,
+    "event" => "order.updated",
+    "customer" => { "name" => "Jane Doe", "email" => "jane@example.com" },
+    "lines" => (1..5).map { |i| { "sku" => "SKU-#{i}", "qty" => i, "price" => i * 9.99 } }
+  }
+  count = target_bytes / JSON.generate(record).bytesize
+  JSON.generate("events" => Array.new(count) { |i| record.merge("id" => i) })
+end
+
+def clock
+  Process.clock_gettime(Process::CLOCK_MONOTONIC)
+end
+
+# Run THREADS parsers concurrently with a ticker thread and report
+# wall time plus the worst gap the ticker saw between wakeups.
+def run(json, threshold)
+  stop = false
+  max_gap = 0.0
+  ticker = Thread.new do
+    last = clock
+    until stop
+      sleep 0.001
+      now = clock
+      max_gap = [max_gap, now - last].max
+      last = now
+    end
+  end
+
+  start = clock
+  workers = THREADS.times.map do
+    Thread.new { ITERATIONS.times { YYJson.load(json, gvl_release_threshold: threshold) } }
+  end
+  workers.each(&:join)
+  elapsed = clock - start
+
+  stop = true
+  ticker.join
+  [elapsed, max_gap]
+end
+
+json = build_payload(PAYLOAD_MB * 1024 * 1024)
+
+puts "=" * 60
+puts "GVL release benchmark"
+puts "=" * 60
+puts "Payload: #{BenchmarkHelpers.format_size(json.bytesize)}"
+puts "Threads: #{THREADS}, parses per thread: #{ITERATIONS}"
+puts
+
+# Warm up
+YYJson.load(json)
+
+results = {
+  "GVL held (threshold: 0)" => run(json, 0),
+  "GVL released (threshold: 1MB)" => run(json, 1024 * 1024)
+}
+
+total_bytes = json.bytesize * THREADS * ITERATIONS
+results.each do |name, (elapsed, max_gap)|
+  throughput = total_bytes / elapsed / (1024.0 * 1024)
+  puts "#{name}:"
+  puts "  Wall time:        #{elapsed.round(3)}s"
+  puts "  Throughput:       #{throughput.round(1)} MB/s"
+  puts "  Max ticker stall: #{(max_gap * 1000).round(1)}ms"
+  puts
+end
+
+held, released = results.values.map(&:first)
+puts "Speedup: #{(held / released).round(2)}x"
@@ -0,0 +1,42 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Selective-read benchmark for YYJson.load_lazy
+#
+# Reads three fields out of a 500-field event. YYJson.load converts every
+# field to Ruby; YYJson.load_lazy parses into a yyjson document and builds
+# only the fields that are accessed.
+#
+# Usage:
+#   ruby benchmark/lazy.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require_relative 'support/allocations'
+require 'json'
+require 'benchmark/ips'
+
+event = { "id" => 42, "type" => "page.view", "user" => { "id" => 7, "plan" => "pro" } }
+500.times { |i| event["field_#{i}"] = i.even? ? "value #{i}" : { "n" => i, "list" => [i, i + 1] } }
+json = JSON.generate(event)
+
+puts "Event: #{BenchmarkHelpers.format_size(json.bytesize)}, #{event.size} fields"
+puts "Objects allocated per read:"
+puts "  YYJson.load:      #{BenchmarkAllocations.per_call { h = YYJson.load(json); [h["id"], h["type"], h["user"]["plan"]] }}"
+puts "  YYJson.load_lazy: #{BenchmarkAllocations.per_call { d = YYJson.load_lazy(json); [d["id"], d["type"], d.dig("user", "plan")] }}"
+puts
+
+BenchmarkHelpers.compare_libraries("Read 3 of #{event.size} fields", json) do |x, input|
+  x.report("YYJson.load") do
+    h = YYJson.load(input)
+    [h["id"], h["type"], h["user"]["plan"]]
+  end
+  x.report("YYJson.load_lazy") do
+    d = YYJson.load_lazy(input)
+    [d["id"], d["type"], d.dig("user", "plan")]
+  end
+  x.report("JSON.parse") do
+    h = JSON.parse(input)
+    [h["id"], h["type"], h["user"]["plan"]]
+  end
+end
@@ -0,0 +1,41 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# NDJSON ingestion benchmark
+#
+# Compares splitting lines in Ruby and calling YYJson.load per record with
+# YYJson.each_line / load_lines, which find record boundaries in C and share
+# one allocator and key cache across records.
+#
+# Usage:
+#   ruby benchmark/lines.rb [records]
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'json'
+require 'stringio'
+require 'benchmark/ips'
+
+RECORDS = (ARGV[0] || 10_000).to_i
+
+ndjson = Array.new(RECORDS) do |i|
+  JSON.generate(
+    "ts" => "2024-01-15T10:30:#{format('%02d', i % 60)}Z",
+    "level" => %w[info warn error][i % 3],
+    "service" => "api",
+    "request_id" => "req-#{i}",
+    "duration_ms" => (i % 500) * 1.5,
+    "status" => 200
+  )
+end.join("\n") << "\n"
+
+puts "Input: #{RECORDS} records, #{BenchmarkHelpers.format_size(ndjson.bytesize)}"
+
+BenchmarkHelpers.compare_libraries("Parse #{RECORDS} NDJSON records", ndjson) do |x, input|
+  x.report("each_line + YYJson.load") { input.each_line { |l| YYJson.load(l) } }
+  x.report("YYJson.each_line") { YYJson.each_line(input) { |_| } }
+  x.report("YYJson.each_line (batch 500)") { YYJson.each_line(input, batch_size: 500) { |_| } }
+  x.report("YYJson.load_lines") { YYJson.load_lines(input) }
+  x.report("YYJson.each_line (IO)") { YYJson.each_line(StringIO.new(input)) { |_| } }
+  x.report("each_line + JSON.parse") { input.each_line { |l| JSON.parse(l) } }
+end
@@ -0,0 +1,32 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Parallel (Ractor) parsing benchmark
+#
+# Parses one large top-level array with YYJson.load (freeze: true, the
+# same deep-frozen output) and with YYJson.load_parallel across 1, 2, 4
+# and all cores. Speedups need as many free cores as shards.
+#
+# Usage:
+#   ruby benchmark/load_parallel.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'benchmark/ips'
+require 'etc'
+
+count = 400_000
+json = YYJson.dump(Array.new(count) do |i|
+  { "id" => i, "name" => "user #{i}", "tags" => ["a", "b"], "score" => i * 0.5 }
+end)
+
+puts "#{count} elements, #{BenchmarkHelpers.format_size(json.bytesize)} of JSON, #{Etc.nprocessors} cores"
+
+Benchmark.ips do |x|
+  x.config(time: 5, warmup: 1)
+  x.report("load freeze: true") { YYJson.load(json, freeze: true) }
+  [1, 2, 4, Etc.nprocessors].uniq.each do |n|
+    x.report("load_parallel threads: #{n}") { YYJson.load_parallel(json, threads: n) }
+  end
+  x.compare!
+end
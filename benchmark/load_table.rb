@@ -0,0 +1,44 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Columnar decoding benchmark
+#
+# Parses an export of 100k homogeneous records with YYJson.load (a Hash per
+# record) and with YYJson.load_table as columns, Structs and Data.
+#
+# Usage:
+#   ruby benchmark/load_table.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'benchmark/ips'
+
+count = 100_000
+json = YYJson.dump(Array.new(count) do |i|
+  { "id" => i, "name" => "user #{i}", "score" => i * 0.5, "active" => i.even?, "team" => i % 7 }
+end)
+
+raise "output mismatch" unless YYJson.load_table(json)["name"] == YYJson.load(json).map { |r| r["name"] }
+
+puts "#{count} records, #{BenchmarkHelpers.format_size(json.bytesize)} of JSON"
+
+Benchmark.ips do |x|
+  x.config(time: 3, warmup: 1)
+  x.report("load") { YYJson.load(json) }
+  x.report("load_table") { YYJson.load_table(json) }
+  x.report("load_table as: :struct") { YYJson.load_table(json, as: :struct) }
+  x.report("load_table as: :data") { YYJson.load_table(json, as: :data) }
+  x.compare!
+end
+
+allocs = lambda do |&blk|
+  GC.disable
+  before = GC.stat(:total_allocated_objects)
+  blk.call
+  GC.stat(:total_allocated_objects) - before
+ensure
+  GC.enable
+end
+puts "Allocations per parse: load #{allocs.() { YYJson.load(json) }}, " \
+     "load_table #{allocs.() { YYJson.load_table(json) }}, " \
+     "as: :struct #{allocs.() { YYJson.load_table(json, as: :struct) }}"
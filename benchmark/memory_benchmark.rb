@@ -32,6 +32,7 @@ end
 $LOAD_PATH.unshift File.expand_path('../lib', __dir__)
 $LOAD_PATH.unshift File.expand_path('../ext', __dir__)
 require 'yyjson'
+require 'tmpdir'
 
 # Force GC for accurate measurements
 def gc_compact
@@ -240,4 +241,55 @@ puts "JSON:   #{after_json - before_json} slots growth"
 puts "YYJson: #{after_yyjson - before_yyjson} slots growth"
 puts
 
+# Peak RSS growth for a block, run in a fresh forked process
+# (VmHWM is a process-wide high-water mark, so variants must not share one)
+def rss_hwm_kb
+  File.read('/proc/self/status')[/VmHWM:\s+(\d+)/, 1].to_i
+rescue Errno::ENOENT
+  nil
+end
+
+def peak_rss_growth_kb
+  reader, writer = IO.pipe
+  pid = fork do
+    reader.close
+    GC.start
+    before = rss_hwm_kb
+    yield
+    writer.write((rss_hwm_kb - before).to_s)
+    writer.close
+    exit!(0)
+  end
+  writer.close
+  result = reader.read.to_i
+  Process.wait(pid)
+  result
+end
+
+if Process.respond_to?(:fork) && rss_hwm_kb
+  puts "=" * 70
+  puts "LOAD_FILE PEAK RSS (lower is better)"
+  puts "=" * 70
+  puts
+
+  Dir.mktmpdir do |dir|
+    path = File.join(dir, 'large.json')
+    size_mb = (ENV['LOAD_FILE_MB'] || 50).to_i
+    record = JSON.parse(TWITTER_JSON)["statuses"][0]
+    count = (size_mb * 1024 * 1024) / record.to_json.bytesize
+    File.write(path, JSON.generate(Array.new(count) { |i| record.merge("id" => i) }))
+    puts "File size: #{(File.size(path) / 1024.0 / 1024).round(1)} MB (set LOAD_FILE_MB to change)"
+
+    json_kb = peak_rss_growth_kb { JSON.parse(File.read(path)) }
+    read_kb = peak_rss_growth_kb { YYJson.load_file(path) }
+    mmap_kb = peak_rss_growth_kb { YYJson.load_file(path, mmap: true) }
+
+    puts "  JSON.parse(File.read):          #{(json_kb / 1024.0).round(1)} MB"
+    puts "  YYJson.load_file:               #{(read_kb / 1024.0).round(1)} MB"
+    puts "  YYJson.load_file(mmap: true):   #{(mmap_kb / 1024.0).round(1)} MB " \
+         "(#{((read_kb - mmap_kb) / 1024.0).round(1)} MB less)"
+    puts
+  end
+end
+
 puts "Memory benchmark complete!"
@@ -0,0 +1,49 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# MessagePack benchmark
+#
+# Loads and dumps corpus documents as JSON and as MessagePack with YYJson,
+# and with the msgpack gem when it is installed, reporting the encoded
+# sizes. Both YYJson formats build the same Ruby objects.
+#
+# Usage:
+#   ruby benchmark/msgpack.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require_relative 'support/corpus'
+require 'benchmark/ips'
+
+begin
+  require 'msgpack'
+rescue LoadError
+  puts "msgpack gem not installed, comparing YYJson formats only"
+end
+
+%w[twitter citm canada].each do |name|
+  json = BenchmarkCorpus.json(name)
+  obj = YYJson.load(json)
+  packed = YYJson.dump_msgpack(obj)
+  raise "#{name}: formats disagree" unless YYJson.load_msgpack(packed) == obj
+
+  puts
+  puts "#{name}: #{BenchmarkHelpers.format_size(json.bytesize)} of JSON, " \
+       "#{BenchmarkHelpers.format_size(packed.bytesize)} of MessagePack"
+
+  Benchmark.ips do |x|
+    x.config(time: 3, warmup: 1)
+    x.report("YYJson.load") { YYJson.load(json) }
+    x.report("YYJson.load_msgpack") { YYJson.load_msgpack(packed) }
+    x.report("MessagePack.unpack") { MessagePack.unpack(packed) } if defined?(MessagePack)
+    x.compare!
+  end
+
+  Benchmark.ips do |x|
+    x.config(time: 3, warmup: 1)
+    x.report("YYJson.dump") { YYJson.dump(obj) }
+    x.report("YYJson.dump_msgpack") { YYJson.dump_msgpack(obj) }
+    x.report("MessagePack.pack") { MessagePack.pack(obj) } if defined?(MessagePack)
+    x.compare!
+  end
+end
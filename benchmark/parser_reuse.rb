@@ -0,0 +1,36 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Small-message parse benchmark for YYJson::Parser
+#
+# Compares YYJson.load with an options Hash (options extracted and a fresh
+# yyjson document malloc'd on every call) against a reused YYJson::Parser
+# (options compiled once, document memory pooled in its allocator).
+#
+# Usage:
+#   ruby benchmark/parser_reuse.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'json'
+require 'benchmark/ips'
+
+message = JSON.generate(
+  "id" => 12_345,
+  "type" => "order.updated",
+  "attributes" => { "status" => "paid", "total" => 99.95, "currency" => "USD" },
+  "tags" => %w[priority web]
+)
+
+opts = { symbolize_names: true }
+parser = YYJson::Parser.new(opts)
+cached_parser = YYJson::Parser.new(symbolize_names: true, key_cache: true)
+
+puts "Message: #{BenchmarkHelpers.format_size(message.bytesize)}"
+
+BenchmarkHelpers.compare_libraries("Parse small message", message) do |x, json|
+  x.report("YYJson.load(json, opts)") { YYJson.load(json, opts) }
+  x.report("Parser#parse") { parser.parse(json) }
+  x.report("Parser#parse (key_cache)") { cached_parser.parse(json) }
+  x.report("JSON.parse") { JSON.parse(json, symbolize_names: true) }
+end
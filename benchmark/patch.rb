@@ -0,0 +1,64 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# JSON Merge Patch / JSON Patch benchmark
+#
+# Updating a stored twitter.json-style document: YYJson.load, a Ruby deep
+# merge (or an in-place edit) and YYJson.dump, against YYJson.merge_patch /
+# YYJson.patch working on the JSON text without building Ruby objects.
+#
+# Usage:
+#   ruby benchmark/patch.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require_relative 'support/corpus'
+require 'benchmark/ips'
+
+json = BenchmarkCorpus.json('twitter')
+
+merge = { "search_metadata" => { "count" => 50, "refresh_url" => nil }, "patched" => true }
+ops = [
+  { "op" => "replace", "path" => "/statuses/0/text", "value" => "edited" },
+  { "op" => "remove", "path" => "/statuses/1" },
+  { "op" => "add", "path" => "/patched", "value" => true }
+]
+merge_json = YYJson.dump(merge)
+ops_json = YYJson.dump(ops)
+
+deep_merge = lambda do |target, patch|
+  return patch unless patch.is_a?(Hash)
+
+  target = {} unless target.is_a?(Hash)
+  patch.each do |k, v|
+    if v.nil?
+      target.delete(k)
+    else
+      target[k] = deep_merge.call(target[k], v)
+    end
+  end
+  target
+end
+
+ruby_patch = lambda do |doc|
+  doc["statuses"][0]["text"] = "edited"
+  doc["statuses"].delete_at(1)
+  doc["patched"] = true
+  doc
+end
+
+unless YYJson.load(YYJson.merge_patch(json, merge_json)) == deep_merge.call(YYJson.load(json), merge) &&
+       YYJson.load(YYJson.patch(json, ops_json)) == ruby_patch.call(YYJson.load(json))
+  raise 'native and Ruby patches disagree'
+end
+
+puts "twitter corpus document, #{BenchmarkHelpers.format_size(json.bytesize)}"
+
+Benchmark.ips do |x|
+  x.config(time: 3, warmup: 1)
+  x.report("load + deep merge + dump") { YYJson.dump(deep_merge.call(YYJson.load(json), merge)) }
+  x.report("YYJson.merge_patch") { YYJson.merge_patch(json, merge_json) }
+  x.report("load + edit + dump") { YYJson.dump(ruby_patch.call(YYJson.load(json))) }
+  x.report("YYJson.patch") { YYJson.patch(json, ops_json) }
+  x.compare!
+end
@@ -0,0 +1,64 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Registered class serializer benchmark
+#
+# Dumps the same models three ways: through as_json (builds a Hash per
+# object), through YYJson.register_class with attrs: (keys pre-escaped,
+# values read from C) and with a block.
+#
+# Usage:
+#   ruby benchmark/register_class.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'json'
+require 'benchmark/ips'
+
+class JsonModel
+  attr_reader :id, :name, :email, :active
+
+  def initialize(id)
+    @id = id
+    @name = "user #{id}"
+    @email = "user#{id}@example.com"
+    @active = id.even?
+  end
+
+  def as_json(*)
+    { "id" => @id, "name" => @name, "email" => @email, "active" => @active }
+  end
+end
+
+class AttrsModel < JsonModel; end
+class BlockModel < JsonModel; end
+
+YYJson.register_class(AttrsModel, attrs: [:id, :name, :email, :active])
+YYJson.register_class(BlockModel, &:as_json)
+
+count = 20_000
+as_json = Array.new(count) { |i| JsonModel.new(i) }
+attrs = Array.new(count) { |i| AttrsModel.new(i) }
+block = Array.new(count) { |i| BlockModel.new(i) }
+
+raise "output mismatch" unless YYJson.dump(as_json) == YYJson.dump(attrs)
+
+puts "#{count} models, #{BenchmarkHelpers.format_size(YYJson.dump(attrs).bytesize)} of JSON"
+
+Benchmark.ips do |x|
+  x.config(time: 3, warmup: 1)
+  x.report("as_json") { YYJson.dump(as_json) }
+  x.report("register_class attrs:") { YYJson.dump(attrs) }
+  x.report("register_class block") { YYJson.dump(block) }
+  x.compare!
+end
+
+allocs = lambda do |data|
+  GC.disable
+  before = GC.stat(:total_allocated_objects)
+  YYJson.dump(data)
+  GC.stat(:total_allocated_objects) - before
+ensure
+  GC.enable
+end
+puts "Allocations per dump: as_json #{allocs.(as_json)}, attrs: #{allocs.(attrs)}"
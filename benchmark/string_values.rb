@@ -0,0 +1,29 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# String value dump benchmark
+#
+# Dumps records embedding 100 KB HTML blobs (escaped in 64 KB pieces
+# instead of reserving 6x the blob) and many short UTF-8 values (written
+# without transcoding).
+#
+# Usage:
+#   ruby benchmark/string_values.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'benchmark/ips'
+
+html = ("<div class=\"row\"><p>Lorem ipsum dolor sit amet, café &amp; crème.</p></div>\n" * 1400)[0, 100_000]
+blobs = Array.new(50) { |i| { "id" => i, "body" => html.dup } }
+short = Array.new(50_000) { |i| "café #{i}" }
+
+puts "50 x #{BenchmarkHelpers.format_size(html.bytesize)} blobs, #{short.size} short strings"
+
+Benchmark.ips do |x|
+  x.config(time: 3, warmup: 1)
+  x.report("100 KB blobs") { YYJson.dump(blobs) }
+  x.report("100 KB blobs escape_html") { YYJson.dump(blobs, escape_html: true) }
+  x.report("short strings") { YYJson.dump(short) }
+  x.compare!
+end
@@ -0,0 +1,205 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Benchmark regression suite
+#
+# Parses and dumps every document of the fixed corpus (support/corpus.rb),
+# as JSON and as MessagePack, parses object-heavy documents with symbolize_names / freeze too (each
+# option combination has its own builder), plus an as_json-heavy Rails
+# dump, and reports for each case:
+#
+#   ops_per_sec  - median of timed batches (spread: relative stddev)
+#   allocations  - Ruby objects allocated per operation
+#   rss_kb       - peak resident set growth of one operation (each case
+#                  runs in a forked child, whose high-water mark starts at
+#                  its current RSS; Linux only, else 0)
+#
+# Results are printed as JSON, or written with --output. Compare two runs
+# with benchmark/compare.rb (rake benchmark:compare[base,head]).
+#
+# Usage:
+#   ruby benchmark/suite.rb [--output FILE] [--time SECONDS] [--filter REGEXP]
+#
+# YYJSON_LIB selects the lib/ directory to load YYJson from (used by
+# compare.rb to benchmark other checkouts with this same suite).
+
+YYJSON_LIB = ENV['YYJSON_LIB'] || File.expand_path('../lib', __dir__)
+$LOAD_PATH.unshift(YYJSON_LIB)
+require 'yyjson'
+require_relative 'support/corpus'
+require_relative 'support/allocations'
+require 'json'
+require 'optparse'
+require 'rbconfig'
+
+module BenchmarkSuite
+  # A record dumped through as_json, as with ActiveRecord in mode: :rails
+  class Model
+    def initialize(id, rng)
+      @id = id
+      @name = BenchmarkCorpus.sentence(rng, 2)
+      @email = "user#{id}@example.com"
+      @score = rng.rand * 100
+      @tags = Array.new(3) { BenchmarkCorpus::WORDS[rng.rand(BenchmarkCorpus::WORDS.size)] }
+      @created_at = Time.at(1_700_000_000 + id * 3600).utc
+    end
+
+    def as_json(*)
+      { 'id' => @id, 'name' => @name, 'email' => @email, 'score' => @score, 'tags' => @tags, 'created_at' => @created_at }
+    end
+  end
+
+  # Documents also parsed with symbolize_names: true and freeze: true
+  OPTION_DOCUMENTS = %w[twitter citm wide_objects].freeze
+
+  module_function
+
+  # name => callable, one per case
+  def cases
+    list = {}
+
+    BenchmarkCorpus::DOCUMENTS.each_key do |name|
+      json = BenchmarkCorpus.json(name)
+      obj = YYJson.load(json)
+      list["parse/#{name}"] = [json.bytesize, -> { YYJson.load(json) }]
+      list["dump/#{name}"] = [json.bytesize, -> { YYJson.dump(obj) }]
+
+      # Absent from checkouts before MessagePack support (compare.rb)
+      next unless YYJson.respond_to?(:dump_msgpack)
+
+      msgpack = YYJson.dump_msgpack(obj)
+      list["msgpack_load/#{name}"] = [msgpack.bytesize, -> { YYJson.load_msgpack(msgpack) }]
+      list["msgpack_dump/#{name}"] = [msgpack.bytesize, -> { YYJson.dump_msgpack(obj) }]
+    end
+
+    OPTION_DOCUMENTS.each do |name|
+      json = BenchmarkCorpus.json(name)
+      list["parse_sym/#{name}"] = [json.bytesize, -> { YYJson.load(json, symbolize_names: true) }]
+      list["parse_frozen/#{name}"] = [json.bytesize, -> { YYJson.load(json, freeze: true) }]
+    end
+
+    rng = Random.new(BenchmarkCorpus::SEED)
+    models = Array.new(2_000) { |i| Model.new(i, rng) }
+    list['dump/rails_as_json'] = [YYJson.dump(models, mode: :rails).bytesize, -> { YYJson.dump(models, mode: :rails) }]
+
+    list
+  end
+
+  def now
+    Process.clock_gettime(Process::CLOCK_MONOTONIC)
+  end
+
+  def rss_hwm_kb
+    File.read('/proc/self/status')[/VmHWM:\s+(\d+)/, 1].to_i
+  rescue Errno::ENOENT
+    0
+  end
+
+  # Median ops/s over batches sized to take about a tenth of `time` each
+  def measure(job, time)
+    warmup_until = now + time * 0.2
+    ops = 0
+    start = now
+    loop do
+      job.call
+      ops += 1
+      break if now >= warmup_until
+    end
+    per_op = (now - start) / ops
+
+    batch = [(time / 10 / per_op).ceil, 1].max
+    samples = []
+    deadline = now + time
+    while samples.size < 5 || now < deadline
+      t = now
+      batch.times { job.call }
+      samples << batch / (now - t)
+    end
+
+    samples.sort!
+    mean = samples.sum / samples.size
+    stddev = Math.sqrt(samples.sum { |s| (s - mean)**2 } / samples.size)
+    { ops_per_sec: samples[samples.size / 2].round(2), spread: (stddev / mean).round(4), samples: samples.size }
+  end
+
+  def run_case(bytes, job, time)
+    # First, before garbage from repeated runs inflates the resident set
+    rss_before = rss_hwm_kb
+    job.call
+    rss = rss_hwm_kb - rss_before
+
+    result = measure(job, time)
+    result[:rss_kb] = rss
+    result[:allocations] = BenchmarkAllocations.per_call(10) { job.call }
+    result[:bytes] = bytes
+    result
+  end
+
+  # Run one case in a forked child, so each measures its own RSS peak
+  def run_isolated(bytes, job, time)
+    return run_case(bytes, job, time) unless Process.respond_to?(:fork) && File.exist?('/proc/self/status')
+
+    reader, writer = IO.pipe
+    pid = fork do
+      reader.close
+      writer.write(JSON.generate(run_case(bytes, job, time)))
+      writer.close
+      exit!(0)
+    end
+    writer.close
+    out = reader.read
+    reader.close
+    Process.wait(pid)
+    raise "benchmark child failed (#{$?})" unless $?.success?
+
+    JSON.parse(out, symbolize_names: true)
+  end
+
+  def git_revision
+    rev = `git -C #{File.dirname(YYJSON_LIB)} rev-parse --short HEAD 2>/dev/null`.strip
+    rev.empty? ? nil : rev
+  end
+
+  def run(time:, filter: nil, io: $stderr)
+    results = {}
+    cases.each do |name, (bytes, job)|
+      next if filter && name !~ filter
+
+      r = run_isolated(bytes, job, time)
+      io.puts format('%-26s %12.1f ops/s  ±%4.1f%%  %9d allocs  %8d KB RSS', name, r[:ops_per_sec], r[:spread] * 100, r[:allocations], r[:rss_kb])
+      results[name] = r
+    end
+
+    {
+      meta: {
+        yyjson_version: YYJson::VERSION,
+        revision: git_revision,
+        ruby: RUBY_DESCRIPTION,
+        platform: RbConfig::CONFIG['host'],
+        corpus_version: BenchmarkCorpus::CORPUS_VERSION,
+        time_per_case: time,
+        created_at: Time.now.utc.strftime('%Y-%m-%dT%H:%M:%SZ')
+      },
+      results: results
+    }
+  end
+end
+
+if $PROGRAM_NAME == __FILE__
+  options = { time: 2.0, output: nil, filter: nil }
+  OptionParser.new do |o|
+    o.banner = 'Usage: ruby benchmark/suite.rb [options]'
+    o.on('-o', '--output FILE', 'Write results JSON to FILE') { |v| options[:output] = v }
+    o.on('-t', '--time SECONDS', Float, 'Measured time per case (default: 2)') { |v| options[:time] = v }
+    o.on('-f', '--filter REGEXP', 'Only run matching cases') { |v| options[:filter] = Regexp.new(v) }
+  end.parse!
+
+  report = BenchmarkSuite.run(time: options[:time], filter: options[:filter])
+  json = JSON.pretty_generate(report)
+  if options[:output]
+    File.write(options[:output], json)
+    warn "Results written to #{options[:output]}"
+  else
+    puts json
+  end
+end
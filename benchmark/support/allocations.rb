@@ -0,0 +1,16 @@
+# frozen_string_literal: true
+
+# Ruby objects allocated per call of a block
+module BenchmarkAllocations
+  module_function
+
+  # Average over runs calls, after one uncounted call so first-use caches
+  # and lazy initialization aren't included
+  def per_call(runs = 1)
+    yield
+    GC.start
+    before = GC.stat(:total_allocated_objects)
+    runs.times { yield }
+    (GC.stat(:total_allocated_objects) - before) / runs
+  end
+end
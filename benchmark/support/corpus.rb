@@ -0,0 +1,169 @@
+# frozen_string_literal: true
+
+require 'json'
+require 'fileutils'
+
+# Fixed benchmark corpus
+#
+# Documents modelled on the usual JSON benchmark files (twitter.json,
+# citm_catalog.json, canada.json) plus shapes that stress particular YYJson
+# paths. Every document is generated from a fixed seed, so the bytes only
+# change when CORPUS_VERSION is bumped: results of different YYJson
+# versions are comparable as long as they name the same corpus version.
+#
+# Generated files are cached in benchmark/corpus/ (not committed).
+module BenchmarkCorpus
+  CORPUS_VERSION = 1
+  DIR = File.expand_path('../corpus', __dir__)
+  SEED = 20_240_601
+
+  WORDS = %w[
+    lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod
+    tempor incididunt ut labore et dolore magna aliqua café naïve 東京 ☕
+  ].freeze
+
+  # name => description
+  DOCUMENTS = {
+    'twitter' => 'Timeline of statuses with nested users and entities (twitter.json-style)',
+    'citm' => 'Event catalog with id-keyed maps and integer arrays (citm_catalog.json-style)',
+    'canada' => 'GeoJSON polygons of float coordinates (canada.json-style)',
+    'wide_objects' => 'Objects with 500 distinct keys',
+    'deep_nesting' => 'Arrays and objects nested 90 levels deep',
+    'numbers' => 'Integers and floats of every magnitude',
+    'strings' => 'Long and short strings with escapes and multibyte characters'
+  }.freeze
+
+  module_function
+
+  # JSON text of a corpus document (generated once, then read from the cache)
+  def json(name)
+    path = File.join(DIR, "v#{CORPUS_VERSION}", "#{name}.json")
+    return File.read(path, encoding: 'UTF-8') if File.exist?(path)
+
+    text = JSON.generate(build(name))
+    FileUtils.mkdir_p(File.dirname(path))
+    File.write(path, text)
+    text
+  end
+
+  def build(name)
+    raise ArgumentError, "unknown corpus document #{name}" unless DOCUMENTS.key?(name)
+
+    send("build_#{name}", Random.new(SEED))
+  end
+
+  def sentence(rng, words)
+    Array.new(words) { WORDS[rng.rand(WORDS.size)] }.join(' ')
+  end
+
+  def build_twitter(rng)
+    statuses = Array.new(400) do |i|
+      user_id = rng.rand(1_000_000_000)
+      {
+        'created_at' => "Sun Aug 31 00:#{format('%02d', i % 60)}:#{format('%02d', rng.rand(60))} +0000 2014",
+        'id' => 505_874_924_095_815_681 + i,
+        'id_str' => (505_874_924_095_815_681 + i).to_s,
+        'text' => sentence(rng, 8 + rng.rand(12)),
+        'source' => '<a href="http://twitter.com/download/iphone" rel="nofollow">Twitter for iPhone</a>',
+        'truncated' => false,
+        'in_reply_to_status_id' => rng.rand(4).zero? ? rng.rand(10**17) : nil,
+        'user' => {
+          'id' => user_id,
+          'id_str' => user_id.to_s,
+          'name' => sentence(rng, 2),
+          'screen_name' => "user_#{rng.rand(100_000)}",
+          'location' => sentence(rng, 2),
+          'description' => sentence(rng, 10),
+          'url' => nil,
+          'protected' => false,
+          'followers_count' => rng.rand(100_000),
+          'friends_count' => rng.rand(5_000),
+          'created_at' => 'Thu Jul 04 00:18:08 +0000 2013',
+          'verified' => rng.rand(10).zero?,
+          'profile_image_url' => "http://pbs.twimg.com/profile_images/#{rng.rand(10**9)}/abc_normal.jpeg"
+        },
+        'entities' => {
+          'hashtags' => Array.new(rng.rand(3)) { { 'text' => WORDS[rng.rand(WORDS.size)], 'indices' => [rng.rand(100), rng.rand(140)] } },
+          'urls' => [],
+          'user_mentions' => Array.new(rng.rand(3)) { { 'screen_name' => "user_#{rng.rand(1000)}", 'id' => rng.rand(10**9), 'indices' => [0, 10] } }
+        },
+        'retweet_count' => rng.rand(1000),
+        'favorite_count' => rng.rand(1000),
+        'favorited' => false,
+        'retweeted' => false,
+        'lang' => 'ja'
+      }
+    end
+    { 'statuses' => statuses, 'search_metadata' => { 'completed_in' => 0.087, 'max_id' => 505_874_924_095_815_681, 'count' => 400 } }
+  end
+
+  def build_citm(rng)
+    events = {}
+    performances = []
+    1500.times do |i|
+      id = (138_586_341 + i * 7).to_s
+      events[id] = {
+        'description' => nil,
+        'id' => id.to_i,
+        'logo' => rng.rand(2).zero? ? "/images/UE0AAAAACEKo#{id}AAAAVDSVVT" : nil,
+        'name' => sentence(rng, 3),
+        'subTopicIds' => Array.new(1 + rng.rand(4)) { 337_184_262 + rng.rand(100) },
+        'subjectCode' => nil,
+        'subtitle' => nil,
+        'topicIds' => Array.new(1 + rng.rand(3)) { 324_846_099 + rng.rand(100) }
+      }
+      performances << {
+        'eventId' => id.to_i,
+        'id' => 339_887_544 + i,
+        'logo' => nil,
+        'name' => nil,
+        'prices' => Array.new(1 + rng.rand(3)) { { 'amount' => 9000 + rng.rand(90_000), 'audienceSubCategoryId' => 337_100_890, 'seatCategoryId' => 338_937_295 + rng.rand(10) } },
+        'seatCategories' => Array.new(1 + rng.rand(3)) { { 'areas' => Array.new(1 + rng.rand(5)) { { 'areaId' => 205_705_999 + rng.rand(100), 'blockIds' => [] } }, 'seatCategoryId' => 338_937_295 + rng.rand(10) } },
+        'seatMapImage' => nil,
+        'start' => 1_372_608_000_000 + rng.rand(10**10),
+        'venueCode' => 'PLEYEL_PLEYEL'
+      }
+    end
+    { 'areaNames' => Array.new(200) { |i| [(205_705_993 + i).to_s, sentence(rng, 2)] }.to_h, 'events' => events, 'performances' => performances }
+  end
+
+  def build_canada(rng)
+    features = Array.new(4) do
+      rings = Array.new(120) do
+        lon = -141.0 + rng.rand * 90
+        lat = 41.0 + rng.rand * 40
+        Array.new(150) { [(lon += rng.rand * 0.02 - 0.01).round(12), (lat += rng.rand * 0.02 - 0.01).round(12)] }
+      end
+      { 'type' => 'Feature', 'properties' => { 'name' => 'Canada' }, 'geometry' => { 'type' => 'Polygon', 'coordinates' => rings } }
+    end
+    { 'type' => 'FeatureCollection', 'features' => features }
+  end
+
+  def build_wide_objects(rng)
+    keys = Array.new(500) { |i| "field_#{i}_#{WORDS[i % WORDS.size]}" }
+    Array.new(60) { keys.to_h { |k| [k, rng.rand(3).zero? ? sentence(rng, 2) : rng.rand(10_000)] } }
+  end
+
+  def build_deep_nesting(rng)
+    Array.new(300) do
+      90.times.reduce(rng.rand(1000)) { |inner, depth| depth.even? ? [inner, depth] : { 'level' => depth, 'next' => inner } }
+    end
+  end
+
+  def build_numbers(rng)
+    {
+      'small_ints' => Array.new(30_000) { rng.rand(-100..100) },
+      'big_ints' => Array.new(20_000) { rng.rand(-2**62..2**62) },
+      'floats' => Array.new(20_000) { (rng.rand - 0.5) * 10**rng.rand(-8..12) },
+      'prices' => Array.new(20_000) { (rng.rand * 1000).round(2) }
+    }
+  end
+
+  def build_strings(rng)
+    {
+      'short' => Array.new(20_000) { sentence(rng, 1 + rng.rand(3)) },
+      'escaped' => Array.new(2_000) { "line \"#{rng.rand(1000)}\"\n\ttab \\ <tag> & #{sentence(rng, 4)}" },
+      'long' => Array.new(20) { sentence(rng, 5_000) }
+    }
+  end
+end
@@ -0,0 +1,41 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Time / Date / Bignum / BigDecimal dump benchmark
+#
+# API-style records where timestamps make up a good share of the bytes.
+# Time and Date are formatted in C from the Time's timespec / the Date's
+# Julian Day; Bignum and BigDecimal are written as exact raw numbers.
+#
+# Usage:
+#   ruby benchmark/time_formatting.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require 'json'
+require 'time'
+require 'date'
+require 'bigdecimal'
+require 'benchmark/ips'
+
+base = Time.utc(2024, 1, 1)
+count = 10_000
+
+records = Array.new(count) do |i|
+  {
+    "id" => i,
+    "created_at" => base + i * 37.25,
+    "updated_at" => (base + i * 91.5).getlocal("+02:00"),
+    "due_on" => Date.new(2024, 1, 1) + (i % 365)
+  }
+end
+numbers = Array.new(count) { |i| i.even? ? 2**64 + i : BigDecimal("#{i}.25") }
+
+puts "#{count} records, #{BenchmarkHelpers.format_size(YYJson.dump(records).bytesize)} of JSON"
+
+Benchmark.ips do |x|
+  x.config(time: 3, warmup: 1)
+  x.report("YYJson.dump records") { YYJson.dump(records) }
+  x.report("YYJson.dump records (time_precision: 3)") { YYJson.dump(records, time_precision: 3) }
+  x.report("YYJson.dump Bignum/BigDecimal") { YYJson.dump(numbers) }
+end
@@ -0,0 +1,82 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Validation benchmark
+#
+# Rejecting or accepting a twitter.json-style request body: a full
+# YYJson.load (what a controller pays to look at the input), YYJson.valid?
+# (syntax only, no Ruby objects), the same load followed by the equivalent
+# checks in Ruby, and a compiled YYJson::Schema doing those checks in C.
+#
+# Usage:
+#   ruby benchmark/validate.rb
+
+require_relative '../lib/yyjson'
+require_relative 'support/helpers'
+require_relative 'support/corpus'
+require_relative 'support/allocations'
+require 'benchmark/ips'
+
+json = BenchmarkCorpus.json('twitter')
+
+schema = YYJson::Schema.compile(
+  'type' => 'object',
+  'required' => %w[statuses search_metadata],
+  'properties' => {
+    'statuses' => {
+      'type' => 'array',
+      'items' => {
+        'type' => 'object',
+        'required' => %w[id text user],
+        'properties' => {
+          'id' => { 'type' => 'integer', 'minimum' => 1 },
+          'text' => { 'type' => 'string', 'maxLength' => 280 },
+          'lang' => { 'type' => 'string' },
+          'user' => {
+            'type' => 'object',
+            'required' => %w[id screen_name],
+            'properties' => {
+              'id' => { 'type' => 'integer' },
+              'screen_name' => { 'type' => 'string', 'minLength' => 1 },
+              'followers_count' => { 'type' => 'integer', 'minimum' => 0 }
+            }
+          }
+        }
+      }
+    }
+  }
+)
+
+ruby_check = lambda do |doc|
+  doc.is_a?(Hash) && doc.key?('statuses') && doc.key?('search_metadata') &&
+    doc['statuses'].is_a?(Array) &&
+    doc['statuses'].all? do |s|
+      user = s['user']
+      s.is_a?(Hash) && s['id'].is_a?(Integer) && s['id'] >= 1 &&
+        s['text'].is_a?(String) && s['text'].length <= 280 &&
+        (!s.key?('lang') || s['lang'].is_a?(String)) &&
+        user.is_a?(Hash) && user['id'].is_a?(Integer) &&
+        user['screen_name'].is_a?(String) && !user['screen_name'].empty? &&
+        (!user.key?('followers_count') || (user['followers_count'].is_a?(Integer) && user['followers_count'] >= 0))
+    end
+end
+
+raise 'schema and Ruby checks disagree' unless schema.valid?(json) && ruby_check.call(YYJson.load(json))
+
+puts "twitter corpus document, #{BenchmarkHelpers.format_size(json.bytesize)}"
+
+Benchmark.ips do |x|
+  x.config(time: 3, warmup: 1)
+  x.report("YYJson.load") { YYJson.load(json) }
+  x.report("YYJson.valid?") { YYJson.valid?(json) }
+  x.report("load + Ruby checks") { ruby_check.call(YYJson.load(json)) }
+  x.report("Schema#valid?") { schema.valid?(json) }
+  x.compare!
+end
+
+puts
+puts "Allocations per call:"
+puts "  YYJson.load         #{BenchmarkAllocations.per_call { YYJson.load(json) }}"
+puts "  YYJson.valid?       #{BenchmarkAllocations.per_call { YYJson.valid?(json) }}"
+puts "  load + Ruby checks  #{BenchmarkAllocations.per_call { ruby_check.call(YYJson.load(json)) }}"
+puts "  Schema#valid?       #{BenchmarkAllocations.per_call { schema.valid?(json) }}"
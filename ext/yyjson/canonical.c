@@ -0,0 +1,150 @@
+/*
+ * canonical.c - Canonical JSON tokens (dump canonical: true)
+ */
+
+#include "canonical.h"
+#include <stdbool.h>
+#include <string.h>
+
+/* Exponents are clamped here, far past anything a double or a sane
+ * BigDecimal has, so the arithmetic below can't overflow */
+#define CANONICAL_EXP_MAX 1000000000L
+
+int
+yyjson_canonical_key_cmp(const char *a, size_t alen, const char *b, size_t blen)
+{
+    size_t n = alen < blen ? alen : blen;
+    size_t i = 0;
+    while (i < n && a[i] == b[i]) i++;
+    if (i == n) return alen < blen ? -1 : alen > blen;
+
+    /* After a common prefix, both bytes start a character or both
+     * continue one of the same length, so only lead bytes need care */
+    unsigned char ca = (unsigned char)a[i];
+    unsigned char cb = (unsigned char)b[i];
+    if (ca >= 0xF0 && (cb == 0xEE || cb == 0xEF)) return -1;
+    if (cb >= 0xF0 && (ca == 0xEE || ca == 0xEF)) return 1;
+    return ca < cb ? -1 : 1;
+}
+
+/*
+ * Copy count digits of the mantissa [m, m_end), from digit index from on
+ * (the '.' is not a digit)
+ */
+static char *
+put_digits(char *cur, const char *m, const char *m_end, long from, long count)
+{
+    long idx = 0;
+    for (; m < m_end && count > 0; m++) {
+        if (*m == '.') continue;
+        if (idx++ < from) continue;
+        *cur++ = *m;
+        count--;
+    }
+    return cur;
+}
+
+char *
+yyjson_canonical_number(char *cur, const char *s, size_t len)
+{
+    const char *p = s;
+    const char *end = s + len;
+    bool neg = p < end && *p == '-';
+    if (neg) p++;
+
+    /* Mantissa: digits with at most one '.'; int_len digits before it.
+     * first / last: digit indexes of the first and last non-zero ones */
+    const char *m = p;
+    long ndigits = 0, int_len = -1, first = -1, last = -1;
+    for (; p < end; p++) {
+        if (*p == '.') {
+            if (int_len >= 0) return NULL;
+            int_len = ndigits;
+        } else if (*p >= '0' && *p <= '9') {
+            if (*p != '0') {
+                if (first < 0) first = ndigits;
+                last = ndigits;
+            }
+            ndigits++;
+        } else {
+            break;
+        }
+    }
+    const char *m_end = p;
+    if (ndigits == 0) return NULL;
+    if (int_len < 0) int_len = ndigits;
+
+    long exp = 0;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool exp_neg = p < end && *p == '-';
+        if (p < end && (*p == '+' || *p == '-')) p++;
+        if (p == end) return NULL;
+        for (; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (exp < CANONICAL_EXP_MAX) exp = exp * 10 + (*p - '0');
+        }
+        if (exp_neg) exp = -exp;
+    }
+    if (p != end) return NULL;
+
+    /* Zero, including -0.0 */
+    if (first < 0) {
+        *cur++ = '0';
+        return cur;
+    }
+
+    /* value = 0.D x 10^n for the k significant digits D (ECMA-262
+     * Number::toString) */
+    long k = last - first + 1;
+    long n = int_len - first + exp;
+
+    if (neg) *cur++ = '-';
+    if (k <= n && n <= 21) {
+        cur = put_digits(cur, m, m_end, first, k);
+        memset(cur, '0', (size_t)(n - k));
+        cur += n - k;
+    } else if (0 < n && n <= 21) {
+        cur = put_digits(cur, m, m_end, first, n);
+        *cur++ = '.';
+        cur = put_digits(cur, m, m_end, first + n, k - n);
+    } else if (-6 < n && n <= 0) {
+        *cur++ = '0';
+        *cur++ = '.';
+        memset(cur, '0', (size_t)-n);
+        cur += -n;
+        cur = put_digits(cur, m, m_end, first, k);
+    } else {
+        cur = put_digits(cur, m, m_end, first, 1);
+        if (k > 1) {
+            *cur++ = '.';
+            cur = put_digits(cur, m, m_end, first + 1, k - 1);
+        }
+        long e = n - 1;
+        *cur++ = 'e';
+        *cur++ = e < 0 ? '-' : '+';
+        if (e < 0) e = -e;
+        char tmp[24];
+        int t = 0;
+        do {
+            tmp[t++] = (char)('0' + e % 10);
+            e /= 10;
+        } while (e > 0);
+        while (t > 0) *cur++ = tmp[--t];
+    }
+    return cur;
+}
+
+void
+yyjson_canonical_lower_escapes(char *cur, char *end)
+{
+    while (cur < end && (cur = memchr(cur, '\\', (size_t)(end - cur)))) {
+        if (cur[1] == 'u') {
+            for (int i = 2; i < 6; i++) {
+                if (cur[i] >= 'A' && cur[i] <= 'F') cur[i] = (char)(cur[i] - 'A' + 'a');
+            }
+            cur += 6;
+        } else {
+            cur += 2;
+        }
+    }
+}
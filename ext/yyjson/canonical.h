@@ -0,0 +1,45 @@
+/*
+ * canonical.h - Canonical JSON tokens (dump canonical: true)
+ *
+ * RFC 8785 (JCS) forms of the pieces that differ from yyjson's output:
+ * object keys in UTF-16 code unit order, numbers as ECMAScript writes
+ * them, and lowercase \u escapes. object_dumper.c applies them.
+ */
+
+#ifndef YYJSON_RUBY_CANONICAL_H
+#define YYJSON_RUBY_CANONICAL_H
+
+#include <stddef.h>
+
+/* Bytes yyjson_canonical_number() may write beyond the input's length */
+#define CANONICAL_NUM_EXTRA 32
+
+/*
+ * Compare two UTF-8 keys in UTF-16 code unit order (the JCS key order)
+ *
+ * Byte order is code point order, which only differs for characters past
+ * U+FFFF (surrogate pairs, D800-DBFF) against U+E000-U+FFFF.
+ *
+ * @return <0, 0 or >0 as a sorts before, with or after b
+ */
+int yyjson_canonical_key_cmp(const char *a, size_t alen, const char *b, size_t blen);
+
+/*
+ * Write a JSON number (yyjson's shortest round-trip double, or a
+ * BigDecimal's digits such as 0.15e1) in ECMAScript Number#toString form:
+ * no exponent from 1e-6 up to 1e21, no fraction for integral values, and
+ * "0" for negative zero. The digits are kept: none are added or rounded.
+ *
+ * Reserve len + CANONICAL_NUM_EXTRA bytes at cur.
+ *
+ * @return Cursor after the number, or NULL if s is not a finite number
+ */
+char *yyjson_canonical_number(char *cur, const char *s, size_t len);
+
+/*
+ * Lowercase the hex digits of the \u escapes in escaped string bytes
+ * [cur, end) (yyjson writes \u001F, JCS wants \u001f)
+ */
+void yyjson_canonical_lower_escapes(char *cur, char *end);
+
+#endif /* YYJSON_RUBY_CANONICAL_H */
@@ -0,0 +1,284 @@
+/*
+ * class_registry.c - Native class serializers: YYJson.register_class
+ *
+ * A registered class is dumped without an intermediate as_json Hash. The
+ * attrs: form is compiled once into reader/ivar IDs and JSON keys that are
+ * already quoted (keys that would need escaping under some dump option are
+ * kept raw), so object_dumper.c writes each key with a memcpy and dumps
+ * each value straight from the object. The block form
+ * dumps whatever the block returns for an instance.
+ */
+
+#include "common.h"
+#include "class_registry.h"
+#include "dispatch.h"
+#include "canonical.h"
+#include <ruby/encoding.h>
+#include <string.h>
+
+/* Class => serializer (attrs object or Proc), compared by identity */
+static VALUE registry = Qnil;
+
+static void
+serializer_free(void *ptr)
+{
+    class_serializer_t *ser = (class_serializer_t *)ptr;
+    for (long i = 0; i < ser->count; i++) {
+        if (ser->attrs[i].key) YYJSON_FREE(ser->attrs[i].key);
+    }
+    if (ser->attrs) YYJSON_FREE(ser->attrs);
+    if (ser->sorted) YYJSON_FREE(ser->sorted);
+    YYJSON_FREE(ser);
+}
+
+static size_t
+serializer_memsize(const void *ptr)
+{
+    const class_serializer_t *ser = (const class_serializer_t *)ptr;
+    size_t size = sizeof(class_serializer_t) + (size_t)ser->count * (sizeof(class_attr_t) + sizeof(long));
+    for (long i = 0; i < ser->count; i++) {
+        size += ser->attrs[i].key_len;
+    }
+    return size;
+}
+
+static const rb_data_type_t serializer_type = {
+    .wrap_struct_name = "YYJson::ClassSerializer",
+    .function = {
+        .dmark = NULL,
+        .dfree = serializer_free,
+        .dsize = serializer_memsize,
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+const class_serializer_t *
+yyjson_class_serializer_get(VALUE serializer)
+{
+    if (!rb_typeddata_is_kind_of(serializer, &serializer_type)) return NULL;
+    return (const class_serializer_t *)RTYPEDDATA_DATA(serializer);
+}
+
+VALUE
+yyjson_class_registry_find(VALUE klass)
+{
+    if (RHASH_EMPTY_P(registry)) return Qnil;
+
+    /* Nearest registered ancestor (included modules never match) */
+    for (VALUE k = klass; RTEST(k); k = rb_class_get_superclass(k)) {
+        VALUE ser = rb_hash_lookup2(registry, k, Qundef);
+        if (ser != Qundef) return ser;
+    }
+    return Qnil;
+}
+
+/*
+ * Printable ASCII that no dump option escapes (not '"', '\', '/', or
+ * the escape_html characters)
+ */
+static bool
+is_plain_key(const char *s, long len)
+{
+    for (long i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c < 0x20 || c > 0x7E || strchr("\"\\/<>&'", c)) return false;
+    }
+    return true;
+}
+
+static VALUE
+name_str(VALUE name)
+{
+    if (SYMBOL_P(name)) return rb_sym2str(name);
+    StringValue(name);
+    return name;
+}
+
+/*
+ * Fill one attribute from a reader/ivar name and its JSON key
+ */
+static void
+compile_attr(class_attr_t *a, VALUE name, VALUE key)
+{
+    VALUE name_s = name_str(name);
+    const char *s = RSTRING_PTR(name_s);
+    long len = RSTRING_LEN(name_s);
+
+    if (len == 0) rb_raise(rb_eArgError, "empty attribute name");
+    a->ivar = s[0] == '@';
+    a->id = rb_intern2(s, len);
+
+    /* Default key: the name without its '@' */
+    VALUE key_s = NIL_P(key) ? (a->ivar ? rb_str_new(s + 1, len - 1) : name_s) : name_str(key);
+    key_s = rb_str_export_to_enc(key_s, rb_utf8_encoding());
+    if (rb_enc_str_coderange(key_s) == ENC_CODERANGE_BROKEN) {
+        rb_raise(rb_eArgError, "invalid UTF-8 in attribute key %+"PRIsVALUE, key_s);
+    }
+
+    const char *k = RSTRING_PTR(key_s);
+    long klen = RSTRING_LEN(key_s);
+    a->key_plain = is_plain_key(k, klen);
+    if (a->key_plain) {
+        a->key_len = (size_t)klen + 2;
+        a->key = YYJSON_ALLOC_N(char, a->key_len);
+        a->key[0] = '"';
+        memcpy(a->key + 1, k, (size_t)klen);
+        a->key[klen + 1] = '"';
+    } else {
+        a->key_len = (size_t)klen;
+        a->key = YYJSON_ALLOC_N(char, a->key_len > 0 ? a->key_len : 1);
+        memcpy(a->key, k, (size_t)klen);
+    }
+    RB_GC_GUARD(key_s);
+}
+
+/* An attribute's unquoted JSON key, for sorting */
+typedef struct {
+    const char *key;
+    size_t len;
+    long idx;
+} attr_sort_key_t;
+
+static int
+compare_attr_keys(const void *a, const void *b)
+{
+    const attr_sort_key_t *ka = a;
+    const attr_sort_key_t *kb = b;
+    int c = yyjson_canonical_key_cmp(ka->key, ka->len, kb->key, kb->len);
+    return c != 0 ? c : (ka->idx < kb->idx ? -1 : ka->idx > kb->idx);
+}
+
+/*
+ * Fill ser->sorted: attribute indexes in canonical key order. Sorting puts
+ * equal keys next to each other: a key given twice raises ArgumentError
+ * (the object would be dumped with it twice).
+ */
+static void
+sort_attrs(class_serializer_t *ser)
+{
+    long n = ser->count;
+    ser->sorted = YYJSON_ALLOC_N(long, n > 0 ? n : 1);
+
+    attr_sort_key_t *keys = YYJSON_ALLOC_N(attr_sort_key_t, n > 0 ? n : 1);
+    for (long i = 0; i < n; i++) {
+        const class_attr_t *a = &ser->attrs[i];
+        /* Plain keys are stored quoted */
+        keys[i].key = a->key_plain ? a->key + 1 : a->key;
+        keys[i].len = a->key_plain ? a->key_len - 2 : a->key_len;
+        keys[i].idx = i;
+    }
+    qsort(keys, (size_t)n, sizeof(attr_sort_key_t), compare_attr_keys);
+    VALUE dup = Qnil;
+    for (long i = 0; i < n; i++) {
+        ser->sorted[i] = keys[i].idx;
+        if (i > 0 && NIL_P(dup) &&
+            yyjson_canonical_key_cmp(keys[i - 1].key, keys[i - 1].len, keys[i].key, keys[i].len) == 0) {
+            dup = rb_utf8_str_new(keys[i].key, (long)keys[i].len);
+        }
+    }
+    YYJSON_FREE(keys);
+    if (!NIL_P(dup)) rb_raise(rb_eArgError, "duplicate attribute key %+"PRIsVALUE, dup);
+}
+
+/*
+ * Compile attrs: (an Array of names, or a Hash of JSON key => name)
+ */
+static VALUE
+compile_serializer(VALUE attrs)
+{
+    class_serializer_t *ser;
+    VALUE obj = TypedData_Make_Struct(0, class_serializer_t, &serializer_type, ser);
+
+    VALUE names, keys = Qnil;
+    if (RB_TYPE_P(attrs, T_HASH)) {
+        keys = rb_funcall(attrs, rb_intern("keys"), 0);
+        names = rb_funcall(attrs, rb_intern("values"), 0);
+    } else {
+        Check_Type(attrs, T_ARRAY);
+        names = attrs;
+    }
+
+    long n = RARRAY_LEN(names);
+    ser->attrs = YYJSON_ALLOC_N(class_attr_t, n > 0 ? n : 1);
+    for (long i = 0; i < n; i++) {
+        /* Count first: serializer_free releases what has been compiled */
+        ser->count = i + 1;
+        compile_attr(&ser->attrs[i], RARRAY_AREF(names, i), NIL_P(keys) ? Qnil : RARRAY_AREF(keys, i));
+    }
+    ser->count = n;
+
+    /* Canonical dumps write the attributes sorted by key */
+    sort_attrs(ser);
+
+    RB_GC_GUARD(names);
+    RB_GC_GUARD(keys);
+    return obj;
+}
+
+/*
+ * YYJson.register_class(klass, attrs: [...])
+ * YYJson.register_class(klass) { |obj| ... }
+ *
+ * Serialize instances of klass (and its subclasses) natively. With attrs,
+ * each entry names a reader method (:name) or an instance variable
+ * (:@name) and the object is dumped as {"name": value, ...}; a Hash maps
+ * JSON keys to names instead. With a block, the block's return value is
+ * dumped in place of the object. Takes precedence over as_json / to_s.
+ */
+static VALUE
+yyjson_register_class(int argc, VALUE *argv, VALUE self)
+{
+    VALUE klass, opts;
+    rb_scan_args(argc, argv, "1:", &klass, &opts);
+    Check_Type(klass, T_CLASS);
+
+    VALUE attrs = NIL_P(opts) ? Qnil : rb_hash_aref(opts, ID2SYM(rb_intern("attrs")));
+    bool block = rb_block_given_p();
+
+    if (block == !NIL_P(attrs)) {
+        rb_raise(rb_eArgError, "pass either attrs: or a block");
+    }
+
+    VALUE serializer = block ? rb_block_proc() : compile_serializer(attrs);
+    rb_hash_aset(registry, klass, serializer);
+    yyjson_dispatch_invalidate();
+    return klass;
+}
+
+/*
+ * YYJson.unregister_class(klass)
+ *
+ * Remove a registration. Returns true if klass was registered.
+ */
+static VALUE
+yyjson_unregister_class(VALUE self, VALUE klass)
+{
+    bool found = rb_hash_lookup2(registry, klass, Qundef) != Qundef;
+    if (found) {
+        rb_hash_delete(registry, klass);
+        yyjson_dispatch_invalidate();
+    }
+    return found ? Qtrue : Qfalse;
+}
+
+/*
+ * YYJson.registered_class?(klass)
+ */
+static VALUE
+yyjson_registered_class_p(VALUE self, VALUE klass)
+{
+    return rb_hash_lookup2(registry, klass, Qundef) != Qundef ? Qtrue : Qfalse;
+}
+
+void
+yyjson_class_registry_init(void)
+{
+    rb_global_variable(&registry);
+    registry = rb_hash_new();
+    rb_funcall(registry, rb_intern("compare_by_identity"), 0);
+    rb_obj_hide(registry);
+
+    rb_define_singleton_method(mYYJson, "register_class", yyjson_register_class, -1);
+    rb_define_singleton_method(mYYJson, "unregister_class", yyjson_unregister_class, 1);
+    rb_define_singleton_method(mYYJson, "registered_class?", yyjson_registered_class_p, 1);
+}
@@ -0,0 +1,48 @@
+/*
+ * class_registry.h - Native class serializers (YYJson.register_class)
+ */
+
+#ifndef YYJSON_RUBY_CLASS_REGISTRY_H
+#define YYJSON_RUBY_CLASS_REGISTRY_H
+
+#include "common.h"
+
+/*
+ * One attribute of a registered class
+ */
+typedef struct {
+    ID id;                   /* Reader method, or instance variable when ivar */
+    bool ivar;
+    bool key_plain;          /* key is quoted and needs no escaping under any dump option */
+    char *key;               /* JSON key: quoted if key_plain, else raw UTF-8 to escape */
+    size_t key_len;
+} class_attr_t;
+
+/*
+ * Compiled `attrs:` list of a registered class
+ */
+typedef struct {
+    long count;
+    class_attr_t *attrs;
+    long *sorted;            /* Attribute indexes in canonical key order (dump canonical: true) */
+} class_serializer_t;
+
+/*
+ * Serializer registered for klass or its nearest registered ancestor: an
+ * attrs serializer object (see yyjson_class_serializer_get) or a Proc;
+ * Qnil if none
+ */
+VALUE yyjson_class_registry_find(VALUE klass);
+
+/*
+ * Attribute list of a serializer returned by yyjson_class_registry_find,
+ * or NULL if it is a Proc
+ */
+const class_serializer_t *yyjson_class_serializer_get(VALUE serializer);
+
+/*
+ * Define YYJson.register_class / unregister_class (called from Init_yyjson)
+ */
+void yyjson_class_registry_init(void);
+
+#endif /* YYJSON_RUBY_CLASS_REGISTRY_H */
@@ -9,6 +9,7 @@
 /* Module and class references */
 extern VALUE mYYJson;
 extern VALUE cParser;
+extern VALUE cGenerator;
 extern VALUE eYYJsonError;
 extern VALUE eParseError;
 extern VALUE eGenerateError;
@@ -39,6 +40,24 @@ extern ID id_max_nesting;
 extern ID id_allow_nan;
 extern ID id_allow_comments;
 extern ID id_create_additions;
+extern ID id_gvl_release_threshold;
+extern ID id_key_cache;
+extern ID id_key_cache_capacity;
+extern ID id_pretty;
+extern ID id_indent;
+extern ID id_escape_slash;
+extern ID id_escape_html;
+extern ID id_mmap;
+extern ID id_batch_size;
+extern ID id_unwrap_array;
+extern ID id_max_buffer_size;
+extern ID id_check_circular;
+extern ID id_time_precision;
+extern ID id_as;
+extern ID id_buffer_size;
+extern ID id_dedup_values;
+extern ID id_canonical;
+extern ID id_digest;
 
 /* Error handling macros */
 #define RAISE_YYJSON_ERROR(msg) rb_raise(eYYJsonError, "%s", (msg))
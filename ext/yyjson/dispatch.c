@@ -0,0 +1,176 @@
+/*
+ * dispatch.c - Per-class serialization strategy cache
+ *
+ * For objects that aren't core JSON types, the dumper used to check
+ * Time/Date/DateTime ancestry (two constant lookups per object), then
+ * respond_to?(:as_json), on every single object. The answer only depends
+ * on the class, so it is resolved once per class and kept in a small
+ * direct-mapped table; the per-object cost is one hashed slot compare.
+ *
+ * Ruby has no public hook for method definition, so entries are tagged
+ * with a global serial instead, bumped by YYJson.clear_dispatch_cache
+ * (and by YYJson.optimize_rails / the Rails reloader).
+ */
+
+#include "common.h"
+#include "dispatch.h"
+#include "class_registry.h"
+#include "fragment.h"
+
+unsigned int yyjson_dispatch_serial = 1;
+
+static dispatch_entry_t dispatch_table[DISPATCH_CACHE_SIZE];
+
+/* Ruby object that marks the cached classes */
+static VALUE table_holder = Qnil;
+
+static ID id_iso8601;
+static ID id_xmlschema;
+static ID id_Date;
+static ID id_DateTime;
+static ID id_BigDecimal;
+
+static inline size_t
+slot_of(VALUE klass)
+{
+    /* Classes are at least 8-byte aligned; mix the rest */
+    uint64_t h = ((uint64_t)klass >> 3) * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h >> 32) & (DISPATCH_CACHE_SIZE - 1);
+}
+
+static bool
+kind_of_const(VALUE obj, ID name)
+{
+    return rb_const_defined(rb_cObject, name) &&
+           RTEST(rb_obj_is_kind_of(obj, rb_const_get(rb_cObject, name)));
+}
+
+/*
+ * Work out the strategy for obj (the slow path)
+ */
+static dispatch_entry_t
+resolve(VALUE obj, bool memoize)
+{
+    dispatch_entry_t e = { .klass = Qfalse, .kind = DISPATCH_TO_S, .mid = id_to_s, .data = Qnil };
+    VALUE klass = rb_class_of(obj);
+    VALUE memo = memoize ? yyjson_memo_find(klass) : Qnil;
+    VALUE registered = yyjson_class_registry_find(klass);
+
+    if (yyjson_fragment_p(obj)) {
+        e.kind = DISPATCH_FRAGMENT;
+    } else if (!NIL_P(memo)) {
+        e.kind = DISPATCH_MEMO;
+        e.data = memo;
+    } else if (!NIL_P(registered)) {
+        e.kind = yyjson_class_serializer_get(registered) ? DISPATCH_ATTRS : DISPATCH_BLOCK;
+        e.data = registered;
+    } else if (rb_obj_is_kind_of(obj, rb_cTime) || kind_of_const(obj, id_Date)) {
+        /* DateTime is a Date subclass with a time part: not formatted natively */
+        e.kind = rb_obj_is_kind_of(obj, rb_cTime) ? DISPATCH_TIME :
+                 kind_of_const(obj, id_DateTime) ? DISPATCH_DATETIME : DISPATCH_DATE;
+        if (rb_respond_to(obj, id_iso8601)) {
+            e.mid = id_iso8601;
+        } else if (rb_respond_to(obj, id_xmlschema)) {
+            e.mid = id_xmlschema;
+        }
+    } else if (kind_of_const(obj, id_BigDecimal)) {
+        e.kind = DISPATCH_BIGDECIMAL;
+        if (rb_respond_to(obj, id_as_json)) e.mid = id_as_json;
+    } else if (rb_respond_to(obj, id_as_json)) {
+        e.kind = DISPATCH_AS_JSON;
+        e.mid = id_as_json;
+    }
+    return e;
+}
+
+dispatch_entry_t
+yyjson_dispatch_lookup(VALUE obj)
+{
+    VALUE klass = rb_class_of(obj);
+    dispatch_entry_t *slot = &dispatch_table[slot_of(klass)];
+
+    if (RB_LIKELY(slot->klass == klass && slot->serial == yyjson_dispatch_serial)) {
+        return *slot;
+    }
+
+    dispatch_entry_t e = resolve(obj, true);
+
+    /* A singleton class belongs to one object: caching it would pin that object */
+    if (!FL_TEST(klass, FL_SINGLETON)) {
+        e.klass = klass;
+        e.serial = yyjson_dispatch_serial;
+        *slot = e;
+    }
+    return e;
+}
+
+dispatch_entry_t
+yyjson_dispatch_resolve_unmemoized(VALUE obj)
+{
+    return resolve(obj, false);
+}
+
+void
+yyjson_dispatch_invalidate(void)
+{
+    if (RB_UNLIKELY(++yyjson_dispatch_serial == 0)) yyjson_dispatch_serial = 1;
+    /* Also unpin the classes (e.g. ones replaced by a code reload) */
+    MEMZERO(dispatch_table, dispatch_entry_t, DISPATCH_CACHE_SIZE);
+}
+
+/*
+ * GC holder: cached classes stay pinned (slots are chosen by address)
+ */
+static void
+table_holder_mark(void *ptr)
+{
+    for (size_t i = 0; i < DISPATCH_CACHE_SIZE; i++) {
+        if (RTEST(dispatch_table[i].klass)) rb_gc_mark(dispatch_table[i].klass);
+        if (RTEST(dispatch_table[i].data)) rb_gc_mark(dispatch_table[i].data);
+    }
+}
+
+static size_t
+table_holder_memsize(const void *ptr)
+{
+    return sizeof(dispatch_table);
+}
+
+static const rb_data_type_t table_holder_type = {
+    .wrap_struct_name = "YYJson::DispatchCache",
+    .function = {
+        .dmark = table_holder_mark,
+        .dfree = RUBY_NEVER_FREE,
+        .dsize = table_holder_memsize,
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+/*
+ * YYJson.clear_dispatch_cache
+ *
+ * Forget how each class is serialized. Needed after defining or removing
+ * as_json (or iso8601 on a Time/Date class) on a class that has already
+ * been dumped. (register_class / unregister_class clear it themselves.)
+ */
+static VALUE
+yyjson_clear_dispatch_cache(VALUE self)
+{
+    yyjson_dispatch_invalidate();
+    return Qnil;
+}
+
+void
+yyjson_dispatch_init(void)
+{
+    id_iso8601 = rb_intern("iso8601");
+    id_xmlschema = rb_intern("xmlschema");
+    id_Date = rb_intern("Date");
+    id_DateTime = rb_intern("DateTime");
+    id_BigDecimal = rb_intern("BigDecimal");
+
+    rb_global_variable(&table_holder);
+    table_holder = TypedData_Wrap_Struct(0, &table_holder_type, dispatch_table);
+
+    rb_define_singleton_method(mYYJson, "clear_dispatch_cache", yyjson_clear_dispatch_cache, 0);
+}
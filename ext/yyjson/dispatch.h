@@ -0,0 +1,71 @@
+/*
+ * dispatch.h - Per-class serialization strategy cache for object_dumper.c
+ */
+
+#ifndef YYJSON_RUBY_DISPATCH_H
+#define YYJSON_RUBY_DISPATCH_H
+
+#include "common.h"
+
+/* Entries in the direct-mapped class table (power of two) */
+#define DISPATCH_CACHE_SIZE 512
+
+/*
+ * How instances of a (non-core) class are dumped
+ */
+typedef enum {
+    DISPATCH_TO_S = 0,       /* Dump obj.to_s as a string */
+    DISPATCH_TIME,           /* Time: ISO 8601 written natively (obj.<mid> outside years 0-9999) */
+    DISPATCH_DATE,           /* Date: ISO 8601 written natively (obj.<mid> before 1582-10-15) */
+    DISPATCH_DATETIME,       /* Dump obj.<mid> (iso8601 / xmlschema / to_s) as a string */
+    DISPATCH_BIGDECIMAL,     /* Exact raw number (mode: :rails dumps obj.<mid> instead) */
+    DISPATCH_AS_JSON,        /* Dump obj.as_json (to_s if it returns nil) */
+    DISPATCH_ATTRS,          /* Registered attrs: dump data's attributes as an object */
+    DISPATCH_BLOCK,          /* Registered block: dump data.call(obj) */
+    DISPATCH_FRAGMENT,       /* YYJson::Fragment: copy its JSON text as is */
+    DISPATCH_MEMO            /* Memoized class: splice JSON stored for data's key (see fragment.h) */
+} dispatch_kind_t;
+
+/*
+ * Resolved strategy for one class
+ */
+typedef struct {
+    VALUE klass;             /* Cached class (Qfalse = empty slot) */
+    unsigned int serial;     /* yyjson_dispatch_serial when resolved */
+    dispatch_kind_t kind;
+    ID mid;                  /* Method for DISPATCH_TIME / DATE / DATETIME / BIGDECIMAL */
+    VALUE data;              /* Registered serializer (DISPATCH_ATTRS / BLOCK) or memo (DISPATCH_MEMO) */
+} dispatch_entry_t;
+
+/*
+ * Bumped to invalidate every cached strategy
+ */
+extern unsigned int yyjson_dispatch_serial;
+
+/*
+ * Strategy for obj's class, resolving (and caching) it on a miss
+ *
+ * Returns a copy: the table may change while the caller runs Ruby code.
+ * Singleton classes are resolved every time and never cached.
+ */
+dispatch_entry_t yyjson_dispatch_lookup(VALUE obj);
+
+/*
+ * Strategy for obj when it is not memoized: how a DISPATCH_MEMO object is
+ * dumped on a miss (resolved every time, never cached)
+ */
+dispatch_entry_t yyjson_dispatch_resolve_unmemoized(VALUE obj);
+
+/*
+ * Drop every cached strategy (after defining as_json / to_s / iso8601 on
+ * classes that were already dumped)
+ */
+void yyjson_dispatch_invalidate(void);
+
+/*
+ * Set up the table and define YYJson.clear_dispatch_cache
+ * (called from Init_yyjson)
+ */
+void yyjson_dispatch_init(void);
+
+#endif /* YYJSON_RUBY_DISPATCH_H */
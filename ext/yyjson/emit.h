@@ -0,0 +1,62 @@
+/*
+ * emit.h - Low-level JSON token writers
+ *
+ * Thin exports of the vendored yyjson writer internals (implemented in
+ * yyjson.c), so tokens written by the direct writer are formatted exactly
+ * like yyjson_mut_write output. Callers must reserve buffer space first.
+ */
+
+#ifndef YYJSON_RUBY_EMIT_H
+#define YYJSON_RUBY_EMIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "yyjson.h"
+
+/* Maximum bytes written by yyjson_emit_sint/uint/f64 */
+#define YYJSON_EMIT_NUM_MAX 32
+
+/* Maximum bytes written by yyjson_emit_str for a string of len bytes */
+#define YYJSON_EMIT_STR_MAX(len) ((len) * 6 + 2)
+
+/*
+ * yyjson_emit_str flag (outside yyjson's own write flags): also write
+ * '<', '>', '&' and '\'' as \u003c, \u003e, \u0026 and \u0027
+ */
+#define YYJSON_EMIT_ESCAPE_HTML ((yyjson_write_flag)1 << 16)
+
+/*
+ * Write a signed/unsigned integer
+ *
+ * @return Cursor after the number
+ */
+char *yyjson_emit_sint(char *cur, int64_t num);
+char *yyjson_emit_uint(char *cur, uint64_t num);
+
+/*
+ * Write a double (shortest round-trip form)
+ *
+ * @return Cursor after the number, or NULL for NaN/Infinity when
+ *         YYJSON_WRITE_ALLOW_INF_AND_NAN is not set in flg
+ */
+char *yyjson_emit_f64(char *cur, double num, yyjson_write_flag flg);
+
+/*
+ * Write a quoted, escaped UTF-8 string
+ *
+ * @return Cursor after the closing quote, or NULL on invalid UTF-8
+ */
+char *yyjson_emit_str(char *cur, const char *str, size_t len, yyjson_write_flag flg);
+
+/*
+ * Write escaped UTF-8 string content without quotes, e.g. one piece of a
+ * long string split at a character boundary
+ *
+ * The byte before cur must be writable (it is restored); reserve
+ * YYJSON_EMIT_STR_MAX(len) bytes from cur.
+ *
+ * @return Cursor after the content, or NULL on invalid UTF-8
+ */
+char *yyjson_emit_str_part(char *cur, const char *str, size_t len, yyjson_write_flag flg);
+
+#endif /* YYJSON_RUBY_EMIT_H */
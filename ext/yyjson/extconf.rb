@@ -95,6 +95,9 @@ have_func('rb_interned_str', 'ruby.h')        # Interned strings alt
 have_func('rb_utf8_str_new', 'ruby.h')        # Fast UTF-8 string (Ruby 2.7+)
 have_func('rb_utf8_str_new_cstr', 'ruby.h')   # Fast UTF-8 C string
 
+# Memory-mapped file parsing (load_file mmap: true)
+have_header('sys/mman.h') && have_func('mmap', 'sys/mman.h')
+
 # Check for required headers
 have_header('ruby.h') or raise 'ruby.h not found'
 
@@ -0,0 +1,440 @@
+/*
+ * feed.c - Incremental parsing: Parser#feed / #finish
+ *
+ * yyjson has no resumable reader, so a small boundary scanner finds where
+ * each value ends (tracking strings, escapes, comments and bracket depth
+ * across chunks) and hands every complete value to yyjson_read_opts().
+ * Only the bytes of the value still being scanned are buffered; input is
+ * copied in FEED_SLICE pieces, so the buffer stays within max_buffer plus
+ * one slice no matter how large the chunks are.
+ */
+
+#include "common.h"
+#include "parser_class.h"
+#include "feed.h"
+#include "stats.h"
+#include <string.h>
+
+/* Bytes of a chunk appended to the buffer per scan pass */
+#define FEED_SLICE (64 * 1024)
+
+typedef struct {
+    yyjson_parser_t *parser;
+    feed_state_t *st;
+    const yyjson_alc *alc;
+    VALUE chunk;           /* Frozen copy of the input, or Qnil for #finish */
+    VALUE result;          /* Collected values, or Qnil to yield */
+    bool completed;        /* feed_body returned normally */
+} feed_ctx_t;
+
+void
+yyjson_feed_reset(feed_state_t *st)
+{
+    st->len = 0;
+    st->scan = 0;
+    st->start = 0;
+    st->consumed = 0;
+    st->depth = 0;
+    st->in_value = false;
+    st->scalar = false;
+    st->lex = FEED_LEX_NORMAL;
+    st->outer = FEED_OUTER_NONE;
+}
+
+void
+yyjson_feed_free(feed_state_t *st)
+{
+    if (st->buf) YYJSON_FREE(st->buf);
+    st->buf = NULL;
+    st->capa = 0;
+    yyjson_feed_reset(st);
+}
+
+static inline bool
+is_ws(unsigned char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/* Characters that end a bare number / true / false / null */
+static inline bool
+ends_scalar(const feed_state_t *st, unsigned char c)
+{
+    return is_ws(c) || c == ',' || c == ']' || c == '}' || c == '[' ||
+           c == '{' || c == '"' || c == ':' || (c == '/' && st->allow_comments);
+}
+
+/*
+ * Drop the stream state and raise (the input can't be resynchronized)
+ */
+NORETURN(static void feed_error(feed_state_t *st, size_t pos, const char *msg));
+static void
+feed_error(feed_state_t *st, size_t pos, const char *msg)
+{
+    size_t offset = st->consumed + pos;
+    yyjson_feed_reset(st);
+    rb_raise(eParseError, "Parse error at byte %zu: %s", offset, msg);
+}
+
+/*
+ * Parse buf[from, to) and hand the value to the caller
+ */
+static void
+emit_value(feed_ctx_t *ctx, size_t from, size_t to)
+{
+    feed_state_t *st = ctx->st;
+    yyjson_parser_t *parser = ctx->parser;
+    yyjson_read_err err;
+
+    uint64_t start = YYJSON_STATS_START();
+    yyjson_doc *doc = yyjson_read_opts(st->buf + from, to - from, parser->flg, ctx->alc, &err);
+    YYJSON_STATS_READ(start, to - from);
+    if (RB_UNLIKELY(!doc)) {
+        feed_error(st, from + err.pos, err.msg);
+    }
+
+    VALUE obj = yyjson_build_ruby_object_free(doc, &parser->opts);
+
+    if (NIL_P(ctx->result)) {
+        rb_yield(obj);
+    } else {
+        rb_ary_push(ctx->result, obj);
+    }
+}
+
+/*
+ * Close the current value at buf[end) and update the scanner
+ */
+static inline void
+complete_value(feed_ctx_t *ctx, size_t end)
+{
+    feed_state_t *st = ctx->st;
+    size_t from = st->start;
+
+    st->in_value = false;
+    st->scalar = false;
+    st->depth = 0;
+    if (st->outer != FEED_OUTER_NONE) st->outer = FEED_OUTER_AFTER;
+    emit_value(ctx, from, end);
+}
+
+/*
+ * Byte between values: separator, array bracket, or the start of a value
+ */
+static void
+scan_between(feed_ctx_t *ctx, size_t i, unsigned char c)
+{
+    feed_state_t *st = ctx->st;
+
+    if (st->outer == FEED_OUTER_AFTER) {
+        if (c == ',') { st->outer = FEED_OUTER_ELEMENT; return; }
+        if (c == ']') { st->outer = FEED_OUTER_NONE; return; }
+        feed_error(st, i, "expected ',' or ']' after array element");
+    }
+    if (st->outer != FEED_OUTER_NONE) {
+        if (c == ']') {
+            if (st->outer == FEED_OUTER_ELEMENT) feed_error(st, i, "trailing comma in array");
+            st->outer = FEED_OUTER_NONE;
+            return;
+        }
+    } else if (c == '[' && st->unwrap_array) {
+        st->outer = FEED_OUTER_START;
+        return;
+    }
+    if (c == ',' || c == ']' || c == '}' || c == ':') {
+        feed_error(st, i, "unexpected character");
+    }
+
+    st->in_value = true;
+    st->start = i;
+    st->depth = 0;
+    st->scalar = false;
+    if (c == '{' || c == '[') {
+        st->depth = 1;
+    } else if (c == '"') {
+        st->lex = FEED_LEX_STRING;
+    } else {
+        st->scalar = true;
+    }
+}
+
+/*
+ * Scan buf[scan, len), emitting every value that completes
+ */
+static void
+scan_buffer(feed_ctx_t *ctx)
+{
+    feed_state_t *st = ctx->st;
+    const unsigned char *buf = (const unsigned char *)st->buf;
+    size_t len = st->len;
+    size_t i = st->scan;
+
+    while (i < len) {
+        unsigned char c = buf[i];
+
+        switch (st->lex) {
+        case FEED_LEX_STRING:
+            /* Skip plain string bytes in one go */
+            while (c != '"' && c != '\\') {
+                if (++i == len) goto done;
+                c = buf[i];
+            }
+            if (c == '\\') {
+                st->lex = FEED_LEX_STRING_ESC;
+            } else {
+                st->lex = FEED_LEX_NORMAL;
+                if (st->depth == 0) complete_value(ctx, i + 1);
+            }
+            i++;
+            continue;
+        case FEED_LEX_STRING_ESC:
+            st->lex = FEED_LEX_STRING;
+            i++;
+            continue;
+        case FEED_LEX_LINE_COMMENT:
+            if (c == '\n') st->lex = FEED_LEX_NORMAL;
+            i++;
+            continue;
+        case FEED_LEX_BLOCK_COMMENT:
+            if (c == '*') st->lex = FEED_LEX_BLOCK_STAR;
+            i++;
+            continue;
+        case FEED_LEX_BLOCK_STAR:
+            if (c == '/') st->lex = FEED_LEX_NORMAL;
+            else if (c != '*') st->lex = FEED_LEX_BLOCK_COMMENT;
+            i++;
+            continue;
+        case FEED_LEX_SLASH:
+            if (c == '/') { st->lex = FEED_LEX_LINE_COMMENT; i++; continue; }
+            if (c == '*') { st->lex = FEED_LEX_BLOCK_COMMENT; i++; continue; }
+            /* A lone '/': let yyjson report it inside a value */
+            st->lex = FEED_LEX_NORMAL;
+            if (!st->in_value) feed_error(st, i - 1, "unexpected character");
+            break;
+        case FEED_LEX_NORMAL:
+            break;
+        }
+
+        if (st->in_value && st->scalar) {
+            if (!ends_scalar(st, c)) { i++; continue; }
+            complete_value(ctx, i);
+            /* c is then handled as a byte between values */
+        }
+
+        if (!st->in_value) {
+            if (is_ws(c)) { i++; continue; }
+            if (c == '/' && st->allow_comments) { st->lex = FEED_LEX_SLASH; i++; continue; }
+            scan_between(ctx, i, c);
+            i++;
+            continue;
+        }
+
+        if (c == '"') {
+            st->lex = FEED_LEX_STRING;
+        } else if (c == '{' || c == '[') {
+            st->depth++;
+        } else if (c == '}' || c == ']') {
+            if (--st->depth == 0) complete_value(ctx, i + 1);
+        } else if (c == '/' && st->allow_comments) {
+            st->lex = FEED_LEX_SLASH;
+        }
+        i++;
+    }
+
+done:
+    st->scan = len;
+}
+
+/*
+ * Drop consumed bytes from the front of the buffer and enforce the cap
+ */
+static void
+compact_buffer(feed_state_t *st)
+{
+    size_t keep_from = st->in_value ? st->start : st->scan;
+
+    if (keep_from > 0) {
+        size_t rest = st->len - keep_from;
+        if (rest > 0) memmove(st->buf, st->buf + keep_from, rest);
+        st->len = rest;
+        st->scan -= keep_from;
+        if (st->in_value) st->start = 0;
+        st->consumed += keep_from;
+    }
+
+    if (st->max_buffer && st->len > st->max_buffer) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "incomplete value exceeds max_buffer_size (%zu bytes)", st->max_buffer);
+        feed_error(st, st->len, msg);
+    }
+
+    /* Give back the room a large value needed once it has been parsed */
+    if (st->capa > 4 * FEED_SLICE && st->len < st->capa / 4) {
+        size_t capa = st->len * 2 > FEED_SLICE ? st->len * 2 : FEED_SLICE;
+        st->buf = YYJSON_REALLOC_N(st->buf, char, capa);
+        st->capa = capa;
+    }
+}
+
+static void
+append_bytes(feed_state_t *st, const char *p, size_t n)
+{
+    if (st->len + n > st->capa) {
+        size_t capa = st->capa ? st->capa * 2 : FEED_SLICE;
+        while (capa < st->len + n) capa *= 2;
+        st->buf = YYJSON_REALLOC_N(st->buf, char, capa);
+        st->capa = capa;
+    }
+    memcpy(st->buf + st->len, p, n);
+    st->len += n;
+}
+
+static VALUE
+feed_body(VALUE ptr)
+{
+    feed_ctx_t *ctx = (feed_ctx_t *)ptr;
+    feed_state_t *st = ctx->st;
+
+    if (!NIL_P(ctx->chunk)) {
+        const char *p = RSTRING_PTR(ctx->chunk);
+        size_t left = (size_t)RSTRING_LEN(ctx->chunk);
+
+        while (left > 0) {
+            size_t n = left < FEED_SLICE ? left : FEED_SLICE;
+            append_bytes(st, p, n);
+            p += n;
+            left -= n;
+            scan_buffer(ctx);
+            compact_buffer(st);
+        }
+        ctx->completed = true;
+        return Qnil;
+    }
+
+    /* End of input: a bare scalar ends here, anything else is truncated */
+    if (st->lex == FEED_LEX_STRING || st->lex == FEED_LEX_STRING_ESC ||
+        (st->in_value && !st->scalar) || st->outer != FEED_OUTER_NONE) {
+        feed_error(st, st->len, "unexpected end of input");
+    }
+    if (st->lex == FEED_LEX_BLOCK_COMMENT || st->lex == FEED_LEX_BLOCK_STAR) {
+        feed_error(st, st->len, "unclosed comment");
+    }
+    if (st->lex == FEED_LEX_SLASH) {
+        feed_error(st, st->len - 1, "unexpected character");
+    }
+    if (st->in_value) complete_value(ctx, st->len);
+
+    yyjson_feed_free(st);
+    ctx->completed = true;
+    return Qnil;
+}
+
+static VALUE
+feed_ensure(VALUE ptr)
+{
+    feed_ctx_t *ctx = (feed_ctx_t *)ptr;
+    /* The rest of an interrupted chunk is lost, so the stream can't resume */
+    if (!ctx->completed) yyjson_feed_reset(ctx->st);
+    ctx->st->active = false;
+    yyjson_parser_release(ctx->parser, ctx->alc);
+    return Qnil;
+}
+
+static VALUE
+feed_run(VALUE self, VALUE chunk)
+{
+    yyjson_parser_t *parser = yyjson_parser_get(self);
+    feed_state_t *st = &parser->feed;
+
+    if (st->active) {
+        rb_raise(rb_eRuntimeError, "YYJson::Parser#feed called from its own block");
+    }
+
+    feed_ctx_t ctx = {
+        .parser = parser,
+        .st = st,
+        .chunk = chunk,
+        .result = rb_block_given_p() ? Qnil : rb_ary_new()
+    };
+
+    st->active = true;
+    ctx.alc = yyjson_parser_acquire(parser);
+    rb_ensure(feed_body, (VALUE)&ctx, feed_ensure, (VALUE)&ctx);
+
+    RB_GC_GUARD(self);
+    RB_GC_GUARD(chunk);
+    return NIL_P(ctx.result) ? self : ctx.result;
+}
+
+/*
+ * parser.feed(chunk) { |obj| ... }
+ *
+ * Append a chunk of a JSON stream and yield every value completed by it:
+ * each whitespace-separated top-level value, or with unwrap_array: true,
+ * each element of a top-level array. A value may span any number of
+ * chunks; the bytes of the unfinished one are kept until the next call.
+ *
+ * Returns self, or an Array of the completed values without a block.
+ * Raises YYJson::ParseError on malformed input. Any exception, including
+ * one from the block, resets the stream.
+ */
+static VALUE
+parser_feed(VALUE self, VALUE chunk)
+{
+    StringValue(chunk);
+    /* Frozen shared copy: the block may mutate the caller's String */
+    return feed_run(self, rb_str_new_frozen(chunk));
+}
+
+/*
+ * parser.finish { |obj| ... }
+ *
+ * Signal the end of the stream: emits a trailing bare scalar (e.g. "42"
+ * with no delimiter after it), raises YYJson::ParseError if a value is
+ * still incomplete, and resets the stream for reuse.
+ *
+ * Returns self, or an Array of the completed values without a block.
+ */
+static VALUE
+parser_finish(VALUE self)
+{
+    return feed_run(self, Qnil);
+}
+
+/*
+ * parser.reset_feed
+ *
+ * Discard any buffered input and start a new stream.
+ */
+static VALUE
+parser_reset_feed(VALUE self)
+{
+    yyjson_parser_t *parser = yyjson_parser_get(self);
+    if (parser->feed.active) {
+        rb_raise(rb_eRuntimeError, "YYJson::Parser#feed is in progress");
+    }
+    yyjson_feed_free(&parser->feed);
+    return self;
+}
+
+/*
+ * parser.feed_buffered
+ *
+ * Bytes of input held for the value still being scanned.
+ */
+static VALUE
+parser_feed_buffered(VALUE self)
+{
+    yyjson_parser_t *parser = yyjson_parser_get(self);
+    const feed_state_t *st = &parser->feed;
+    return SIZET2NUM(st->in_value ? st->len - st->start : 0);
+}
+
+void
+yyjson_feed_init(void)
+{
+    rb_define_method(cParser, "feed", parser_feed, 1);
+    rb_define_method(cParser, "finish", parser_finish, 0);
+    rb_define_method(cParser, "reset_feed", parser_reset_feed, 0);
+    rb_define_method(cParser, "feed_buffered", parser_feed_buffered, 0);
+}
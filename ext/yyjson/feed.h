@@ -0,0 +1,76 @@
+/*
+ * feed.h - Incremental (chunked) parsing state for Parser#feed
+ */
+
+#ifndef YYJSON_RUBY_FEED_H
+#define YYJSON_RUBY_FEED_H
+
+#include "common.h"
+
+/* Default cap on buffered input (bytes of one incomplete value) */
+#define FEED_DEFAULT_MAX_BUFFER (64 * 1024 * 1024)
+
+/*
+ * Lexer state of the boundary scanner (survives across chunks)
+ */
+typedef enum {
+    FEED_LEX_NORMAL = 0,
+    FEED_LEX_STRING,         /* Inside "..." */
+    FEED_LEX_STRING_ESC,     /* After a backslash inside "..." */
+    FEED_LEX_SLASH,          /* Saw '/', waiting for '/' or '*' */
+    FEED_LEX_LINE_COMMENT,   /* Inside // ... */
+    FEED_LEX_BLOCK_COMMENT,  /* Inside / * ... * / */
+    FEED_LEX_BLOCK_STAR      /* Saw '*' inside a block comment */
+} feed_lex_t;
+
+/*
+ * Position relative to an unwrapped top-level array
+ */
+typedef enum {
+    FEED_OUTER_NONE = 0,     /* Not inside an unwrapped array */
+    FEED_OUTER_START,        /* After '[': element or ']' */
+    FEED_OUTER_ELEMENT,      /* After ',': element required */
+    FEED_OUTER_AFTER         /* After an element: ',' or ']' */
+} feed_outer_t;
+
+/*
+ * Buffered input and scanner state
+ *
+ * Only the bytes of the value currently being scanned are kept; complete
+ * values are parsed as soon as their last byte arrives and then dropped.
+ */
+typedef struct {
+    char *buf;               /* ruby_xmalloc'd pending input */
+    size_t len;              /* Bytes in buf */
+    size_t capa;             /* Capacity of buf */
+    size_t scan;             /* Bytes of buf already scanned */
+    size_t start;            /* Start of the current value (when in_value) */
+    size_t max_buffer;       /* Cap on len (0 = unlimited) */
+    size_t consumed;         /* Bytes dropped from the front (for error offsets) */
+    int depth;               /* Container depth inside the current value */
+    bool in_value;           /* Scanning a value */
+    bool scalar;             /* Current value is a bare number/true/false/null */
+    bool unwrap_array;       /* Emit elements of a top-level array */
+    bool allow_comments;     /* Treat comments as whitespace */
+    bool active;             /* Inside a #feed / #finish call */
+    feed_lex_t lex;
+    feed_outer_t outer;
+} feed_state_t;
+
+/*
+ * Reset scanner state (keeps the buffer allocation and settings)
+ */
+void yyjson_feed_reset(feed_state_t *st);
+
+/*
+ * Free the buffer
+ */
+void yyjson_feed_free(feed_state_t *st);
+
+/*
+ * Define Parser#feed, #finish and #reset_feed (called from Init_yyjson
+ * after the Parser class exists)
+ */
+void yyjson_feed_init(void);
+
+#endif /* YYJSON_RUBY_FEED_H */
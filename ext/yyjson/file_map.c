@@ -0,0 +1,151 @@
+/*
+ * file_map.c - Copy-on-write file mappings for insitu parsing
+ *
+ * yyjson_read_file() reads the whole file into a malloc'd buffer before
+ * parsing. Mapping the file instead lets yyjson parse straight from the
+ * page cache: with YYJSON_READ_INSITU it unescapes strings in place and
+ * allocates only the value array, not a copy of the input.
+ *
+ * INSITU needs YYJSON_PADDING_SIZE zero bytes after the input. The tail of
+ * a file's last page is zero-filled by the kernel; when the file ends too
+ * close to a page boundary, an anonymous page is reserved behind it.
+ *
+ * yyjson NUL-terminates insitu strings, so parsing dirties (copies) nearly
+ * every page of the mapping. yyjson_file_map_release() lets the value
+ * builder hand consumed pages back while it builds the Ruby objects, so
+ * the input and the finished object graph are not resident at once.
+ */
+
+#include "common.h"
+#include "file_map.h"
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+static size_t
+round_up(size_t n, size_t page)
+{
+    return (n + page - 1) & ~(page - 1);
+}
+
+/*
+ * Map `file_len` bytes of fd privately into a region of `map_len` bytes
+ */
+static char *
+map_private(int fd, size_t file_len, size_t map_len, size_t page)
+{
+    size_t file_pages = round_up(file_len, page);
+    const int prot = PROT_READ | PROT_WRITE;
+
+    if (file_pages == map_len) {
+        void *p = mmap(NULL, map_len, prot, MAP_PRIVATE, fd, 0);
+        return p == MAP_FAILED ? NULL : (char *)p;
+    }
+
+    /* Reserve the whole region anonymously, then put the file over its head */
+    void *base = mmap(NULL, map_len, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+
+    void *p = mmap(base, file_pages, prot, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (p == MAP_FAILED) {
+        munmap(base, map_len);
+        return NULL;
+    }
+    return (char *)base;
+}
+
+yyjson_file_map_result
+yyjson_file_map_open(const char *path, yyjson_file_map_t *map)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return FILE_MAP_OPEN_FAILED;
+
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return FILE_MAP_OPEN_FAILED;
+    }
+    if (!S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (unsigned long long)st.st_size > (unsigned long long)(SIZE_MAX - YYJSON_PADDING_SIZE)) {
+        close(fd);
+        return FILE_MAP_UNSUPPORTED;
+    }
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t len = (size_t)st.st_size;
+    size_t map_len = round_up(len + YYJSON_PADDING_SIZE, page);
+    char *data = map_private(fd, len, map_len, page);
+    close(fd);  /* The mapping keeps the file referenced */
+
+    if (!data) return FILE_MAP_UNSUPPORTED;
+
+#ifdef MADV_SEQUENTIAL
+    madvise(data, map_len, MADV_SEQUENTIAL);
+#endif
+    memset(data + len, 0, YYJSON_PADDING_SIZE);
+
+    map->data = data;
+    map->len = len;
+    map->map_len = map_len;
+    map->released = 0;
+    return FILE_MAP_OK;
+}
+
+void
+yyjson_file_map_release(yyjson_file_map_t *map, const char *upto)
+{
+#ifdef MADV_DONTNEED
+    if (upto <= map->data || upto > map->data + map->len) return;
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t end = (size_t)(upto - map->data) & ~(page - 1);
+    if (end <= map->released) return;
+
+    madvise(map->data + map->released, end - map->released, MADV_DONTNEED);
+    map->released = end;
+#else
+    (void)map;
+    (void)upto;
+#endif
+}
+
+void
+yyjson_file_map_close(yyjson_file_map_t *map)
+{
+    if (map->data) munmap(map->data, map->map_len);
+    map->data = NULL;
+}
+
+#else /* no mmap */
+
+yyjson_file_map_result
+yyjson_file_map_open(const char *path, yyjson_file_map_t *map)
+{
+    (void)path;
+    (void)map;
+    return FILE_MAP_UNSUPPORTED;
+}
+
+void
+yyjson_file_map_release(yyjson_file_map_t *map, const char *upto)
+{
+    (void)map;
+    (void)upto;
+}
+
+void
+yyjson_file_map_close(yyjson_file_map_t *map)
+{
+    (void)map;
+}
+
+#endif
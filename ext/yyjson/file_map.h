@@ -0,0 +1,52 @@
+/*
+ * file_map.h - Copy-on-write file mappings for insitu parsing
+ */
+
+#ifndef YYJSON_RUBY_FILE_MAP_H
+#define YYJSON_RUBY_FILE_MAP_H
+
+#include "common.h"
+
+/*
+ * A private, writable mapping of a whole file
+ *
+ * `data[len .. len + YYJSON_PADDING_SIZE)` is mapped and zeroed, so the
+ * mapping can be handed to yyjson_read_opts() with YYJSON_READ_INSITU.
+ * Writes (yyjson unescaping strings in place) only touch private
+ * copy-on-write pages, never the file.
+ */
+typedef struct {
+    char *data;      /* Start of the file contents */
+    size_t len;      /* File size in bytes */
+    size_t map_len;  /* Length of the mapping */
+    size_t released; /* Page-aligned prefix already handed back to the kernel */
+} yyjson_file_map_t;
+
+typedef enum {
+    FILE_MAP_OK = 0,
+    FILE_MAP_OPEN_FAILED,  /* open(2)/fstat(2) failed (errno is set) */
+    FILE_MAP_UNSUPPORTED   /* No mmap, not a regular file, empty, or mmap failed */
+} yyjson_file_map_result;
+
+/*
+ * Map a file for insitu parsing
+ *
+ * On FILE_MAP_UNSUPPORTED the caller should fall back to yyjson_read_file().
+ */
+yyjson_file_map_result yyjson_file_map_open(const char *path, yyjson_file_map_t *map);
+
+/*
+ * Drop the pages below `upto` (already consumed by the value builder)
+ *
+ * Private pages revert to the file contents, so any copy-on-write copies
+ * made by the insitu parse are freed. Reading them again is still safe,
+ * it just faults the original file bytes back in.
+ */
+void yyjson_file_map_release(yyjson_file_map_t *map, const char *upto);
+
+/*
+ * Unmap a mapping created by yyjson_file_map_open()
+ */
+void yyjson_file_map_close(yyjson_file_map_t *map);
+
+#endif /* YYJSON_RUBY_FILE_MAP_H */
@@ -0,0 +1,386 @@
+/*
+ * fragment.c - Pre-serialized JSON: YYJson::Fragment and YYJson.memoize
+ *
+ * A Fragment holds JSON text that the dumper copies into the output
+ * verbatim, the way yyjson writes a raw value (yyjson_mut_raw): no parse
+ * and no re-serialization. It can be dumped directly, nested anywhere, or
+ * returned from as_json / a register_class block. The text is only checked
+ * when validation is on (YYJson::Fragment.validate = true, meant for
+ * development and tests).
+ *
+ * YYJson.memoize builds on it: instances of a memoized class are dumped
+ * once per cache key (and per set of output-affecting dump options) and
+ * spliced from the stored JSON afterwards. The rendering itself lives in
+ * object_dumper.c; this file holds the registrations and their stores.
+ */
+
+#include "common.h"
+#include "fragment.h"
+#include "dispatch.h"
+#include <ruby/encoding.h>
+
+/* Default entries of a memo's internal store before it is cleared */
+#define MEMO_DEFAULT_CAPACITY 4096
+
+static VALUE cFragment;
+
+/* Class => memo object, compared by identity */
+static VALUE memos = Qnil;
+
+/* YYJson::Fragment.validate */
+static bool fragment_validate = false;
+
+static ID id_fetch;
+static ID id_validate;
+static ID id_store;
+static ID id_capacity;
+
+/* ---- YYJson::Fragment ---- */
+
+typedef struct {
+    VALUE json;              /* Frozen UTF-8 String (0 until initialized) */
+} fragment_t;
+
+static void
+fragment_mark(void *ptr)
+{
+    fragment_t *f = ptr;
+    if (f->json) rb_gc_mark(f->json);
+}
+
+static const rb_data_type_t fragment_type = {
+    .wrap_struct_name = "YYJson::Fragment",
+    .function = {
+        .dmark = fragment_mark,
+        .dfree = RUBY_TYPED_DEFAULT_FREE,
+        .dsize = NULL,
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY | RUBY_TYPED_FROZEN_SHAREABLE
+};
+
+bool
+yyjson_fragment_p(VALUE obj)
+{
+    return rb_typeddata_is_kind_of(obj, &fragment_type);
+}
+
+VALUE
+yyjson_fragment_json(VALUE fragment)
+{
+    fragment_t *f = rb_check_typeddata(fragment, &fragment_type);
+    if (!f->json) rb_raise(rb_eArgError, "uninitialized YYJson::Fragment");
+    return f->json;
+}
+
+static VALUE
+fragment_alloc(VALUE klass)
+{
+    fragment_t *f;
+    return TypedData_Make_Struct(klass, fragment_t, &fragment_type, f);
+}
+
+VALUE
+yyjson_fragment_new(VALUE json)
+{
+    VALUE self = fragment_alloc(cFragment);
+    fragment_t *f = DATA_PTR(self);
+    RB_OBJ_WRITE(self, &f->json, rb_str_new_frozen(json));
+    rb_obj_freeze(self);
+    return self;
+}
+
+/*
+ * Raise ParseError unless json is a complete, standard JSON document
+ */
+static void
+validate_json(VALUE json)
+{
+    yyjson_read_err err;
+    yyjson_doc *doc = yyjson_read_opts(RSTRING_PTR(json), RSTRING_LEN(json), YYJSON_READ_NOFLAG, NULL, &err);
+    if (!doc) {
+        rb_raise(eParseError, "Invalid JSON fragment at position %zu: %s", err.pos, err.msg);
+    }
+    yyjson_doc_free(doc);
+}
+
+/*
+ * YYJson::Fragment.new(json, validate: nil)
+ *
+ * Wrap JSON text to be dumped as is. It is checked when validate is true,
+ * or when it is nil and YYJson::Fragment.validate is set.
+ */
+static VALUE
+fragment_initialize(int argc, VALUE *argv, VALUE self)
+{
+    VALUE json, opts;
+    rb_scan_args(argc, argv, "1:", &json, &opts);
+
+    fragment_t *f = rb_check_typeddata(self, &fragment_type);
+    if (f->json) rb_raise(rb_eArgError, "YYJson::Fragment already initialized");
+
+    StringValue(json);
+    json = rb_str_export_to_enc(json, rb_utf8_encoding());
+    /* Binary Strings stay unconverted: take their bytes as UTF-8 */
+    if (rb_enc_get_index(json) != rb_utf8_encindex() && rb_enc_get_index(json) != rb_usascii_encindex()) {
+        json = rb_enc_associate(rb_str_dup(json), rb_utf8_encoding());
+    }
+
+    VALUE validate = NIL_P(opts) ? Qnil : rb_hash_lookup2(opts, ID2SYM(id_validate), Qnil);
+    if (NIL_P(validate) ? fragment_validate : RTEST(validate)) validate_json(json);
+
+    RB_OBJ_WRITE(self, &f->json, rb_str_new_frozen(json));
+    rb_obj_freeze(self);
+    return self;
+}
+
+/*
+ * The JSON text (frozen)
+ */
+static VALUE
+fragment_to_s(VALUE self)
+{
+    return yyjson_fragment_json(self);
+}
+
+/*
+ * #to_json(*) - the JSON text, so JSON.generate and to_json embed it too
+ */
+static VALUE
+fragment_to_json(int argc, VALUE *argv, VALUE self)
+{
+    return yyjson_fragment_json(self);
+}
+
+/*
+ * #as_json(*) - self: mode: :rails dumps it as is
+ */
+static VALUE
+fragment_as_json(int argc, VALUE *argv, VALUE self)
+{
+    return self;
+}
+
+static VALUE
+fragment_eq(VALUE self, VALUE other)
+{
+    if (!yyjson_fragment_p(other)) return Qfalse;
+    return rb_str_equal(yyjson_fragment_json(self), yyjson_fragment_json(other));
+}
+
+static VALUE
+fragment_hash(VALUE self)
+{
+    return ST2FIX(rb_str_hash(yyjson_fragment_json(self)));
+}
+
+static VALUE
+fragment_inspect(VALUE self)
+{
+    return rb_sprintf("#<YYJson::Fragment %"PRIsVALUE">", yyjson_fragment_json(self));
+}
+
+static VALUE
+fragment_get_validate(VALUE klass)
+{
+    return fragment_validate ? Qtrue : Qfalse;
+}
+
+static VALUE
+fragment_set_validate(VALUE klass, VALUE value)
+{
+    fragment_validate = RTEST(value);
+    return value;
+}
+
+/* ---- YYJson.memoize ---- */
+
+static void
+memo_mark(void *ptr)
+{
+    yyjson_memo_t *m = ptr;
+    rb_gc_mark(m->key_proc);
+    rb_gc_mark(m->store);
+    rb_gc_mark(m->tables);
+}
+
+static const rb_data_type_t memo_type = {
+    .wrap_struct_name = "YYJson::Memo",
+    .function = {
+        .dmark = memo_mark,
+        .dfree = RUBY_TYPED_DEFAULT_FREE,
+        .dsize = NULL,
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+VALUE
+yyjson_memo_find(VALUE klass)
+{
+    if (RHASH_EMPTY_P(memos)) return Qnil;
+
+    for (VALUE k = klass; RTEST(k); k = rb_class_get_superclass(k)) {
+        VALUE memo = rb_hash_lookup2(memos, k, Qundef);
+        if (memo != Qundef) return memo;
+    }
+    return Qnil;
+}
+
+yyjson_memo_t *
+yyjson_memo_get(VALUE memo)
+{
+    return rb_check_typeddata(memo, &memo_type);
+}
+
+typedef struct {
+    VALUE (*render)(VALUE);
+    VALUE arg;
+} memo_render_t;
+
+static VALUE
+memo_render_i(RB_BLOCK_CALL_FUNC_ARGLIST(yielded, data))
+{
+    memo_render_t *r = (memo_render_t *)data;
+    return r->render(r->arg);
+}
+
+VALUE
+yyjson_memo_fetch(VALUE memo, VALUE key, int signature, VALUE (*render)(VALUE), VALUE arg)
+{
+    yyjson_memo_t *m = yyjson_memo_get(memo);
+    VALUE json;
+
+    if (!NIL_P(m->store)) {
+        VALUE store_key = rb_ary_new_from_args(2, key, INT2FIX(signature));
+        memo_render_t r = { .render = render, .arg = arg };
+        json = rb_block_call(m->store, id_fetch, 1, &store_key, memo_render_i, (VALUE)&r);
+        if (yyjson_fragment_p(json)) return yyjson_fragment_json(json);
+        StringValue(json);
+        return json;
+    }
+
+    /* One table per signature: the user's key is looked up as is */
+    VALUE table = rb_hash_lookup2(m->tables, INT2FIX(signature), Qnil);
+    if (NIL_P(table)) {
+        table = rb_hash_new();
+        rb_hash_aset(m->tables, INT2FIX(signature), table);
+    }
+
+    json = rb_hash_lookup2(table, key, Qundef);
+    if (json != Qundef) return json;
+
+    json = rb_str_new_frozen(render(arg));
+    /* Full: start over, as with the load_table shape cache */
+    if (RHASH_SIZE(table) >= (size_t)m->capacity) rb_hash_clear(table);
+    rb_hash_aset(table, key, json);
+    return json;
+}
+
+/*
+ * YYJson.memoize(klass, store: nil, capacity: 4096) { |obj| cache_key }
+ *
+ * Dump each instance of klass (and its subclasses) once per cache key and
+ * splice the stored JSON afterwards. The block returns the key (nil to
+ * dump that instance normally); it must change whenever the instance's
+ * JSON would, e.g. record.cache_key_with_version. Entries are kept
+ * separately for each set of output-affecting dump options.
+ *
+ * By default entries live in a process-local store, cleared once it holds
+ * `capacity` entries for one set of options; `store:` can name a shared cache instead, anything
+ * with fetch(key) { json } (such as Rails.cache). Instances are dumped
+ * as without memoize on a miss, and always when pretty-printing.
+ */
+static VALUE
+yyjson_memoize(int argc, VALUE *argv, VALUE self)
+{
+    VALUE klass, opts;
+    rb_scan_args(argc, argv, "1:", &klass, &opts);
+    Check_Type(klass, T_CLASS);
+    if (!rb_block_given_p()) rb_raise(rb_eArgError, "memoize needs a block returning the cache key");
+
+    VALUE store = NIL_P(opts) ? Qnil : rb_hash_lookup2(opts, ID2SYM(id_store), Qnil);
+    VALUE capacity = NIL_P(opts) ? Qnil : rb_hash_lookup2(opts, ID2SYM(id_capacity), Qnil);
+    if (!NIL_P(store) && !rb_respond_to(store, id_fetch)) {
+        rb_raise(rb_eArgError, "store must respond to fetch");
+    }
+
+    yyjson_memo_t *m;
+    VALUE memo = TypedData_Make_Struct(0, yyjson_memo_t, &memo_type, m);
+    m->key_proc = rb_block_proc();
+    m->store = store;
+    m->tables = rb_hash_new();
+    m->capacity = NIL_P(capacity) ? MEMO_DEFAULT_CAPACITY : NUM2LONG(capacity);
+    if (m->capacity < 1) rb_raise(rb_eArgError, "capacity must be positive");
+
+    rb_hash_aset(memos, klass, memo);
+    yyjson_dispatch_invalidate();
+    return klass;
+}
+
+/*
+ * YYJson.unmemoize(klass)
+ *
+ * Stop memoizing klass, dropping its internal store. Returns true if klass
+ * was memoized.
+ */
+static VALUE
+yyjson_unmemoize(VALUE self, VALUE klass)
+{
+    bool found = rb_hash_lookup2(memos, klass, Qundef) != Qundef;
+    if (found) {
+        rb_hash_delete(memos, klass);
+        yyjson_dispatch_invalidate();
+    }
+    return found ? Qtrue : Qfalse;
+}
+
+static int
+clear_memo_i(VALUE klass, VALUE memo, VALUE arg)
+{
+    rb_hash_clear(yyjson_memo_get(memo)->tables);
+    return ST_CONTINUE;
+}
+
+/*
+ * YYJson.clear_memos
+ *
+ * Empty the internal store of every memoized class (external stores are
+ * left alone).
+ */
+static VALUE
+yyjson_clear_memos(VALUE self)
+{
+    rb_hash_foreach(memos, clear_memo_i, Qnil);
+    return Qnil;
+}
+
+void
+yyjson_fragment_init(void)
+{
+    id_fetch = rb_intern("fetch");
+    id_validate = rb_intern("validate");
+    id_store = rb_intern("store");
+    id_capacity = rb_intern("capacity");
+
+    rb_global_variable(&memos);
+    memos = rb_hash_new();
+    rb_funcall(memos, rb_intern("compare_by_identity"), 0);
+    rb_obj_hide(memos);
+
+    cFragment = rb_define_class_under(mYYJson, "Fragment", rb_cObject);
+    rb_define_alloc_func(cFragment, fragment_alloc);
+    rb_define_method(cFragment, "initialize", fragment_initialize, -1);
+    rb_define_method(cFragment, "to_s", fragment_to_s, 0);
+    rb_define_method(cFragment, "json", fragment_to_s, 0);
+    rb_define_method(cFragment, "to_json", fragment_to_json, -1);
+    rb_define_method(cFragment, "as_json", fragment_as_json, -1);
+    rb_define_method(cFragment, "==", fragment_eq, 1);
+    rb_define_method(cFragment, "eql?", fragment_eq, 1);
+    rb_define_method(cFragment, "hash", fragment_hash, 0);
+    rb_define_method(cFragment, "inspect", fragment_inspect, 0);
+    rb_define_singleton_method(cFragment, "validate", fragment_get_validate, 0);
+    rb_define_singleton_method(cFragment, "validate=", fragment_set_validate, 1);
+
+    rb_define_singleton_method(mYYJson, "memoize", yyjson_memoize, -1);
+    rb_define_singleton_method(mYYJson, "unmemoize", yyjson_unmemoize, 1);
+    rb_define_singleton_method(mYYJson, "clear_memos", yyjson_clear_memos, 0);
+}
@@ -0,0 +1,58 @@
+/*
+ * fragment.h - Pre-serialized JSON (YYJson::Fragment) and YYJson.memoize
+ */
+
+#ifndef YYJSON_RUBY_FRAGMENT_H
+#define YYJSON_RUBY_FRAGMENT_H
+
+#include "common.h"
+
+/*
+ * Serialized-JSON memo of one class (YYJson.memoize)
+ */
+typedef struct {
+    VALUE key_proc;          /* obj => cache key (nil = don't memoize obj) */
+    VALUE store;             /* External store responding to fetch(key) { json }, or nil */
+    VALUE tables;            /* Internal store: options signature => { key => frozen JSON String } */
+    long capacity;           /* Entries in one table before it is cleared */
+} yyjson_memo_t;
+
+/*
+ * True if obj is a YYJson::Fragment
+ */
+bool yyjson_fragment_p(VALUE obj);
+
+/*
+ * JSON text of a fragment (frozen UTF-8 String)
+ */
+VALUE yyjson_fragment_json(VALUE fragment);
+
+/*
+ * Fragment of JSON text the caller has just written (frozen, not checked
+ * even with YYJson::Fragment.validate)
+ */
+VALUE yyjson_fragment_new(VALUE json);
+
+/*
+ * Memo registered for klass or its nearest memoized ancestor; Qnil if none
+ */
+VALUE yyjson_memo_find(VALUE klass);
+
+/*
+ * Struct of a memo returned by yyjson_memo_find
+ */
+yyjson_memo_t *yyjson_memo_get(VALUE memo);
+
+/*
+ * JSON for `key` under the dump options `signature` in the memo's store,
+ * calling render(arg) to produce it on a miss (render returns a String of
+ * JSON and may raise). External stores get the key [key, signature].
+ */
+VALUE yyjson_memo_fetch(VALUE memo, VALUE key, int signature, VALUE (*render)(VALUE), VALUE arg);
+
+/*
+ * Define YYJson::Fragment and YYJson.memoize (called from Init_yyjson)
+ */
+void yyjson_fragment_init(void);
+
+#endif /* YYJSON_RUBY_FRAGMENT_H */
@@ -0,0 +1,181 @@
+/*
+ * generator_class.c - YYJson::Generator
+ *
+ * A Generator resolves its dump options once and keeps a scratch output
+ * buffer across #generate calls. Once the buffer has grown to fit the
+ * usual output, a dump writes with no reallocation and finishes with a
+ * single exact-size copy into the result String.
+ */
+
+#include "common.h"
+#include "object_dumper.h"
+#include "writer.h"
+#include "generator_class.h"
+
+/* Starting size of the scratch buffer */
+#define GENERATOR_INITIAL_CAPA 4096
+
+typedef struct {
+    yyjson_dump_options opts;
+    char *scratch;            /* ruby_xmalloc'd output buffer, reused across dumps */
+    size_t scratch_capa;
+    bool initialized;
+    bool busy;                /* scratch is in use (reentrant to_json/as_json or another thread) */
+} yyjson_generator_t;
+
+static void
+generator_free(void *ptr)
+{
+    yyjson_generator_t *gen = (yyjson_generator_t *)ptr;
+    if (gen->scratch) YYJSON_FREE(gen->scratch);
+    YYJSON_FREE(gen);
+}
+
+static size_t
+generator_memsize(const void *ptr)
+{
+    const yyjson_generator_t *gen = (const yyjson_generator_t *)ptr;
+    return sizeof(yyjson_generator_t) + gen->scratch_capa;
+}
+
+static const rb_data_type_t generator_type = {
+    .wrap_struct_name = "YYJson::Generator",
+    .function = {
+        .dmark = NULL,
+        .dfree = generator_free,
+        .dsize = generator_memsize,
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE
+generator_alloc(VALUE klass)
+{
+    yyjson_generator_t *gen;
+    VALUE obj = TypedData_Make_Struct(klass, yyjson_generator_t, &generator_type, gen);
+    return obj;
+}
+
+static yyjson_generator_t *
+get_generator(VALUE self)
+{
+    yyjson_generator_t *gen;
+    TypedData_Get_Struct(self, yyjson_generator_t, &generator_type, gen);
+    if (!gen->initialized) {
+        rb_raise(rb_eRuntimeError, "uninitialized YYJson::Generator");
+    }
+    return gen;
+}
+
+/*
+ * YYJson::Generator.new(opts = {})
+ *
+ * Create a generator with fixed options. Accepts the same options as
+ * YYJson.dump.
+ */
+static VALUE
+generator_initialize(int argc, VALUE *argv, VALUE self)
+{
+    yyjson_generator_t *gen;
+    VALUE opts;
+
+    TypedData_Get_Struct(self, yyjson_generator_t, &generator_type, gen);
+    if (gen->initialized) {
+        rb_raise(rb_eRuntimeError, "YYJson::Generator is already initialized");
+    }
+
+    rb_scan_args(argc, argv, "01", &opts);
+    if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+
+    yyjson_extract_dump_options(opts, &gen->opts);
+    gen->initialized = true;
+    return self;
+}
+
+typedef struct {
+    yyjson_generator_t *gen;
+    json_buf_t buf;
+    VALUE obj;
+} generator_call_args;
+
+static VALUE
+generator_call(VALUE ptr)
+{
+    generator_call_args *args = (generator_call_args *)ptr;
+    return yyjson_ruby_write_buf(args->obj, &args->buf, &args->gen->opts);
+}
+
+/*
+ * Take back the scratch memory (json_buf_grow may have moved it)
+ */
+static VALUE
+generator_call_ensure(VALUE ptr)
+{
+    generator_call_args *args = (generator_call_args *)ptr;
+    yyjson_generator_t *gen = args->gen;
+
+    gen->scratch = args->buf.head;
+    gen->scratch_capa = (size_t)(args->buf.end - args->buf.head);
+    gen->busy = false;
+    return Qnil;
+}
+
+/*
+ * generator.generate(obj)
+ *
+ * Serialize obj with this generator's options.
+ */
+static VALUE
+generator_generate(VALUE self, VALUE obj)
+{
+    yyjson_generator_t *gen = get_generator(self);
+
+    /* Already writing into the scratch buffer: use a fresh String instead */
+    if (RB_UNLIKELY(gen->busy)) {
+        return yyjson_ruby_write_string(obj, &gen->opts);
+    }
+
+    if (!gen->scratch) {
+        gen->scratch = YYJSON_ALLOC_N(char, GENERATOR_INITIAL_CAPA);
+        gen->scratch_capa = GENERATOR_INITIAL_CAPA;
+    }
+
+    generator_call_args args = { .gen = gen, .obj = obj };
+    json_buf_init_scratch(&args.buf, gen->scratch, gen->scratch_capa);
+    gen->busy = true;
+
+    VALUE result = rb_ensure(generator_call, (VALUE)&args, generator_call_ensure, (VALUE)&args);
+    RB_GC_GUARD(self);
+    return result;
+}
+
+/*
+ * generator.reset
+ *
+ * Release the scratch buffer (it only grows otherwise, up to the largest
+ * output generated so far).
+ */
+static VALUE
+generator_reset(VALUE self)
+{
+    yyjson_generator_t *gen = get_generator(self);
+    if (gen->busy) {
+        rb_raise(rb_eRuntimeError, "YYJson::Generator is in use");
+    }
+
+    if (gen->scratch) YYJSON_FREE(gen->scratch);
+    gen->scratch = NULL;
+    gen->scratch_capa = 0;
+    return self;
+}
+
+void
+yyjson_generator_class_init(void)
+{
+    cGenerator = rb_define_class_under(mYYJson, "Generator", rb_cObject);
+    rb_define_alloc_func(cGenerator, generator_alloc);
+    rb_define_method(cGenerator, "initialize", generator_initialize, -1);
+    rb_define_method(cGenerator, "generate", generator_generate, 1);
+    rb_define_method(cGenerator, "dump", generator_generate, 1);
+    rb_define_method(cGenerator, "reset", generator_reset, 0);
+}
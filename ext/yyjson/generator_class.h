@@ -0,0 +1,15 @@
+/*
+ * generator_class.h - YYJson::Generator (reusable generator with preset options)
+ */
+
+#ifndef YYJSON_RUBY_GENERATOR_CLASS_H
+#define YYJSON_RUBY_GENERATOR_CLASS_H
+
+#include "common.h"
+
+/*
+ * Define YYJson::Generator (called from Init_yyjson)
+ */
+void yyjson_generator_class_init(void);
+
+#endif /* YYJSON_RUBY_GENERATOR_CLASS_H */
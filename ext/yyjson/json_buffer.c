@@ -0,0 +1,129 @@
+/*
+ * json_buffer.c - Growable output buffer backed by a Ruby String
+ *
+ * Generated JSON is written directly into the String that is returned to
+ * Ruby, so there is no intermediate malloc'd buffer or final copy.
+ * Scratch buffers (YYJson::Generator) trade one final copy for memory that
+ * is sized once and reused by every dump. Streaming buffers (dump to an
+ * IO, dump_file, dump_chunks) drain fixed-size scratch memory instead.
+ */
+
+#include "common.h"
+#include "json_buffer.h"
+
+/* Streaming buffers keep a byte before head: yyjson_emit_str_part writes
+ * to cur[-1], and a flush leaves cur at head */
+#define STREAM_GUARD 1
+
+/*
+ * Re-read pointers after the backing String was (re)allocated
+ */
+static void
+json_buf_sync(json_buf_t *buf, size_t len)
+{
+    buf->head = RSTRING_PTR(buf->str);
+    buf->cur = buf->head + len;
+    buf->end = buf->head + rb_str_capacity(buf->str);
+}
+
+void
+json_buf_init(json_buf_t *buf, size_t capa)
+{
+    buf->str = rb_str_buf_new((long)capa);
+    buf->flush = NULL;
+    buf->flush_arg = NULL;
+    buf->flushed = 0;
+    json_buf_sync(buf, 0);
+}
+
+void
+json_buf_init_scratch(json_buf_t *buf, char *mem, size_t capa)
+{
+    buf->str = Qfalse;
+    buf->head = buf->cur = mem;
+    buf->end = mem + capa;
+    buf->flush = NULL;
+    buf->flush_arg = NULL;
+    buf->flushed = 0;
+}
+
+void
+json_buf_init_stream(json_buf_t *buf, size_t capa, json_buf_flush_fn flush, void *arg)
+{
+    char *mem = ruby_xmalloc(capa + STREAM_GUARD);
+    json_buf_init_scratch(buf, mem + STREAM_GUARD, capa);
+    buf->flush = flush;
+    buf->flush_arg = arg;
+}
+
+void
+json_buf_flush(json_buf_t *buf)
+{
+    size_t len = (size_t)(buf->cur - buf->head);
+    if (len == 0) return;
+
+    /* Rewind first: if the callback raises, the data counts as handed over */
+    buf->cur = buf->head;
+    buf->flushed += len;
+    buf->flush(buf, buf->head, len);
+}
+
+void
+json_buf_free_stream(json_buf_t *buf)
+{
+    if (buf->head) ruby_xfree(buf->head - STREAM_GUARD);
+    buf->head = buf->cur = buf->end = NULL;
+}
+
+void
+json_buf_grow(json_buf_t *buf, size_t need)
+{
+    if (buf->flush) {
+        json_buf_flush(buf);
+        if ((size_t)(buf->end - buf->cur) >= need) return;
+    }
+
+    size_t len = (size_t)(buf->cur - buf->head);
+    size_t capa = (size_t)(buf->end - buf->head);
+    size_t new_capa = capa * 2;
+
+    if (new_capa < len + need) {
+        new_capa = len + need;
+    }
+
+    if (buf->str == Qfalse) {
+        size_t guard = buf->flush ? STREAM_GUARD : 0;
+        char *mem = (char *)ruby_xrealloc(buf->head - guard, new_capa + guard);
+        buf->head = mem + guard;
+        buf->cur = buf->head + len;
+        buf->end = buf->head + new_capa;
+        return;
+    }
+
+    rb_str_set_len(buf->str, (long)len);
+    rb_str_modify_expand(buf->str, (long)(new_capa - len));
+    json_buf_sync(buf, len);
+}
+
+VALUE
+json_buf_finish(json_buf_t *buf)
+{
+    VALUE str = buf->str;
+
+    if (str == Qfalse) {
+        return rb_utf8_str_new(buf->head, (long)(buf->cur - buf->head));
+    }
+
+    /*
+     * rb_str_resize also releases excess capacity. It only keeps the bytes
+     * within the String's current length, so set that first: shrinking
+     * back into an embedded String would otherwise drop the output.
+     */
+    long len = (long)(buf->cur - buf->head);
+    rb_str_set_len(str, len);
+    rb_str_resize(str, len);
+    rb_enc_associate(str, rb_utf8_encoding());
+
+    buf->head = buf->cur = buf->end = NULL;
+    return str;
+}
@@ -0,0 +1,116 @@
+/*
+ * json_buffer.h - Growable output buffer backed by a Ruby String
+ */
+
+#ifndef YYJSON_RUBY_JSON_BUFFER_H
+#define YYJSON_RUBY_JSON_BUFFER_H
+
+#include "common.h"
+#include <string.h>
+
+/*
+ * Output buffer writing straight into a Ruby String's heap memory
+ *
+ * The struct must live on the C stack: the backing String is only kept
+ * alive (and pinned against compaction) through the conservative stack
+ * scan. Raising midway simply leaves the String to the GC.
+ *
+ * A buffer can instead write into caller-owned scratch memory
+ * (json_buf_init_scratch, str == Qfalse). It grows with ruby_xrealloc and
+ * the result is copied out, so the memory can be reused across dumps.
+ *
+ * A streaming buffer (json_buf_init_stream) is scratch memory that hands
+ * its contents to a flush callback whenever it is full instead of growing,
+ * so output of any size passes through a fixed amount of memory. It only
+ * grows for a single token larger than its capacity. Positions that must
+ * survive flushes are absolute: buf->flushed + (buf->cur - buf->head).
+ */
+typedef struct json_buf json_buf_t;
+
+/* Receives len bytes of output at data (may raise) */
+typedef void (*json_buf_flush_fn)(json_buf_t *buf, const char *data, size_t len);
+
+struct json_buf {
+    VALUE str;   /* Backing Ruby String (Qfalse for scratch memory) */
+    char *head;  /* Start of the String's buffer */
+    char *cur;   /* Write cursor */
+    char *end;   /* End of usable capacity */
+    json_buf_flush_fn flush;  /* Streaming: drains the buffer (NULL = grow instead) */
+    void *flush_arg;          /* For the flush callback */
+    size_t flushed;           /* Bytes handed to flush so far */
+};
+
+/*
+ * Initialize a buffer with the given starting capacity
+ */
+void json_buf_init(json_buf_t *buf, size_t capa);
+
+/*
+ * Initialize a buffer over ruby_xmalloc'd scratch memory owned by the caller
+ *
+ * After writing, the (possibly reallocated) memory is at buf->head with
+ * capacity buf->end - buf->head; the caller takes it back from there.
+ */
+void json_buf_init_scratch(json_buf_t *buf, char *mem, size_t capa);
+
+/*
+ * Initialize a streaming buffer of capa bytes (ruby_xmalloc'd; release it
+ * with json_buf_free_stream, also when writing raises)
+ */
+void json_buf_init_stream(json_buf_t *buf, size_t capa, json_buf_flush_fn flush, void *arg);
+
+/*
+ * Hand everything written so far to the flush callback (streaming buffers)
+ */
+void json_buf_flush(json_buf_t *buf);
+
+/*
+ * Free a streaming buffer's memory
+ */
+void json_buf_free_stream(json_buf_t *buf);
+
+/*
+ * Grow the buffer so at least `need` more bytes fit after the cursor
+ */
+void json_buf_grow(json_buf_t *buf, size_t need);
+
+/*
+ * Finish writing and return the UTF-8 String (trimmed to its length)
+ *
+ * Scratch buffers return a copy and keep their memory.
+ */
+VALUE json_buf_finish(json_buf_t *buf);
+
+/*
+ * Ensure `need` bytes are available and return the cursor
+ */
+static inline char *
+json_buf_reserve(json_buf_t *buf, size_t need)
+{
+    if (__builtin_expect((size_t)(buf->end - buf->cur) < need, 0)) {
+        json_buf_grow(buf, need);
+    }
+    return buf->cur;
+}
+
+/*
+ * Append a single byte
+ */
+static inline void
+json_buf_putc(json_buf_t *buf, char c)
+{
+    *json_buf_reserve(buf, 1) = c;
+    buf->cur++;
+}
+
+/*
+ * Append raw bytes
+ */
+static inline void
+json_buf_write(json_buf_t *buf, const char *src, size_t len)
+{
+    memcpy(json_buf_reserve(buf, len), src, len);
+    buf->cur += len;
+}
+
+#endif /* YYJSON_RUBY_JSON_BUFFER_H */
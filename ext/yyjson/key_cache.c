@@ -0,0 +1,237 @@
+/*
+ * key_cache.c - Persistent object-key intern cache
+ *
+ * The per-document string_cache_t in value_builder.c is rebuilt for every
+ * parse. This cache keeps key Strings/Symbols alive across parses, so
+ * workloads with many small documents sharing the same keys stop paying
+ * for interning on every call.
+ *
+ * Layout: `capacity / KEY_CACHE_WAYS` sets of KEY_CACHE_WAYS entries.
+ * The set is chosen from the key hash; within a set, a miss takes an
+ * empty slot or evicts the first entry not referenced since the last
+ * scan (NRU / second chance).
+ */
+
+#include "common.h"
+#include "key_cache.h"
+#include <string.h>
+
+key_cache_t yyjson_global_key_cache;
+bool yyjson_key_cache_default = false;
+
+/* Ruby object that marks yyjson_global_key_cache */
+static VALUE global_holder = Qnil;
+
+/*
+ * Create frozen interned UTF-8 string
+ */
+static VALUE
+make_key_str(const char *s, size_t len)
+{
+#ifdef HAVE_RB_ENC_INTERNED_STR
+    return rb_enc_interned_str(s, len, rb_utf8_encoding());
+#else
+    VALUE str = rb_enc_str_new(s, len, rb_utf8_encoding());
+    return rb_str_freeze(str);
+#endif
+}
+
+void
+yyjson_key_cache_init(key_cache_t *cache, size_t capacity)
+{
+    size_t sets = 1;
+    while (sets * KEY_CACHE_WAYS < capacity) sets <<= 1;
+
+    cache->capacity = sets * KEY_CACHE_WAYS;
+    cache->set_mask = sets - 1;
+    cache->entries = YYJSON_ALLOC_N(key_cache_entry_t, cache->capacity);
+    cache->size = 0;
+    cache->hits = cache->misses = cache->evictions = 0;
+}
+
+void
+yyjson_key_cache_free(key_cache_t *cache)
+{
+    if (cache->entries) YYJSON_FREE(cache->entries);
+    cache->entries = NULL;
+    cache->capacity = cache->size = 0;
+}
+
+void
+yyjson_key_cache_clear(key_cache_t *cache)
+{
+    memset(cache->entries, 0, cache->capacity * sizeof(key_cache_entry_t));
+    cache->size = 0;
+    cache->hits = cache->misses = cache->evictions = 0;
+}
+
+void
+yyjson_key_cache_mark(const key_cache_t *cache)
+{
+    for (size_t i = 0; i < cache->capacity; i++) {
+        const key_cache_entry_t *e = &cache->entries[i];
+        if (!RTEST(e->str)) continue;
+#ifdef HAVE_RB_GC_MARK_MOVABLE
+        rb_gc_mark_movable(e->str);
+        if (RTEST(e->sym)) rb_gc_mark_movable(e->sym);
+#else
+        rb_gc_mark(e->str);
+        if (RTEST(e->sym)) rb_gc_mark(e->sym);
+#endif
+    }
+}
+
+void
+yyjson_key_cache_compact(key_cache_t *cache)
+{
+#ifdef HAVE_RB_GC_MARK_MOVABLE
+    for (size_t i = 0; i < cache->capacity; i++) {
+        key_cache_entry_t *e = &cache->entries[i];
+        if (!RTEST(e->str)) continue;
+        e->str = rb_gc_location(e->str);
+        if (RTEST(e->sym)) e->sym = rb_gc_location(e->sym);
+    }
+#endif
+}
+
+size_t
+yyjson_key_cache_memsize(const key_cache_t *cache)
+{
+    return sizeof(key_cache_t) + cache->capacity * sizeof(key_cache_entry_t);
+}
+
+/*
+ * Find the entry for a key, or claim a slot for it (counting hit/miss)
+ *
+ * On a miss the returned entry has str == Qfalse and the caller fills it.
+ */
+static key_cache_entry_t *
+key_cache_lookup(key_cache_t *cache, const char *s, size_t len, uint32_t hash)
+{
+    key_cache_entry_t *set = &cache->entries[(hash & cache->set_mask) * KEY_CACHE_WAYS];
+    key_cache_entry_t *victim = NULL;
+
+    for (int w = 0; w < KEY_CACHE_WAYS; w++) {
+        key_cache_entry_t *e = &set[w];
+        if (!RTEST(e->str)) {
+            if (!victim) victim = e;
+            continue;
+        }
+        if (e->hash == hash && e->len == len &&
+            memcmp(RSTRING_PTR(e->str), s, len) == 0) {
+            e->ref = true;
+            cache->hits++;
+            return e;
+        }
+    }
+
+    cache->misses++;
+
+    if (!victim) {
+        /* Set is full: evict the first entry not referenced since the last scan */
+        for (int pass = 0; pass < 2 && !victim; pass++) {
+            for (int w = 0; w < KEY_CACHE_WAYS; w++) {
+                if (!set[w].ref) {
+                    victim = &set[w];
+                    break;
+                }
+                set[w].ref = false;
+            }
+        }
+        cache->evictions++;
+        cache->size--;
+    }
+
+    victim->str = Qfalse;
+    victim->sym = Qfalse;
+    return victim;
+}
+
+/*
+ * Fill a claimed slot (the key String is created before the slot is
+ * published, as creating it may run the GC)
+ */
+static void
+key_cache_fill(key_cache_t *cache, key_cache_entry_t *e, const char *s, size_t len, uint32_t hash)
+{
+    VALUE str = make_key_str(s, len);
+    e->hash = hash;
+    e->len = (uint32_t)len;
+    e->ref = false;
+    e->str = str;
+    cache->size++;
+}
+
+VALUE
+yyjson_key_cache_fetch_str(key_cache_t *cache, const char *s, size_t len, uint32_t hash)
+{
+    key_cache_entry_t *e = key_cache_lookup(cache, s, len, hash);
+    if (!RTEST(e->str)) key_cache_fill(cache, e, s, len, hash);
+    return e->str;
+}
+
+VALUE
+yyjson_key_cache_fetch_sym(key_cache_t *cache, const char *s, size_t len, uint32_t hash)
+{
+    key_cache_entry_t *e = key_cache_lookup(cache, s, len, hash);
+    if (!RTEST(e->str)) key_cache_fill(cache, e, s, len, hash);
+    if (!RTEST(e->sym)) e->sym = ID2SYM(rb_intern3(s, (long)len, rb_utf8_encoding()));
+    return e->sym;
+}
+
+VALUE
+yyjson_key_cache_stats(const key_cache_t *cache)
+{
+    VALUE stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("hits")), SIZET2NUM(cache->hits));
+    rb_hash_aset(stats, ID2SYM(rb_intern("misses")), SIZET2NUM(cache->misses));
+    rb_hash_aset(stats, ID2SYM(rb_intern("evictions")), SIZET2NUM(cache->evictions));
+    rb_hash_aset(stats, ID2SYM(rb_intern("size")), SIZET2NUM(cache->size));
+    rb_hash_aset(stats, ID2SYM(rb_intern("capacity")), SIZET2NUM(cache->capacity));
+    return stats;
+}
+
+/*
+ * GC holder for the process-wide cache
+ */
+static void
+global_holder_mark(void *ptr)
+{
+    yyjson_key_cache_mark((key_cache_t *)ptr);
+}
+
+#ifdef HAVE_RB_GC_MARK_MOVABLE
+static void
+global_holder_compact(void *ptr)
+{
+    yyjson_key_cache_compact((key_cache_t *)ptr);
+}
+#endif
+
+static size_t
+global_holder_memsize(const void *ptr)
+{
+    return yyjson_key_cache_memsize((const key_cache_t *)ptr);
+}
+
+static const rb_data_type_t global_holder_type = {
+    .wrap_struct_name = "YYJson::KeyCache",
+    .function = {
+        .dmark = global_holder_mark,
+        .dfree = RUBY_NEVER_FREE,
+        .dsize = global_holder_memsize,
+#ifdef HAVE_RB_GC_MARK_MOVABLE
+        .dcompact = global_holder_compact,
+#endif
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+void
+yyjson_key_cache_init_global(void)
+{
+    yyjson_key_cache_init(&yyjson_global_key_cache, KEY_CACHE_DEFAULT_CAPACITY);
+
+    rb_global_variable(&global_holder);
+    global_holder = TypedData_Wrap_Struct(0, &global_holder_type, &yyjson_global_key_cache);
+}
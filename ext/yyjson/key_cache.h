@@ -0,0 +1,93 @@
+/*
+ * key_cache.h - Persistent object-key intern cache
+ */
+
+#ifndef YYJSON_RUBY_KEY_CACHE_H
+#define YYJSON_RUBY_KEY_CACHE_H
+
+#include "common.h"
+
+/* Keys longer than this are never cached */
+#define KEY_CACHE_MAX_LEN 55
+
+/* Entries per set (lookups probe one set) */
+#define KEY_CACHE_WAYS 4
+
+/* Default capacity of the process-wide cache (entries) */
+#define KEY_CACHE_DEFAULT_CAPACITY 1024
+
+typedef struct {
+    uint32_t hash;     /* FNV-1a hash of the key bytes */
+    uint32_t len;      /* Key length */
+    VALUE str;         /* Frozen interned String (Qfalse = empty slot) */
+    VALUE sym;         /* Symbol, created on first symbolize_names use */
+    bool ref;          /* Referenced since the last eviction scan (NRU) */
+} key_cache_entry_t;
+
+/*
+ * Bounded, set-associative cache of Ruby key objects that survives across
+ * parses. Keyed on hash+length like the per-document string_cache_t; when
+ * a set is full the not-recently-used entry is evicted.
+ *
+ * Cached VALUEs are only reachable through yyjson_key_cache_mark(), so
+ * every cache must be owned by a marked Ruby object.
+ */
+typedef struct {
+    key_cache_entry_t *entries;
+    size_t capacity;   /* Total entries (sets * KEY_CACHE_WAYS) */
+    size_t set_mask;   /* Number of sets - 1 */
+    size_t size;       /* Occupied entries */
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+} key_cache_t;
+
+/*
+ * Allocate entries for a cache (capacity is rounded up to a power of two)
+ */
+void yyjson_key_cache_init(key_cache_t *cache, size_t capacity);
+
+/*
+ * Release a cache's entries
+ */
+void yyjson_key_cache_free(key_cache_t *cache);
+
+/*
+ * Drop all entries and reset the counters
+ */
+void yyjson_key_cache_clear(key_cache_t *cache);
+
+/*
+ * GC integration for the owning object's dmark/dcompact/dsize
+ */
+void yyjson_key_cache_mark(const key_cache_t *cache);
+void yyjson_key_cache_compact(key_cache_t *cache);
+size_t yyjson_key_cache_memsize(const key_cache_t *cache);
+
+/*
+ * Return the cached frozen String / Symbol for a key, creating it on a miss
+ *
+ * @param hash FNV-1a hash of the key bytes
+ */
+VALUE yyjson_key_cache_fetch_str(key_cache_t *cache, const char *s, size_t len, uint32_t hash);
+VALUE yyjson_key_cache_fetch_sym(key_cache_t *cache, const char *s, size_t len, uint32_t hash);
+
+/*
+ * Return {hits:, misses:, evictions:, size:, capacity:}
+ */
+VALUE yyjson_key_cache_stats(const key_cache_t *cache);
+
+/*
+ * Process-wide cache used by YYJson.load(..., key_cache: true)
+ */
+extern key_cache_t yyjson_global_key_cache;
+
+/* Default for the :key_cache parse option */
+extern bool yyjson_key_cache_default;
+
+/*
+ * Create the process-wide cache and its GC holder
+ */
+void yyjson_key_cache_init_global(void);
+
+#endif /* YYJSON_RUBY_KEY_CACHE_H */
@@ -0,0 +1,451 @@
+/*
+ * lazy.c - Lazy document mode: YYJson.load_lazy
+ *
+ * A YYJson::Document owns the yyjson_doc and converts values to Ruby only
+ * when they are read. Containers come back as YYJson::Node proxies that
+ * point into the document (and keep it alive); scalars come back as plain
+ * Ruby values. Reading a few fields of a large document allocates only
+ * those fields instead of the whole tree.
+ */
+
+#include "common.h"
+#include "parser.h"
+#include "fragment.h"
+#include "lazy.h"
+
+static VALUE cNode = Qnil;
+static VALUE cDocument = Qnil;
+
+typedef struct {
+    yyjson_doc *doc;
+    yyjson_parse_options opts;
+} lazy_doc_t;
+
+typedef struct {
+    VALUE owner;           /* YYJson::Document holding doc (Qnil for the Document itself) */
+    lazy_doc_t *doc;
+    yyjson_val *val;
+} lazy_node_t;
+
+typedef struct {
+    lazy_node_t node;      /* First member: a Document is its root Node */
+    lazy_doc_t data;
+} lazy_document_t;
+
+static void
+node_mark(void *ptr)
+{
+    lazy_node_t *node = (lazy_node_t *)ptr;
+#ifdef HAVE_RB_GC_MARK_MOVABLE
+    rb_gc_mark_movable(node->owner);
+#else
+    rb_gc_mark(node->owner);
+#endif
+}
+
+#ifdef HAVE_RB_GC_MARK_MOVABLE
+static void
+node_compact(void *ptr)
+{
+    lazy_node_t *node = (lazy_node_t *)ptr;
+    node->owner = rb_gc_location(node->owner);
+}
+#endif
+
+static size_t
+node_memsize(const void *ptr)
+{
+    return sizeof(lazy_node_t);
+}
+
+static const rb_data_type_t node_type = {
+    .wrap_struct_name = "YYJson::Node",
+    .function = {
+        .dmark = node_mark,
+        .dfree = RUBY_TYPED_DEFAULT_FREE,
+        .dsize = node_memsize,
+#ifdef HAVE_RB_GC_MARK_MOVABLE
+        .dcompact = node_compact,
+#endif
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static void
+document_free(void *ptr)
+{
+    lazy_document_t *document = (lazy_document_t *)ptr;
+    if (document->data.doc) yyjson_doc_free(document->data.doc);
+    YYJSON_FREE(document);
+}
+
+static size_t
+document_memsize(const void *ptr)
+{
+    const lazy_document_t *document = (const lazy_document_t *)ptr;
+    size_t size = sizeof(lazy_document_t);
+    const yyjson_doc *doc = document->data.doc;
+    if (doc) size += doc->val_read * sizeof(yyjson_val) + doc->dat_read;
+    return size;
+}
+
+static const rb_data_type_t document_type = {
+    .wrap_struct_name = "YYJson::Document",
+    .function = {
+        .dmark = NULL,
+        .dfree = document_free,
+        .dsize = document_memsize,
+    },
+    .parent = &node_type,
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static lazy_node_t *
+get_node(VALUE self)
+{
+    lazy_node_t *node;
+    TypedData_Get_Struct(self, lazy_node_t, &node_type, node);
+    return node;
+}
+
+/* The Document keeping self's values alive */
+static inline VALUE
+owner_of(VALUE self, const lazy_node_t *node)
+{
+    return NIL_P(node->owner) ? self : node->owner;
+}
+
+/*
+ * Ruby value for a document value: a Node for containers, else the scalar
+ */
+static VALUE
+wrap_val(VALUE owner, lazy_doc_t *doc, yyjson_val *val)
+{
+    if (!yyjson_is_ctn(val)) return yyjson_build_ruby_value(val, &doc->opts);
+
+    lazy_node_t *node;
+    VALUE obj = TypedData_Make_Struct(cNode, lazy_node_t, &node_type, node);
+    node->owner = owner;
+    node->doc = doc;
+    node->val = val;
+    return obj;
+}
+
+NORETURN(static void raise_not_container(yyjson_val *val, const char *method));
+static void
+raise_not_container(yyjson_val *val, const char *method)
+{
+    rb_raise(rb_eTypeError, "JSON %s does not have #%s", yyjson_get_type_desc(val), method);
+}
+
+/*
+ * Child of an object (String/Symbol key) or array (Integer index), or NULL
+ */
+static yyjson_val *
+lookup(yyjson_val *val, VALUE key)
+{
+    if (yyjson_is_obj(val)) {
+        if (SYMBOL_P(key)) {
+            key = rb_sym2str(key);
+        } else if (!RB_TYPE_P(key, T_STRING)) {
+            return NULL;
+        }
+        yyjson_val *found = yyjson_obj_getn(val, RSTRING_PTR(key), (size_t)RSTRING_LEN(key));
+        RB_GC_GUARD(key);
+        return found;
+    }
+
+    long idx = NUM2LONG(key);
+    long size = (long)yyjson_arr_size(val);
+    if (idx < 0) idx += size;
+    if (idx < 0 || idx >= size) return NULL;
+    return yyjson_arr_get(val, (size_t)idx);
+}
+
+/*
+ * node[key]
+ *
+ * Value under a key (object; String or Symbol) or index (array; negative
+ * counts from the end). Containers are returned as YYJson::Node, scalars
+ * as Ruby values; nil if absent.
+ */
+static VALUE
+node_aref(VALUE self, VALUE key)
+{
+    lazy_node_t *node = get_node(self);
+    if (!yyjson_is_ctn(node->val)) raise_not_container(node->val, "[]");
+
+    yyjson_val *found = lookup(node->val, key);
+    if (!found) return Qnil;
+    return wrap_val(owner_of(self, node), node->doc, found);
+}
+
+/*
+ * node.dig(key, ...)
+ *
+ * Follow keys and indexes like Hash#dig without creating Nodes for the
+ * intermediate containers.
+ */
+static VALUE
+node_dig(int argc, VALUE *argv, VALUE self)
+{
+    rb_check_arity(argc, 1, UNLIMITED_ARGUMENTS);
+    lazy_node_t *node = get_node(self);
+    yyjson_val *val = node->val;
+
+    for (int i = 0; i < argc; i++) {
+        if (!yyjson_is_ctn(val)) {
+            if (yyjson_is_null(val)) return Qnil;
+            raise_not_container(val, "dig");
+        }
+        val = lookup(val, argv[i]);
+        if (!val) return Qnil;
+    }
+    return wrap_val(owner_of(self, node), node->doc, val);
+}
+
+/*
+ * node.each { |key, value| ... } / node.each { |element| ... }
+ *
+ * Iterate over an object's pairs or an array's elements. Nested
+ * containers are yielded as Nodes.
+ */
+static VALUE
+node_each(VALUE self)
+{
+    RETURN_ENUMERATOR(self, 0, 0);
+    lazy_node_t *node = get_node(self);
+    VALUE owner = owner_of(self, node);
+    yyjson_val *val = node->val;
+
+    if (yyjson_is_obj(val)) {
+        yyjson_obj_iter iter = yyjson_obj_iter_with(val);
+        yyjson_val *key;
+        while ((key = yyjson_obj_iter_next(&iter))) {
+            VALUE k = yyjson_build_ruby_key(key, &node->doc->opts);
+            VALUE v = wrap_val(owner, node->doc, yyjson_obj_iter_get_val(key));
+            rb_yield(rb_assoc_new(k, v));
+        }
+    } else if (yyjson_is_arr(val)) {
+        yyjson_arr_iter iter = yyjson_arr_iter_with(val);
+        yyjson_val *elem;
+        while ((elem = yyjson_arr_iter_next(&iter))) {
+            rb_yield(wrap_val(owner, node->doc, elem));
+        }
+    } else {
+        raise_not_container(val, "each");
+    }
+
+    RB_GC_GUARD(owner);
+    return self;
+}
+
+/*
+ * node.keys
+ *
+ * Keys of an object (Strings, or Symbols with symbolize_names).
+ */
+static VALUE
+node_keys(VALUE self)
+{
+    lazy_node_t *node = get_node(self);
+    if (!yyjson_is_obj(node->val)) raise_not_container(node->val, "keys");
+
+    VALUE keys = rb_ary_new_capa((long)yyjson_obj_size(node->val));
+    yyjson_obj_iter iter = yyjson_obj_iter_with(node->val);
+    yyjson_val *key;
+    while ((key = yyjson_obj_iter_next(&iter))) {
+        rb_ary_push(keys, yyjson_build_ruby_key(key, &node->doc->opts));
+    }
+    return keys;
+}
+
+/*
+ * node.key?(key)
+ */
+static VALUE
+node_has_key(VALUE self, VALUE key)
+{
+    lazy_node_t *node = get_node(self);
+    if (!yyjson_is_obj(node->val)) raise_not_container(node->val, "key?");
+    return lookup(node->val, key) ? Qtrue : Qfalse;
+}
+
+/*
+ * node.size
+ *
+ * Number of pairs of an object or elements of an array.
+ */
+static VALUE
+node_size(VALUE self)
+{
+    lazy_node_t *node = get_node(self);
+    if (!yyjson_is_ctn(node->val)) raise_not_container(node->val, "size");
+    return SIZET2NUM(yyjson_get_len(node->val));
+}
+
+static VALUE
+node_object_p(VALUE self)
+{
+    return yyjson_is_obj(get_node(self)->val) ? Qtrue : Qfalse;
+}
+
+static VALUE
+node_array_p(VALUE self)
+{
+    return yyjson_is_arr(get_node(self)->val) ? Qtrue : Qfalse;
+}
+
+/*
+ * node.to_ruby
+ *
+ * Convert the whole subtree, exactly as YYJson.load would.
+ */
+static VALUE
+node_to_ruby(VALUE self)
+{
+    lazy_node_t *node = get_node(self);
+    VALUE result = yyjson_build_ruby_value(node->val, &node->doc->opts);
+    RB_GC_GUARD(self);
+    return result;
+}
+
+/*
+ * node.to_h
+ *
+ * Convert an object subtree to a Hash.
+ */
+static VALUE
+node_to_h(VALUE self)
+{
+    lazy_node_t *node = get_node(self);
+    if (!yyjson_is_obj(node->val)) raise_not_container(node->val, "to_h");
+    return node_to_ruby(self);
+}
+
+/*
+ * node.to_a
+ *
+ * Convert an array subtree to an Array (an object gives its [key, value]
+ * pairs, like Hash#to_a).
+ */
+static VALUE
+node_to_a(VALUE self)
+{
+    lazy_node_t *node = get_node(self);
+    if (yyjson_is_obj(node->val)) return rb_funcall(node_to_ruby(self), rb_intern("to_a"), 0);
+    if (!yyjson_is_arr(node->val)) raise_not_container(node->val, "to_a");
+    return node_to_ruby(self);
+}
+
+/*
+ * node.to_json(opts = nil)
+ *
+ * Serialize the subtree straight from the document. A Hash of
+ * YYJson.dump options applies :pretty, :escape_slash and :allow_nan (which
+ * defaults to the document's); any other argument, such as the state
+ * JSON.generate passes, is ignored so nodes still embed there.
+ */
+static VALUE
+node_to_json(int argc, VALUE *argv, VALUE self)
+{
+    rb_check_arity(argc, 0, 1);
+    lazy_node_t *node = get_node(self);
+    bool allow_nan = node->doc->opts.allow_nan;
+    yyjson_write_flag flg = YYJSON_WRITE_NOFLAG;
+    if (argc == 1 && RB_TYPE_P(argv[0], T_HASH)) {
+        VALUE val = rb_hash_aref(argv[0], ID2SYM(id_allow_nan));
+        if (!NIL_P(val)) allow_nan = RTEST(val);
+        if (RTEST(rb_hash_aref(argv[0], ID2SYM(id_pretty)))) flg |= YYJSON_WRITE_PRETTY_TWO_SPACES;
+        if (RTEST(rb_hash_aref(argv[0], ID2SYM(id_escape_slash)))) flg |= YYJSON_WRITE_ESCAPE_SLASHES;
+    }
+    if (allow_nan) flg |= YYJSON_WRITE_ALLOW_INF_AND_NAN;
+    yyjson_write_err err;
+    size_t len;
+
+    char *json = yyjson_val_write_opts(node->val, flg, NULL, &len, &err);
+    if (!json) rb_raise(eGenerateError, "%s", err.msg);
+
+    VALUE str = rb_utf8_str_new(json, (long)len);
+    free(json);
+    RB_GC_GUARD(self);
+    return str;
+}
+
+/*
+ * node.as_json(*)
+ *
+ * The subtree as a YYJson::Fragment of its to_json, so YYJson.dump (and
+ * JSON.generate under yyjson/mimic) embed it without converting it
+ */
+static VALUE
+node_as_json(int argc, VALUE *argv, VALUE self)
+{
+    return yyjson_fragment_new(node_to_json(0, NULL, self));
+}
+
+static VALUE
+node_inspect(VALUE self)
+{
+    lazy_node_t *node = get_node(self);
+    if (!yyjson_is_ctn(node->val)) {
+        return rb_sprintf("#<%"PRIsVALUE" %"PRIsVALUE">", rb_obj_class(self),
+                          rb_inspect(node_to_ruby(self)));
+    }
+    return rb_sprintf("#<%"PRIsVALUE" %s size=%zu>", rb_obj_class(self),
+                      yyjson_get_type_desc(node->val), yyjson_get_len(node->val));
+}
+
+/*
+ * YYJson.load_lazy(source, opts = {})
+ *
+ * Parse source into a YYJson::Document without converting it. Values are
+ * built on access with the YYJson.load options given here.
+ */
+static VALUE
+yyjson_load_lazy(int argc, VALUE *argv, VALUE self)
+{
+    VALUE source, opts;
+    rb_scan_args(argc, argv, "11", &source, &opts);
+    if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+
+    /* Allocate first so a raised error can't leak the document */
+    lazy_document_t *document;
+    VALUE obj = TypedData_Make_Struct(cDocument, lazy_document_t, &document_type, document);
+    document->node.owner = Qnil;
+    document->node.doc = &document->data;
+
+    yyjson_extract_parse_options(opts, &document->data.opts);
+    document->data.doc = yyjson_read_string_doc(source, &document->data.opts,
+                                                yyjson_read_flags(&document->data.opts), NULL);
+    document->node.val = yyjson_doc_get_root(document->data.doc);
+    return obj;
+}
+
+void
+yyjson_lazy_init(void)
+{
+    cNode = rb_define_class_under(mYYJson, "Node", rb_cObject);
+    rb_undef_alloc_func(cNode);
+    rb_include_module(cNode, rb_mEnumerable);
+    rb_define_method(cNode, "[]", node_aref, 1);
+    rb_define_method(cNode, "dig", node_dig, -1);
+    rb_define_method(cNode, "each", node_each, 0);
+    rb_define_method(cNode, "keys", node_keys, 0);
+    rb_define_method(cNode, "key?", node_has_key, 1);
+    rb_define_method(cNode, "size", node_size, 0);
+    rb_define_method(cNode, "length", node_size, 0);
+    rb_define_method(cNode, "object?", node_object_p, 0);
+    rb_define_method(cNode, "array?", node_array_p, 0);
+    rb_define_method(cNode, "to_ruby", node_to_ruby, 0);
+    rb_define_method(cNode, "to_h", node_to_h, 0);
+    rb_define_method(cNode, "to_a", node_to_a, 0);
+    rb_define_method(cNode, "to_json", node_to_json, -1);
+    rb_define_method(cNode, "as_json", node_as_json, -1);
+    rb_define_method(cNode, "inspect", node_inspect, 0);
+
+    cDocument = rb_define_class_under(mYYJson, "Document", cNode);
+    rb_undef_alloc_func(cDocument);
+
+    rb_define_singleton_method(mYYJson, "load_lazy", yyjson_load_lazy, -1);
+}
@@ -0,0 +1,17 @@
+/*
+ * lazy.h - Lazy document mode (YYJson.load_lazy)
+ */
+
+#ifndef YYJSON_RUBY_LAZY_H
+#define YYJSON_RUBY_LAZY_H
+
+#include "common.h"
+#include "value_builder.h"
+
+/*
+ * Define YYJson::Node, YYJson::Document and YYJson.load_lazy
+ * (called from Init_yyjson)
+ */
+void yyjson_lazy_init(void);
+
+#endif /* YYJSON_RUBY_LAZY_H */
@@ -0,0 +1,292 @@
+/*
+ * lines.c - NDJSON / JSON Lines reader
+ *
+ * Splits input on '\n' in C (JSON text can't contain a raw newline, so
+ * every newline is a record boundary) and parses each record with one
+ * YYJson::Parser: its pooled allocator and key cache are shared by every
+ * record instead of being set up for each YYJson.load call.
+ */
+
+#include "common.h"
+#include "parser_class.h"
+#include "lines.h"
+#include "stats.h"
+#include <string.h>
+
+/* Bytes requested from an IO source per read */
+#define LINES_READ_CHUNK (64 * 1024)
+
+typedef struct {
+    VALUE parser_obj;
+    yyjson_parser_t *parser;
+    const yyjson_alc *alc;
+    VALUE source;
+    long batch_size;       /* 0 = yield records one by one */
+    VALUE batch;           /* Pending batch (batch_size > 0) */
+    VALUE result;          /* Collected records (load_lines), or Qnil to yield */
+    long lineno;
+} lines_ctx_t;
+
+static bool
+is_blank(const char *p, const char *end)
+{
+    for (; p < end; p++) {
+        if (*p != ' ' && *p != '\t' && *p != '\r') return false;
+    }
+    return true;
+}
+
+static void
+emit(lines_ctx_t *ctx, VALUE obj)
+{
+    if (!NIL_P(ctx->result)) {
+        rb_ary_push(ctx->result, obj);
+    } else if (ctx->batch_size > 0) {
+        rb_ary_push(ctx->batch, obj);
+        if (RARRAY_LEN(ctx->batch) >= ctx->batch_size) {
+            VALUE full = ctx->batch;
+            ctx->batch = rb_ary_new_capa(ctx->batch_size);
+            rb_yield(full);
+        }
+    } else {
+        rb_yield(obj);
+    }
+}
+
+/*
+ * Parse one record (without its newline)
+ */
+static void
+parse_record(lines_ctx_t *ctx, const char *p, size_t len)
+{
+    yyjson_parser_t *parser = ctx->parser;
+    yyjson_read_err err;
+
+    ctx->lineno++;
+    if (is_blank(p, p + len)) return;
+
+    uint64_t start = YYJSON_STATS_START();
+    yyjson_doc *doc = yyjson_read_opts((char *)p, len, parser->flg, ctx->alc, &err);
+    YYJSON_STATS_READ(start, len);
+    if (RB_UNLIKELY(!doc)) {
+        rb_raise(eParseError, "Parse error on line %ld at position %zu: %s",
+                 ctx->lineno, err.pos, err.msg);
+    }
+
+    VALUE obj = yyjson_build_ruby_object_free(doc, &parser->opts);
+    emit(ctx, obj);
+}
+
+/*
+ * Parse every complete line in [p, end); returns the start of the
+ * unterminated tail
+ */
+static const char *
+parse_complete_lines(lines_ctx_t *ctx, const char *p, const char *end)
+{
+    const char *nl;
+    while ((nl = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        parse_record(ctx, p, (size_t)(nl - p));
+        p = nl + 1;
+    }
+    return p;
+}
+
+static void
+each_in_string(lines_ctx_t *ctx, VALUE str)
+{
+    /* Frozen shared copy: the block may mutate the caller's String */
+    VALUE frozen = rb_str_new_frozen(str);
+    const char *start = RSTRING_PTR(frozen);
+    const char *end = start + RSTRING_LEN(frozen);
+
+    const char *tail = parse_complete_lines(ctx, start, end);
+    if (tail < end) parse_record(ctx, tail, (size_t)(end - tail));
+
+    RB_GC_GUARD(frozen);
+}
+
+static void
+each_in_io(lines_ctx_t *ctx, VALUE io)
+{
+    VALUE pending = rb_str_buf_new(LINES_READ_CHUNK);
+    VALUE chunk_len = LONG2NUM(LINES_READ_CHUNK);
+    rb_obj_hide(pending);
+
+    for (;;) {
+        VALUE chunk = rb_funcall(io, id_read, 1, chunk_len);
+        if (NIL_P(chunk)) break;
+        StringValue(chunk);
+
+        rb_str_buf_cat(pending, RSTRING_PTR(chunk), RSTRING_LEN(chunk));
+
+        const char *start = RSTRING_PTR(pending);
+        const char *end = start + RSTRING_LEN(pending);
+        const char *tail = parse_complete_lines(ctx, start, end);
+
+        /* Keep only the unterminated tail */
+        long rest = (long)(end - tail);
+        memmove(RSTRING_PTR(pending), tail, (size_t)rest);
+        rb_str_set_len(pending, rest);
+    }
+
+    if (RSTRING_LEN(pending) > 0) {
+        parse_record(ctx, RSTRING_PTR(pending), (size_t)RSTRING_LEN(pending));
+    }
+    RB_GC_GUARD(pending);
+}
+
+static VALUE
+lines_body(VALUE ptr)
+{
+    lines_ctx_t *ctx = (lines_ctx_t *)ptr;
+
+    if (RB_TYPE_P(ctx->source, T_STRING)) {
+        each_in_string(ctx, ctx->source);
+    } else if (rb_respond_to(ctx->source, id_read)) {
+        each_in_io(ctx, ctx->source);
+    } else {
+        rb_raise(rb_eTypeError, "expected a String or an IO-like object responding to #read, got %s",
+                 rb_obj_classname(ctx->source));
+    }
+
+    if (ctx->batch_size > 0 && RARRAY_LEN(ctx->batch) > 0) {
+        rb_yield(ctx->batch);
+    }
+    return Qnil;
+}
+
+static VALUE
+lines_ensure(VALUE ptr)
+{
+    lines_ctx_t *ctx = (lines_ctx_t *)ptr;
+    yyjson_parser_release(ctx->parser, ctx->alc);
+    return Qnil;
+}
+
+static VALUE
+lines_run(VALUE parser_obj, VALUE source, long batch_size, VALUE result)
+{
+    lines_ctx_t ctx = {
+        .parser_obj = parser_obj,
+        .parser = yyjson_parser_get(parser_obj),
+        .source = source,
+        .batch_size = batch_size,
+        .batch = batch_size > 0 ? rb_ary_new_capa(batch_size) : Qnil,
+        .result = result,
+        .lineno = 0
+    };
+    ctx.alc = yyjson_parser_acquire(ctx.parser);
+
+    rb_ensure(lines_body, (VALUE)&ctx, lines_ensure, (VALUE)&ctx);
+    RB_GC_GUARD(ctx.parser_obj);
+    RB_GC_GUARD(ctx.batch);
+    return result;
+}
+
+static long
+extract_batch_size(VALUE opts)
+{
+    if (NIL_P(opts)) return 0;
+    Check_Type(opts, T_HASH);
+
+    VALUE val = rb_hash_aref(opts, ID2SYM(id_batch_size));
+    if (NIL_P(val) || val == Qfalse) return 0;
+
+    long n = NUM2LONG(val);
+    if (n <= 0) rb_raise(rb_eArgError, "batch_size must be positive");
+    return n;
+}
+
+/*
+ * parser.each_line(source, batch_size: nil) { |obj| ... }
+ *
+ * Parse newline-delimited JSON from a String or an IO (anything with
+ * #read) using this parser's options. Blank lines are skipped. With
+ * :batch_size, yields Arrays of up to that many records instead.
+ *
+ * Returns source, or an Enumerator without a block.
+ */
+static VALUE
+parser_each_line(int argc, VALUE *argv, VALUE self)
+{
+    VALUE source, opts;
+    rb_scan_args(argc, argv, "11", &source, &opts);
+    RETURN_ENUMERATOR(self, argc, argv);
+
+    lines_run(self, source, extract_batch_size(opts), Qnil);
+    return source;
+}
+
+/*
+ * parser.load_lines(source)
+ *
+ * Parse newline-delimited JSON and return an Array of all records.
+ */
+static VALUE
+parser_load_lines(VALUE self, VALUE source)
+{
+    return lines_run(self, source, 0, rb_ary_new());
+}
+
+/*
+ * Temporary parser for the module methods: a private key cache unless
+ * the options pick one
+ */
+static VALUE
+new_lines_parser(VALUE opts)
+{
+    if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+    VALUE parser_opts = NIL_P(opts) ? rb_hash_new() : rb_hash_dup(opts);
+
+    if (rb_hash_lookup2(parser_opts, ID2SYM(id_key_cache), Qundef) == Qundef) {
+        rb_hash_aset(parser_opts, ID2SYM(id_key_cache), Qtrue);
+    }
+    return rb_class_new_instance(1, &parser_opts, cParser);
+}
+
+/*
+ * YYJson.each_line(source, opts = {}) { |obj| ... }
+ *
+ * Parse newline-delimited JSON (NDJSON / JSON Lines) from a String or IO.
+ * Accepts the YYJson.load options plus :batch_size (yield Arrays of up to
+ * that many records). Records share one allocator and key cache.
+ *
+ * Returns source, or an Enumerator without a block.
+ */
+static VALUE
+yyjson_each_line(int argc, VALUE *argv, VALUE self)
+{
+    VALUE source, opts;
+    rb_scan_args(argc, argv, "11", &source, &opts);
+    RETURN_ENUMERATOR(self, argc, argv);
+
+    long batch_size = extract_batch_size(opts);
+    VALUE parser = new_lines_parser(opts);
+    lines_run(parser, source, batch_size, Qnil);
+    return source;
+}
+
+/*
+ * YYJson.load_lines(source, opts = {})
+ *
+ * Parse newline-delimited JSON and return an Array of all records.
+ */
+static VALUE
+yyjson_load_lines(int argc, VALUE *argv, VALUE self)
+{
+    VALUE source, opts;
+    rb_scan_args(argc, argv, "11", &source, &opts);
+
+    VALUE parser = new_lines_parser(opts);
+    return lines_run(parser, source, 0, rb_ary_new());
+}
+
+void
+yyjson_lines_init(void)
+{
+    rb_define_singleton_method(mYYJson, "each_line", yyjson_each_line, -1);
+    rb_define_singleton_method(mYYJson, "load_lines", yyjson_load_lines, -1);
+    rb_define_method(cParser, "each_line", parser_each_line, -1);
+    rb_define_method(cParser, "load_lines", parser_load_lines, 1);
+}
@@ -0,0 +1,16 @@
+/*
+ * lines.h - NDJSON / JSON Lines reader
+ */
+
+#ifndef YYJSON_RUBY_LINES_H
+#define YYJSON_RUBY_LINES_H
+
+#include "common.h"
+
+/*
+ * Define YYJson.each_line/load_lines and Parser#each_line/load_lines
+ * (called from Init_yyjson after the Parser class exists)
+ */
+void yyjson_lines_init(void);
+
+#endif /* YYJSON_RUBY_LINES_H */
@@ -0,0 +1,454 @@
+/*
+ * msgpack.c - MessagePack encoding and decoding
+ *
+ * YYJson.dump_msgpack runs the JSON dumper with opts.msgpack set, so
+ * every type, as_json, Time and mode rule is shared with YYJson.dump.
+ * YYJson.load_msgpack reads the input into an array of yyjson_val laid
+ * out exactly as yyjson lays out a parsed document (pre-order, containers
+ * knowing the size of their subtree), then hands its root to the value
+ * builder: keys, small integers, bulk Hash inserts, freeze, dedup_values
+ * and max_nesting all behave as they do for YYJson.load.
+ */
+
+#include "common.h"
+#include "msgpack.h"
+#include "object_dumper.h"
+#include "writer.h"
+#include "parser.h"
+#include "value_builder.h"
+#include "stats.h"
+#include <ruby/encoding.h>
+#include <math.h>
+
+/* Smallest starting sizes of the value array and the frame stack */
+#define READ_VALS_MIN 64
+#define READ_FRAMES_MIN 16
+
+/*
+ * Whether len bytes are well-formed UTF-8 (no overlong forms, surrogates,
+ * or code points past U+10FFFF)
+ */
+bool
+yyjson_msgpack_utf8_valid(const char *str, size_t len)
+{
+    const uint8_t *s = (const uint8_t *)str;
+    const uint8_t *end = s + len;
+
+    while (s < end) {
+        /* ASCII eight bytes at a time */
+        if (end - s >= 8) {
+            uint64_t word;
+            memcpy(&word, s, sizeof(word));
+            if (!(word & 0x8080808080808080ULL)) {
+                s += 8;
+                continue;
+            }
+        }
+
+        uint8_t c = *s;
+        if (c < 0x80) {
+            s++;
+            continue;
+        }
+
+        size_t n;
+        uint8_t lo = 0x80, hi = 0xbf;  /* Range of the second byte */
+        if (c >= 0xc2 && c <= 0xdf) {
+            n = 2;
+        } else if (c >= 0xe0 && c <= 0xef) {
+            n = 3;
+            if (c == 0xe0) lo = 0xa0;
+            if (c == 0xed) hi = 0x9f;
+        } else if (c >= 0xf0 && c <= 0xf4) {
+            n = 4;
+            if (c == 0xf0) lo = 0x90;
+            if (c == 0xf4) hi = 0x8f;
+        } else {
+            return false;
+        }
+
+        if ((size_t)(end - s) < n) return false;
+        if (s[1] < lo || s[1] > hi) return false;
+        for (size_t i = 2; i < n; i++) {
+            if ((s[i] & 0xc0) != 0x80) return false;
+        }
+        s += n;
+    }
+    return true;
+}
+
+typedef struct {
+    json_buf_t *buf;
+    yyjson_doc *doc;
+} transcode_args;
+
+/*
+ * Write a document's values in order: the layout is pre-order, so each
+ * container's header is followed by its elements (keys and values)
+ */
+static VALUE
+transcode_body(VALUE arg)
+{
+    transcode_args *a = (transcode_args *)arg;
+    yyjson_val *v = a->doc->root;
+    yyjson_val *end = unsafe_yyjson_get_next(v);
+
+    for (; v < end; v++) {
+        uint8_t tag = unsafe_yyjson_get_tag(v);
+        switch (tag & YYJSON_TYPE_MASK) {
+            case YYJSON_TYPE_NULL:
+                json_buf_putc(a->buf, (char)0xc0);
+                break;
+            case YYJSON_TYPE_BOOL:
+                json_buf_putc(a->buf, (tag & YYJSON_SUBTYPE_MASK) ? (char)0xc3 : (char)0xc2);
+                break;
+            case YYJSON_TYPE_NUM:
+                if ((tag & YYJSON_SUBTYPE_MASK) == YYJSON_SUBTYPE_UINT) {
+                    msgpack_write_uint(a->buf, unsafe_yyjson_get_uint(v));
+                } else if ((tag & YYJSON_SUBTYPE_MASK) == YYJSON_SUBTYPE_SINT) {
+                    msgpack_write_sint(a->buf, unsafe_yyjson_get_sint(v));
+                } else {
+                    msgpack_write_f64(a->buf, unsafe_yyjson_get_real(v));
+                }
+                break;
+            case YYJSON_TYPE_STR:
+                msgpack_write_str(a->buf, unsafe_yyjson_get_str(v), unsafe_yyjson_get_len(v));
+                break;
+            case YYJSON_TYPE_ARR:
+                msgpack_write_array_header(a->buf, unsafe_yyjson_get_len(v));
+                break;
+            case YYJSON_TYPE_OBJ:
+                msgpack_write_map_header(a->buf, unsafe_yyjson_get_len(v));
+                break;
+            default:
+                break;
+        }
+    }
+    return Qnil;
+}
+
+static VALUE
+transcode_ensure(VALUE arg)
+{
+    yyjson_doc_free(((transcode_args *)arg)->doc);
+    return Qnil;
+}
+
+void
+yyjson_msgpack_write_json(json_buf_t *buf, VALUE json)
+{
+    yyjson_read_err err;
+    yyjson_doc *doc = yyjson_read_opts(RSTRING_PTR(json), RSTRING_LEN(json), YYJSON_READ_NOFLAG, NULL, &err);
+    if (!doc) {
+        rb_raise(eGenerateError, "Invalid JSON fragment at position %zu: %s", err.pos, err.msg);
+    }
+
+    transcode_args a = { .buf = buf, .doc = doc };
+    rb_ensure(transcode_body, (VALUE)&a, transcode_ensure, (VALUE)&a);
+    RB_GC_GUARD(json);
+}
+
+/*
+ * An open array or map of the input
+ */
+typedef struct {
+    size_t val;              /* Index of its value */
+    size_t left;             /* Items not read yet (keys count, for maps) */
+    bool map;
+} read_frame_t;
+
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *cur;
+    const uint8_t *end;
+    const yyjson_parse_options *opts;
+    yyjson_val *vals;        /* The document, root first (ruby_xmalloc) */
+    size_t len;
+    size_t capa;
+    read_frame_t *frames;    /* Open containers, outermost first (ruby_xmalloc) */
+    size_t depth;
+    size_t frames_capa;
+} msgpack_reader_t;
+
+#define read_error(pos, msg) \
+    rb_raise(eParseError, "Invalid MessagePack at position %zu: " msg, (size_t)(pos))
+
+static inline void
+need(msgpack_reader_t *r, const uint8_t *tok, size_t n)
+{
+    if (RB_UNLIKELY((size_t)(r->end - r->cur) < n)) {
+        read_error(tok - r->start, "unexpected end of data");
+    }
+}
+
+static inline uint64_t
+read_be(msgpack_reader_t *r, const uint8_t *tok, size_t n)
+{
+    need(r, tok, n);
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) v = (v << 8) | r->cur[i];
+    r->cur += n;
+    return v;
+}
+
+static yyjson_val *
+push_val(msgpack_reader_t *r)
+{
+    if (RB_UNLIKELY(r->len == r->capa)) {
+        r->capa *= 2;
+        r->vals = YYJSON_REALLOC_N(r->vals, yyjson_val, r->capa);
+    }
+    return &r->vals[r->len++];
+}
+
+static void
+push_frame(msgpack_reader_t *r, size_t val, size_t items, bool map)
+{
+    if (RB_UNLIKELY(r->depth == r->frames_capa)) {
+        r->frames_capa *= 2;
+        r->frames = YYJSON_REALLOC_N(r->frames, read_frame_t, r->frames_capa);
+    }
+    r->frames[r->depth++] = (read_frame_t){ .val = val, .left = items, .map = map };
+}
+
+/*
+ * A str or bin of len bytes at the cursor
+ */
+static void
+read_bytes(msgpack_reader_t *r, const uint8_t *tok, yyjson_val *v, uint8_t type, size_t len)
+{
+    need(r, tok, len);
+    const char *s = (const char *)r->cur;
+    if (type == YYJSON_TYPE_STR && RB_UNLIKELY(!yyjson_msgpack_utf8_valid(s, len))) {
+        read_error(tok - r->start, "invalid UTF-8 in string");
+    }
+    v->tag = ((uint64_t)len << YYJSON_TAG_BIT) | type;
+    v->uni.str = s;
+    r->cur += len;
+}
+
+static inline void
+set_uint(yyjson_val *v, uint64_t n)
+{
+    v->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_UINT;
+    v->uni.u64 = n;
+}
+
+static inline void
+set_sint(yyjson_val *v, int64_t n)
+{
+    v->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_SINT;
+    v->uni.i64 = n;
+}
+
+static void
+set_real(msgpack_reader_t *r, const uint8_t *tok, yyjson_val *v, double d)
+{
+    if (!r->opts->allow_nan && (isnan(d) || isinf(d))) {
+        read_error(tok - r->start, "NaN and Infinity not allowed");
+    }
+    v->tag = YYJSON_TYPE_NUM | YYJSON_SUBTYPE_REAL;
+    v->uni.f64 = d;
+}
+
+/*
+ * Read one value; an array or map is pushed for its items to follow
+ */
+static void
+read_value(msgpack_reader_t *r, bool key)
+{
+    const uint8_t *tok = r->cur;
+    need(r, tok, 1);
+    uint8_t b = *r->cur++;
+
+    size_t idx = r->len;
+    yyjson_val *v = push_val(r);
+    size_t n = 0;
+    uint8_t ctn = 0;  /* YYJSON_TYPE_ARR or _OBJ for containers */
+
+    if (b <= 0x7f) {
+        set_uint(v, b);
+    } else if (b <= 0x8f) {
+        ctn = YYJSON_TYPE_OBJ;
+        n = b & 0x0f;
+    } else if (b <= 0x9f) {
+        ctn = YYJSON_TYPE_ARR;
+        n = b & 0x0f;
+    } else if (b <= 0xbf) {
+        read_bytes(r, tok, v, YYJSON_TYPE_STR, b & 0x1f);
+    } else if (b >= 0xe0) {
+        set_sint(v, (int8_t)b);
+    } else {
+        switch (b) {
+            case 0xc0: v->tag = YYJSON_TYPE_NULL; break;
+            case 0xc2: v->tag = YYJSON_TYPE_BOOL | YYJSON_SUBTYPE_FALSE; break;
+            case 0xc3: v->tag = YYJSON_TYPE_BOOL | YYJSON_SUBTYPE_TRUE; break;
+            case 0xc4: read_bytes(r, tok, v, YYJSON_TYPE_RAW, read_be(r, tok, 1)); break;
+            case 0xc5: read_bytes(r, tok, v, YYJSON_TYPE_RAW, read_be(r, tok, 2)); break;
+            case 0xc6: read_bytes(r, tok, v, YYJSON_TYPE_RAW, read_be(r, tok, 4)); break;
+            case 0xca: {
+                uint32_t bits = (uint32_t)read_be(r, tok, 4);
+                float f;
+                memcpy(&f, &bits, sizeof(f));
+                set_real(r, tok, v, f);
+                break;
+            }
+            case 0xcb: {
+                uint64_t bits = read_be(r, tok, 8);
+                double d;
+                memcpy(&d, &bits, sizeof(d));
+                set_real(r, tok, v, d);
+                break;
+            }
+            case 0xcc: set_uint(v, read_be(r, tok, 1)); break;
+            case 0xcd: set_uint(v, read_be(r, tok, 2)); break;
+            case 0xce: set_uint(v, read_be(r, tok, 4)); break;
+            case 0xcf: set_uint(v, read_be(r, tok, 8)); break;
+            case 0xd0: set_sint(v, (int8_t)read_be(r, tok, 1)); break;
+            case 0xd1: set_sint(v, (int16_t)read_be(r, tok, 2)); break;
+            case 0xd2: set_sint(v, (int32_t)read_be(r, tok, 4)); break;
+            case 0xd3: set_sint(v, (int64_t)read_be(r, tok, 8)); break;
+            case 0xd9: read_bytes(r, tok, v, YYJSON_TYPE_STR, read_be(r, tok, 1)); break;
+            case 0xda: read_bytes(r, tok, v, YYJSON_TYPE_STR, read_be(r, tok, 2)); break;
+            case 0xdb: read_bytes(r, tok, v, YYJSON_TYPE_STR, read_be(r, tok, 4)); break;
+            case 0xdc: ctn = YYJSON_TYPE_ARR; n = read_be(r, tok, 2); break;
+            case 0xdd: ctn = YYJSON_TYPE_ARR; n = read_be(r, tok, 4); break;
+            case 0xde: ctn = YYJSON_TYPE_OBJ; n = read_be(r, tok, 2); break;
+            case 0xdf: ctn = YYJSON_TYPE_OBJ; n = read_be(r, tok, 4); break;
+            case 0xc1:
+                read_error(tok - r->start, "invalid type byte 0xc1");
+            default:
+                /* ext 8/16/32 and fixext 1-16 */
+                read_error(tok - r->start, "unsupported extension type");
+        }
+    }
+
+    if (key && (ctn || (unsafe_yyjson_get_tag(v) & YYJSON_TYPE_MASK) != YYJSON_TYPE_STR)) {
+        read_error(tok - r->start, "map keys must be strings");
+    }
+    if (!ctn) return;
+
+    v->tag = ((uint64_t)n << YYJSON_TAG_BIT) | ctn;
+    v->uni.ofs = sizeof(yyjson_val);
+    if (n > 0) push_frame(r, idx, ctn == YYJSON_TYPE_OBJ ? n * 2 : n, ctn == YYJSON_TYPE_OBJ);
+}
+
+/*
+ * Read the whole input as one value
+ */
+static void
+read_document(msgpack_reader_t *r)
+{
+    do {
+        bool key = false;
+        if (r->depth > 0) {
+            read_frame_t *f = &r->frames[r->depth - 1];
+            key = f->map && (f->left & 1) == 0;
+            f->left--;
+        }
+        read_value(r, key);
+
+        /* Close completed containers: their subtree ends here */
+        while (r->depth > 0 && r->frames[r->depth - 1].left == 0) {
+            size_t val = r->frames[--r->depth].val;
+            r->vals[val].uni.ofs = (r->len - val) * sizeof(yyjson_val);
+        }
+    } while (r->depth > 0);
+
+    if (r->cur != r->end) {
+        read_error(r->cur - r->start, "unexpected data after the value");
+    }
+}
+
+static VALUE
+load_body(VALUE arg)
+{
+    msgpack_reader_t *r = (msgpack_reader_t *)arg;
+
+    uint64_t start = YYJSON_STATS_START();
+    read_document(r);
+    YYJSON_STATS_READ(start, (size_t)(r->end - r->start));
+
+    return yyjson_build_ruby_value(r->vals, r->opts);
+}
+
+static VALUE
+load_ensure(VALUE arg)
+{
+    msgpack_reader_t *r = (msgpack_reader_t *)arg;
+    YYJSON_FREE(r->vals);
+    YYJSON_FREE(r->frames);
+    return Qnil;
+}
+
+/*
+ * YYJson.load_msgpack(bytes, opts = {})
+ *
+ * Decode MessagePack into the Ruby objects YYJson.load builds for the
+ * equivalent JSON, taking the same options. Map keys must be strings;
+ * bin values load as binary (ASCII-8BIT) Strings, and extension types
+ * raise ParseError.
+ */
+static VALUE
+yyjson_load_msgpack(int argc, VALUE *argv, VALUE self)
+{
+    VALUE bytes, opts;
+    rb_scan_args(argc, argv, "11", &bytes, &opts);
+
+    StringValue(bytes);
+    yyjson_parse_options parse_opts;
+    yyjson_extract_parse_options(opts, &parse_opts);
+
+    /* Strings point into the input while building: hold it unchanged */
+    VALUE src = rb_str_new_frozen(bytes);
+    size_t len = (size_t)RSTRING_LEN(src);
+    const uint8_t *ptr = (const uint8_t *)RSTRING_PTR(src);
+
+    /* Most values take a few bytes: grows by doubling from here */
+    size_t capa = len / 4 > READ_VALS_MIN ? len / 4 : READ_VALS_MIN;
+    msgpack_reader_t r = {
+        .start = ptr, .cur = ptr, .end = ptr + len,
+        .opts = &parse_opts,
+        .vals = NULL, .len = 0, .capa = capa,
+        .frames = NULL, .depth = 0, .frames_capa = READ_FRAMES_MIN
+    };
+    r.vals = YYJSON_ALLOC_N(yyjson_val, capa);
+    r.frames = YYJSON_ALLOC_N(read_frame_t, READ_FRAMES_MIN);
+
+    VALUE result = rb_ensure(load_body, (VALUE)&r, load_ensure, (VALUE)&r);
+    RB_GC_GUARD(src);
+    return result;
+}
+
+/*
+ * YYJson.dump_msgpack(obj, opts = {})
+ *
+ * Encode obj as MessagePack, converting every object as YYJson.dump
+ * would (:mode, :allow_nan, :check_circular and :time_precision apply;
+ * the text formatting options don't). Integers use their shortest form,
+ * Floats float64, and binary (ASCII-8BIT) Strings bin.
+ *
+ * Returns a binary String.
+ */
+static VALUE
+yyjson_dump_msgpack(int argc, VALUE *argv, VALUE self)
+{
+    VALUE obj, opts;
+    rb_scan_args(argc, argv, "11", &obj, &opts);
+
+    yyjson_dump_options dump_opts;
+    yyjson_extract_dump_options(opts, &dump_opts);
+    dump_opts.msgpack = true;
+    dump_opts.pretty = false;
+
+    VALUE str = yyjson_ruby_write_string(obj, &dump_opts);
+    rb_enc_associate_index(str, rb_ascii8bit_encindex());
+    return str;
+}
+
+void
+yyjson_msgpack_init(void)
+{
+    rb_define_singleton_method(mYYJson, "dump_msgpack", yyjson_dump_msgpack, -1);
+    rb_define_singleton_method(mYYJson, "load_msgpack", yyjson_load_msgpack, -1);
+}
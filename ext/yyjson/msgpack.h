@@ -0,0 +1,192 @@
+/*
+ * msgpack.h - MessagePack encoding and decoding (YYJson.dump_msgpack,
+ * YYJson.load_msgpack)
+ *
+ * The encoder is object_dumper.c with yyjson_dump_options.msgpack set: the
+ * same dispatch writes these tokens instead of JSON ones. The decoder
+ * lays MessagePack out as a yyjson value tree, which value_builder.c
+ * turns into Ruby objects as it does parsed JSON.
+ */
+
+#ifndef YYJSON_RUBY_MSGPACK_H
+#define YYJSON_RUBY_MSGPACK_H
+
+#include "common.h"
+#include "json_buffer.h"
+
+/* Longest int, float or container header token */
+#define MSGPACK_TOKEN_MAX 9
+
+static inline char *
+msgpack_put_be16(char *cur, uint16_t v)
+{
+    cur[0] = (char)(v >> 8);
+    cur[1] = (char)v;
+    return cur + 2;
+}
+
+static inline char *
+msgpack_put_be32(char *cur, uint32_t v)
+{
+    cur[0] = (char)(v >> 24);
+    cur[1] = (char)(v >> 16);
+    cur[2] = (char)(v >> 8);
+    cur[3] = (char)v;
+    return cur + 4;
+}
+
+static inline char *
+msgpack_put_be64(char *cur, uint64_t v)
+{
+    cur = msgpack_put_be32(cur, (uint32_t)(v >> 32));
+    return msgpack_put_be32(cur, (uint32_t)v);
+}
+
+/*
+ * A non-negative integer in its shortest form
+ */
+static inline void
+msgpack_write_uint(json_buf_t *buf, uint64_t v)
+{
+    char *cur = json_buf_reserve(buf, MSGPACK_TOKEN_MAX);
+    if (v < 0x80) {
+        *cur++ = (char)v;
+    } else if (v <= UINT8_MAX) {
+        *cur++ = (char)0xcc;
+        *cur++ = (char)v;
+    } else if (v <= UINT16_MAX) {
+        *cur++ = (char)0xcd;
+        cur = msgpack_put_be16(cur, (uint16_t)v);
+    } else if (v <= UINT32_MAX) {
+        *cur++ = (char)0xce;
+        cur = msgpack_put_be32(cur, (uint32_t)v);
+    } else {
+        *cur++ = (char)0xcf;
+        cur = msgpack_put_be64(cur, v);
+    }
+    buf->cur = cur;
+}
+
+/*
+ * An integer in its shortest form (non-negative ones as uint)
+ */
+static inline void
+msgpack_write_sint(json_buf_t *buf, int64_t v)
+{
+    if (v >= 0) {
+        msgpack_write_uint(buf, (uint64_t)v);
+        return;
+    }
+
+    char *cur = json_buf_reserve(buf, MSGPACK_TOKEN_MAX);
+    if (v >= -32) {
+        *cur++ = (char)(uint8_t)v;
+    } else if (v >= INT8_MIN) {
+        *cur++ = (char)0xd0;
+        *cur++ = (char)(uint8_t)v;
+    } else if (v >= INT16_MIN) {
+        *cur++ = (char)0xd1;
+        cur = msgpack_put_be16(cur, (uint16_t)v);
+    } else if (v >= INT32_MIN) {
+        *cur++ = (char)0xd2;
+        cur = msgpack_put_be32(cur, (uint32_t)v);
+    } else {
+        *cur++ = (char)0xd3;
+        cur = msgpack_put_be64(cur, (uint64_t)v);
+    }
+    buf->cur = cur;
+}
+
+/*
+ * A Float, always as float64 (as JSON numbers load)
+ */
+static inline void
+msgpack_write_f64(json_buf_t *buf, double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+
+    char *cur = json_buf_reserve(buf, MSGPACK_TOKEN_MAX);
+    *cur++ = (char)0xcb;
+    buf->cur = msgpack_put_be64(cur, bits);
+}
+
+/*
+ * A length header: fix is the fix* type byte (0 if there is none, as for
+ * bin) and fix_max the longest length it holds; wide8 is the 8-bit form's
+ * type byte (0 if there is none, as for array and map) and wide16 the
+ * 16-bit form's, which the 32-bit form's follows
+ */
+static inline void
+msgpack_write_header(json_buf_t *buf, uint8_t fix, size_t fix_max, uint8_t wide8, uint8_t wide16,
+                     size_t len)
+{
+    if (RB_UNLIKELY(len > UINT32_MAX)) {
+        RAISE_GENERATE_ERROR("Failed to write MessagePack: string or container too large");
+    }
+
+    char *cur = json_buf_reserve(buf, MSGPACK_TOKEN_MAX);
+    if (fix && len <= fix_max) {
+        *cur++ = (char)(fix | len);
+    } else if (wide8 && len <= UINT8_MAX) {
+        *cur++ = (char)wide8;
+        *cur++ = (char)len;
+    } else if (len <= UINT16_MAX) {
+        *cur++ = (char)wide16;
+        cur = msgpack_put_be16(cur, (uint16_t)len);
+    } else {
+        *cur++ = (char)(wide16 + 1);
+        cur = msgpack_put_be32(cur, (uint32_t)len);
+    }
+    buf->cur = cur;
+}
+
+static inline void
+msgpack_write_array_header(json_buf_t *buf, size_t len)
+{
+    msgpack_write_header(buf, 0x90, 15, 0, 0xdc, len);
+}
+
+static inline void
+msgpack_write_map_header(json_buf_t *buf, size_t len)
+{
+    msgpack_write_header(buf, 0x80, 15, 0, 0xde, len);
+}
+
+/*
+ * A str of len UTF-8 bytes (not checked here)
+ */
+static inline void
+msgpack_write_str(json_buf_t *buf, const char *s, size_t len)
+{
+    msgpack_write_header(buf, 0xa0, 31, 0xd9, 0xda, len);
+    json_buf_write(buf, s, len);
+}
+
+static inline void
+msgpack_write_bin(json_buf_t *buf, const char *s, size_t len)
+{
+    msgpack_write_header(buf, 0, 0, 0xc4, 0xc5, len);
+    json_buf_write(buf, s, len);
+}
+
+/*
+ * Whether len bytes are well-formed UTF-8
+ */
+bool yyjson_msgpack_utf8_valid(const char *s, size_t len);
+
+/*
+ * Transcode JSON text (a YYJson::Fragment's) to MessagePack
+ *
+ * @param buf The output buffer to append to
+ * @param json The JSON document; raises GenerateError if it is invalid
+ */
+void yyjson_msgpack_write_json(json_buf_t *buf, VALUE json);
+
+/*
+ * Define YYJson.dump_msgpack and YYJson.load_msgpack (called from
+ * Init_yyjson)
+ */
+void yyjson_msgpack_init(void);
+
+#endif /* YYJSON_RUBY_MSGPACK_H */
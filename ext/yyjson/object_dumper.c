@@ -1,116 +1,340 @@
 /*
  * object_dumper.c - Ruby to JSON object conversion
  *
- * Converts Ruby objects to yyjson mutable values for JSON generation.
+ * Walks Ruby objects and writes JSON text straight into a json_buf_t,
+ * without building an intermediate yyjson_mut_doc. Tokens are formatted
+ * by the vendored yyjson writer (see emit.h), so the output is identical
+ * to yyjson_mut_write. The same walk writes MessagePack for
+ * YYJson.dump_msgpack: only the leaf writers branch on the format.
+ * canonical: true also sorts each Hash's pairs before writing them.
  */
 
 #include "common.h"
 #include "object_dumper.h"
+#include "emit.h"
+#include "dispatch.h"
+#include "class_registry.h"
+#include "fragment.h"
+#include "stats.h"
+#include "msgpack.h"
+#include "canonical.h"
 #include <ruby/encoding.h>
 #include <math.h>
 
 /* Maximum nesting depth to prevent stack overflow */
 #define MAX_NESTING_DEPTH 100
 
+/* Spaces per indentation level in pretty mode (YYJSON_WRITE_PRETTY_TWO_SPACES) */
+#define PRETTY_INDENT 2
+
+/* Strings longer than this are escaped in pieces of this size, so the
+ * worst-case escape reservation (6x) stays small */
+#define STR_CHUNK 65536
+
+/* Escaped key cache geometry (slots must be a power of two) */
+#define KEY_CACHE_SLOTS 128
+#define KEY_CACHE_BYTES 8192
+#define KEY_CACHE_ENTRY_MAX 256
+
+/*
+ * Escaped Hash keys of one dump, by key object
+ *
+ * Arrays of Hashes sharing keys (serialized relations) write the same key
+ * objects over and over: each is escaped once, with its separator, and
+ * later copied from here. Only frozen Strings (every String Hash key, as
+ * Hash#[]= freezes them) and Symbols are cached, so identity means equal
+ * bytes. Lives in ALLOCV memory, which the GC marks conservatively: the
+ * cached keys are pinned and can't be moved or recycled mid-dump.
+ */
+typedef struct {
+    VALUE keys[KEY_CACHE_SLOTS];     /* 0 = empty slot */
+    uint32_t off[KEY_CACHE_SLOTS];   /* Entry bytes in `bytes` */
+    uint32_t len[KEY_CACHE_SLOTS];
+    size_t used;
+    char bytes[KEY_CACHE_BYTES];     /* "key": (pretty: "key": , MessagePack: the str) */
+} dump_key_cache_t;
+
+/* Sort permutation cache geometry (slots must be a power of two; a shape
+ * goes in either slot of its pair) */
+#define SORT_CACHE_SLOTS 16
+#define SORT_CACHE_KEYS_MAX 32
+
+/*
+ * Canonical key orders of one dump, by key shape
+ *
+ * Rows of Hashes built alike iterate the same key objects in the same
+ * order, so their sorting permutation is computed once per shape. Shapes
+ * are compared by key identity, cached under the same rules (and in the
+ * same pinning ALLOCV memory) as dump_key_cache_t. Two slots per hash,
+ * so a row and the Hash nested in it can't keep evicting each other.
+ */
+typedef struct {
+    long count;                          /* Keys in the shape (0 = empty slot) */
+    VALUE keys[SORT_CACHE_KEYS_MAX];     /* In iteration order */
+    uint8_t order[SORT_CACHE_KEYS_MAX];  /* Iteration indexes in key order */
+} dump_sort_entry_t;
+
+typedef struct {
+    dump_sort_entry_t slots[SORT_CACHE_SLOTS];
+} dump_sort_cache_t;
+
 /*
  * Context for tracking circular references and nesting depth
  */
 typedef struct {
-    yyjson_mut_doc *doc;
+    json_buf_t *buf;
     const yyjson_dump_options *opts;
+    yyjson_write_flag flg;  /* yyjson flags for number/string tokens */
+    bool msgpack;           /* opts->msgpack */
+    bool canonical;         /* opts->canonical */
     int depth;
-    VALUE visited;  /* Hash for circular reference detection */
+    dump_key_cache_t *keys; /* Set up by the first Array of Hashes (NULL until then) */
+    VALUE keys_holder;      /* ALLOCV holder of `keys` */
+    dump_sort_cache_t *sorts; /* Canonical: set up with `keys` */
+    VALUE sorts_holder;     /* ALLOCV holder of `sorts` */
+    /* Containers being dumped, outermost first: stack[i] is at depth i */
+    VALUE stack[MAX_NESTING_DEPTH + 1];
 } dump_context;
 
 /*
  * Forward declaration
  */
-static yyjson_mut_val *dump_ruby_object(VALUE obj, dump_context *ctx);
+static void dump_ruby_object(VALUE obj, dump_context *ctx);
+static void dump_dispatched(VALUE obj, dispatch_entry_t d, dump_context *ctx);
 
 /*
- * Check for circular references
+ * Check the nesting limit and for circular references, then push a
+ * container
+ *
+ * An object is circular exactly when it is one of its own ancestors, and
+ * the ancestors are the (at most MAX_NESTING_DEPTH) containers on the
+ * stack, so a linear scan of raw VALUEs is enough: no object ids, no Hash.
+ * The stack lives in the C frame, where the GC sees it.
  */
-static void
-check_circular_reference(VALUE obj, dump_context *ctx)
+static inline void
+enter_container(VALUE obj, dump_context *ctx)
 {
-    if (ctx->depth > MAX_NESTING_DEPTH) {
+    if (RB_UNLIKELY(ctx->depth > MAX_NESTING_DEPTH)) {
         rb_raise(eGenerateError, "nesting of %d is too deep", ctx->depth);
     }
 
-    /* Only check for collections (Array, Hash) */
-    if (TYPE(obj) != T_ARRAY && TYPE(obj) != T_HASH) {
-        return;
+    if (ctx->opts->check_circular) {
+        for (int i = 0; i < ctx->depth; i++) {
+            if (RB_UNLIKELY(ctx->stack[i] == obj)) {
+                rb_raise(eGenerateError, "circular reference detected");
+            }
+        }
     }
 
-    /* Check if we've seen this object before */
-    VALUE obj_id = rb_obj_id(obj);
-    if (rb_hash_lookup(ctx->visited, obj_id) != Qnil) {
-        rb_raise(eGenerateError, "circular reference detected");
-    }
+    ctx->stack[ctx->depth++] = obj;
+}
 
-    /* Mark as visited */
-    rb_hash_aset(ctx->visited, obj_id, Qtrue);
+/*
+ * Pop the container pushed by enter_container()
+ */
+static inline void
+leave_container(dump_context *ctx)
+{
+    ctx->depth--;
+}
+
+/*
+ * Write a newline and indentation for the given level (pretty mode)
+ */
+static inline void
+write_indent(dump_context *ctx, int level)
+{
+    size_t n = (size_t)level * PRETTY_INDENT;
+    char *cur = json_buf_reserve(ctx->buf, n + 1);
+    *cur++ = '\n';
+    memset(cur, ' ', n);
+    ctx->buf->cur = cur + n;
 }
 
 /*
- * Unmark object as visited (for backtracking)
+ * Write UTF-8 bytes as a quoted, escaped JSON string
  */
 static void
-unmark_visited(VALUE obj, dump_context *ctx)
+write_long_str(const char *cstr, size_t len, dump_context *ctx)
+{
+    json_buf_putc(ctx->buf, '"');
+    while (len > 0) {
+        size_t n = len;
+        if (n > STR_CHUNK) {
+            /* Don't split a UTF-8 sequence (cstr[n] starts the next piece) */
+            n = STR_CHUNK;
+            while (n > STR_CHUNK - 4 && ((unsigned char)cstr[n] & 0xC0) == 0x80) n--;
+        }
+
+        char *start = json_buf_reserve(ctx->buf, YYJSON_EMIT_STR_MAX(n));
+        char *cur = yyjson_emit_str_part(start, cstr, n, ctx->flg);
+        if (!cur) {
+            RAISE_GENERATE_ERROR("Failed to write JSON: invalid UTF-8 encoding in string");
+        }
+        if (ctx->canonical && (size_t)(cur - start) > n) yyjson_canonical_lower_escapes(start, cur);
+        ctx->buf->cur = cur;
+        cstr += n;
+        len -= n;
+    }
+    json_buf_putc(ctx->buf, '"');
+}
+
+static void
+write_str(const char *cstr, size_t len, dump_context *ctx)
 {
-    if (TYPE(obj) != T_ARRAY && TYPE(obj) != T_HASH) {
+    if (RB_UNLIKELY(len > STR_CHUNK)) {
+        write_long_str(cstr, len, ctx);
         return;
     }
 
-    VALUE obj_id = rb_obj_id(obj);
-    rb_hash_delete(ctx->visited, obj_id);
+    char *start = json_buf_reserve(ctx->buf, YYJSON_EMIT_STR_MAX(len));
+    char *cur = yyjson_emit_str(start, cstr, len, ctx->flg);
+    if (!cur) {
+        RAISE_GENERATE_ERROR("Failed to write JSON: invalid UTF-8 encoding in string");
+    }
+    /* Only strings that grew have escapes */
+    if (ctx->canonical && (size_t)(cur - start) > len + 2) yyjson_canonical_lower_escapes(start, cur);
+    ctx->buf->cur = cur;
 }
 
 /*
- * Dump Ruby String to JSON string
+ * A String's bytes as UTF-8
+ *
+ * UTF-8, US-ASCII and 7-bit strings are used as they are (their bytes are
+ * validated while escaping); only other encodings are transcoded.
  */
-static yyjson_mut_val *
-dump_string(VALUE str, dump_context *ctx)
+static inline VALUE
+utf8_str(VALUE str)
+{
+    int encidx = RB_ENCODING_GET_INLINED(str);
+    if (RB_LIKELY(encidx == rb_utf8_encindex() || encidx == rb_usascii_encindex())) {
+        return str;
+    }
+    if (rb_enc_str_coderange(str) == ENC_CODERANGE_7BIT) return str;
+    return rb_str_export_to_enc(str, rb_utf8_encoding());
+}
+
+/*
+ * Write a String from utf8_str() as a MessagePack str
+ *
+ * Its bytes must be UTF-8, as in JSON: the coderange is cached on the
+ * String, and binary ones (JSON takes their bytes as UTF-8) are scanned.
+ */
+static void
+write_msgpack_str(VALUE str, dump_context *ctx)
 {
-    /* Ensure string is UTF-8 */
-    str = rb_str_export_to_enc(str, rb_utf8_encoding());
+    const char *s = RSTRING_PTR(str);
+    long len = RSTRING_LEN(str);
+    int cr = ENC_CODERANGE(str);
+    if (cr == ENC_CODERANGE_UNKNOWN) cr = rb_enc_str_coderange(str);
 
-    const char *cstr = RSTRING_PTR(str);
-    size_t len = RSTRING_LEN(str);
+    if (cr == ENC_CODERANGE_BROKEN ||
+        (cr != ENC_CODERANGE_7BIT && RB_ENCODING_GET_INLINED(str) == rb_ascii8bit_encindex() &&
+         !yyjson_msgpack_utf8_valid(s, (size_t)len))) {
+        RAISE_GENERATE_ERROR("Failed to write MessagePack: invalid UTF-8 encoding in string");
+    }
+    msgpack_write_str(ctx->buf, s, (size_t)len);
+}
+
+/*
+ * Dump Ruby String to JSON string (MessagePack: binary Strings as bin)
+ */
+static void
+dump_string(VALUE str, dump_context *ctx)
+{
+    if (ctx->msgpack) {
+        if (RB_ENCODING_GET_INLINED(str) == rb_ascii8bit_encindex()) {
+            msgpack_write_bin(ctx->buf, RSTRING_PTR(str), (size_t)RSTRING_LEN(str));
+        } else {
+            write_msgpack_str(utf8_str(str), ctx);
+        }
+        return;
+    }
 
-    return yyjson_mut_strncpy(ctx->doc, cstr, len);
+    str = utf8_str(str);
+    write_str(RSTRING_PTR(str), RSTRING_LEN(str), ctx);
+    RB_GC_GUARD(str);
 }
 
 /*
  * Dump Ruby Symbol to JSON string
  */
-static yyjson_mut_val *
+static void
 dump_symbol(VALUE sym, dump_context *ctx)
 {
-    const char *cstr = rb_id2name(SYM2ID(sym));
-    return yyjson_mut_str(ctx->doc, cstr);
+    VALUE str = rb_sym2str(sym);
+    if (ctx->msgpack) {
+        write_msgpack_str(str, ctx);
+        return;
+    }
+    write_str(RSTRING_PTR(str), RSTRING_LEN(str), ctx);
+}
+
+/*
+ * Dump Ruby Integer to MessagePack int (or float64 beyond 64 bits, which
+ * is what their JSON digits load as)
+ */
+static void
+dump_msgpack_integer(VALUE num, dump_context *ctx)
+{
+    if (RB_LIKELY(FIXNUM_P(num))) {
+        msgpack_write_sint(ctx->buf, (int64_t)FIX2LONG(num));
+        return;
+    }
+
+    uint64_t mag;
+    int sign = rb_integer_pack(num, &mag, 1, sizeof(mag), 0, INTEGER_PACK_NATIVE_BYTE_ORDER);
+
+    if (sign == 1) {
+        msgpack_write_uint(ctx->buf, mag);
+    } else if (sign == -1 && mag <= (uint64_t)INT64_MAX + 1) {
+        msgpack_write_sint(ctx->buf, -(int64_t)(mag - 1) - 1);
+    } else {
+        msgpack_write_f64(ctx->buf, rb_big2dbl(num));
+    }
 }
 
 /*
  * Dump Ruby Integer to JSON number
  */
-static yyjson_mut_val *
+static void
 dump_integer(VALUE num, dump_context *ctx)
 {
-    if (FIXNUM_P(num)) {
-        long val = FIX2LONG(num);
-        return yyjson_mut_sint(ctx->doc, val);
+    char *cur;
+
+    if (ctx->msgpack) {
+        dump_msgpack_integer(num, ctx);
+        return;
+    }
+
+    if (RB_LIKELY(FIXNUM_P(num))) {
+        cur = json_buf_reserve(ctx->buf, YYJSON_EMIT_NUM_MAX);
+        ctx->buf->cur = yyjson_emit_sint(cur, (int64_t)FIX2LONG(num));
+        return;
+    }
+
+    /* Bignum: magnitude and sign, without allocating when it fits 64 bits */
+    uint64_t mag;
+    int sign = rb_integer_pack(num, &mag, 1, sizeof(mag), 0, INTEGER_PACK_NATIVE_BYTE_ORDER);
+
+    if (sign == 1) {
+        cur = json_buf_reserve(ctx->buf, YYJSON_EMIT_NUM_MAX);
+        ctx->buf->cur = yyjson_emit_uint(cur, mag);
+    } else if (sign == -1 && mag <= (uint64_t)INT64_MAX + 1) {
+        cur = json_buf_reserve(ctx->buf, YYJSON_EMIT_NUM_MAX);
+        ctx->buf->cur = yyjson_emit_sint(cur, -(int64_t)(mag - 1) - 1);
     } else {
-        /* Bignum - convert to int64 if possible */
-        long long val = NUM2LL(num);
-        return yyjson_mut_sint(ctx->doc, val);
+        /* Wider than 64 bits: exact decimal digits as a raw number */
+        VALUE str = rb_big2str(num, 10);
+        json_buf_write(ctx->buf, RSTRING_PTR(str), (size_t)RSTRING_LEN(str));
+        RB_GC_GUARD(str);
     }
 }
 
 /*
  * Dump Ruby Float to JSON number
  */
-static yyjson_mut_val *
+static void
 dump_float(VALUE num, dump_context *ctx)
 {
     double val = NUM2DBL(num);
@@ -122,226 +346,985 @@ dump_float(VALUE num, dump_context *ctx)
         }
     }
 
-    return yyjson_mut_real(ctx->doc, val);
+    if (ctx->msgpack) {
+        msgpack_write_f64(ctx->buf, val);
+        return;
+    }
+
+    if (ctx->canonical) {
+        /* yyjson's shortest digits, laid out as ECMAScript does */
+        char num[YYJSON_EMIT_NUM_MAX];
+        char *end = yyjson_emit_f64(num, val, ctx->flg);
+        char *cur = json_buf_reserve(ctx->buf, YYJSON_EMIT_NUM_MAX + CANONICAL_NUM_EXTRA);
+        if (end) cur = yyjson_canonical_number(cur, num, (size_t)(end - num));
+        if (!end || !cur) {
+            RAISE_GENERATE_ERROR("Failed to write JSON: invalid number");
+        }
+        ctx->buf->cur = cur;
+        return;
+    }
+
+    char *cur = json_buf_reserve(ctx->buf, YYJSON_EMIT_NUM_MAX);
+    cur = yyjson_emit_f64(cur, val, ctx->flg);
+    if (!cur) {
+        RAISE_GENERATE_ERROR("Failed to write JSON: invalid number");
+    }
+    ctx->buf->cur = cur;
+}
+
+/*
+ * Write a BigDecimal as an exact raw number (its to_s, e.g. 0.15e1);
+ * MessagePack has no decimals, so there it is the float64 the JSON loads as
+ */
+static void
+dump_bigdecimal(VALUE num, dump_context *ctx)
+{
+    VALUE str = rb_funcall(num, id_to_s, 0);
+    const char *s = RSTRING_PTR(str);
+    long len = RSTRING_LEN(str);
+
+    /* NaN / Infinity / -Infinity: same rules and spelling as Float */
+    const char *digits = (len > 1 && s[0] == '-') ? s + 1 : s;
+    if (len == 0 || *digits < '0' || *digits > '9') {
+        if (!ctx->opts->allow_nan) {
+            rb_raise(eGenerateError, "NaN and Infinity not allowed in JSON");
+        }
+    }
+
+    if (ctx->msgpack) {
+        msgpack_write_f64(ctx->buf, NUM2DBL(rb_funcall(num, rb_intern("to_f"), 0)));
+    } else if (ctx->canonical) {
+        /* Same digits, in the layout a Float of that value gets */
+        char *cur = json_buf_reserve(ctx->buf, (size_t)len + CANONICAL_NUM_EXTRA);
+        cur = yyjson_canonical_number(cur, s, (size_t)len);
+        if (!cur) {
+            RAISE_GENERATE_ERROR("Failed to write JSON: invalid number");
+        }
+        ctx->buf->cur = cur;
+    } else {
+        json_buf_write(ctx->buf, s, (size_t)len);
+    }
+    RB_GC_GUARD(str);
+}
+
+/*
+ * Proleptic Gregorian date of a day count from 1970-01-01
+ * (H. Hinnant's civil_from_days)
+ */
+static void
+civil_from_days(int64_t z, int64_t *year, int *month, int *day)
+{
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+
+    *day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *year = (int64_t)yoe + era * 400 + (*month <= 2);
+}
+
+static inline char *
+put_digits(char *cur, unsigned long val, int width)
+{
+    for (int i = width - 1; i >= 0; i--) {
+        cur[i] = (char)('0' + val % 10);
+        val /= 10;
+    }
+    return cur + width;
+}
+
+/* "YYYY-MM-DD" */
+static inline char *
+put_date(char *cur, int64_t year, int month, int day)
+{
+    cur = put_digits(cur, (unsigned long)year, 4);
+    *cur++ = '-';
+    cur = put_digits(cur, (unsigned long)month, 2);
+    *cur++ = '-';
+    return put_digits(cur, (unsigned long)day, 2);
+}
+
+/* Longest native timestamp: "YYYY-MM-DDTHH:MM:SS.nnnnnnnnn+HH:MM" */
+#define TIME_STR_MAX 36
+
+/*
+ * Write formatted ASCII text (a timestamp) as a string token
+ */
+static void
+write_plain_str(const char *s, size_t len, dump_context *ctx)
+{
+    if (ctx->msgpack) {
+        msgpack_write_str(ctx->buf, s, len);
+        return;
+    }
+
+    char *cur = json_buf_reserve(ctx->buf, len + 2);
+    *cur++ = '"';
+    memcpy(cur, s, len);
+    cur[len] = '"';
+    ctx->buf->cur = cur + len + 1;
+}
+
+/*
+ * Write a Time as ISO 8601 with ctx->opts->time_precision fraction
+ * digits, like Time#iso8601(n), straight from its timespec
+ *
+ * Returns false (writing nothing) for years outside 0000-9999.
+ */
+static bool
+write_time(VALUE time, dump_context *ctx)
+{
+    struct timespec ts = rb_time_timespec(time);
+    bool utc = RTEST(rb_funcall(time, rb_intern("utc?"), 0));
+    long offset = utc ? 0 : NUM2LONG(rb_time_utc_offset(time));
+
+    int64_t local = (int64_t)ts.tv_sec + offset;
+    int64_t days = local / 86400;
+    int64_t secs = local % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        days--;
+    }
+
+    int64_t year;
+    int month, day;
+    civil_from_days(days, &year, &month, &day);
+    if (year < 0 || year > 9999) return false;
+
+    char str[TIME_STR_MAX];
+    char *cur = put_date(str, year, month, day);
+    *cur++ = 'T';
+    cur = put_digits(cur, (unsigned long)(secs / 3600), 2);
+    *cur++ = ':';
+    cur = put_digits(cur, (unsigned long)(secs / 60 % 60), 2);
+    *cur++ = ':';
+    cur = put_digits(cur, (unsigned long)(secs % 60), 2);
+
+    int prec = ctx->opts->time_precision;
+    if (prec > 0) {
+        /* Truncated, as Time#iso8601 does */
+        unsigned long frac = (unsigned long)ts.tv_nsec;
+        for (int i = prec; i < 9; i++) frac /= 10;
+        *cur++ = '.';
+        cur = put_digits(cur, frac, prec);
+    }
+
+    if (utc) {
+        *cur++ = 'Z';
+    } else {
+        unsigned long minutes = (unsigned long)(offset < 0 ? -offset : offset) / 60;
+        *cur++ = offset < 0 ? '-' : '+';
+        cur = put_digits(cur, minutes / 60, 2);
+        *cur++ = ':';
+        cur = put_digits(cur, minutes % 60, 2);
+    }
+
+    write_plain_str(str, (size_t)(cur - str), ctx);
+    return true;
+}
+
+/*
+ * Write a Date as "YYYY-MM-DD" from its Julian Day Number
+ *
+ * Returns false (writing nothing) for Julian-calendar dates and years
+ * past 9999.
+ */
+static bool
+write_date(VALUE date, dump_context *ctx)
+{
+    if (!RTEST(rb_funcall(date, rb_intern("gregorian?"), 0))) return false;
+
+    /* JD 2440588 is 1970-01-01 */
+    int64_t year;
+    int month, day;
+    civil_from_days((int64_t)NUM2LL(rb_funcall(date, rb_intern("jd"), 0)) - 2440588,
+                    &year, &month, &day);
+    if (year < 0 || year > 9999) return false;
+
+    char str[10];
+    put_date(str, year, month, day);
+    write_plain_str(str, sizeof(str), ctx);
+    return true;
 }
 
 /*
  * Dump Ruby Array to JSON array
  */
-static yyjson_mut_val *
+static void
 dump_array(VALUE ary, dump_context *ctx)
 {
-    check_circular_reference(ary, ctx);
-    ctx->depth++;
+    enter_container(ary, ctx);
 
-    yyjson_mut_val *arr = yyjson_mut_arr(ctx->doc);
+    bool pretty = ctx->opts->pretty;
     long len = RARRAY_LEN(ary);
 
-    for (long i = 0; i < len; i++) {
-        VALUE item = rb_ary_entry(ary, i);
-        yyjson_mut_val *json_val = dump_ruby_object(item, ctx);
-        yyjson_mut_arr_append(arr, json_val);
+    /* Rows of Hashes likely repeat their keys */
+    if (!ctx->keys && len > 1 && RB_TYPE_P(RARRAY_AREF(ary, 0), T_HASH)) {
+        ctx->keys = ALLOCV(ctx->keys_holder, sizeof(dump_key_cache_t));
+        memset(ctx->keys->keys, 0, sizeof(ctx->keys->keys));
+        ctx->keys->used = 0;
+        if (ctx->canonical) {
+            ctx->sorts = ALLOCV(ctx->sorts_holder, sizeof(dump_sort_cache_t));
+            for (int i = 0; i < SORT_CACHE_SLOTS; i++) ctx->sorts->slots[i].count = 0;
+        }
     }
 
-    ctx->depth--;
-    unmark_visited(ary, ctx);
+    if (ctx->msgpack) {
+        msgpack_write_array_header(ctx->buf, (size_t)len);
+        for (long i = 0; i < len; i++) {
+            dump_ruby_object(rb_ary_entry(ary, i), ctx);
+        }
+        leave_container(ctx);
+        return;
+    }
+
+    json_buf_putc(ctx->buf, '[');
+    for (long i = 0; i < len; i++) {
+        if (i > 0) json_buf_putc(ctx->buf, ',');
+        if (pretty) write_indent(ctx, ctx->depth);
+        dump_ruby_object(rb_ary_entry(ary, i), ctx);
+    }
 
-    return arr;
+    leave_container(ctx);
+    if (pretty && len > 0) write_indent(ctx, ctx->depth);
+    json_buf_putc(ctx->buf, ']');
 }
 
 /*
  * Dump Ruby Hash to JSON object
  */
-static int
-dump_hash_iter(VALUE key, VALUE val, VALUE arg)
+typedef struct {
+    dump_context *ctx;
+    long count;  /* Pairs written so far */
+} dump_hash_arg;
+
+static inline size_t
+key_cache_slot(VALUE key)
 {
-    dump_context *ctx = (dump_context *)arg;
+    return (size_t)(((uint64_t)key >> 3) * 0x9E3779B97F4A7C15ULL >> 32) & (KEY_CACHE_SLOTS - 1);
+}
 
-    /* Convert key to string */
-    VALUE key_str;
-    if (TYPE(key) == T_STRING) {
-        key_str = key;
-    } else if (TYPE(key) == T_SYMBOL) {
-        key_str = rb_sym2str(key);
-    } else {
-        key_str = rb_funcall(key, rb_intern("to_s"), 0);
-    }
+/*
+ * Write a cached key and separator; false on a miss
+ */
+static inline bool
+write_cached_key(VALUE key, dump_context *ctx)
+{
+    dump_key_cache_t *kc = ctx->keys;
+    size_t slot = key_cache_slot(key);
+    if (kc->keys[slot] != key) return false;
 
-    /* Get the JSON object from context (stored temporarily in opts) */
-    yyjson_mut_val *obj = (yyjson_mut_val *)ctx->opts->temp_obj;
+    json_buf_write(ctx->buf, kc->bytes + kc->off[slot], kc->len[slot]);
+    return true;
+}
 
-    /* Dump the value */
-    yyjson_mut_val *json_val = dump_ruby_object(val, ctx);
+/*
+ * Cache the key and separator just written ([start, cur) of the buffer)
+ */
+static void
+cache_key(VALUE key, const char *start, dump_context *ctx)
+{
+    dump_key_cache_t *kc = ctx->keys;
+    size_t len = (size_t)(ctx->buf->cur - start);
+    if (len > KEY_CACHE_ENTRY_MAX) return;
 
-    /* Add to object */
-    key_str = rb_str_export_to_enc(key_str, rb_utf8_encoding());
-    const char *key_cstr = RSTRING_PTR(key_str);
-    size_t key_len = RSTRING_LEN(key_str);
+    if (kc->used + len > KEY_CACHE_BYTES) {
+        /* Full: start over */
+        memset(kc->keys, 0, sizeof(kc->keys));
+        kc->used = 0;
+    }
 
-    yyjson_mut_obj_add(obj, yyjson_mut_strncpy(ctx->doc, key_cstr, key_len), json_val);
+    size_t slot = key_cache_slot(key);
+    memcpy(kc->bytes + kc->used, start, len);
+    kc->keys[slot] = key;
+    kc->off[slot] = (uint32_t)kc->used;
+    kc->len[slot] = (uint32_t)len;
+    kc->used += len;
+}
 
-    return ST_CONTINUE;
+/*
+ * A Hash key as a String (Symbols by name, other objects by to_s)
+ */
+static inline VALUE
+key_string(VALUE key)
+{
+    if (RB_TYPE_P(key, T_STRING)) return key;
+    if (SYMBOL_P(key)) return rb_sym2str(key);
+    return rb_funcall(key, id_to_s, 0);
 }
 
-static yyjson_mut_val *
-dump_hash(VALUE hash, dump_context *ctx)
+/*
+ * Write one pair; key_str is key_string(key), or Qundef if not made yet
+ */
+static void
+dump_pair(VALUE key, VALUE key_str, VALUE val, dump_hash_arg *ha)
 {
-    check_circular_reference(hash, ctx);
-    ctx->depth++;
+    dump_context *ctx = ha->ctx;
 
-    yyjson_mut_val *obj = yyjson_mut_obj(ctx->doc);
+    /* Frozen String and Symbol keys can be cached by identity */
+    bool cacheable = ctx->keys &&
+                     (SYMBOL_P(key) || (RB_TYPE_P(key, T_STRING) && OBJ_FROZEN_RAW(key)));
 
-    /* Temporarily store object in context for iterator */
-    void *saved_temp = (void *)ctx->opts->temp_obj;
-    ((yyjson_dump_options *)ctx->opts)->temp_obj = obj;
+    if (ha->count++ > 0 && !ctx->msgpack) json_buf_putc(ctx->buf, ',');
+    if (ctx->opts->pretty) write_indent(ctx, ctx->depth);
 
-    /* Iterate hash */
-    rb_hash_foreach(hash, dump_hash_iter, (VALUE)ctx);
+    if (cacheable && write_cached_key(key, ctx)) {
+        dump_ruby_object(val, ctx);
+        return;
+    }
 
-    /* Restore temp */
-    ((yyjson_dump_options *)ctx->opts)->temp_obj = saved_temp;
+    /* Absolute position, not pointer: writing may move or flush the buffer */
+    size_t key_start = ctx->buf->flushed + (size_t)(ctx->buf->cur - ctx->buf->head);
 
-    ctx->depth--;
-    unmark_visited(hash, ctx);
+    /* Write key */
+    if (key_str == Qundef) key_str = key_string(key);
+    key_str = utf8_str(key_str);
+    if (ctx->msgpack) {
+        write_msgpack_str(key_str, ctx);
+    } else {
+        write_str(RSTRING_PTR(key_str), RSTRING_LEN(key_str), ctx);
+        if (ctx->opts->pretty) {
+            json_buf_write(ctx->buf, ": ", 2);
+        } else {
+            json_buf_putc(ctx->buf, ':');
+        }
+    }
+    RB_GC_GUARD(key_str);
+
+    /* Unless a streaming flush took part of it */
+    if (cacheable && key_start >= ctx->buf->flushed) {
+        cache_key(key, ctx->buf->head + (key_start - ctx->buf->flushed), ctx);
+    }
 
-    return obj;
+    /* Dump the value */
+    dump_ruby_object(val, ctx);
+}
+
+static int
+dump_hash_iter(VALUE key, VALUE val, VALUE arg)
+{
+    dump_pair(key, Qundef, val, (dump_hash_arg *)arg);
+    return ST_CONTINUE;
 }
 
 /*
- * Fast path: Check if object is a basic Ruby type that doesn't need as_json()
- *
- * This optimization avoids calling as_json() on Hash, Array, String, Numeric
- * which already have their as_json() method return self.
+ * A Hash's pairs, collected for sorting (canonical: true)
  */
-static bool
-is_basic_json_type(VALUE obj)
+typedef struct {
+    VALUE key;
+    VALUE val;
+    VALUE str;   /* key_string(key) as UTF-8 (Qundef when the order was cached) */
+} dump_sorted_pair_t;
+
+typedef struct {
+    const char *ptr;
+    long len;
+    long idx;    /* Iteration index */
+} dump_sort_key_t;
+
+typedef struct {
+    dump_sorted_pair_t *pairs;
+    long count;
+    uint64_t shape;      /* Hash of the key identities */
+    bool cacheable;      /* All keys are frozen Strings or Symbols */
+} dump_collect_arg;
+
+static int
+collect_pair(VALUE key, VALUE val, VALUE arg)
+{
+    dump_collect_arg *ca = (dump_collect_arg *)arg;
+    dump_sorted_pair_t *p = &ca->pairs[ca->count++];
+    p->key = key;
+    p->val = val;
+    p->str = Qundef;
+
+    ca->shape = (ca->shape ^ (uint64_t)key) * 0x100000001B3ULL;
+    if (!SYMBOL_P(key) && !(RB_TYPE_P(key, T_STRING) && OBJ_FROZEN_RAW(key))) ca->cacheable = false;
+    return ST_CONTINUE;
+}
+
+static int
+compare_sort_keys(const void *a, const void *b)
 {
-    int type = TYPE(obj);
-    return (type == T_NIL || type == T_TRUE || type == T_FALSE ||
-            type == T_FIXNUM || type == T_BIGNUM || type == T_FLOAT ||
-            type == T_STRING || type == T_SYMBOL ||
-            type == T_ARRAY || type == T_HASH);
+    const dump_sort_key_t *ka = a;
+    const dump_sort_key_t *kb = b;
+    int c = yyjson_canonical_key_cmp(ka->ptr, (size_t)ka->len, kb->ptr, (size_t)kb->len);
+    if (c != 0) return c;
+    /* Equal after conversion (:a and "a"): rejected after sorting, the
+     * iteration order keeps the message stable */
+    return ka->idx < kb->idx ? -1 : ka->idx > kb->idx;
 }
 
 /*
- * Check if object is a Time, Date, or DateTime
+ * Cached shape of the collected keys, or NULL
  */
-static bool
-is_time_like(VALUE obj)
+static dump_sort_entry_t *
+sort_cache_lookup(const dump_collect_arg *ca, dump_context *ctx)
+{
+    if (!ctx->sorts || !ca->cacheable || ca->count > SORT_CACHE_KEYS_MAX) return NULL;
+
+    size_t slot = (size_t)(ca->shape >> 32) & (SORT_CACHE_SLOTS - 2);
+    for (size_t way = 0; way < 2; way++) {
+        dump_sort_entry_t *e = &ctx->sorts->slots[slot + way];
+        if (e->count != ca->count) continue;
+        long i = 0;
+        while (i < ca->count && e->keys[i] == ca->pairs[i].key) i++;
+        if (i == ca->count) return e;
+    }
+    return NULL;
+}
+
+static void
+sort_cache_store(const dump_collect_arg *ca, const dump_sort_key_t *sorted, dump_context *ctx)
 {
-    return (rb_obj_is_kind_of(obj, rb_cTime) ||
-            (rb_const_defined(rb_cObject, rb_intern("Date")) &&
-             rb_obj_is_kind_of(obj, rb_const_get(rb_cObject, rb_intern("Date")))) ||
-            (rb_const_defined(rb_cObject, rb_intern("DateTime")) &&
-             rb_obj_is_kind_of(obj, rb_const_get(rb_cObject, rb_intern("DateTime")))));
+    if (!ctx->sorts || !ca->cacheable || ca->count > SORT_CACHE_KEYS_MAX) return;
+
+    /* Newest shape first: a full pair drops the older one */
+    dump_sort_entry_t *e = &ctx->sorts->slots[(size_t)(ca->shape >> 32) & (SORT_CACHE_SLOTS - 2)];
+    if (e->count) e[1] = e[0];
+    e->count = ca->count;
+    for (long i = 0; i < ca->count; i++) {
+        e->keys[i] = ca->pairs[i].key;
+        e->order[i] = (uint8_t)sorted[i].idx;
+    }
 }
 
 /*
- * Dump Time/Date/DateTime to ISO8601 string
+ * Write a Hash's pairs in canonical key order
+ *
+ * The pairs are copied out first, so values are dumped from the snapshot
+ * that was sorted even if a to_json / as_json changes the Hash.
  */
-static yyjson_mut_val *
-dump_time(VALUE obj, dump_context *ctx)
+static void
+dump_hash_sorted(VALUE hash, dump_hash_arg *arg)
+{
+    dump_context *ctx = arg->ctx;
+    long n = (long)RHASH_SIZE(hash);
+    if (n == 0) return;
+
+    VALUE holder = 0;
+    size_t size = (size_t)n * (sizeof(dump_sorted_pair_t) + sizeof(dump_sort_key_t));
+    dump_sorted_pair_t *pairs = ALLOCV(holder, size);
+    dump_sort_key_t *sorted = (dump_sort_key_t *)(pairs + n);
+
+    dump_collect_arg ca = { .pairs = pairs, .count = 0, .shape = 0xCBF29CE484222325ULL, .cacheable = true };
+    rb_hash_foreach(hash, collect_pair, (VALUE)&ca);
+
+    dump_sort_entry_t *cached = sort_cache_lookup(&ca, ctx);
+    if (cached) {
+        YYJSON_STATS_ADD(sort_cache_hits, 1);
+        for (long i = 0; i < ca.count; i++) sorted[i].idx = cached->order[i];
+    } else {
+        for (long i = 0; i < ca.count; i++) {
+            /* Held by pairs (ALLOCV memory is marked) while sorting */
+            pairs[i].str = utf8_str(key_string(pairs[i].key));
+            sorted[i].ptr = RSTRING_PTR(pairs[i].str);
+            sorted[i].len = RSTRING_LEN(pairs[i].str);
+            sorted[i].idx = i;
+        }
+        qsort(sorted, (size_t)ca.count, sizeof(dump_sort_key_t), compare_sort_keys);
+        /* Sorting puts equal keys next to each other; the same key twice
+         * isn't canonical (nor parsed back the same everywhere) */
+        for (long i = 1; i < ca.count; i++) {
+            if (yyjson_canonical_key_cmp(sorted[i - 1].ptr, (size_t)sorted[i - 1].len,
+                                         sorted[i].ptr, (size_t)sorted[i].len) == 0) {
+                rb_raise(eGenerateError, "duplicate key \"%"PRIsVALUE"\" in canonical output",
+                         pairs[sorted[i].idx].str);
+            }
+        }
+        sort_cache_store(&ca, sorted, ctx);
+    }
+
+    for (long i = 0; i < ca.count; i++) {
+        const dump_sorted_pair_t *p = &pairs[sorted[i].idx];
+        dump_pair(p->key, p->str, p->val, arg);
+    }
+    ALLOCV_END(holder);
+}
+
+static void
+dump_hash(VALUE hash, dump_context *ctx)
 {
-    /* Call iso8601() or to_s to get ISO8601 formatted string */
-    VALUE str;
-    if (rb_respond_to(obj, rb_intern("iso8601"))) {
-        str = rb_funcall(obj, rb_intern("iso8601"), 0);
-    } else if (rb_respond_to(obj, rb_intern("xmlschema"))) {
-        str = rb_funcall(obj, rb_intern("xmlschema"), 0);
+    enter_container(hash, ctx);
+
+    dump_hash_arg arg = { .ctx = ctx, .count = 0 };
+
+    if (ctx->msgpack) {
+        msgpack_write_map_header(ctx->buf, (size_t)RHASH_SIZE(hash));
+        if (ctx->canonical) {
+            dump_hash_sorted(hash, &arg);
+        } else {
+            rb_hash_foreach(hash, dump_hash_iter, (VALUE)&arg);
+        }
+        leave_container(ctx);
+        return;
+    }
+
+    json_buf_putc(ctx->buf, '{');
+    if (ctx->canonical) {
+        dump_hash_sorted(hash, &arg);
     } else {
-        /* Fallback to to_s */
-        str = rb_funcall(obj, id_to_s, 0);
+        rb_hash_foreach(hash, dump_hash_iter, (VALUE)&arg);
     }
-    return dump_string(str, ctx);
+
+    leave_container(ctx);
+    if (ctx->opts->pretty && arg.count > 0) write_indent(ctx, ctx->depth);
+    json_buf_putc(ctx->buf, '}');
 }
 
 /*
- * Try to call as_json() if available (Rails compatibility)
+ * Dump an instance of a class registered with attrs: as a JSON object
+ *
+ * Keys were quoted at registration (unless they need escaping), values are
+ * read straight from the ivars / readers: no intermediate Hash.
  */
-static VALUE
-try_as_json(VALUE obj, dump_context *ctx)
+static void
+dump_registered(VALUE obj, const class_serializer_t *ser, dump_context *ctx)
 {
-    /* Fast path: Skip as_json() for basic JSON types in compat mode */
-    if (ctx->opts->mode == MODE_COMPAT && is_basic_json_type(obj)) {
-        return Qnil;  /* Indicates: use default handler */
-    }
+    enter_container(obj, ctx);
+
+    bool pretty = ctx->opts->pretty;
 
-    /* In Rails mode, always try as_json() for custom objects */
-    /* But skip it for basic types as an optimization */
-    if (ctx->opts->mode == MODE_RAILS && is_basic_json_type(obj)) {
-        return Qnil;  /* Use default handler for basic types */
+    if (ctx->msgpack) {
+        msgpack_write_map_header(ctx->buf, (size_t)ser->count);
+        for (long i = 0; i < ser->count; i++) {
+            const class_attr_t *a = &ser->attrs[ctx->canonical ? ser->sorted[i] : i];
+            /* Plain keys are stored quoted */
+            if (a->key_plain) {
+                msgpack_write_str(ctx->buf, a->key + 1, a->key_len - 2);
+            } else {
+                msgpack_write_str(ctx->buf, a->key, a->key_len);
+            }
+            dump_ruby_object(a->ivar ? rb_ivar_get(obj, a->id) : rb_funcall(obj, a->id, 0), ctx);
+        }
+        leave_container(ctx);
+        return;
     }
 
-    if (rb_respond_to(obj, id_as_json)) {
-        return rb_funcall(obj, id_as_json, 0);
+    json_buf_putc(ctx->buf, '{');
+    for (long i = 0; i < ser->count; i++) {
+        const class_attr_t *a = &ser->attrs[ctx->canonical ? ser->sorted[i] : i];
+
+        if (i > 0) json_buf_putc(ctx->buf, ',');
+        if (pretty) write_indent(ctx, ctx->depth);
+
+        if (RB_LIKELY(a->key_plain)) {
+            json_buf_write(ctx->buf, a->key, a->key_len);
+        } else {
+            write_str(a->key, a->key_len, ctx);
+        }
+
+        if (pretty) {
+            json_buf_write(ctx->buf, ": ", 2);
+        } else {
+            json_buf_putc(ctx->buf, ':');
+        }
+
+        dump_ruby_object(a->ivar ? rb_ivar_get(obj, a->id) : rb_funcall(obj, a->id, 0), ctx);
     }
-    return Qnil;
+
+    leave_container(ctx);
+    if (pretty && ser->count > 0) write_indent(ctx, ctx->depth);
+    json_buf_putc(ctx->buf, '}');
 }
 
 /*
  * Dump arbitrary Ruby object
  */
-static yyjson_mut_val *
+static void
 dump_ruby_object(VALUE obj, dump_context *ctx)
 {
     switch (TYPE(obj)) {
         case T_NIL:
-            return yyjson_mut_null(ctx->doc);
+            if (ctx->msgpack) json_buf_putc(ctx->buf, (char)0xc0);
+            else json_buf_write(ctx->buf, "null", 4);
+            return;
 
         case T_TRUE:
-            return yyjson_mut_true(ctx->doc);
+            if (ctx->msgpack) json_buf_putc(ctx->buf, (char)0xc3);
+            else json_buf_write(ctx->buf, "true", 4);
+            return;
 
         case T_FALSE:
-            return yyjson_mut_false(ctx->doc);
+            if (ctx->msgpack) json_buf_putc(ctx->buf, (char)0xc2);
+            else json_buf_write(ctx->buf, "false", 5);
+            return;
 
         case T_FIXNUM:
         case T_BIGNUM:
-            return dump_integer(obj, ctx);
+            dump_integer(obj, ctx);
+            return;
 
         case T_FLOAT:
-            return dump_float(obj, ctx);
+            dump_float(obj, ctx);
+            return;
 
         case T_STRING:
-            return dump_string(obj, ctx);
+            dump_string(obj, ctx);
+            return;
 
         case T_SYMBOL:
-            return dump_symbol(obj, ctx);
+            dump_symbol(obj, ctx);
+            return;
 
         case T_ARRAY:
-            return dump_array(obj, ctx);
+            dump_array(obj, ctx);
+            return;
 
         case T_HASH:
-            return dump_hash(obj, ctx);
+            dump_hash(obj, ctx);
+            return;
 
         default:
-            /* Fast path: Handle Time/Date/DateTime objects */
-            if (is_time_like(obj)) {
-                return dump_time(obj, ctx);
+            /* Strategy resolved once per class (see dispatch.c) */
+            dump_dispatched(obj, yyjson_dispatch_lookup(obj), ctx);
+            return;
+    }
+}
+
+/*
+ * Dump options that change the JSON of a memoized object (pretty output
+ * is never memoized: its indentation depends on the nesting depth; nor is
+ * MessagePack, as the memo stores JSON)
+ */
+static inline int
+memo_signature(const yyjson_dump_options *opts)
+{
+    return (opts->escape_slash ? 1 : 0) | (opts->allow_nan ? 2 : 0) | (opts->escape_html ? 4 : 0) |
+           ((int)opts->mode << 3) | (opts->time_precision << 6) | (opts->canonical ? 1 << 10 : 0);
+}
+
+typedef struct {
+    VALUE obj;
+    dump_context *ctx;
+    json_buf_t *outer;       /* ctx->buf while rendering into a buffer of its own */
+} memo_render_arg;
+
+static VALUE
+memo_render_body(VALUE arg)
+{
+    memo_render_arg *r = (memo_render_arg *)arg;
+    json_buf_t buf;
+    json_buf_init(&buf, 256);
+    r->ctx->buf = &buf;
+
+    dump_dispatched(r->obj, yyjson_dispatch_resolve_unmemoized(r->obj), r->ctx);
+    return json_buf_finish(&buf);
+}
+
+static VALUE
+memo_render_ensure(VALUE arg)
+{
+    memo_render_arg *r = (memo_render_arg *)arg;
+    r->ctx->buf = r->outer;
+    return Qnil;
+}
+
+/*
+ * Dump obj as it would be without memoize, into a String of its own
+ *
+ * Keeps the dump's context, so the nesting limit and circular reference
+ * checks span memoized objects (and a self-containing one can't recurse
+ * forever); the key cache stays valid, as it copies what it caches.
+ */
+static VALUE
+memo_render(VALUE arg)
+{
+    memo_render_arg *r = (memo_render_arg *)arg;
+    r->outer = r->ctx->buf;
+    return rb_ensure(memo_render_body, arg, memo_render_ensure, arg);
+}
+
+/*
+ * Dump an instance of a memoized class: splice the JSON stored for its
+ * key, rendering and storing it first on a miss
+ */
+static void
+dump_memoized(VALUE obj, VALUE memo, dump_context *ctx)
+{
+    VALUE key = Qnil;
+    if (!ctx->opts->pretty && !ctx->msgpack) {
+        key = rb_proc_call_with_block(yyjson_memo_get(memo)->key_proc, 1, &obj, Qnil);
+    }
+    if (NIL_P(key)) {
+        dump_dispatched(obj, yyjson_dispatch_resolve_unmemoized(obj), ctx);
+        return;
+    }
+
+    memo_render_arg r = { .obj = obj, .ctx = ctx, .outer = NULL };
+    VALUE json = yyjson_memo_fetch(memo, key, memo_signature(ctx->opts), memo_render, (VALUE)&r);
+    json_buf_write(ctx->buf, RSTRING_PTR(json), RSTRING_LEN(json));
+    RB_GC_GUARD(json);
+}
+
+/*
+ * A Fragment's JSON in canonical form: parsed, then rewritten with sorted
+ * keys, ECMAScript numbers and lowercase escapes (bytes spliced as they
+ * are would break the guarantee). Integers beyond 64 bits keep their
+ * digits, as Bignums do; numbers beyond a double raise, as Infinity does.
+ */
+typedef struct {
+    dump_context *ctx;
+    yyjson_doc *doc;
+} canonical_fragment_args;
+
+static int
+compare_fragment_keys(const void *a, const void *b)
+{
+    yyjson_val *ka = *(yyjson_val *const *)a;
+    yyjson_val *kb = *(yyjson_val *const *)b;
+    return yyjson_canonical_key_cmp(unsafe_yyjson_get_str(ka), unsafe_yyjson_get_len(ka),
+                                    unsafe_yyjson_get_str(kb), unsafe_yyjson_get_len(kb));
+}
+
+static void
+write_canonical_number(const char *s, size_t len, dump_context *ctx)
+{
+    char *cur = json_buf_reserve(ctx->buf, len + CANONICAL_NUM_EXTRA);
+    cur = yyjson_canonical_number(cur, s, len);
+    if (!cur) {
+        RAISE_GENERATE_ERROR("Failed to write JSON: invalid number");
+    }
+    ctx->buf->cur = cur;
+}
+
+static void
+write_canonical_val(yyjson_val *val, dump_context *ctx)
+{
+    char *cur;
+
+    switch (unsafe_yyjson_get_type(val)) {
+        case YYJSON_TYPE_NULL:
+            json_buf_write(ctx->buf, "null", 4);
+            return;
+        case YYJSON_TYPE_BOOL:
+            if (unsafe_yyjson_get_bool(val)) {
+                json_buf_write(ctx->buf, "true", 4);
+            } else {
+                json_buf_write(ctx->buf, "false", 5);
+            }
+            return;
+        case YYJSON_TYPE_RAW: {
+            const char *raw = unsafe_yyjson_get_raw(val);
+            size_t len = unsafe_yyjson_get_len(val);
+            /* Past a double's range is Infinity to us */
+            if (memchr(raw, '.', len) || memchr(raw, 'e', len) || memchr(raw, 'E', len)) {
+                rb_raise(eGenerateError, "NaN and Infinity not allowed in JSON");
+            }
+            json_buf_write(ctx->buf, raw, len);
+            return;
+        }
+        case YYJSON_TYPE_NUM:
+            cur = json_buf_reserve(ctx->buf, YYJSON_EMIT_NUM_MAX);
+            if (unsafe_yyjson_is_uint(val)) {
+                ctx->buf->cur = yyjson_emit_uint(cur, unsafe_yyjson_get_uint(val));
+            } else if (unsafe_yyjson_is_sint(val)) {
+                ctx->buf->cur = yyjson_emit_sint(cur, unsafe_yyjson_get_sint(val));
+            } else {
+                char num[YYJSON_EMIT_NUM_MAX];
+                char *end = yyjson_emit_f64(num, unsafe_yyjson_get_real(val), ctx->flg);
+                if (!end) RAISE_GENERATE_ERROR("Failed to write JSON: invalid number");
+                write_canonical_number(num, (size_t)(end - num), ctx);
             }
+            return;
+        case YYJSON_TYPE_STR:
+            write_str(unsafe_yyjson_get_str(val), unsafe_yyjson_get_len(val), ctx);
+            return;
+        default:
+            break;
+    }
 
-            /* Try as_json() for custom objects */
-            VALUE as_json_result = try_as_json(obj, ctx);
-            if (!NIL_P(as_json_result)) {
-                return dump_ruby_object(as_json_result, ctx);
+    if (RB_UNLIKELY(ctx->depth > MAX_NESTING_DEPTH)) {
+        rb_raise(eGenerateError, "nesting of %d is too deep", ctx->depth);
+    }
+    ctx->depth++;
+
+    size_t i, max;
+    if (unsafe_yyjson_is_arr(val)) {
+        yyjson_val *item;
+        json_buf_putc(ctx->buf, '[');
+        yyjson_arr_foreach(val, i, max, item) {
+            if (i > 0) json_buf_putc(ctx->buf, ',');
+            write_canonical_val(item, ctx);
+        }
+        json_buf_putc(ctx->buf, ']');
+    } else {
+        /* Sort the keys; each one's value follows it */
+        size_t n = unsafe_yyjson_get_len(val);
+        VALUE holder = 0;
+        yyjson_val **keys = ALLOCV_N(yyjson_val *, holder, n > 0 ? n : 1);
+        yyjson_val *key, *item;
+        yyjson_obj_foreach(val, i, max, key, item) keys[i] = key;
+        qsort(keys, n, sizeof(yyjson_val *), compare_fragment_keys);
+
+        json_buf_putc(ctx->buf, '{');
+        for (i = 0; i < n; i++) {
+            if (i > 0) {
+                if (compare_fragment_keys(&keys[i - 1], &keys[i]) == 0) {
+                    rb_raise(eGenerateError, "duplicate key \"%s\" in canonical output",
+                             unsafe_yyjson_get_str(keys[i]));
+                }
+                json_buf_putc(ctx->buf, ',');
+            }
+            write_str(unsafe_yyjson_get_str(keys[i]), unsafe_yyjson_get_len(keys[i]), ctx);
+            json_buf_putc(ctx->buf, ':');
+            write_canonical_val(keys[i] + 1, ctx);
+        }
+        json_buf_putc(ctx->buf, '}');
+        ALLOCV_END(holder);
+    }
+
+    ctx->depth--;
+}
+
+static VALUE
+canonical_fragment_body(VALUE arg)
+{
+    canonical_fragment_args *a = (canonical_fragment_args *)arg;
+    write_canonical_val(yyjson_doc_get_root(a->doc), a->ctx);
+    return Qnil;
+}
+
+static VALUE
+canonical_fragment_ensure(VALUE arg)
+{
+    yyjson_doc_free(((canonical_fragment_args *)arg)->doc);
+    return Qnil;
+}
+
+static void
+dump_canonical_fragment(VALUE json, dump_context *ctx)
+{
+    yyjson_read_err err;
+    yyjson_doc *doc = yyjson_read_opts(RSTRING_PTR(json), (size_t)RSTRING_LEN(json),
+                                       YYJSON_READ_BIGNUM_AS_RAW, NULL, &err);
+    if (!doc) {
+        rb_raise(eGenerateError, "Invalid JSON fragment at position %zu: %s", err.pos, err.msg);
+    }
+
+    canonical_fragment_args a = { .ctx = ctx, .doc = doc };
+    rb_ensure(canonical_fragment_body, (VALUE)&a, canonical_fragment_ensure, (VALUE)&a);
+    RB_GC_GUARD(json);
+}
+
+/*
+ * Dump a non-core object with its resolved strategy
+ */
+static void
+dump_dispatched(VALUE obj, dispatch_entry_t d, dump_context *ctx)
+{
+    switch (d.kind) {
+        case DISPATCH_ATTRS:
+            /* d.data keeps the attribute list alive if it is unregistered meanwhile */
+            dump_registered(obj, yyjson_class_serializer_get(d.data), ctx);
+            RB_GC_GUARD(d.data);
+            return;
+
+        case DISPATCH_BLOCK:
+            dump_ruby_object(rb_proc_call_with_block(d.data, 1, &obj, Qnil), ctx);
+            RB_GC_GUARD(d.data);
+            return;
+
+        case DISPATCH_FRAGMENT: {
+            VALUE json = yyjson_fragment_json(obj);
+            if (ctx->msgpack) {
+                yyjson_msgpack_write_json(ctx->buf, json);
+            } else if (ctx->canonical) {
+                dump_canonical_fragment(json, ctx);
+            } else {
+                json_buf_write(ctx->buf, RSTRING_PTR(json), RSTRING_LEN(json));
+            }
+            return;
+        }
+
+        case DISPATCH_MEMO:
+            dump_memoized(obj, d.data, ctx);
+            RB_GC_GUARD(d.data);
+            return;
+
+        case DISPATCH_TIME:
+            if (write_time(obj, ctx)) return;
+            /* iso8601 / xmlschema take the digit count; to_s doesn't */
+            if (d.mid != id_to_s) {
+                dump_string(rb_funcall(obj, d.mid, 1, INT2FIX(ctx->opts->time_precision)), ctx);
+                return;
+            }
+            break;
+
+        case DISPATCH_DATE:
+            if (write_date(obj, ctx)) return;
+            break;
+
+        case DISPATCH_DATETIME:
+            if (d.mid != id_to_s) {
+                dump_string(rb_funcall(obj, d.mid, 1, INT2FIX(ctx->opts->time_precision)), ctx);
+                return;
+            }
+            break;
+
+        case DISPATCH_BIGDECIMAL:
+            /* Rails encodes BigDecimal as a string (its as_json) */
+            if (ctx->opts->mode != MODE_RAILS) {
+                dump_bigdecimal(obj, ctx);
+                return;
             }
+            if (d.mid == id_as_json) d.kind = DISPATCH_AS_JSON;
+            break;
+
+        default:
+            break;
+    }
 
-            /* Fallback: convert to string */
-            VALUE str = rb_funcall(obj, id_to_s, 0);
-            return dump_string(str, ctx);
+    if (d.kind == DISPATCH_AS_JSON) {
+        YYJSON_STATS_ADD(as_json_calls, 1);
+        VALUE as_json = rb_funcall(obj, id_as_json, 0);
+        if (!NIL_P(as_json)) {
+            dump_ruby_object(as_json, ctx);
+            return;
+        }
+        d.mid = id_to_s;
     }
+
+    /* Date as ISO 8601 or to_s, everything else as to_s */
+    dump_string(rb_funcall(obj, d.mid, 0), ctx);
 }
 
 /*
- * Public API: Dump a Ruby object to a yyjson mutable document
+ * Public API: Dump a Ruby object as JSON text into an output buffer
  */
-yyjson_mut_val *
-yyjson_dump_ruby_object(VALUE obj, yyjson_mut_doc *doc, const yyjson_dump_options *opts)
+void
+yyjson_dump_ruby_object(VALUE obj, json_buf_t *buf, const yyjson_dump_options *opts)
 {
     dump_context ctx;
-    ctx.doc = doc;
+    ctx.buf = buf;
     ctx.opts = opts;
+    ctx.flg = YYJSON_WRITE_NOFLAG;
+    ctx.msgpack = opts->msgpack;
+    ctx.canonical = opts->canonical;
     ctx.depth = 0;
-    ctx.visited = rb_hash_new();
+    ctx.keys = NULL;
+    ctx.keys_holder = 0;
+    ctx.sorts = NULL;
+    ctx.sorts_holder = 0;
+
+    if (opts->escape_slash) ctx.flg |= YYJSON_WRITE_ESCAPE_SLASHES;
+    if (opts->allow_nan) ctx.flg |= YYJSON_WRITE_ALLOW_INF_AND_NAN;
+    if (opts->escape_html) ctx.flg |= YYJSON_EMIT_ESCAPE_HTML;
 
-    return dump_ruby_object(obj, &ctx);
+    size_t start = buf->flushed + (size_t)(buf->cur - buf->head);
+    dump_ruby_object(obj, &ctx);
+
+    /* If the dump raises, the GC frees the caches */
+    if (ctx.sorts_holder) ALLOCV_END(ctx.sorts_holder);
+    if (ctx.keys_holder) ALLOCV_END(ctx.keys_holder);
+
+    if (RB_UNLIKELY(yyjson_stats_enabled)) {
+        yyjson_stats_t *s = yyjson_stats_local();
+        s->dumps++;
+        s->bytes_emitted += buf->flushed + (size_t)(buf->cur - buf->head) - start;
+        if (opts->escape_html) s->escape_html_dumps++;
+    }
 }
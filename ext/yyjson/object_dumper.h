@@ -6,6 +6,7 @@
 #define YYJSON_RUBY_OBJECT_DUMPER_H
 
 #include "common.h"
+#include "json_buffer.h"
 
 /*
  * Dump options for controlling how Ruby objects are converted to JSON
@@ -15,19 +16,26 @@ typedef struct {
     bool escape_slash;       /* Escape forward slashes */
     bool allow_nan;          /* Allow NaN and Infinity values */
     bool escape_html;        /* Escape HTML entities (<, >, &, ') for XSS prevention */
+    bool check_circular;     /* Detect circular references (else rely on the depth limit) */
+    int time_precision;      /* Fraction digits for Time (0-9) */
     int indent;              /* Number of spaces for indentation (0 = compact) */
     yyjson_mode_t mode;      /* Generation mode */
-    void *temp_obj;          /* Temporary storage for context passing */
+    size_t buffer_size;      /* Bytes buffered per write when streaming */
+    bool msgpack;            /* Write MessagePack instead of JSON (YYJson.dump_msgpack) */
+    bool canonical;          /* RFC 8785 output: sorted keys, ECMAScript numbers (see canonical.h) */
 } yyjson_dump_options;
 
 /*
- * Dump a Ruby object to a yyjson mutable value
+ * Dump a Ruby object as JSON text into an output buffer
+ *
+ * Walks the object graph and writes escaped JSON directly, formatted
+ * exactly like yyjson_mut_write with the equivalent write flags. With
+ * opts->msgpack, writes MessagePack instead (see msgpack.h).
  *
  * @param obj The Ruby object to convert
- * @param doc The yyjson mutable document to use
+ * @param buf The output buffer to append to
  * @param opts Dump options controlling the conversion
- * @return A yyjson mutable value representing the object
  */
-yyjson_mut_val *yyjson_dump_ruby_object(VALUE obj, yyjson_mut_doc *doc, const yyjson_dump_options *opts);
+void yyjson_dump_ruby_object(VALUE obj, json_buf_t *buf, const yyjson_dump_options *opts);
 
 #endif /* YYJSON_RUBY_OBJECT_DUMPER_H */
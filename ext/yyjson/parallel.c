@@ -0,0 +1,181 @@
+/*
+ * parallel.c - Sharded documents for YYJson.load_parallel
+ *
+ * A large top-level array is parsed once with yyjson. Its element range is
+ * split into shards, and each shard is built into Ruby objects by its own
+ * Ractor (see lib/yyjson/parallel.rb). Object allocation runs in parallel
+ * only across Ractors: threads would serialize on the GVL.
+ *
+ * The document object is frozen and Ractor-shareable (the yyjson document
+ * is read-only once parsed), and shards are built frozen with every
+ * String / Array / Hash flagged shareable as it is created, so they pass
+ * back to the caller by reference with no Ractor.make_shareable walk.
+ * Only #shard is declared Ractor-safe.
+ */
+
+#include "common.h"
+#include "parser.h"
+#include "parallel.h"
+
+/* Fewest elements per shard (smaller arrays are built in one piece) */
+#define PARALLEL_MIN_SHARD 4096
+
+typedef struct {
+    yyjson_doc *doc;
+    yyjson_parse_options opts;
+    size_t count;            /* Shards (0 = not sharded) */
+    yyjson_val **starts;     /* First element of each shard */
+    size_t *lens;            /* Elements in each shard */
+} sharded_doc_t;
+
+static VALUE cShardedDocument;
+
+static void
+sharded_doc_free(void *ptr)
+{
+    sharded_doc_t *sd = ptr;
+    if (sd->doc) yyjson_doc_free(sd->doc);
+    xfree(sd->starts);
+    xfree(sd->lens);
+    xfree(sd);
+}
+
+static size_t
+sharded_doc_memsize(const void *ptr)
+{
+    const sharded_doc_t *sd = ptr;
+    return sizeof(*sd) + sd->count * (sizeof(yyjson_val *) + sizeof(size_t));
+}
+
+static const rb_data_type_t sharded_doc_type = {
+    .wrap_struct_name = "YYJson::ShardedDocument",
+    .function = {
+        .dfree = sharded_doc_free,
+        .dsize = sharded_doc_memsize,
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY | RUBY_TYPED_FROZEN_SHAREABLE
+};
+
+static VALUE
+sharded_doc_alloc(VALUE klass)
+{
+    sharded_doc_t *sd;
+    return TypedData_Make_Struct(klass, sharded_doc_t, &sharded_doc_type, sd);
+}
+
+static sharded_doc_t *
+get_sharded_doc(VALUE self)
+{
+    sharded_doc_t *sd = rb_check_typeddata(self, &sharded_doc_type);
+    if (!sd->doc) rb_raise(rb_eArgError, "uninitialized YYJson::ShardedDocument");
+    return sd;
+}
+
+/*
+ * Split the root array into `want` shards of near-equal length
+ */
+static void
+split_shards(sharded_doc_t *sd, size_t want)
+{
+    yyjson_val *root = sd->doc->root;
+    size_t len = unsafe_yyjson_get_len(root);
+    size_t count = len / PARALLEL_MIN_SHARD;
+    if (count > want) count = want;
+    if (count < 2) return;
+
+    sd->starts = ALLOC_N(yyjson_val *, count);
+    sd->lens = ALLOC_N(size_t, count);
+    sd->count = count;
+
+    yyjson_val *v = unsafe_yyjson_get_first(root);
+    for (size_t s = 0; s < count; s++) {
+        size_t n = len / count + (s < len % count ? 1 : 0);
+        sd->starts[s] = v;
+        sd->lens[s] = n;
+        for (size_t i = 0; i < n; i++) v = unsafe_yyjson_get_next(v);
+    }
+}
+
+/*
+ * YYJson::ShardedDocument.new(source, shards, opts = {})
+ *
+ * Parse source; a root array of at least 2 * 4096 elements is split into
+ * up to `shards` shards. Accepts the YYJson.load options (output is always
+ * frozen; :key_cache is not used).
+ */
+static VALUE
+sharded_doc_initialize(int argc, VALUE *argv, VALUE self)
+{
+    VALUE source, shards, opts;
+    rb_scan_args(argc, argv, "21", &source, &shards, &opts);
+    if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+
+    sharded_doc_t *sd = rb_check_typeddata(self, &sharded_doc_type);
+    if (sd->doc) rb_raise(rb_eArgError, "YYJson::ShardedDocument already initialized");
+
+    long want = NUM2LONG(shards);
+    yyjson_extract_parse_options(opts, &sd->opts);
+    sd->opts.freeze = true;
+    sd->opts.shareable = true;
+    /* The process-wide key cache isn't safe to use from other Ractors */
+    sd->opts.key_cache = NULL;
+
+    sd->doc = yyjson_read_string_doc(source, &sd->opts, yyjson_read_flags(&sd->opts), NULL);
+    if (want > 1 && yyjson_is_arr(sd->doc->root)) split_shards(sd, (size_t)want);
+
+    rb_obj_freeze(self);
+    return self;
+}
+
+/*
+ * Number of shards (0 when the document is not sharded: use #value)
+ */
+static VALUE
+sharded_doc_shards(VALUE self)
+{
+    return SIZET2NUM(get_sharded_doc(self)->count);
+}
+
+/*
+ * Frozen, shareable Array of the elements of shard i (Ractor-safe)
+ */
+static VALUE
+sharded_doc_shard(VALUE self, VALUE index)
+{
+    sharded_doc_t *sd = get_sharded_doc(self);
+    long i = NUM2LONG(index);
+    if (i < 0 || (size_t)i >= sd->count) {
+        rb_raise(rb_eIndexError, "shard %ld out of range (%zu shards)", i, sd->count);
+    }
+
+    VALUE ary = yyjson_build_ruby_elements(sd->starts[i], sd->lens[i], &sd->opts);
+    RB_GC_GUARD(self);
+    return ary;
+}
+
+/*
+ * The whole document, frozen and shareable, built in the calling Ractor
+ */
+static VALUE
+sharded_doc_value(VALUE self)
+{
+    sharded_doc_t *sd = get_sharded_doc(self);
+    VALUE value = yyjson_build_ruby_value(sd->doc->root, &sd->opts);
+    RB_GC_GUARD(self);
+    return value;
+}
+
+void
+yyjson_parallel_init(void)
+{
+    cShardedDocument = rb_define_class_under(mYYJson, "ShardedDocument", rb_cObject);
+    rb_define_alloc_func(cShardedDocument, sharded_doc_alloc);
+    rb_define_method(cShardedDocument, "initialize", sharded_doc_initialize, -1);
+    rb_define_method(cShardedDocument, "shards", sharded_doc_shards, 0);
+    rb_define_method(cShardedDocument, "value", sharded_doc_value, 0);
+
+    /* Called from worker Ractors: builds from the read-only document only */
+    rb_ext_ractor_safe(true);
+    rb_define_method(cShardedDocument, "shard", sharded_doc_shard, 1);
+    rb_ext_ractor_safe(false);
+}
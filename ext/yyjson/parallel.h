@@ -0,0 +1,15 @@
+/*
+ * parallel.h - Sharded documents for YYJson.load_parallel
+ */
+
+#ifndef YYJSON_RUBY_PARALLEL_H
+#define YYJSON_RUBY_PARALLEL_H
+
+#include "common.h"
+
+/*
+ * Define YYJson::ShardedDocument (called from Init_yyjson)
+ */
+void yyjson_parallel_init(void);
+
+#endif /* YYJSON_RUBY_PARALLEL_H */
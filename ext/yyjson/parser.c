@@ -7,7 +7,175 @@
 #include "common.h"
 #include "value_builder.h"
 #include "parser.h"
+#include "file_map.h"
+#include "stats.h"
 #include <math.h>
+#include <ruby/thread.h>
+#include <sys/stat.h>
+
+/* Process-wide default for :gvl_release_threshold (0 = never release) */
+size_t yyjson_gvl_release_threshold = 0;
+
+/*
+ * Arguments for a yyjson_read_opts call made without the GVL
+ */
+typedef struct {
+    const char *json;
+    size_t len;
+    yyjson_read_flag flg;
+    const yyjson_alc *alc;
+    yyjson_doc *doc;
+    yyjson_read_err err;
+} read_nogvl_args;
+
+/*
+ * Run yyjson_read_opts outside the GVL (touches no Ruby objects)
+ */
+static void *
+read_nogvl(void *ptr)
+{
+    read_nogvl_args *args = (read_nogvl_args *)ptr;
+    args->doc = yyjson_read_opts((char *)args->json, args->len, args->flg, args->alc, &args->err);
+    return NULL;
+}
+
+/*
+ * Read a document from a Ruby string, releasing the GVL for large inputs
+ *
+ * The raw parse runs on a frozen (shared) copy of the source, so other
+ * threads can't mutate or free the bytes while the lock is released.
+ * The copy lives on this stack frame, which also pins it against
+ * GC compaction.
+ */
+static yyjson_doc *
+read_string(VALUE json_str, yyjson_read_flag flg, const yyjson_alc *alc,
+            size_t threshold, yyjson_read_err *err)
+{
+    size_t len = RSTRING_LEN(json_str);
+    uint64_t start = YYJSON_STATS_START();
+
+    if (__builtin_expect(threshold == 0 || len < threshold, 1)) {
+        yyjson_doc *doc = yyjson_read_opts(RSTRING_PTR(json_str), len, flg, alc, err);
+        YYJSON_STATS_READ(start, len);
+        return doc;
+    }
+
+    VALUE frozen = rb_str_new_frozen(json_str);
+    read_nogvl_args args = {
+        .json = RSTRING_PTR(frozen),
+        .len = len,
+        .flg = flg,
+        .alc = alc,
+        .doc = NULL
+    };
+
+    rb_thread_call_without_gvl(read_nogvl, &args, NULL, NULL);
+    RB_GC_GUARD(frozen);
+    YYJSON_STATS_READ(start, len);
+
+    *err = args.err;
+    return args.doc;
+}
+
+/*
+ * Arguments for a yyjson_read_file call made without the GVL
+ */
+typedef struct {
+    const char *path;
+    yyjson_read_flag flg;
+    const yyjson_alc *alc;
+    yyjson_doc *doc;
+    yyjson_read_err err;
+} read_file_nogvl_args;
+
+static void *
+read_file_nogvl(void *ptr)
+{
+    read_file_nogvl_args *args = (read_file_nogvl_args *)ptr;
+    args->doc = yyjson_read_file(args->path, args->flg, args->alc, &args->err);
+    return NULL;
+}
+
+/*
+ * Read a document from a file, releasing the GVL for files of at least
+ * `threshold` bytes (the path is a frozen copy, safe from other threads)
+ */
+static yyjson_doc *
+read_file(VALUE path_str, yyjson_read_flag flg, const yyjson_alc *alc,
+          size_t threshold, yyjson_read_err *err)
+{
+    struct stat st;
+    const char *path = RSTRING_PTR(path_str);
+    uint64_t start = YYJSON_STATS_START();
+
+    if (__builtin_expect(threshold == 0, 1) ||
+        stat(path, &st) != 0 || (unsigned long long)st.st_size < threshold) {
+        yyjson_doc *doc = yyjson_read_file(path, flg, alc, err);
+        YYJSON_STATS_READ(start, doc ? yyjson_doc_get_read_size(doc) : 0);
+        return doc;
+    }
+
+    VALUE frozen = rb_str_new_frozen(path_str);
+    read_file_nogvl_args args = {
+        .path = RSTRING_PTR(frozen),
+        .flg = flg,
+        .alc = alc,
+        .doc = NULL
+    };
+
+    rb_thread_call_without_gvl(read_file_nogvl, &args, NULL, NULL);
+    RB_GC_GUARD(frozen);
+    YYJSON_STATS_READ(start, args.doc ? yyjson_doc_get_read_size(args.doc) : 0);
+
+    *err = args.err;
+    return args.doc;
+}
+
+/*
+ * yyjson read flags for a set of parse options
+ */
+yyjson_read_flag
+yyjson_read_flags(const yyjson_parse_options *opts)
+{
+    yyjson_read_flag flg = YYJSON_READ_NOFLAG;
+    if (opts->allow_comments) flg |= YYJSON_READ_ALLOW_COMMENTS;
+    if (opts->allow_nan) flg |= YYJSON_READ_ALLOW_INF_AND_NAN;
+    return flg;
+}
+
+/*
+ * Depth at which a document nests deeper than max_nesting allows (the
+ * check YYJson.load makes while building), or 0 if it doesn't. Walks the
+ * flat value array once with a stack of open containers' ends.
+ */
+int
+yyjson_doc_nesting_exceeded(yyjson_doc *doc, int max_nesting)
+{
+    if (max_nesting <= 0) return 0;
+
+    /* Nothing nests deeper than the document has values */
+    size_t capa = (size_t)max_nesting;
+    if (capa > yyjson_doc_get_val_count(doc)) capa = yyjson_doc_get_val_count(doc);
+
+    yyjson_val *stack_buf[128];
+    yyjson_val **ends = capa <= 128 ? stack_buf : ALLOC_N(yyjson_val *, capa);
+    int depth = 0, exceeded = 0;
+
+    yyjson_val *root = yyjson_doc_get_root(doc);
+    yyjson_val *end = unsafe_yyjson_get_next(root);
+    for (yyjson_val *v = root; v < end; v++) {
+        while (depth > 0 && ends[depth - 1] == v) depth--;
+        if (!unsafe_yyjson_is_ctn(v)) continue;
+        if (depth >= max_nesting) {
+            exceeded = depth + 1;
+            break;
+        }
+        if (unsafe_yyjson_get_len(v) > 0) ends[depth++] = unsafe_yyjson_get_next(v);
+    }
+
+    if (ends != stack_buf) xfree(ends);
+    return exceeded;
+}
 
 /*
  * Parse JSON from a string
@@ -19,27 +187,45 @@
 VALUE
 yyjson_parse_string(VALUE json_str, const yyjson_parse_options *opts)
 {
-    /* Ensure we have a string */
-    Check_Type(json_str, T_STRING);
-
-    const char *json = RSTRING_PTR(json_str);
-    size_t len = RSTRING_LEN(json_str);
-
-    yyjson_doc *doc;
-    yyjson_read_err err;
-
     /* Fast path: default options (allow_nan + allow_comments) */
     if (opts->allow_nan && opts->allow_comments) {
         static const yyjson_read_flag default_flg =
             YYJSON_READ_ALLOW_COMMENTS | YYJSON_READ_ALLOW_INF_AND_NAN;
-        doc = yyjson_read_opts((char *)json, len, default_flg, NULL, &err);
-    } else {
-        /* Configure yyjson read flags */
-        yyjson_read_flag flg = YYJSON_READ_NOFLAG;
-        if (opts->allow_comments) flg |= YYJSON_READ_ALLOW_COMMENTS;
-        if (opts->allow_nan) flg |= YYJSON_READ_ALLOW_INF_AND_NAN;
-        doc = yyjson_read_opts((char *)json, len, flg, NULL, &err);
+        return yyjson_parse_string_alc(json_str, opts, default_flg, NULL);
     }
+    return yyjson_parse_string_alc(json_str, opts, yyjson_read_flags(opts), NULL);
+}
+
+/*
+ * Read a JSON string into a yyjson document, NULL with err set if it
+ * isn't valid JSON
+ */
+yyjson_doc *
+yyjson_try_read_string_doc(VALUE json_str, const yyjson_parse_options *opts,
+                           yyjson_read_flag flg, const yyjson_alc *alc,
+                           yyjson_read_err *err)
+{
+    /* Ensure we have a string */
+    Check_Type(json_str, T_STRING);
+
+    return read_string(json_str, flg, alc, opts->gvl_release_threshold, err);
+}
+
+/*
+ * Read a JSON string into a yyjson document (raises ParseError)
+ *
+ * @param json_str The JSON string to parse
+ * @param opts Parse options
+ * @param flg Read flags (see yyjson_read_flags())
+ * @param alc Allocator for the yyjson document (NULL = libc malloc)
+ * @return Document owned by the caller (free with yyjson_doc_free)
+ */
+yyjson_doc *
+yyjson_read_string_doc(VALUE json_str, const yyjson_parse_options *opts,
+                       yyjson_read_flag flg, const yyjson_alc *alc)
+{
+    yyjson_read_err err;
+    yyjson_doc *doc = yyjson_try_read_string_doc(json_str, opts, flg, alc, &err);
 
     if (__builtin_expect(!doc, 0)) {
         /* Parse error - raise Ruby exception with details */
@@ -49,14 +235,26 @@ yyjson_parse_string(VALUE json_str, const yyjson_parse_options *opts)
                  err.pos, err.msg);
         RAISE_PARSE_ERROR(error_msg);
     }
+    return doc;
+}
 
-    /* Build Ruby object from the document */
-    VALUE result = yyjson_build_ruby_object(doc, opts);
-
-    /* Free the yyjson document */
-    yyjson_doc_free(doc);
+/*
+ * Parse JSON from a string with precomputed flags and an allocator
+ *
+ * @param json_str The JSON string to parse
+ * @param opts Parse options
+ * @param flg Read flags (see yyjson_read_flags())
+ * @param alc Allocator for the yyjson document (NULL = libc malloc)
+ * @return Ruby object representing the parsed JSON
+ */
+VALUE
+yyjson_parse_string_alc(VALUE json_str, const yyjson_parse_options *opts,
+                        yyjson_read_flag flg, const yyjson_alc *alc)
+{
+    yyjson_doc *doc = yyjson_read_string_doc(json_str, opts, flg, alc);
 
-    return result;
+    /* Build Ruby object from the document, then free it */
+    return yyjson_build_ruby_object_free(doc, opts);
 }
 
 /*
@@ -68,6 +266,80 @@ yyjson_parse_string(VALUE json_str, const yyjson_parse_options *opts)
  */
 VALUE
 yyjson_parse_file(VALUE file_path, const yyjson_parse_options *opts)
+{
+    return yyjson_parse_file_alc(file_path, opts, yyjson_read_flags(opts), NULL);
+}
+
+/*
+ * State for parsing a mapped file (released in map_parse_ensure)
+ */
+typedef struct {
+    yyjson_file_map_t map;
+    yyjson_doc *doc;
+    const yyjson_parse_options *opts;
+    yyjson_read_flag flg;
+    const yyjson_alc *alc;
+    const char *path;
+} map_parse_args;
+
+static VALUE
+map_parse_body(VALUE ptr)
+{
+    map_parse_args *args = (map_parse_args *)ptr;
+    yyjson_read_err err;
+    yyjson_read_flag flg = args->flg | YYJSON_READ_INSITU;
+    size_t threshold = args->opts->gvl_release_threshold;
+    uint64_t start = YYJSON_STATS_START();
+
+    if (threshold && args->map.len >= threshold) {
+        read_nogvl_args nogvl = {
+            .json = args->map.data,
+            .len = args->map.len,
+            .flg = flg,
+            .alc = args->alc,
+            .doc = NULL
+        };
+        rb_thread_call_without_gvl(read_nogvl, &nogvl, NULL, NULL);
+        args->doc = nogvl.doc;
+        err = nogvl.err;
+    } else {
+        args->doc = yyjson_read_opts(args->map.data, args->map.len, flg, args->alc, &err);
+    }
+    YYJSON_STATS_READ(start, args->map.len);
+
+    if (!args->doc) {
+        char error_msg[512];
+        snprintf(error_msg, sizeof(error_msg),
+                 "Parse error in file %s at position %zu: %s (code: %u)",
+                 args->path, err.pos, err.msg, err.code);
+        RAISE_PARSE_ERROR(error_msg);
+    }
+
+    return yyjson_build_ruby_object_mapped(args->doc, args->opts, &args->map);
+}
+
+static VALUE
+map_parse_ensure(VALUE ptr)
+{
+    map_parse_args *args = (map_parse_args *)ptr;
+    /* The insitu doc points into the mapping: free it first */
+    if (args->doc) yyjson_doc_free(args->doc);
+    yyjson_file_map_close(&args->map);
+    return Qnil;
+}
+
+/*
+ * Parse JSON from a file with precomputed flags and an allocator
+ *
+ * @param file_path Path to the JSON file
+ * @param opts Parse options
+ * @param flg Read flags (see yyjson_read_flags())
+ * @param alc Allocator for the yyjson document (NULL = libc malloc)
+ * @return Ruby object representing the parsed JSON
+ */
+VALUE
+yyjson_parse_file_alc(VALUE file_path, const yyjson_parse_options *opts,
+                      yyjson_read_flag flg, const yyjson_alc *alc)
 {
     /* Ensure we have a string path */
     Check_Type(file_path, T_STRING);
@@ -75,19 +347,30 @@ yyjson_parse_file(VALUE file_path, const yyjson_parse_options *opts)
 
     const char *path = RSTRING_PTR(file_path);
 
-    /* Configure yyjson read flags */
-    yyjson_read_flag flg = 0;
-
-    if (opts->allow_comments) {
-        flg |= YYJSON_READ_ALLOW_COMMENTS;
-    }
-    if (opts->allow_nan) {
-        flg |= YYJSON_READ_ALLOW_INF_AND_NAN;
+    /* mmap: true - parse insitu from a private mapping when possible */
+    if (opts->mmap) {
+        map_parse_args args = {
+            .doc = NULL,
+            .opts = opts,
+            .flg = flg,
+            .alc = alc,
+            .path = path
+        };
+        yyjson_file_map_result res = yyjson_file_map_open(path, &args.map);
+        if (res == FILE_MAP_OPEN_FAILED) {
+            rb_raise(rb_eIOError, "Cannot open file: %s", path);
+        }
+        if (res == FILE_MAP_OK) {
+            VALUE result = rb_ensure(map_parse_body, (VALUE)&args, map_parse_ensure, (VALUE)&args);
+            RB_GC_GUARD(file_path);
+            return result;
+        }
+        /* FILE_MAP_UNSUPPORTED: fall back to reading the file */
     }
 
     /* Parse the JSON file */
     yyjson_read_err err;
-    yyjson_doc *doc = yyjson_read_file(path, flg, NULL, &err);
+    yyjson_doc *doc = read_file(file_path, flg, alc, opts->gvl_release_threshold, &err);
 
     if (!doc) {
         /* Check if file doesn't exist or parse error */
@@ -103,13 +386,8 @@ yyjson_parse_file(VALUE file_path, const yyjson_parse_options *opts)
         }
     }
 
-    /* Build Ruby object from the document */
-    VALUE result = yyjson_build_ruby_object(doc, opts);
-
-    /* Free the yyjson document */
-    yyjson_doc_free(doc);
-
-    return result;
+    /* Build Ruby object from the document, then free it */
+    return yyjson_build_ruby_object_free(doc, opts);
 }
 
 /*
@@ -130,6 +408,11 @@ yyjson_extract_parse_options(VALUE opts_hash, yyjson_parse_options *opts)
     opts->allow_comments = true;
     opts->max_nesting = 100;
     opts->mode = MODE_COMPAT;
+    opts->gvl_release_threshold = yyjson_gvl_release_threshold;
+    opts->key_cache = yyjson_key_cache_default ? &yyjson_global_key_cache : NULL;
+    opts->mmap = false;
+    opts->shareable = false;
+    opts->dedup_values = false;
 
     /* If no options hash provided, use defaults */
     if (NIL_P(opts_hash)) {
@@ -187,6 +470,26 @@ yyjson_extract_parse_options(VALUE opts_hash, yyjson_parse_options *opts)
 
     val = rb_hash_aref(opts_hash, ID2SYM(id_max_nesting));
     if (!NIL_P(val)) {
-        opts->max_nesting = NUM2INT(val);
+        opts->max_nesting = yyjson_is_falsey(val) ? 0 : NUM2INT(val);
+    }
+
+    val = rb_hash_aref(opts_hash, ID2SYM(id_gvl_release_threshold));
+    if (!NIL_P(val)) {
+        opts->gvl_release_threshold = yyjson_is_falsey(val) ? 0 : NUM2SIZET(val);
+    }
+
+    val = rb_hash_aref(opts_hash, ID2SYM(id_key_cache));
+    if (!NIL_P(val)) {
+        opts->key_cache = RTEST(val) ? &yyjson_global_key_cache : NULL;
+    }
+
+    val = rb_hash_aref(opts_hash, ID2SYM(id_mmap));
+    if (!NIL_P(val)) {
+        opts->mmap = RTEST(val);
+    }
+
+    val = rb_hash_aref(opts_hash, ID2SYM(id_dedup_values));
+    if (!NIL_P(val)) {
+        opts->dedup_values = RTEST(val);
     }
 }
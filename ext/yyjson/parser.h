@@ -8,6 +8,12 @@
 #include "common.h"
 #include "value_builder.h"
 
+/*
+ * Process-wide default for the :gvl_release_threshold parse option
+ * (inputs of at least this many bytes are read without the GVL, 0 = never)
+ */
+extern size_t yyjson_gvl_release_threshold;
+
 /*
  * Parse JSON from a string
  *
@@ -17,6 +23,44 @@
  */
 VALUE yyjson_parse_string(VALUE json_str, const yyjson_parse_options *opts);
 
+/*
+ * Parse JSON from a string with precomputed read flags and an allocator
+ *
+ * @param json_str The JSON string to parse
+ * @param opts Parse options
+ * @param flg Read flags (see yyjson_read_flags())
+ * @param alc Allocator for the yyjson document (NULL = libc malloc)
+ * @return Ruby object representing the parsed JSON
+ */
+VALUE yyjson_parse_string_alc(VALUE json_str, const yyjson_parse_options *opts,
+                              yyjson_read_flag flg, const yyjson_alc *alc);
+
+/*
+ * Read a JSON string into a yyjson document without building Ruby objects
+ *
+ * @param json_str The JSON string to parse
+ * @param opts Parse options (reads gvl_release_threshold)
+ * @param flg Read flags (see yyjson_read_flags())
+ * @param alc Allocator for the yyjson document (NULL = libc malloc)
+ * @return Document owned by the caller; raises YYJson::ParseError on failure
+ */
+yyjson_doc *yyjson_read_string_doc(VALUE json_str, const yyjson_parse_options *opts,
+                                   yyjson_read_flag flg, const yyjson_alc *alc);
+
+/*
+ * Read a JSON string into a yyjson document, without raising on invalid JSON
+ *
+ * @param json_str The JSON string to parse
+ * @param opts Parse options (reads gvl_release_threshold)
+ * @param flg Read flags (see yyjson_read_flags())
+ * @param alc Allocator for the yyjson document (NULL = libc malloc)
+ * @param err Set to the error position and message when NULL is returned
+ * @return Document owned by the caller, or NULL if json_str isn't valid JSON
+ */
+yyjson_doc *yyjson_try_read_string_doc(VALUE json_str, const yyjson_parse_options *opts,
+                                       yyjson_read_flag flg, const yyjson_alc *alc,
+                                       yyjson_read_err *err);
+
 /*
  * Parse JSON from a file
  *
@@ -26,6 +70,36 @@ VALUE yyjson_parse_string(VALUE json_str, const yyjson_parse_options *opts);
  */
 VALUE yyjson_parse_file(VALUE file_path, const yyjson_parse_options *opts);
 
+/*
+ * Parse JSON from a file with precomputed read flags and an allocator
+ *
+ * @param file_path Path to the JSON file
+ * @param opts Parse options
+ * @param flg Read flags (see yyjson_read_flags())
+ * @param alc Allocator for the yyjson document (NULL = libc malloc)
+ * @return Ruby object representing the parsed JSON
+ */
+VALUE yyjson_parse_file_alc(VALUE file_path, const yyjson_parse_options *opts,
+                            yyjson_read_flag flg, const yyjson_alc *alc);
+
+/*
+ * yyjson read flags for a set of parse options
+ *
+ * @param opts Parse options
+ * @return Flags for yyjson_read_opts()
+ */
+yyjson_read_flag yyjson_read_flags(const yyjson_parse_options *opts);
+
+/*
+ * Check a document against a nesting limit without building it
+ *
+ * @param doc The yyjson document
+ * @param max_nesting Maximum depth (0 or less = unlimited)
+ * @return The depth YYJson.load would raise at ("nesting of %d is too
+ *         deep"), or 0 if the document is within the limit
+ */
+int yyjson_doc_nesting_exceeded(yyjson_doc *doc, int max_nesting);
+
 /*
  * Extract parse options from a Ruby hash
  *
@@ -0,0 +1,291 @@
+/*
+ * parser_class.c - YYJson::Parser
+ *
+ * A Parser compiles its options once and owns a yyjson dynamic allocator.
+ * yyjson_doc_free() hands document memory back to that allocator's free
+ * list, so repeated parses reuse the same chunks instead of going through
+ * malloc/free every call.
+ */
+
+#include "common.h"
+#include "parser.h"
+#include "parser_class.h"
+
+static void
+parser_mark(void *ptr)
+{
+    yyjson_parser_t *parser = (yyjson_parser_t *)ptr;
+    if (parser->own_key_cache) yyjson_key_cache_mark(&parser->key_cache);
+}
+
+static void
+parser_free(void *ptr)
+{
+    yyjson_parser_t *parser = (yyjson_parser_t *)ptr;
+    if (parser->alc) yyjson_alc_dyn_free(parser->alc);
+    if (parser->own_key_cache) yyjson_key_cache_free(&parser->key_cache);
+    yyjson_feed_free(&parser->feed);
+    YYJSON_FREE(parser);
+}
+
+static size_t
+parser_memsize(const void *ptr)
+{
+    const yyjson_parser_t *parser = (const yyjson_parser_t *)ptr;
+    size_t size = sizeof(yyjson_parser_t);
+    if (parser->own_key_cache) size += yyjson_key_cache_memsize(&parser->key_cache);
+    size += parser->feed.capa;
+    return size;
+}
+
+#ifdef HAVE_RB_GC_MARK_MOVABLE
+static void
+parser_compact(void *ptr)
+{
+    yyjson_parser_t *parser = (yyjson_parser_t *)ptr;
+    if (parser->own_key_cache) yyjson_key_cache_compact(&parser->key_cache);
+}
+#endif
+
+static const rb_data_type_t parser_type = {
+    .wrap_struct_name = "YYJson::Parser",
+    .function = {
+        .dmark = parser_mark,
+        .dfree = parser_free,
+        .dsize = parser_memsize,
+#ifdef HAVE_RB_GC_MARK_MOVABLE
+        .dcompact = parser_compact,
+#endif
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE
+parser_alloc(VALUE klass)
+{
+    yyjson_parser_t *parser;
+    VALUE obj = TypedData_Make_Struct(klass, yyjson_parser_t, &parser_type, parser);
+    return obj;
+}
+
+yyjson_parser_t *
+yyjson_parser_get(VALUE self)
+{
+    yyjson_parser_t *parser;
+    TypedData_Get_Struct(self, yyjson_parser_t, &parser_type, parser);
+    if (!parser->alc) {
+        rb_raise(rb_eRuntimeError, "uninitialized YYJson::Parser");
+    }
+    return parser;
+}
+
+/*
+ * YYJson::Parser.new(opts = {})
+ *
+ * Create a parser with fixed options. Accepts the same options as
+ * YYJson.load, except that :key_cache selects the parser's own cache:
+ *
+ *   :key_cache - true for a private key cache, :global for the process-wide
+ *                one, false for none (default: YYJson.key_cache ? :global : false)
+ *   :key_cache_capacity - Entries in the private key cache (default: 1024)
+ *
+ * and two options for #feed:
+ *
+ *   :unwrap_array - Emit the elements of a top-level array one by one
+ *   :max_buffer_size - Cap in bytes on buffered input for one incomplete
+ *                      value (default: 64 MiB, nil for no cap)
+ */
+static VALUE
+parser_initialize(int argc, VALUE *argv, VALUE self)
+{
+    yyjson_parser_t *parser;
+    VALUE opts;
+    size_t capacity = KEY_CACHE_DEFAULT_CAPACITY;
+
+    TypedData_Get_Struct(self, yyjson_parser_t, &parser_type, parser);
+    if (parser->alc) {
+        rb_raise(rb_eRuntimeError, "YYJson::Parser is already initialized");
+    }
+
+    rb_scan_args(argc, argv, "01", &opts);
+    if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+
+    yyjson_extract_parse_options(opts, &parser->opts);
+    parser->feed.max_buffer = FEED_DEFAULT_MAX_BUFFER;
+    parser->feed.allow_comments = parser->opts.allow_comments;
+
+    if (!NIL_P(opts)) {
+        VALUE val = rb_hash_aref(opts, ID2SYM(id_key_cache_capacity));
+        if (!NIL_P(val)) {
+            capacity = NUM2SIZET(val);
+            if (capacity == 0) {
+                rb_raise(rb_eArgError, "key cache capacity must be positive");
+            }
+        }
+
+        val = rb_hash_aref(opts, ID2SYM(id_key_cache));
+        if (val == Qtrue) {
+            yyjson_key_cache_init(&parser->key_cache, capacity);
+            parser->own_key_cache = true;
+            parser->opts.key_cache = &parser->key_cache;
+        } else if (SYMBOL_P(val) && SYM2ID(val) == rb_intern("global")) {
+            parser->opts.key_cache = &yyjson_global_key_cache;
+        }
+
+        parser->feed.unwrap_array = RTEST(rb_hash_aref(opts, ID2SYM(id_unwrap_array)));
+
+        VALUE max_buffer = rb_hash_lookup2(opts, ID2SYM(id_max_buffer_size), Qundef);
+        if (max_buffer != Qundef) {
+            if (NIL_P(max_buffer)) {
+                parser->feed.max_buffer = 0;
+            } else {
+                parser->feed.max_buffer = NUM2SIZET(max_buffer);
+                if (parser->feed.max_buffer == 0) {
+                    rb_raise(rb_eArgError, "max_buffer_size must be positive");
+                }
+            }
+        }
+    }
+
+    parser->flg = yyjson_read_flags(&parser->opts);
+    parser->alc = yyjson_alc_dyn_new();
+    if (!parser->alc) {
+        rb_raise(rb_eNoMemError, "failed to allocate YYJson::Parser allocator");
+    }
+
+    return self;
+}
+
+/*
+ * Allocator for the next parse
+ *
+ * Falls back to libc malloc when the pooled allocator is already in use,
+ * e.g. by another thread while the GVL is released during a large read.
+ */
+const yyjson_alc *
+yyjson_parser_acquire(yyjson_parser_t *parser)
+{
+    if (RB_UNLIKELY(parser->busy)) return NULL;
+    parser->busy = true;
+    return parser->alc;
+}
+
+void
+yyjson_parser_release(yyjson_parser_t *parser, const yyjson_alc *alc)
+{
+    if (alc) parser->busy = false;
+}
+
+typedef struct {
+    yyjson_parser_t *parser;
+    const yyjson_alc *alc;
+    VALUE source;
+    bool file;
+} parser_call_args;
+
+static VALUE
+parser_call(VALUE ptr)
+{
+    parser_call_args *args = (parser_call_args *)ptr;
+    yyjson_parser_t *parser = args->parser;
+
+    if (args->file) {
+        return yyjson_parse_file_alc(args->source, &parser->opts, parser->flg, args->alc);
+    }
+    return yyjson_parse_string_alc(args->source, &parser->opts, parser->flg, args->alc);
+}
+
+static VALUE
+parser_call_ensure(VALUE ptr)
+{
+    parser_call_args *args = (parser_call_args *)ptr;
+    yyjson_parser_release(args->parser, args->alc);
+    return Qnil;
+}
+
+static VALUE
+parser_run(VALUE self, VALUE source, bool file)
+{
+    yyjson_parser_t *parser = yyjson_parser_get(self);
+    parser_call_args args = {
+        .parser = parser,
+        .alc = yyjson_parser_acquire(parser),
+        .source = source,
+        .file = file
+    };
+
+    VALUE result = rb_ensure(parser_call, (VALUE)&args, parser_call_ensure, (VALUE)&args);
+    RB_GC_GUARD(self);
+    return result;
+}
+
+/*
+ * parser.parse(source)
+ *
+ * Parse a JSON string with this parser's options.
+ */
+static VALUE
+parser_parse(VALUE self, VALUE source)
+{
+    return parser_run(self, source, false);
+}
+
+/*
+ * parser.parse_file(path)
+ *
+ * Parse a JSON file with this parser's options.
+ */
+static VALUE
+parser_parse_file(VALUE self, VALUE path)
+{
+    return parser_run(self, path, true);
+}
+
+/*
+ * parser.reset
+ *
+ * Release the memory pooled by the allocator (it only grows otherwise,
+ * up to the largest document parsed so far).
+ */
+static VALUE
+parser_reset(VALUE self)
+{
+    yyjson_parser_t *parser = yyjson_parser_get(self);
+    if (parser->busy) {
+        rb_raise(rb_eRuntimeError, "YYJson::Parser is in use");
+    }
+
+    yyjson_alc *alc = yyjson_alc_dyn_new();
+    if (!alc) {
+        rb_raise(rb_eNoMemError, "failed to allocate YYJson::Parser allocator");
+    }
+    yyjson_alc_dyn_free(parser->alc);
+    parser->alc = alc;
+    return self;
+}
+
+/*
+ * parser.key_cache_stats
+ *
+ * Returns the stats Hash of the key cache this parser uses, or nil.
+ */
+static VALUE
+parser_key_cache_stats(VALUE self)
+{
+    yyjson_parser_t *parser = yyjson_parser_get(self);
+    if (!parser->opts.key_cache) return Qnil;
+    return yyjson_key_cache_stats(parser->opts.key_cache);
+}
+
+void
+yyjson_parser_class_init(void)
+{
+    cParser = rb_define_class_under(mYYJson, "Parser", rb_cObject);
+    rb_define_alloc_func(cParser, parser_alloc);
+    rb_define_method(cParser, "initialize", parser_initialize, -1);
+    rb_define_method(cParser, "parse", parser_parse, 1);
+    rb_define_method(cParser, "load", parser_parse, 1);
+    rb_define_method(cParser, "parse_file", parser_parse_file, 1);
+    rb_define_method(cParser, "reset", parser_reset, 0);
+    rb_define_method(cParser, "key_cache_stats", parser_key_cache_stats, 0);
+}
@@ -0,0 +1,48 @@
+/*
+ * parser_class.h - YYJson::Parser (reusable parser with preset options)
+ */
+
+#ifndef YYJSON_RUBY_PARSER_CLASS_H
+#define YYJSON_RUBY_PARSER_CLASS_H
+
+#include "common.h"
+#include "value_builder.h"
+#include "feed.h"
+
+/*
+ * Native state of a YYJson::Parser
+ */
+typedef struct {
+    yyjson_parse_options opts;
+    yyjson_read_flag flg;
+    yyjson_alc *alc;          /* yyjson_alc_dyn_new(), reused across parses */
+    bool busy;                /* alc is in use by a parse (GVL released or reentrant) */
+    bool own_key_cache;       /* key_cache below is initialized */
+    key_cache_t key_cache;    /* Private key cache (key_cache: true) */
+    feed_state_t feed;        /* Incremental input for #feed */
+} yyjson_parser_t;
+
+/*
+ * Define YYJson::Parser (called from Init_yyjson)
+ */
+void yyjson_parser_class_init(void);
+
+/*
+ * Native state of an initialized YYJson::Parser (raises otherwise)
+ */
+yyjson_parser_t *yyjson_parser_get(VALUE self);
+
+/*
+ * Take the parser's pooled allocator for one parse
+ *
+ * Returns NULL (use libc malloc) if it is already in use. Pass the result
+ * to yyjson_parser_release() when the document has been freed.
+ */
+const yyjson_alc *yyjson_parser_acquire(yyjson_parser_t *parser);
+
+/*
+ * Give back an allocator returned by yyjson_parser_acquire()
+ */
+void yyjson_parser_release(yyjson_parser_t *parser, const yyjson_alc *alc);
+
+#endif /* YYJSON_RUBY_PARSER_CLASS_H */
@@ -0,0 +1,187 @@
+/*
+ * patch.c - JSON Merge Patch (RFC 7386) and JSON Patch (RFC 6902):
+ * YYJson.merge_patch / YYJson.patch
+ *
+ * Both documents are read into yyjson documents, patched into a
+ * yyjson_mut_doc by the vendored yyjson_merge_patch() / yyjson_patch(),
+ * and written back as JSON text: no Ruby object is made for any part of
+ * either document, only the result String.
+ */
+
+#include "common.h"
+#include "parser.h"
+#include "patch.h"
+
+/* The vendored patch functions copy and compare values recursively:
+ * deeper documents are rejected even with max_nesting: false */
+#define PATCH_MAX_NESTING 1000
+
+static VALUE ePatchError = Qnil;
+static ID id_dump;
+
+/*
+ * Arguments of one patch (released in patch_ensure)
+ */
+typedef struct {
+    VALUE source;
+    VALUE patch;             /* JSON text of the patch */
+    bool merge;              /* RFC 7386 (else RFC 6902) */
+    yyjson_parse_options opts;
+    yyjson_write_flag wflg;
+    yyjson_doc *doc;
+    yyjson_doc *patch_doc;
+    yyjson_mut_doc *out;
+    char *json;              /* The written result (malloc) */
+} patch_args;
+
+static yyjson_doc *
+read_doc(VALUE source, patch_args *args)
+{
+    /* Integers beyond 64 bits stay raw, so they are written back exactly */
+    yyjson_read_flag flg = yyjson_read_flags(&args->opts) | YYJSON_READ_BIGNUM_AS_RAW;
+    yyjson_doc *doc = yyjson_read_string_doc(source, &args->opts, flg, NULL);
+
+    int max_nesting = args->opts.max_nesting;
+    if (max_nesting <= 0 || max_nesting > PATCH_MAX_NESTING) max_nesting = PATCH_MAX_NESTING;
+
+    int depth = yyjson_doc_nesting_exceeded(doc, max_nesting);
+    if (depth) {
+        yyjson_doc_free(doc);
+        rb_raise(eParseError, "nesting of %d is too deep", depth);
+    }
+    return doc;
+}
+
+/*
+ * Raise for a JSON Patch that could not be applied
+ */
+static void
+raise_patch_error(const yyjson_patch_err *err)
+{
+    if (err->code == YYJSON_PATCH_ERROR_MEMORY_ALLOCATION) rb_memerror();
+    if (err->code == YYJSON_PATCH_ERROR_POINTER && err->ptr.msg) {
+        rb_raise(ePatchError, "JSON Patch operation %zu failed: %s (%s)", err->idx, err->msg, err->ptr.msg);
+    }
+    rb_raise(ePatchError, "JSON Patch operation %zu failed: %s", err->idx, err->msg);
+}
+
+static VALUE
+patch_body(VALUE ptr)
+{
+    patch_args *args = (patch_args *)ptr;
+
+    args->doc = read_doc(args->source, args);
+    args->patch_doc = read_doc(args->patch, args);
+
+    args->out = yyjson_mut_doc_new(NULL);
+    if (!args->out) rb_memerror();
+
+    yyjson_val *orig = yyjson_doc_get_root(args->doc);
+    yyjson_val *patch = yyjson_doc_get_root(args->patch_doc);
+    yyjson_mut_val *root;
+    if (args->merge) {
+        root = yyjson_merge_patch(args->out, orig, patch);
+        if (!root) rb_memerror();
+    } else {
+        if (!yyjson_is_arr(patch)) {
+            rb_raise(rb_eArgError, "JSON Patch must be an array of operations");
+        }
+        yyjson_patch_err err;
+        root = yyjson_patch(args->out, orig, patch, &err);
+        if (!root) raise_patch_error(&err);
+    }
+    yyjson_mut_doc_set_root(args->out, root);
+
+    size_t len;
+    yyjson_write_err err;
+    args->json = yyjson_mut_write_opts(args->out, args->wflg, NULL, &len, &err);
+    if (!args->json) {
+        rb_raise(eGenerateError, "Failed to write JSON: %s", err.msg);
+    }
+    return rb_utf8_str_new(args->json, (long)len);
+}
+
+static VALUE
+patch_ensure(VALUE ptr)
+{
+    patch_args *args = (patch_args *)ptr;
+    if (args->json) free(args->json);
+    if (args->out) yyjson_mut_doc_free(args->out);
+    if (args->patch_doc) yyjson_doc_free(args->patch_doc);
+    if (args->doc) yyjson_doc_free(args->doc);
+    return Qnil;
+}
+
+static VALUE
+patch_run(int argc, VALUE *argv, bool merge)
+{
+    VALUE source, patch, opts;
+    rb_scan_args(argc, argv, "21", &source, &patch, &opts);
+    if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+
+    /* A patch given as Ruby objects is dumped first */
+    if (!RB_TYPE_P(patch, T_STRING)) patch = rb_funcall(mYYJson, id_dump, 1, patch);
+
+    patch_args args = {
+        .source = source,
+        .patch = patch,
+        .merge = merge,
+        .wflg = YYJSON_WRITE_NOFLAG,
+        .doc = NULL,
+        .patch_doc = NULL,
+        .out = NULL,
+        .json = NULL
+    };
+    yyjson_extract_parse_options(opts, &args.opts);
+    if (args.opts.allow_nan) args.wflg |= YYJSON_WRITE_ALLOW_INF_AND_NAN;
+    if (!NIL_P(opts) && RTEST(rb_hash_aref(opts, ID2SYM(id_pretty)))) {
+        args.wflg |= YYJSON_WRITE_PRETTY_TWO_SPACES;
+    }
+
+    VALUE result = rb_ensure(patch_body, (VALUE)&args, patch_ensure, (VALUE)&args);
+    RB_GC_GUARD(patch);
+    return result;
+}
+
+/*
+ * YYJson.merge_patch(json, patch, opts = {})
+ *
+ * Apply a JSON Merge Patch (RFC 7386): members of the patch object replace
+ * those of the document, null members remove them, and nested objects
+ * merge recursively. patch is JSON text, or Ruby objects to dump first.
+ * Accepts the YYJson.load parsing options, plus :pretty.
+ *
+ * Returns the patched document as a JSON String.
+ */
+static VALUE
+yyjson_merge_patch_m(int argc, VALUE *argv, VALUE self)
+{
+    return patch_run(argc, argv, true);
+}
+
+/*
+ * YYJson.patch(json, operations, opts = {})
+ *
+ * Apply a JSON Patch (RFC 6902): an array of add / remove / replace /
+ * move / copy / test operations, as JSON text or Ruby objects to dump
+ * first. Accepts the same options as YYJson.merge_patch.
+ *
+ * Returns the patched document as a JSON String. Raises
+ * YYJson::PatchError if an operation fails (nothing is applied) and
+ * ArgumentError unless operations is an array.
+ */
+static VALUE
+yyjson_patch_m(int argc, VALUE *argv, VALUE self)
+{
+    return patch_run(argc, argv, false);
+}
+
+void
+yyjson_patch_init(void)
+{
+    id_dump = rb_intern("dump");
+
+    ePatchError = rb_define_class_under(mYYJson, "PatchError", eYYJsonError);
+    rb_define_singleton_method(mYYJson, "merge_patch", yyjson_merge_patch_m, -1);
+    rb_define_singleton_method(mYYJson, "patch", yyjson_patch_m, -1);
+}
@@ -0,0 +1,17 @@
+/*
+ * patch.h - JSON Merge Patch / JSON Patch on documents (YYJson.merge_patch,
+ * YYJson.patch)
+ */
+
+#ifndef YYJSON_RUBY_PATCH_H
+#define YYJSON_RUBY_PATCH_H
+
+#include "common.h"
+
+/*
+ * Define YYJson.merge_patch, YYJson.patch and YYJson::PatchError (called
+ * from Init_yyjson)
+ */
+void yyjson_patch_init(void);
+
+#endif /* YYJSON_RUBY_PATCH_H */
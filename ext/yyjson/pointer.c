@@ -0,0 +1,134 @@
+/*
+ * pointer.c - JSON Pointer extraction: YYJson.extract / extract_many
+ *
+ * The input is parsed into a yyjson document once, the requested RFC 6901
+ * pointers are resolved with yyjson_doc_ptr_getx(), and only the values
+ * they point at are converted to Ruby. The rest of the document never
+ * becomes Hashes, Arrays or Strings.
+ */
+
+#include "common.h"
+#include "parser.h"
+#include "pointer.h"
+
+typedef struct {
+    VALUE source;
+    VALUE paths;           /* Array of pointer Strings (extract_many), or one String */
+    yyjson_parse_options opts;
+    yyjson_doc *doc;
+} extract_args;
+
+/*
+ * Ruby value at a pointer, nil if it doesn't resolve
+ */
+static VALUE
+extract_one(extract_args *args, VALUE path)
+{
+    yyjson_ptr_err err;
+    yyjson_val *val = yyjson_doc_ptr_getx(args->doc, RSTRING_PTR(path), (size_t)RSTRING_LEN(path), &err);
+
+    if (!val) {
+        if (err.code == YYJSON_PTR_ERR_SYNTAX) {
+            rb_raise(rb_eArgError, "invalid JSON Pointer %+"PRIsVALUE" at position %zu: %s",
+                     path, err.pos, err.msg);
+        }
+        return Qnil;
+    }
+    return yyjson_build_ruby_value(val, &args->opts);
+}
+
+static VALUE
+extract_body(VALUE ptr)
+{
+    extract_args *args = (extract_args *)ptr;
+
+    args->doc = yyjson_read_string_doc(args->source, &args->opts,
+                                       yyjson_read_flags(&args->opts), NULL);
+
+    if (RB_TYPE_P(args->paths, T_STRING)) {
+        return extract_one(args, args->paths);
+    }
+
+    long n = RARRAY_LEN(args->paths);
+    VALUE result = rb_ary_new_capa(n);
+    for (long i = 0; i < n; i++) {
+        rb_ary_push(result, extract_one(args, RARRAY_AREF(args->paths, i)));
+    }
+    return result;
+}
+
+static VALUE
+extract_ensure(VALUE ptr)
+{
+    extract_args *args = (extract_args *)ptr;
+    if (args->doc) yyjson_doc_free(args->doc);
+    return Qnil;
+}
+
+static VALUE
+extract_run(VALUE source, VALUE paths, VALUE opts)
+{
+    if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+
+    extract_args args = {
+        .source = source,
+        .paths = paths,
+        .doc = NULL
+    };
+    yyjson_extract_parse_options(opts, &args.opts);
+
+    VALUE result = rb_ensure(extract_body, (VALUE)&args, extract_ensure, (VALUE)&args);
+    RB_GC_GUARD(paths);
+    return result;
+}
+
+/*
+ * YYJson.extract(source, pointer, opts = {})
+ *
+ * Value at a JSON Pointer (RFC 6901, e.g. "/users/0/name"; "" is the whole
+ * document), or nil if nothing is there. Only that value is converted to
+ * Ruby. Accepts the YYJson.load options.
+ *
+ * Raises ArgumentError for a malformed pointer.
+ */
+static VALUE
+yyjson_extract(int argc, VALUE *argv, VALUE self)
+{
+    VALUE source, path, opts;
+    rb_scan_args(argc, argv, "21", &source, &path, &opts);
+    StringValue(path);
+
+    return extract_run(source, path, opts);
+}
+
+/*
+ * YYJson.extract_many(source, pointers, opts = {})
+ *
+ * Values at several JSON Pointers (an Array of Strings), in the same
+ * order, from a single parse. Unresolved pointers give nil.
+ */
+static VALUE
+yyjson_extract_many(int argc, VALUE *argv, VALUE self)
+{
+    VALUE source, paths, opts;
+    rb_scan_args(argc, argv, "21", &source, &paths, &opts);
+    Check_Type(paths, T_ARRAY);
+
+    /* Convert every pointer before parsing */
+    long n = RARRAY_LEN(paths);
+    VALUE strs = rb_ary_new_capa(n);
+    for (long i = 0; i < n; i++) {
+        VALUE path = RARRAY_AREF(paths, i);
+        StringValue(path);
+        rb_ary_push(strs, path);
+    }
+
+    return extract_run(source, strs, opts);
+}
+
+void
+yyjson_pointer_init(void)
+{
+    rb_define_singleton_method(mYYJson, "extract", yyjson_extract, -1);
+    rb_define_singleton_method(mYYJson, "extract_many", yyjson_extract_many, -1);
+}
@@ -0,0 +1,15 @@
+/*
+ * pointer.h - JSON Pointer extraction (YYJson.extract / extract_many)
+ */
+
+#ifndef YYJSON_RUBY_POINTER_H
+#define YYJSON_RUBY_POINTER_H
+
+#include "common.h"
+
+/*
+ * Define YYJson.extract and YYJson.extract_many (called from Init_yyjson)
+ */
+void yyjson_pointer_init(void);
+
+#endif /* YYJSON_RUBY_POINTER_H */
@@ -0,0 +1,1266 @@
+/*
+ * schema.c - Validation without building Ruby objects: YYJson.valid? and
+ * YYJson::Schema
+ *
+ * YYJson.valid? reads the input into a yyjson document and frees it, so
+ * rejecting bad input costs a parse and no Hashes, Arrays or Strings.
+ *
+ * YYJson::Schema.compile turns a JSON Schema (draft 7 keywords, local
+ * $refs) into a flat array of nodes once. Validation walks a parsed yyjson
+ * document against those nodes in C; Ruby objects are only created for
+ * error reports and for the strings checked by `pattern` /
+ * `patternProperties`. Errors point into the input with JSON Pointers
+ * (RFC 6901).
+ *
+ * The walk recurses per nesting level of the input, which YYJson.valid?
+ * and the Schema methods bound by :max_nesting first, the way YYJson.load
+ * would reject the document. Without a limit, running short of C stack
+ * stops the walk and counts as too deeply nested.
+ */
+
+#include "common.h"
+#include "parser.h"
+#include "schema.h"
+#include <math.h>
+#include <ruby/st.h>
+#include <ruby/re.h>
+
+static VALUE cSchema;
+
+static ID id_schema;
+static ID id_match_p;
+static ID id_dump;
+static VALUE sym_pointer;
+static VALUE sym_keyword;
+static VALUE sym_message;
+
+/* Instance types a node accepts (integers are numbers too) */
+enum {
+    TYPE_NULL = 1 << 0,
+    TYPE_BOOLEAN = 1 << 1,
+    TYPE_OBJECT = 1 << 2,
+    TYPE_ARRAY = 1 << 3,
+    TYPE_NUMBER = 1 << 4,
+    TYPE_INTEGER = 1 << 5,
+    TYPE_STRING = 1 << 6
+};
+
+static const char *const type_names[] = {
+    "null", "boolean", "object", "array", "number", "integer", "string"
+};
+#define TYPE_COUNT ((int)(sizeof(type_names) / sizeof(type_names[0])))
+
+/* Numeric keywords present on a node */
+enum {
+    HAS_MINIMUM = 1 << 0,
+    HAS_MAXIMUM = 1 << 1,
+    HAS_EXCLUSIVE_MINIMUM = 1 << 2,
+    HAS_EXCLUSIVE_MAXIMUM = 1 << 3,
+    HAS_MULTIPLE_OF = 1 << 4
+};
+
+/* `properties` entry (sorted by length, then bytes) */
+typedef struct {
+    const char *name;
+    size_t len;
+    int node;
+} schema_prop_t;
+
+/* `patternProperties` entry */
+typedef struct {
+    long regex;              /* Index into schema_t.patterns */
+    int node;
+} schema_pattern_prop_t;
+
+typedef struct {
+    int *nodes;
+    long len;
+} schema_list_t;
+
+/*
+ * One compiled (sub)schema. Node indexes are -1 when the keyword is absent.
+ */
+typedef struct {
+    bool reject;             /* The `false` schema */
+    int ref;                 /* $ref target (other keywords are ignored) */
+    unsigned types;          /* TYPE_* bits accepted, 0 = any */
+    unsigned num_flags;      /* HAS_* bits */
+    double minimum, maximum, exclusive_minimum, exclusive_maximum, multiple_of;
+    size_t min_length, max_length;         /* In code points; max SIZE_MAX = none */
+    size_t min_items, max_items;
+    size_t min_properties, max_properties;
+    bool unique_items;
+    yyjson_val *const_val;   /* Into schema_t.doc */
+    yyjson_val *enum_vals;   /* Array, into schema_t.doc */
+    long pattern;            /* Index into schema_t.patterns, -1 = none */
+
+    schema_prop_t *props;
+    long nprops;
+    yyjson_val **required;   /* String values in schema_t.doc */
+    long nrequired;
+    schema_pattern_prop_t *pattern_props;
+    long npattern_props;
+    int additional_properties;
+    int property_names;
+
+    int items;               /* One schema for every item */
+    schema_list_t tuple;     /* `items` given as an array */
+    int additional_items;    /* Items past the tuple */
+    int contains;
+
+    schema_list_t all_of, any_of, one_of;
+    int not_schema, if_schema, then_schema, else_schema;
+} schema_node_t;
+
+typedef struct {
+    yyjson_doc *doc;         /* The schema itself (const / enum / names point into it) */
+    schema_node_t *nodes;    /* nodes[0] is the root */
+    long len, capa;
+    VALUE patterns;          /* Frozen Array of frozen Regexps */
+    st_table *compiled;      /* yyjson_val * => node index, only while compiling */
+    bool too_deep;           /* Ran out of C stack while compiling */
+} schema_t;
+
+/* ---- YYJson::Schema object ---- */
+
+static void
+schema_mark(void *ptr)
+{
+    schema_t *s = ptr;
+    rb_gc_mark(s->patterns);
+}
+
+static void
+schema_free(void *ptr)
+{
+    schema_t *s = ptr;
+    for (long i = 0; i < s->len; i++) {
+        schema_node_t *n = &s->nodes[i];
+        xfree(n->props);
+        xfree(n->required);
+        xfree(n->pattern_props);
+        xfree(n->tuple.nodes);
+        xfree(n->all_of.nodes);
+        xfree(n->any_of.nodes);
+        xfree(n->one_of.nodes);
+    }
+    xfree(s->nodes);
+    if (s->compiled) st_free_table(s->compiled);
+    if (s->doc) yyjson_doc_free(s->doc);
+    xfree(s);
+}
+
+static size_t
+schema_memsize(const void *ptr)
+{
+    const schema_t *s = ptr;
+    return sizeof(*s) + (size_t)s->capa * sizeof(schema_node_t) +
+           (s->doc ? yyjson_doc_get_val_count(s->doc) * sizeof(yyjson_val) : 0);
+}
+
+static const rb_data_type_t schema_type = {
+    .wrap_struct_name = "YYJson::Schema",
+    .function = {
+        .dmark = schema_mark,
+        .dfree = schema_free,
+        .dsize = schema_memsize,
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY | RUBY_TYPED_FROZEN_SHAREABLE
+};
+
+static VALUE
+schema_alloc(VALUE klass)
+{
+    schema_t *s;
+    VALUE self = TypedData_Make_Struct(klass, schema_t, &schema_type, s);
+    s->patterns = Qnil;
+    return self;
+}
+
+static schema_t *
+get_schema(VALUE self)
+{
+    schema_t *s = rb_check_typeddata(self, &schema_type);
+    if (!s->nodes) rb_raise(rb_eArgError, "uninitialized YYJson::Schema");
+    return s;
+}
+
+/* ---- Compiling ---- */
+
+/* Raise ArgumentError for a malformed schema (fmt must be a literal) */
+#define invalid_schema(...) rb_raise(rb_eArgError, "invalid JSON Schema: " __VA_ARGS__)
+
+static int
+new_node(schema_t *s)
+{
+    if (s->len == s->capa) {
+        long capa = s->capa ? s->capa * 2 : 16;
+        REALLOC_N(s->nodes, schema_node_t, capa);
+        s->capa = capa;
+    }
+    s->nodes[s->len] = (schema_node_t){
+        .ref = -1,
+        .max_length = SIZE_MAX,
+        .max_items = SIZE_MAX,
+        .max_properties = SIZE_MAX,
+        .pattern = -1,
+        .additional_properties = -1,
+        .property_names = -1,
+        .items = -1,
+        .additional_items = -1,
+        .contains = -1,
+        .not_schema = -1,
+        .if_schema = -1,
+        .then_schema = -1,
+        .else_schema = -1
+    };
+    return (int)s->len++;
+}
+
+static int compile_node(schema_t *s, yyjson_val *val);
+
+static size_t
+get_size(yyjson_val *val, const char *keyword)
+{
+    if (yyjson_is_uint(val)) return (size_t)yyjson_get_uint(val);
+    if (yyjson_is_real(val) && yyjson_get_real(val) >= 0 && yyjson_get_real(val) == floor(yyjson_get_real(val))) {
+        return (size_t)yyjson_get_real(val);
+    }
+    invalid_schema("%s must be a non-negative integer", keyword);
+}
+
+static double
+get_number(yyjson_val *val, const char *keyword)
+{
+    if (!yyjson_is_num(val)) invalid_schema("%s must be a number", keyword);
+    return yyjson_get_num(val);
+}
+
+static long
+add_pattern(schema_t *s, yyjson_val *val, const char *keyword)
+{
+    if (!yyjson_is_str(val)) invalid_schema("%s must be a string", keyword);
+    VALUE re = rb_reg_new_str(rb_utf8_str_new(yyjson_get_str(val), (long)yyjson_get_len(val)), 0);
+    rb_obj_freeze(re);
+    rb_ary_push(s->patterns, re);
+    return RARRAY_LEN(s->patterns) - 1;
+}
+
+static unsigned
+type_bit(yyjson_val *val)
+{
+    if (!yyjson_is_str(val)) invalid_schema("type must be a string or an array of strings");
+    for (int i = 0; i < TYPE_COUNT; i++) {
+        if (yyjson_equals_str(val, type_names[i])) {
+            /* "number" covers integers */
+            return i == 4 ? (TYPE_NUMBER | TYPE_INTEGER) : 1u << i;
+        }
+    }
+    invalid_schema("unknown type \"%s\"", yyjson_get_str(val));
+}
+
+/*
+ * Compile a non-empty array of schemas (allOf / anyOf / oneOf / items)
+ */
+static void
+compile_list(schema_t *s, int idx, size_t list_offset, yyjson_val *val, const char *keyword)
+{
+    if (!yyjson_is_arr(val) || yyjson_arr_size(val) == 0) {
+        invalid_schema("%s must be a non-empty array of schemas", keyword);
+    }
+    size_t n = yyjson_arr_size(val);
+    schema_list_t *list = (schema_list_t *)((char *)&s->nodes[idx] + list_offset);
+    /* A repeated keyword replaces the earlier one */
+    xfree(list->nodes);
+    list->nodes = ALLOC_N(int, n);
+    list->len = 0;
+
+    size_t i, max;
+    yyjson_val *item;
+    yyjson_arr_foreach(val, i, max, item) {
+        int child = compile_node(s, item);
+        /* s->nodes may have moved */
+        list = (schema_list_t *)((char *)&s->nodes[idx] + list_offset);
+        list->nodes[list->len++] = child;
+    }
+}
+
+static int
+compare_props(const void *a, const void *b)
+{
+    const schema_prop_t *x = a, *y = b;
+    if (x->len != y->len) return x->len < y->len ? -1 : 1;
+    return memcmp(x->name, y->name, x->len);
+}
+
+static void
+compile_properties(schema_t *s, int idx, yyjson_val *val)
+{
+    if (!yyjson_is_obj(val)) invalid_schema("properties must be an object");
+    xfree(s->nodes[idx].props);
+    s->nodes[idx].nprops = 0;
+    s->nodes[idx].props = ALLOC_N(schema_prop_t, yyjson_obj_size(val));
+
+    size_t i, max;
+    yyjson_val *key, *sub;
+    yyjson_obj_foreach(val, i, max, key, sub) {
+        int child = compile_node(s, sub);
+        schema_node_t *n = &s->nodes[idx];
+        n->props[n->nprops++] = (schema_prop_t){
+            .name = yyjson_get_str(key),
+            .len = yyjson_get_len(key),
+            .node = child
+        };
+    }
+    qsort(s->nodes[idx].props, (size_t)s->nodes[idx].nprops, sizeof(schema_prop_t), compare_props);
+}
+
+static void
+compile_pattern_properties(schema_t *s, int idx, yyjson_val *val)
+{
+    if (!yyjson_is_obj(val)) invalid_schema("patternProperties must be an object");
+    xfree(s->nodes[idx].pattern_props);
+    s->nodes[idx].npattern_props = 0;
+    s->nodes[idx].pattern_props = ALLOC_N(schema_pattern_prop_t, yyjson_obj_size(val));
+
+    size_t i, max;
+    yyjson_val *key, *sub;
+    yyjson_obj_foreach(val, i, max, key, sub) {
+        long regex = add_pattern(s, key, "patternProperties keys");
+        int child = compile_node(s, sub);
+        schema_node_t *n = &s->nodes[idx];
+        n->pattern_props[n->npattern_props++] = (schema_pattern_prop_t){ .regex = regex, .node = child };
+    }
+}
+
+static void
+compile_required(schema_t *s, int idx, yyjson_val *val)
+{
+    if (!yyjson_is_arr(val)) invalid_schema("required must be an array of strings");
+    schema_node_t *n = &s->nodes[idx];
+    xfree(n->required);
+    n->nrequired = 0;
+    n->required = ALLOC_N(yyjson_val *, yyjson_arr_size(val) + 1);
+
+    size_t i, max;
+    yyjson_val *name;
+    yyjson_arr_foreach(val, i, max, name) {
+        if (!yyjson_is_str(name)) invalid_schema("required must be an array of strings");
+        n->required[n->nrequired++] = name;
+    }
+}
+
+#define KEYWORD(k) yyjson_equals_str(key, (k))
+#define LIST_OFFSET(field) offsetof(schema_node_t, field)
+
+/*
+ * Apply one keyword of an object schema to node idx (unknown keywords,
+ * including annotations like title / format / $schema, are ignored)
+ */
+static void
+compile_keyword(schema_t *s, int idx, yyjson_val *key, yyjson_val *val)
+{
+    int child;
+
+    if (KEYWORD("type")) {
+        unsigned types = 0;
+        if (yyjson_is_arr(val)) {
+            size_t i, max;
+            yyjson_val *t;
+            yyjson_arr_foreach(val, i, max, t) types |= type_bit(t);
+        } else {
+            types = type_bit(val);
+        }
+        s->nodes[idx].types = types;
+    } else if (KEYWORD("const")) {
+        s->nodes[idx].const_val = val;
+    } else if (KEYWORD("enum")) {
+        if (!yyjson_is_arr(val)) invalid_schema("enum must be an array");
+        s->nodes[idx].enum_vals = val;
+    } else if (KEYWORD("minimum")) {
+        s->nodes[idx].minimum = get_number(val, "minimum");
+        s->nodes[idx].num_flags |= HAS_MINIMUM;
+    } else if (KEYWORD("maximum")) {
+        s->nodes[idx].maximum = get_number(val, "maximum");
+        s->nodes[idx].num_flags |= HAS_MAXIMUM;
+    } else if (KEYWORD("exclusiveMinimum")) {
+        s->nodes[idx].exclusive_minimum = get_number(val, "exclusiveMinimum");
+        s->nodes[idx].num_flags |= HAS_EXCLUSIVE_MINIMUM;
+    } else if (KEYWORD("exclusiveMaximum")) {
+        s->nodes[idx].exclusive_maximum = get_number(val, "exclusiveMaximum");
+        s->nodes[idx].num_flags |= HAS_EXCLUSIVE_MAXIMUM;
+    } else if (KEYWORD("multipleOf")) {
+        double m = get_number(val, "multipleOf");
+        if (!(m > 0)) invalid_schema("multipleOf must be greater than 0");
+        s->nodes[idx].multiple_of = m;
+        s->nodes[idx].num_flags |= HAS_MULTIPLE_OF;
+    } else if (KEYWORD("minLength")) {
+        s->nodes[idx].min_length = get_size(val, "minLength");
+    } else if (KEYWORD("maxLength")) {
+        s->nodes[idx].max_length = get_size(val, "maxLength");
+    } else if (KEYWORD("pattern")) {
+        long pattern = add_pattern(s, val, "pattern");
+        s->nodes[idx].pattern = pattern;
+    } else if (KEYWORD("minItems")) {
+        s->nodes[idx].min_items = get_size(val, "minItems");
+    } else if (KEYWORD("maxItems")) {
+        s->nodes[idx].max_items = get_size(val, "maxItems");
+    } else if (KEYWORD("uniqueItems")) {
+        s->nodes[idx].unique_items = yyjson_is_true(val);
+    } else if (KEYWORD("items")) {
+        if (yyjson_is_arr(val)) {
+            compile_list(s, idx, LIST_OFFSET(tuple), val, "items");
+        } else {
+            child = compile_node(s, val);
+            s->nodes[idx].items = child;
+        }
+    } else if (KEYWORD("additionalItems")) {
+        child = compile_node(s, val);
+        s->nodes[idx].additional_items = child;
+    } else if (KEYWORD("contains")) {
+        child = compile_node(s, val);
+        s->nodes[idx].contains = child;
+    } else if (KEYWORD("minProperties")) {
+        s->nodes[idx].min_properties = get_size(val, "minProperties");
+    } else if (KEYWORD("maxProperties")) {
+        s->nodes[idx].max_properties = get_size(val, "maxProperties");
+    } else if (KEYWORD("required")) {
+        compile_required(s, idx, val);
+    } else if (KEYWORD("properties")) {
+        compile_properties(s, idx, val);
+    } else if (KEYWORD("patternProperties")) {
+        compile_pattern_properties(s, idx, val);
+    } else if (KEYWORD("additionalProperties")) {
+        child = compile_node(s, val);
+        s->nodes[idx].additional_properties = child;
+    } else if (KEYWORD("propertyNames")) {
+        child = compile_node(s, val);
+        s->nodes[idx].property_names = child;
+    } else if (KEYWORD("allOf")) {
+        compile_list(s, idx, LIST_OFFSET(all_of), val, "allOf");
+    } else if (KEYWORD("anyOf")) {
+        compile_list(s, idx, LIST_OFFSET(any_of), val, "anyOf");
+    } else if (KEYWORD("oneOf")) {
+        compile_list(s, idx, LIST_OFFSET(one_of), val, "oneOf");
+    } else if (KEYWORD("not")) {
+        child = compile_node(s, val);
+        s->nodes[idx].not_schema = child;
+    } else if (KEYWORD("if")) {
+        child = compile_node(s, val);
+        s->nodes[idx].if_schema = child;
+    } else if (KEYWORD("then")) {
+        child = compile_node(s, val);
+        s->nodes[idx].then_schema = child;
+    } else if (KEYWORD("else")) {
+        child = compile_node(s, val);
+        s->nodes[idx].else_schema = child;
+    }
+}
+
+#undef KEYWORD
+#undef LIST_OFFSET
+
+/*
+ * Schema a $ref points at: "#" or "#/json/pointer" within this document
+ */
+static yyjson_val *
+resolve_ref(schema_t *s, yyjson_val *ref)
+{
+    if (!yyjson_is_str(ref)) invalid_schema("$ref must be a string");
+    const char *str = yyjson_get_str(ref);
+    size_t len = yyjson_get_len(ref);
+    if (len == 0 || str[0] != '#' || (len > 1 && str[1] != '/')) {
+        invalid_schema("unsupported $ref \"%s\" (only local \"#/...\" references)", str);
+    }
+
+    yyjson_val *target = yyjson_doc_ptr_getn(s->doc, str + 1, len - 1);
+    if (!target) invalid_schema("unresolved $ref \"%s\"", str);
+    return target;
+}
+
+/*
+ * Node index for a schema value, compiling it on first use. Each value is
+ * compiled once, which also ties recursive $refs into cycles.
+ */
+static int
+compile_node(schema_t *s, yyjson_val *val)
+{
+    st_data_t found;
+    if (st_lookup(s->compiled, (st_data_t)val, &found)) return (int)found;
+    /* Near the end of the C stack: unwind (raising here would overflow),
+     * schema_s_compile reports it */
+    if (RB_UNLIKELY(s->too_deep || ruby_stack_check())) {
+        s->too_deep = true;
+        return 0;
+    }
+    if (!yyjson_is_obj(val) && !yyjson_is_bool(val)) {
+        invalid_schema("a schema must be an object or a boolean");
+    }
+
+    int idx = new_node(s);
+    st_insert(s->compiled, (st_data_t)val, (st_data_t)idx);
+
+    if (yyjson_is_bool(val)) {
+        s->nodes[idx].reject = !yyjson_get_bool(val);
+        return idx;
+    }
+
+    yyjson_val *ref = yyjson_obj_get(val, "$ref");
+    if (ref) {
+        int target = compile_node(s, resolve_ref(s, ref));
+        s->nodes[idx].ref = target;
+        return idx;
+    }
+
+    size_t i, max;
+    yyjson_val *key, *sub;
+    yyjson_obj_foreach(val, i, max, key, sub) {
+        compile_keyword(s, idx, key, sub);
+    }
+    return idx;
+}
+
+/*
+ * k-th subschema that node n applies to the value itself ($ref, allOf /
+ * anyOf / oneOf, not, if / then / else): -1 if absent, -2 past the last
+ */
+static int
+inplace_child(const schema_node_t *n, long k)
+{
+    /* A $ref replaces the node's other keywords */
+    if (n->ref >= 0) return k == 0 ? n->ref : -2;
+
+    const schema_list_t *lists[] = { &n->all_of, &n->any_of, &n->one_of };
+    for (int i = 0; i < 3; i++) {
+        if (k < lists[i]->len) return lists[i]->nodes[k];
+        k -= lists[i]->len;
+    }
+    const int singles[] = { n->not_schema, n->if_schema, n->then_schema, n->else_schema };
+    return k < 4 ? singles[k] : -2;
+}
+
+/*
+ * Reject $refs that lead back to their own schema without moving into
+ * the instance (through other $refs or combinators): validation would
+ * check the same value forever. Any such cycle has a $ref, as subschemas
+ * are otherwise a tree. Depth-first, with an explicit stack.
+ */
+static void
+check_ref_cycles(schema_t *s)
+{
+    typedef struct { int idx; long next; } frame_t;
+    enum { UNSEEN, OPEN, DONE };
+
+    VALUE holder = 0;
+    long len = s->len;
+    frame_t *stack = ALLOCV(holder, (size_t)len * (sizeof(frame_t) + 1));
+    uint8_t *state = (uint8_t *)(stack + len);
+    memset(state, UNSEEN, (size_t)len);
+
+    for (int root = 0; root < len; root++) {
+        if (state[root] != UNSEEN) continue;
+        long depth = 0;
+        stack[depth++] = (frame_t){ root, 0 };
+        state[root] = OPEN;
+
+        while (depth > 0) {
+            frame_t *f = &stack[depth - 1];
+            int child = inplace_child(&s->nodes[f->idx], f->next++);
+            if (child == -2) {
+                state[f->idx] = DONE;
+                depth--;
+            } else if (child >= 0 && state[child] == OPEN) {
+                invalid_schema("circular $ref");
+            } else if (child >= 0 && state[child] == UNSEEN) {
+                state[child] = OPEN;
+                stack[depth++] = (frame_t){ child, 0 };
+            }
+        }
+    }
+    ALLOCV_END(holder);
+}
+
+/*
+ * YYJson::Schema.compile(schema)
+ *
+ * Compile a JSON Schema, given as JSON text or as a Hash / true / false
+ * (dumped with YYJson.dump first). Supports the draft 7 validation
+ * keywords (type, enum, const, numeric and string bounds, pattern, items,
+ * additionalItems, contains, uniqueItems, properties, patternProperties,
+ * additionalProperties, propertyNames, required, min/maxProperties, allOf,
+ * anyOf, oneOf, not, if/then/else) and $refs within the schema. format
+ * and other annotations are ignored; patterns use Ruby Regexp syntax.
+ *
+ * Raises ArgumentError for malformed schemas (or ones nested too deeply
+ * for the C stack), unsupported $refs and $refs that loop on the same
+ * value, ParseError for invalid JSON, RegexpError for invalid patterns.
+ */
+static VALUE
+schema_s_compile(VALUE klass, VALUE source)
+{
+    if (!RB_TYPE_P(source, T_STRING)) source = rb_funcall(mYYJson, id_dump, 1, source);
+
+    VALUE self = schema_alloc(klass);
+    schema_t *s = DATA_PTR(self);
+    RB_OBJ_WRITE(self, &s->patterns, rb_ary_new());
+
+    yyjson_read_err err;
+    s->doc = yyjson_read_opts(RSTRING_PTR(source), (size_t)RSTRING_LEN(source), YYJSON_READ_NOFLAG, NULL, &err);
+    RB_GC_GUARD(source);
+    if (!s->doc) {
+        rb_raise(eParseError, "Invalid JSON Schema at position %zu: %s", err.pos, err.msg);
+    }
+
+    s->compiled = st_init_numtable();
+    compile_node(s, yyjson_doc_get_root(s->doc));
+    if (s->too_deep) invalid_schema("nesting is too deep");
+    check_ref_cycles(s);
+    st_free_table(s->compiled);
+    s->compiled = NULL;
+
+    rb_obj_freeze(s->patterns);
+    rb_obj_freeze(self);
+    return self;
+}
+
+/* ---- Validating ---- */
+
+typedef struct {
+    const schema_t *schema;
+    VALUE errors;            /* Array of error Hashes, or Qnil = stop at the first failure */
+    char *path;              /* JSON Pointer of the value being checked */
+    size_t path_len, path_capa;
+    bool too_deep;           /* Ran out of C stack (only with max_nesting: false) */
+} validate_ctx;
+
+/*
+ * Append a pointer segment (escaped per RFC 6901); returns the previous
+ * length to restore
+ */
+static size_t
+push_segment(validate_ctx *ctx, const char *s, size_t len)
+{
+    size_t mark = ctx->path_len;
+    if (ctx->path_len + 2 * len + 1 > ctx->path_capa) {
+        size_t capa = ctx->path_capa * 2;
+        while (capa < ctx->path_len + 2 * len + 1) capa *= 2;
+        REALLOC_N(ctx->path, char, capa);
+        ctx->path_capa = capa;
+    }
+
+    char *p = ctx->path + ctx->path_len;
+    *p++ = '/';
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '~') {
+            *p++ = '~';
+            *p++ = '0';
+        } else if (s[i] == '/') {
+            *p++ = '~';
+            *p++ = '1';
+        } else {
+            *p++ = s[i];
+        }
+    }
+    ctx->path_len = (size_t)(p - ctx->path);
+    return mark;
+}
+
+static size_t
+push_index(validate_ctx *ctx, size_t i)
+{
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%zu", i);
+    return push_segment(ctx, buf, (size_t)len);
+}
+
+/*
+ * Record a failure at the current path; always returns false
+ */
+static bool
+fail(validate_ctx *ctx, const char *keyword, VALUE msg)
+{
+    if (NIL_P(ctx->errors)) return false;
+
+    VALUE error = rb_hash_new();
+    rb_hash_aset(error, sym_pointer, rb_utf8_str_new(ctx->path, (long)ctx->path_len));
+    rb_hash_aset(error, sym_keyword, rb_usascii_str_new_cstr(keyword));
+    rb_hash_aset(error, sym_message, msg);
+    rb_ary_push(ctx->errors, error);
+    return false;
+}
+
+/* Record a failure (when only validity is asked for, it's final) */
+#define REJECT(keyword, ...) do { \
+    if (NIL_P(ctx->errors)) return false; \
+    ok = fail(ctx, (keyword), rb_sprintf(__VA_ARGS__)); \
+} while (0)
+
+/* Fold a sub-check's result into ok */
+#define CHECK(expr) do { \
+    if (!(expr)) { \
+        ok = false; \
+        if (NIL_P(ctx->errors)) return false; \
+    } \
+} while (0)
+
+static bool validate_node(validate_ctx *ctx, int idx, yyjson_val *val);
+
+/*
+ * Check a child value at path segment `mark` was pushed for
+ */
+static bool
+validate_child(validate_ctx *ctx, int idx, yyjson_val *val, size_t mark)
+{
+    bool ok = validate_node(ctx, idx, val);
+    ctx->path_len = mark;
+    return ok;
+}
+
+/*
+ * Whether val matches node idx, without recording errors (anyOf, oneOf,
+ * not, if, contains)
+ */
+static bool
+matches(validate_ctx *ctx, int idx, yyjson_val *val)
+{
+    VALUE errors = ctx->errors;
+    size_t path_len = ctx->path_len;
+    ctx->errors = Qnil;
+    bool ok = validate_node(ctx, idx, val);
+    if (!ctx->too_deep) ctx->errors = errors;
+    ctx->path_len = path_len;
+    return ok;
+}
+
+/*
+ * Near the end of the C stack: stop recording and unwind (raising here
+ * would itself overflow), validate_body reports it
+ */
+static bool
+out_of_stack(validate_ctx *ctx)
+{
+    if (!ruby_stack_check()) return false;
+    ctx->too_deep = true;
+    ctx->errors = Qnil;
+    return true;
+}
+
+static bool
+integral_p(yyjson_val *val)
+{
+    if (!yyjson_is_real(val)) return true;
+    double d = yyjson_get_real(val);
+    return isfinite(d) && d == floor(d);
+}
+
+static unsigned
+instance_type(yyjson_val *val)
+{
+    switch (yyjson_get_type(val)) {
+    case YYJSON_TYPE_NULL: return TYPE_NULL;
+    case YYJSON_TYPE_BOOL: return TYPE_BOOLEAN;
+    case YYJSON_TYPE_OBJ: return TYPE_OBJECT;
+    case YYJSON_TYPE_ARR: return TYPE_ARRAY;
+    case YYJSON_TYPE_STR: return TYPE_STRING;
+    default: return integral_p(val) ? (TYPE_NUMBER | TYPE_INTEGER) : TYPE_NUMBER;
+    }
+}
+
+/*
+ * "integer", "string or null", ... for type errors. An instance is named
+ * "integer" when integral; a schema accepting numbers is named "number".
+ */
+static VALUE
+type_list(unsigned types, bool instance)
+{
+    if ((types & TYPE_NUMBER) && (types & TYPE_INTEGER)) {
+        types &= instance ? ~(unsigned)TYPE_NUMBER : ~(unsigned)TYPE_INTEGER;
+    }
+
+    VALUE str = rb_str_new_cstr("");
+    for (int i = 0; i < TYPE_COUNT; i++) {
+        if (!(types & (1u << i))) continue;
+        if (RSTRING_LEN(str) > 0) rb_str_cat_cstr(str, " or ");
+        rb_str_cat_cstr(str, type_names[i]);
+    }
+    return str;
+}
+
+/*
+ * Shortest of %.15g / %.17g that reads back as d (5, 0.1, 1e+20) for
+ * messages
+ */
+static VALUE
+number_str(double d)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.15g", d);
+    if (strtod(buf, NULL) != d) snprintf(buf, sizeof(buf), "%.17g", d);
+    return rb_usascii_str_new_cstr(buf);
+}
+
+/*
+ * JSON equality: numbers by value (1 == 1.0), objects regardless of order.
+ * False once out of stack (ctx->too_deep is set then).
+ */
+static bool
+json_equal(validate_ctx *ctx, yyjson_val *a, yyjson_val *b)
+{
+    yyjson_type type = yyjson_get_type(a);
+    if (type != yyjson_get_type(b)) return false;
+
+    switch (type) {
+    case YYJSON_TYPE_NUM:
+        if (yyjson_is_real(a) || yyjson_is_real(b)) return yyjson_get_num(a) == yyjson_get_num(b);
+        return unsafe_yyjson_equals(a, b);
+    case YYJSON_TYPE_ARR: {
+        if (yyjson_arr_size(a) != yyjson_arr_size(b)) return false;
+        if (RB_UNLIKELY(out_of_stack(ctx))) return false;
+        yyjson_val *x = yyjson_arr_get_first(a), *y = yyjson_arr_get_first(b);
+        for (size_t i = yyjson_arr_size(a); i > 0; i--) {
+            if (!json_equal(ctx, x, y)) return false;
+            x = unsafe_yyjson_get_next(x);
+            y = unsafe_yyjson_get_next(y);
+        }
+        return true;
+    }
+    case YYJSON_TYPE_OBJ: {
+        if (yyjson_obj_size(a) != yyjson_obj_size(b)) return false;
+        if (RB_UNLIKELY(out_of_stack(ctx))) return false;
+        size_t i, max;
+        yyjson_val *key, *val;
+        yyjson_obj_foreach(a, i, max, key, val) {
+            yyjson_val *other = yyjson_obj_getn(b, yyjson_get_str(key), yyjson_get_len(key));
+            if (!other || !json_equal(ctx, val, other)) return false;
+        }
+        return true;
+    }
+    default:
+        return unsafe_yyjson_equals(a, b);
+    }
+}
+
+static bool
+multiple_of_p(yyjson_val *val, double m)
+{
+    if (!yyjson_is_real(val) && m == floor(m) && m <= 9007199254740992.0) {
+        uint64_t im = (uint64_t)m;
+        if (yyjson_is_uint(val)) return yyjson_get_uint(val) % im == 0;
+        int64_t v = yyjson_get_sint(val);
+        return (v < 0 ? 0 - (uint64_t)v : (uint64_t)v) % im == 0;
+    }
+    double q = yyjson_get_num(val) / m;
+    return isfinite(q) && fabs(q - nearbyint(q)) <= 1e-9 * fmax(1.0, fabs(q));
+}
+
+static bool
+check_number(validate_ctx *ctx, const schema_node_t *n, yyjson_val *val)
+{
+    bool ok = true;
+    double d = yyjson_get_num(val);
+
+    if ((n->num_flags & HAS_MINIMUM) && d < n->minimum) {
+        REJECT("minimum", "must be >= %"PRIsVALUE, number_str(n->minimum));
+    }
+    if ((n->num_flags & HAS_MAXIMUM) && d > n->maximum) {
+        REJECT("maximum", "must be <= %"PRIsVALUE, number_str(n->maximum));
+    }
+    if ((n->num_flags & HAS_EXCLUSIVE_MINIMUM) && d <= n->exclusive_minimum) {
+        REJECT("exclusiveMinimum", "must be > %"PRIsVALUE, number_str(n->exclusive_minimum));
+    }
+    if ((n->num_flags & HAS_EXCLUSIVE_MAXIMUM) && d >= n->exclusive_maximum) {
+        REJECT("exclusiveMaximum", "must be < %"PRIsVALUE, number_str(n->exclusive_maximum));
+    }
+    if ((n->num_flags & HAS_MULTIPLE_OF) && !multiple_of_p(val, n->multiple_of)) {
+        REJECT("multipleOf", "must be a multiple of %"PRIsVALUE, number_str(n->multiple_of));
+    }
+    return ok;
+}
+
+static bool
+regex_match_p(const schema_t *s, long pattern, const char *str, size_t len)
+{
+    VALUE re = RARRAY_AREF(s->patterns, pattern);
+    return RTEST(rb_funcall(re, id_match_p, 1, rb_utf8_str_new(str, (long)len)));
+}
+
+static bool
+check_string(validate_ctx *ctx, const schema_node_t *n, yyjson_val *val)
+{
+    bool ok = true;
+    const char *str = yyjson_get_str(val);
+    size_t len = yyjson_get_len(val);
+
+    if (n->min_length > 0 || n->max_length != SIZE_MAX) {
+        size_t chars = 0;
+        for (size_t i = 0; i < len; i++) chars += ((unsigned char)str[i] & 0xC0) != 0x80;
+        if (chars < n->min_length) {
+            REJECT("minLength", "must be at least %zu characters long", n->min_length);
+        }
+        if (chars > n->max_length) {
+            REJECT("maxLength", "must be at most %zu characters long", n->max_length);
+        }
+    }
+    if (n->pattern >= 0 && !regex_match_p(ctx->schema, n->pattern, str, len)) {
+        REJECT("pattern", "must match %"PRIsVALUE, rb_inspect(RARRAY_AREF(ctx->schema->patterns, n->pattern)));
+    }
+    return ok;
+}
+
+static bool
+check_array(validate_ctx *ctx, const schema_node_t *n, yyjson_val *val)
+{
+    bool ok = true;
+    size_t size = yyjson_arr_size(val);
+
+    if (size < n->min_items) REJECT("minItems", "must have at least %zu items", n->min_items);
+    if (size > n->max_items) REJECT("maxItems", "must have at most %zu items", n->max_items);
+
+    if (n->unique_items && size > 1) {
+        yyjson_val *a = yyjson_arr_get_first(val);
+        for (size_t i = 0; i + 1 < size; i++, a = unsafe_yyjson_get_next(a)) {
+            yyjson_val *b = unsafe_yyjson_get_next(a);
+            size_t j = i + 1;
+            for (; j < size && !json_equal(ctx, a, b); j++) {
+                if (RB_UNLIKELY(ctx->too_deep)) return false;
+                b = unsafe_yyjson_get_next(b);
+            }
+            if (j < size) {
+                REJECT("uniqueItems", "must not contain duplicates (items %zu and %zu are equal)", i, j);
+                break;
+            }
+        }
+    }
+
+    if (n->items >= 0 || n->tuple.len > 0 || n->contains >= 0) {
+        bool contained = false;
+        size_t i, max;
+        yyjson_val *item;
+        yyjson_arr_foreach(val, i, max, item) {
+            int idx = n->items;
+            if (n->tuple.len > 0) idx = (long)i < n->tuple.len ? n->tuple.nodes[i] : n->additional_items;
+            if (idx >= 0) CHECK(validate_child(ctx, idx, item, push_index(ctx, i)));
+            if (n->contains >= 0 && !contained) contained = matches(ctx, n->contains, item);
+        }
+        if (n->contains >= 0 && !contained) {
+            REJECT("contains", "must contain an item matching the contains schema");
+        }
+    }
+    return ok;
+}
+
+/*
+ * `properties` entry for a key, or NULL
+ */
+static const schema_prop_t *
+find_prop(const schema_node_t *n, const char *name, size_t len)
+{
+    schema_prop_t probe = { .name = name, .len = len };
+    return bsearch(&probe, n->props, (size_t)n->nprops, sizeof(schema_prop_t), compare_props);
+}
+
+static bool
+check_object(validate_ctx *ctx, const schema_node_t *n, yyjson_val *val)
+{
+    bool ok = true;
+    const schema_t *s = ctx->schema;
+    size_t size = yyjson_obj_size(val);
+
+    if (size < n->min_properties) {
+        REJECT("minProperties", "must have at least %zu properties", n->min_properties);
+    }
+    if (size > n->max_properties) {
+        REJECT("maxProperties", "must have at most %zu properties", n->max_properties);
+    }
+    for (long r = 0; r < n->nrequired; r++) {
+        yyjson_val *name = n->required[r];
+        if (!yyjson_obj_getn(val, yyjson_get_str(name), yyjson_get_len(name))) {
+            REJECT("required", "missing required property \"%s\"", yyjson_get_str(name));
+        }
+    }
+
+    if (n->nprops == 0 && n->npattern_props == 0 &&
+        n->additional_properties < 0 && n->property_names < 0) {
+        return ok;
+    }
+
+    size_t i, max;
+    yyjson_val *key, *item;
+    yyjson_obj_foreach(val, i, max, key, item) {
+        const char *name = yyjson_get_str(key);
+        size_t len = yyjson_get_len(key);
+        bool matched = false;
+
+        if (n->property_names >= 0) {
+            CHECK(validate_child(ctx, n->property_names, key, push_segment(ctx, name, len)));
+        }
+
+        const schema_prop_t *prop = n->nprops > 0 ? find_prop(n, name, len) : NULL;
+        if (prop) {
+            matched = true;
+            CHECK(validate_child(ctx, prop->node, item, push_segment(ctx, name, len)));
+        }
+        for (long p = 0; p < n->npattern_props; p++) {
+            if (!regex_match_p(s, n->pattern_props[p].regex, name, len)) continue;
+            matched = true;
+            CHECK(validate_child(ctx, n->pattern_props[p].node, item, push_segment(ctx, name, len)));
+        }
+
+        if (!matched && n->additional_properties >= 0) {
+            size_t mark = push_segment(ctx, name, len);
+            if (s->nodes[n->additional_properties].reject) {
+                REJECT("additionalProperties", "is not a permitted property");
+                ctx->path_len = mark;
+            } else {
+                CHECK(validate_child(ctx, n->additional_properties, item, mark));
+            }
+        }
+    }
+    return ok;
+}
+
+static bool
+check_combinators(validate_ctx *ctx, const schema_node_t *n, yyjson_val *val)
+{
+    bool ok = true;
+
+    for (long i = 0; i < n->all_of.len; i++) {
+        CHECK(validate_node(ctx, n->all_of.nodes[i], val));
+    }
+    if (n->any_of.len > 0) {
+        long i = 0;
+        while (i < n->any_of.len && !matches(ctx, n->any_of.nodes[i], val)) i++;
+        if (i == n->any_of.len) REJECT("anyOf", "must match at least one schema in anyOf");
+    }
+    if (n->one_of.len > 0) {
+        long matched = 0;
+        for (long i = 0; i < n->one_of.len && matched < 2; i++) {
+            matched += matches(ctx, n->one_of.nodes[i], val);
+        }
+        if (matched != 1) {
+            REJECT("oneOf", "must match exactly one schema in oneOf (matched %s)",
+                   matched == 0 ? "none" : "more than one");
+        }
+    }
+    if (n->not_schema >= 0 && matches(ctx, n->not_schema, val)) {
+        REJECT("not", "must not match the schema in not");
+    }
+    if (n->if_schema >= 0) {
+        int branch = matches(ctx, n->if_schema, val) ? n->then_schema : n->else_schema;
+        if (branch >= 0) CHECK(validate_node(ctx, branch, val));
+    }
+    return ok;
+}
+
+static bool
+validate_node(validate_ctx *ctx, int idx, yyjson_val *val)
+{
+    const schema_node_t *n = &ctx->schema->nodes[idx];
+    while (n->ref >= 0) n = &ctx->schema->nodes[n->ref];
+
+    if (n->reject) {
+        return NIL_P(ctx->errors) ? false : fail(ctx, "false", rb_str_new_cstr("no value is allowed here"));
+    }
+
+    bool ok = true;
+    if (n->types) {
+        unsigned type = instance_type(val);
+        if (!(n->types & type)) {
+            REJECT("type", "expected %"PRIsVALUE", got %"PRIsVALUE, type_list(n->types, false), type_list(type, true));
+        }
+    }
+    if (n->const_val && !json_equal(ctx, n->const_val, val)) {
+        REJECT("const", "must be equal to the const value");
+    }
+    if (n->enum_vals) {
+        bool found = false;
+        size_t i, max;
+        yyjson_val *option;
+        yyjson_arr_foreach(n->enum_vals, i, max, option) {
+            if ((found = json_equal(ctx, option, val))) break;
+            if (RB_UNLIKELY(ctx->too_deep)) return false;
+        }
+        if (!found) REJECT("enum", "must be one of the enum values");
+    }
+
+    switch (yyjson_get_type(val)) {
+    case YYJSON_TYPE_NUM:
+        if (n->num_flags) CHECK(check_number(ctx, n, val));
+        break;
+    case YYJSON_TYPE_STR:
+        CHECK(check_string(ctx, n, val));
+        break;
+    case YYJSON_TYPE_ARR:
+        if (RB_UNLIKELY(out_of_stack(ctx))) return false;
+        CHECK(check_array(ctx, n, val));
+        break;
+    case YYJSON_TYPE_OBJ:
+        if (RB_UNLIKELY(out_of_stack(ctx))) return false;
+        CHECK(check_object(ctx, n, val));
+        break;
+    default:
+        break;
+    }
+
+    return check_combinators(ctx, n, val) && ok;
+}
+
+#undef REJECT
+#undef CHECK
+
+/*
+ * Arguments of one validation (released in validate_ensure)
+ */
+typedef struct {
+    VALUE source;
+    const schema_t *schema;  /* NULL = syntax only */
+    yyjson_parse_options opts;
+    bool raise;              /* Raise ParseError for invalid JSON instead of returning false */
+    yyjson_doc *doc;
+    validate_ctx ctx;
+} validate_args;
+
+static VALUE
+validate_body(VALUE ptr)
+{
+    validate_args *args = (validate_args *)ptr;
+    yyjson_read_flag flg = yyjson_read_flags(&args->opts);
+
+    if (args->raise) {
+        args->doc = yyjson_read_string_doc(args->source, &args->opts, flg, NULL);
+    } else {
+        yyjson_read_err err;
+        args->doc = yyjson_try_read_string_doc(args->source, &args->opts, flg, NULL, &err);
+        if (!args->doc) return Qfalse;
+    }
+
+    int depth = yyjson_doc_nesting_exceeded(args->doc, args->opts.max_nesting);
+    if (depth) {
+        if (!args->raise) return Qfalse;
+        rb_raise(eParseError, "nesting of %d is too deep", depth);
+    }
+    if (!args->schema) return Qtrue;
+
+    args->ctx.path = ALLOC_N(char, 64);
+    args->ctx.path_capa = 64;
+    bool ok = validate_node(&args->ctx, 0, yyjson_doc_get_root(args->doc));
+    if (args->ctx.too_deep && args->raise) rb_raise(eParseError, "nesting is too deep to validate");
+    return ok ? Qtrue : Qfalse;
+}
+
+static VALUE
+validate_ensure(VALUE ptr)
+{
+    validate_args *args = (validate_args *)ptr;
+    if (args->doc) yyjson_doc_free(args->doc);
+    xfree(args->ctx.path);
+    return Qnil;
+}
+
+/*
+ * Parse source and check it; errors (an Array or Qnil) collects failures
+ */
+static VALUE
+validate_run(VALUE source, const schema_t *schema, VALUE opts, bool raise, VALUE errors)
+{
+    if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+
+    validate_args args = {
+        .source = source,
+        .schema = schema,
+        .raise = raise,
+        .doc = NULL,
+        .ctx = { .schema = schema, .errors = errors }
+    };
+    yyjson_extract_parse_options(opts, &args.opts);
+
+    return rb_ensure(validate_body, (VALUE)&args, validate_ensure, (VALUE)&args);
+}
+
+/*
+ * schema.valid?(source, opts = {})
+ *
+ * Whether source is JSON that matches the schema. Accepts the parse
+ * options of YYJson.load; invalid JSON (or nesting beyond :max_nesting)
+ * returns false.
+ */
+static VALUE
+schema_valid_p(int argc, VALUE *argv, VALUE self)
+{
+    VALUE source, opts;
+    rb_scan_args(argc, argv, "11", &source, &opts);
+    return validate_run(source, get_schema(self), opts, false, Qnil);
+}
+
+/*
+ * schema.validate(source, opts = {})
+ *
+ * Failures of source against the schema, [] when it matches. Each is a
+ * Hash with :pointer (JSON Pointer of the failing value, "" for the
+ * root), :keyword and :message. Raises ParseError for invalid JSON.
+ */
+static VALUE
+schema_validate(int argc, VALUE *argv, VALUE self)
+{
+    VALUE source, opts;
+    rb_scan_args(argc, argv, "11", &source, &opts);
+
+    VALUE errors = rb_ary_new();
+    validate_run(source, get_schema(self), opts, true, errors);
+    return errors;
+}
+
+/*
+ * YYJson.valid?(source, opts = {})
+ *
+ * Whether source is valid JSON (with the YYJson.load parse options, so
+ * e.g. comments count as valid unless mode: :strict / allow_comments:
+ * false). The document is parsed and freed without building Ruby objects.
+ * With schema: (a YYJson::Schema, or a schema to compile), the document
+ * must also match it.
+ */
+static VALUE
+yyjson_valid_p(int argc, VALUE *argv, VALUE self)
+{
+    VALUE source, opts;
+    rb_scan_args(argc, argv, "11", &source, &opts);
+
+    const schema_t *schema = NULL;
+    VALUE schema_obj = Qnil;
+    if (RB_TYPE_P(opts, T_HASH)) {
+        schema_obj = rb_hash_lookup2(opts, ID2SYM(id_schema), Qnil);
+        if (!NIL_P(schema_obj)) {
+            if (!rb_typeddata_is_kind_of(schema_obj, &schema_type)) {
+                schema_obj = schema_s_compile(cSchema, schema_obj);
+            }
+            schema = get_schema(schema_obj);
+        }
+    }
+
+    VALUE result = validate_run(source, schema, opts, false, Qnil);
+    RB_GC_GUARD(schema_obj);
+    return result;
+}
+
+void
+yyjson_schema_init(void)
+{
+    id_schema = rb_intern("schema");
+    id_match_p = rb_intern("match?");
+    id_dump = rb_intern("dump");
+    sym_pointer = ID2SYM(rb_intern("pointer"));
+    sym_keyword = ID2SYM(rb_intern("keyword"));
+    sym_message = ID2SYM(rb_intern("message"));
+
+    cSchema = rb_define_class_under(mYYJson, "Schema", rb_cObject);
+    rb_define_alloc_func(cSchema, schema_alloc);
+    rb_undef_method(CLASS_OF(cSchema), "new");
+    rb_define_singleton_method(cSchema, "compile", schema_s_compile, 1);
+
+    /* Read only the document and the frozen (shareable) schema */
+    rb_ext_ractor_safe(true);
+    rb_define_singleton_method(mYYJson, "valid?", yyjson_valid_p, -1);
+    rb_define_method(cSchema, "valid?", schema_valid_p, -1);
+    rb_define_method(cSchema, "validate", schema_validate, -1);
+    rb_ext_ractor_safe(false);
+}
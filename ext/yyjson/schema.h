@@ -0,0 +1,16 @@
+/*
+ * schema.h - Validation without building Ruby objects (YYJson.valid?,
+ * YYJson::Schema)
+ */
+
+#ifndef YYJSON_RUBY_SCHEMA_H
+#define YYJSON_RUBY_SCHEMA_H
+
+#include "common.h"
+
+/*
+ * Define YYJson.valid? and YYJson::Schema (called from Init_yyjson)
+ */
+void yyjson_schema_init(void);
+
+#endif /* YYJSON_RUBY_SCHEMA_H */
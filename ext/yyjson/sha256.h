@@ -0,0 +1,27 @@
+/*
+ * sha256.h - SHA-256 (FIPS 180-4) for dump digest: :sha256
+ *
+ * Hashes output as the streaming buffer flushes it, so a digest never
+ * needs the whole JSON text in memory.
+ */
+
+#ifndef YYJSON_RUBY_SHA256_H
+#define YYJSON_RUBY_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define YYJSON_SHA256_SIZE 32
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;          /* Bytes hashed so far */
+    uint8_t block[64];        /* Pending partial block */
+    size_t used;              /* Bytes in block */
+} yyjson_sha256_ctx;
+
+void yyjson_sha256_init(yyjson_sha256_ctx *ctx);
+void yyjson_sha256_update(yyjson_sha256_ctx *ctx, const void *data, size_t len);
+void yyjson_sha256_final(yyjson_sha256_ctx *ctx, uint8_t out[YYJSON_SHA256_SIZE]);
+
+#endif /* YYJSON_RUBY_SHA256_H */
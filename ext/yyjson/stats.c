@@ -0,0 +1,220 @@
+/*
+ * stats.c - Opt-in hot-path counters (YYJson.stats)
+ *
+ * Counters live in one block per native thread, found through a pthread
+ * key and linked into a global list when first used, so threads and
+ * Ractors count without sharing cache lines or taking locks. YYJson.stats
+ * sums the blocks; a thread's block is folded into the totals of exited
+ * threads when it ends. Without pthreads all threads share one block.
+ *
+ * Counts are plain loads and stores: a read concurrent with counting
+ * threads can be a few operations behind, which is fine for monitoring.
+ */
+
+#include "common.h"
+#include "stats.h"
+#include <string.h>
+#include <time.h>
+#include <ruby/thread_native.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+bool yyjson_stats_enabled = false;
+
+/* Blocks of live threads, and the sum of exited ones */
+static yyjson_stats_t *stats_list = NULL;
+static yyjson_stats_t stats_retired;
+static rb_nativethread_lock_t stats_lock;
+
+#ifdef HAVE_PTHREAD_H
+static pthread_key_t stats_key;
+
+/*
+ * Thread exit: fold the block into the retired totals
+ */
+static void
+stats_thread_exit(void *ptr)
+{
+    yyjson_stats_t *s = ptr;
+
+    rb_nativethread_lock_lock(&stats_lock);
+    for (yyjson_stats_t **p = &stats_list; *p; p = &(*p)->next) {
+        if (*p == s) {
+            *p = s->next;
+            break;
+        }
+    }
+    stats_retired.parses += s->parses;
+    stats_retired.bytes_parsed += s->bytes_parsed;
+    stats_retired.read_ns += s->read_ns;
+    stats_retired.build_ns += s->build_ns;
+    stats_retired.key_cache_hits += s->key_cache_hits;
+    stats_retired.key_cache_misses += s->key_cache_misses;
+    stats_retired.heap_fallbacks += s->heap_fallbacks;
+    stats_retired.value_cache_hits += s->value_cache_hits;
+    stats_retired.value_cache_misses += s->value_cache_misses;
+    stats_retired.dumps += s->dumps;
+    stats_retired.bytes_emitted += s->bytes_emitted;
+    stats_retired.as_json_calls += s->as_json_calls;
+    stats_retired.escape_html_dumps += s->escape_html_dumps;
+    stats_retired.sort_cache_hits += s->sort_cache_hits;
+    rb_nativethread_lock_unlock(&stats_lock);
+
+    free(s);
+}
+
+yyjson_stats_t *
+yyjson_stats_local(void)
+{
+    yyjson_stats_t *s = pthread_getspecific(stats_key);
+    if (RB_LIKELY(s != NULL)) return s;
+
+    /* Plain calloc: may run in any Ractor, and outlives nothing Ruby owns */
+    s = calloc(1, sizeof(*s));
+    if (!s) return &stats_retired;
+    pthread_setspecific(stats_key, s);
+
+    rb_nativethread_lock_lock(&stats_lock);
+    s->next = stats_list;
+    stats_list = s;
+    rb_nativethread_lock_unlock(&stats_lock);
+    return s;
+}
+#else
+yyjson_stats_t *
+yyjson_stats_local(void)
+{
+    return &stats_retired;
+}
+#endif
+
+uint64_t
+yyjson_stats_now(void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#else
+    return (uint64_t)clock() * (1000000000u / CLOCKS_PER_SEC);
+#endif
+}
+
+/*
+ * YYJson.stats
+ *
+ * Returns a Hash of counters summed over all threads since the last
+ * YYJson.reset_stats (counted only while YYJson.stats_enabled is true):
+ *
+ *   :parses, :bytes_parsed - Documents read and their size
+ *   :read_time_ns - Time spent in the yyjson reader
+ *   :build_time_ns - Time spent converting documents to Ruby objects
+ *   :key_cache_hits, :key_cache_misses - Object keys served from / added
+ *                                        to the per-document key cache
+ *   :heap_fallbacks - Builds of documents too deep or wide for the build
+ *                     stack's C-stack buffers
+ *   :value_cache_hits, :value_cache_misses - Short string values shared
+ *                                            from / added to the value cache
+ *                                            (dedup_values / freeze)
+ *   :dumps, :bytes_emitted - Dumps and their output size
+ *   :as_json_calls - as_json calls made while dumping
+ *   :escape_html_dumps - Dumps with escape_html
+ *   :sort_cache_hits - Hashes whose canonical key order was cached
+ */
+static VALUE
+yyjson_stats_m(VALUE self)
+{
+    yyjson_stats_t t;
+
+    rb_nativethread_lock_lock(&stats_lock);
+    t = stats_retired;
+    for (yyjson_stats_t *s = stats_list; s; s = s->next) {
+        t.parses += s->parses;
+        t.bytes_parsed += s->bytes_parsed;
+        t.read_ns += s->read_ns;
+        t.build_ns += s->build_ns;
+        t.key_cache_hits += s->key_cache_hits;
+        t.key_cache_misses += s->key_cache_misses;
+        t.heap_fallbacks += s->heap_fallbacks;
+        t.value_cache_hits += s->value_cache_hits;
+        t.value_cache_misses += s->value_cache_misses;
+        t.dumps += s->dumps;
+        t.bytes_emitted += s->bytes_emitted;
+        t.as_json_calls += s->as_json_calls;
+        t.escape_html_dumps += s->escape_html_dumps;
+        t.sort_cache_hits += s->sort_cache_hits;
+    }
+    rb_nativethread_lock_unlock(&stats_lock);
+
+    VALUE stats = rb_hash_new();
+    rb_hash_aset(stats, ID2SYM(rb_intern("parses")), SIZET2NUM(t.parses));
+    rb_hash_aset(stats, ID2SYM(rb_intern("bytes_parsed")), SIZET2NUM(t.bytes_parsed));
+    rb_hash_aset(stats, ID2SYM(rb_intern("read_time_ns")), ULL2NUM(t.read_ns));
+    rb_hash_aset(stats, ID2SYM(rb_intern("build_time_ns")), ULL2NUM(t.build_ns));
+    rb_hash_aset(stats, ID2SYM(rb_intern("key_cache_hits")), SIZET2NUM(t.key_cache_hits));
+    rb_hash_aset(stats, ID2SYM(rb_intern("key_cache_misses")), SIZET2NUM(t.key_cache_misses));
+    rb_hash_aset(stats, ID2SYM(rb_intern("heap_fallbacks")), SIZET2NUM(t.heap_fallbacks));
+    rb_hash_aset(stats, ID2SYM(rb_intern("value_cache_hits")), SIZET2NUM(t.value_cache_hits));
+    rb_hash_aset(stats, ID2SYM(rb_intern("value_cache_misses")), SIZET2NUM(t.value_cache_misses));
+    rb_hash_aset(stats, ID2SYM(rb_intern("dumps")), SIZET2NUM(t.dumps));
+    rb_hash_aset(stats, ID2SYM(rb_intern("bytes_emitted")), SIZET2NUM(t.bytes_emitted));
+    rb_hash_aset(stats, ID2SYM(rb_intern("as_json_calls")), SIZET2NUM(t.as_json_calls));
+    rb_hash_aset(stats, ID2SYM(rb_intern("escape_html_dumps")), SIZET2NUM(t.escape_html_dumps));
+    rb_hash_aset(stats, ID2SYM(rb_intern("sort_cache_hits")), SIZET2NUM(t.sort_cache_hits));
+    return stats;
+}
+
+/*
+ * YYJson.reset_stats
+ *
+ * Zero all counters. Returns nil.
+ */
+static VALUE
+yyjson_reset_stats(VALUE self)
+{
+    rb_nativethread_lock_lock(&stats_lock);
+    memset(&stats_retired, 0, sizeof(stats_retired));
+    for (yyjson_stats_t *s = stats_list; s; s = s->next) {
+        yyjson_stats_t *next = s->next;
+        memset(s, 0, sizeof(*s));
+        s->next = next;
+    }
+    rb_nativethread_lock_unlock(&stats_lock);
+    return Qnil;
+}
+
+/*
+ * YYJson.stats_enabled
+ */
+static VALUE
+yyjson_get_stats_enabled(VALUE self)
+{
+    return yyjson_stats_enabled ? Qtrue : Qfalse;
+}
+
+/*
+ * YYJson.stats_enabled = bool
+ *
+ * Start or stop counting (default: off). Counters keep their values.
+ */
+static VALUE
+yyjson_set_stats_enabled(VALUE self, VALUE val)
+{
+    yyjson_stats_enabled = RTEST(val);
+    return val;
+}
+
+void
+yyjson_stats_init(void)
+{
+    rb_nativethread_lock_initialize(&stats_lock);
+#ifdef HAVE_PTHREAD_H
+    pthread_key_create(&stats_key, stats_thread_exit);
+#endif
+
+    rb_define_singleton_method(mYYJson, "stats", yyjson_stats_m, 0);
+    rb_define_singleton_method(mYYJson, "reset_stats", yyjson_reset_stats, 0);
+    rb_define_singleton_method(mYYJson, "stats_enabled", yyjson_get_stats_enabled, 0);
+    rb_define_singleton_method(mYYJson, "stats_enabled=", yyjson_set_stats_enabled, 1);
+}
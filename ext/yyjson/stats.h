@@ -0,0 +1,78 @@
+/*
+ * stats.h - Opt-in hot-path counters (YYJson.stats)
+ */
+
+#ifndef YYJSON_RUBY_STATS_H
+#define YYJSON_RUBY_STATS_H
+
+#include "common.h"
+
+/*
+ * Counters of one native thread, summed over all threads by YYJson.stats
+ *
+ * Each block is only written by its own thread, so counting needs no
+ * locks or atomics (worker Ractors count in parallel).
+ */
+typedef struct yyjson_stats {
+    size_t parses;            /* Documents read */
+    size_t bytes_parsed;
+    uint64_t read_ns;         /* In yyjson_read_opts / yyjson_read_file */
+    uint64_t build_ns;        /* Converting documents to Ruby objects */
+    size_t key_cache_hits;    /* Object keys reused from the per-document cache */
+    size_t key_cache_misses;
+    size_t heap_fallbacks;    /* Build stacks that outgrew their C-stack buffers */
+    size_t value_cache_hits;  /* Short string values shared from the value cache */
+    size_t value_cache_misses;
+    size_t dumps;             /* yyjson_dump_ruby_object calls */
+    size_t bytes_emitted;
+    size_t as_json_calls;
+    size_t escape_html_dumps; /* Dumps escaping HTML characters */
+    size_t sort_cache_hits;   /* canonical: Hashes ordered from the sort permutation cache */
+    struct yyjson_stats *next;
+} yyjson_stats_t;
+
+/* YYJson.stats_enabled (off by default: counting costs a branch when off) */
+extern bool yyjson_stats_enabled;
+
+/*
+ * This thread's counters (allocated on first use)
+ */
+yyjson_stats_t *yyjson_stats_local(void);
+
+/*
+ * Monotonic clock in nanoseconds
+ */
+uint64_t yyjson_stats_now(void);
+
+/* Add n to a counter when stats are enabled */
+#define YYJSON_STATS_ADD(field, n) do { \
+    if (RB_UNLIKELY(yyjson_stats_enabled)) yyjson_stats_local()->field += (n); \
+} while (0)
+
+/* Start time of a timed section (0 when stats are disabled) */
+#define YYJSON_STATS_START() (RB_UNLIKELY(yyjson_stats_enabled) ? yyjson_stats_now() : 0)
+
+/* Add the time since `start` to a counter (no-op if start is 0) */
+#define YYJSON_STATS_TIME(field, start) do { \
+    if (RB_UNLIKELY(start)) yyjson_stats_local()->field += yyjson_stats_now() - (start); \
+} while (0)
+
+/*
+ * Count one document read of `bytes` bytes that took since `start`
+ */
+#define YYJSON_STATS_READ(start, bytes) do { \
+    if (RB_UNLIKELY(start)) { \
+        yyjson_stats_t *s_ = yyjson_stats_local(); \
+        s_->parses++; \
+        s_->bytes_parsed += (bytes); \
+        s_->read_ns += yyjson_stats_now() - (start); \
+    } \
+} while (0)
+
+/*
+ * Define YYJson.stats, YYJson.reset_stats and YYJson.stats_enabled(=)
+ * (called from Init_yyjson)
+ */
+void yyjson_stats_init(void);
+
+#endif /* YYJSON_RUBY_STATS_H */
@@ -0,0 +1,326 @@
+/*
+ * table.c - Columnar decoding of arrays of objects: YYJson.load_table
+ *
+ * Arrays of homogeneous records are converted without building a Hash per
+ * row. The key shape of the first record is resolved once (one key VALUE
+ * per column), and every record is matched against it position by
+ * position, searching the shape only when a record's keys differ. Rows
+ * become column Arrays (as: :columns), or instances of a Struct / Data
+ * class cached per shape (as: :struct / :data).
+ */
+
+#include "common.h"
+#include "parser.h"
+#include "table.h"
+#include <string.h>
+
+/* Shape classes cached before the cache is cleared */
+#define TABLE_SHAPE_CACHE_MAX 64
+
+typedef enum {
+    TABLE_COLUMNS,
+    TABLE_STRUCT,
+    TABLE_DATA
+} table_as_t;
+
+/* A column key, as bytes in the document */
+typedef struct {
+    const char *str;
+    size_t len;
+} table_key_t;
+
+typedef struct {
+    VALUE source;
+    yyjson_parse_options opts;
+    table_as_t as;
+    yyjson_doc *doc;
+    table_key_t *keys;       /* xmalloc'd, one per column */
+    size_t ncols;
+    size_t capa;
+    VALUE names;             /* Column names: Hash keys, or member Symbols */
+    VALUE cols;              /* Column Arrays (as: :columns) */
+    yyjson_value_cache_t *values; /* Cell values shared across the table (NULL = off) */
+    yyjson_value_cache_t values_buf;
+} table_args;
+
+/* Struct / Data classes by frozen member list */
+static VALUE struct_shapes = Qnil;
+static VALUE data_shapes = Qnil;
+
+static ID id_columns;
+static ID id_struct;
+static ID id_data;
+
+static table_as_t
+table_as_value(VALUE opts)
+{
+    VALUE val = NIL_P(opts) ? Qnil : rb_hash_aref(opts, ID2SYM(id_as));
+    if (NIL_P(val)) return TABLE_COLUMNS;
+
+    if (SYMBOL_P(val)) {
+        ID as = SYM2ID(val);
+        if (as == id_columns) return TABLE_COLUMNS;
+        if (as == id_struct) return TABLE_STRUCT;
+        if (as == id_data) return TABLE_DATA;
+    }
+    rb_raise(rb_eArgError, "unknown table format %+"PRIsVALUE" (expected :columns, :struct or :data)", val);
+}
+
+/*
+ * Column of an object key, or -1; tries column `hint` (the key's position
+ * in its record) first
+ */
+static long
+find_col(const table_args *t, yyjson_val *key, size_t hint)
+{
+    const char *s = unsafe_yyjson_get_str(key);
+    size_t len = unsafe_yyjson_get_len(key);
+
+    if (RB_LIKELY(hint < t->ncols) && t->keys[hint].len == len &&
+        memcmp(t->keys[hint].str, s, len) == 0) {
+        return (long)hint;
+    }
+    for (size_t i = 0; i < t->ncols; i++) {
+        if (t->keys[i].len == len && memcmp(t->keys[i].str, s, len) == 0) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+static long
+add_col(table_args *t, yyjson_val *key, size_t nrows)
+{
+    if (t->ncols == t->capa) {
+        t->capa = t->capa ? t->capa * 2 : 16;
+        REALLOC_N(t->keys, table_key_t, t->capa);
+    }
+    t->keys[t->ncols] = (table_key_t){ unsafe_yyjson_get_str(key), unsafe_yyjson_get_len(key) };
+
+    if (t->as == TABLE_COLUMNS) {
+        rb_ary_push(t->names, yyjson_build_ruby_key(key, &t->opts));
+        rb_ary_push(t->cols, rb_ary_new_capa((long)nrows));
+    } else {
+        rb_ary_push(t->names, ID2SYM(rb_intern3(t->keys[t->ncols].str, (long)t->keys[t->ncols].len,
+                                                rb_utf8_encoding())));
+    }
+    return (long)t->ncols++;
+}
+
+static void
+not_an_object(size_t row)
+{
+    rb_raise(eParseError, "load_table expects an array of objects (element %zu is not an object)", row);
+}
+
+/*
+ * Register the first record's keys as the columns
+ */
+static void
+read_shape(table_args *t, yyjson_val *obj, size_t nrows)
+{
+    yyjson_val *key = unsafe_yyjson_get_first(obj);
+    size_t n = unsafe_yyjson_get_len(obj);
+
+    for (size_t i = 0; i < n; i++) {
+        if (find_col(t, key, i) < 0) add_col(t, key, nrows);
+        key = unsafe_yyjson_get_next(key + 1);
+    }
+}
+
+/*
+ * as: :columns - Hash of column name => Array of values (nil where a
+ * record lacks the key)
+ */
+static VALUE
+build_columns(table_args *t, yyjson_val *row, size_t nrows)
+{
+    for (size_t r = 0; r < nrows; r++, row = unsafe_yyjson_get_next(row)) {
+        if (RB_UNLIKELY(!yyjson_is_obj(row))) not_an_object(r);
+
+        yyjson_val *key = unsafe_yyjson_get_first(row);
+        size_t n = unsafe_yyjson_get_len(row);
+        for (size_t i = 0; i < n; i++) {
+            long c = find_col(t, key, i);
+            if (RB_UNLIKELY(c < 0)) c = add_col(t, key, nrows);
+
+            /* Pads skipped rows with nil; a repeated key overwrites */
+            rb_ary_store(RARRAY_AREF(t->cols, c), (long)r, yyjson_build_ruby_value_cached(key + 1, &t->opts, t->values));
+            key = unsafe_yyjson_get_next(key + 1);
+        }
+    }
+
+#ifdef HAVE_RB_HASH_NEW_CAPA
+    VALUE result = rb_hash_new_capa((long)t->ncols);
+#else
+    VALUE result = rb_hash_new();
+#endif
+    for (size_t c = 0; c < t->ncols; c++) {
+        VALUE col = RARRAY_AREF(t->cols, c);
+        if (RARRAY_LEN(col) < (long)nrows) rb_ary_store(col, (long)nrows - 1, Qnil);
+        if (t->opts.freeze) rb_obj_freeze(col);
+        rb_hash_aset(result, RARRAY_AREF(t->names, c), col);
+    }
+    if (t->opts.freeze) rb_obj_freeze(result);
+    return result;
+}
+
+/*
+ * Struct / Data class for the current members, from the shape cache
+ */
+static VALUE
+shape_class(table_args *t)
+{
+    VALUE cache = t->as == TABLE_DATA ? data_shapes : struct_shapes;
+    VALUE members = rb_ary_freeze(t->names);
+    VALUE klass = rb_hash_lookup2(cache, members, Qundef);
+    if (klass != Qundef) return klass;
+
+    if (t->as == TABLE_DATA) {
+        VALUE cData = rb_const_get(rb_cObject, rb_intern("Data"));
+        klass = rb_funcallv(cData, rb_intern("define"), (int)t->ncols, RARRAY_CONST_PTR(members));
+    } else {
+        klass = rb_funcallv(rb_cStruct, id_new, (int)t->ncols, RARRAY_CONST_PTR(members));
+    }
+
+    if (RHASH_SIZE(cache) >= TABLE_SHAPE_CACHE_MAX) rb_hash_clear(cache);
+    rb_hash_aset(cache, members, klass);
+    return klass;
+}
+
+/*
+ * as: :struct / :data - Array of shape class instances; every record must
+ * only use keys of the first one (missing members are nil)
+ */
+static VALUE
+build_rows(table_args *t, yyjson_val *row, size_t nrows)
+{
+    VALUE result = rb_ary_new_capa((long)nrows);
+    if (nrows == 0) return result;
+
+    VALUE klass = shape_class(t);
+    long ncols = (long)t->ncols;
+
+    /* Member values of the current record, copied into each instance */
+    VALUE vals = rb_ary_new_capa(ncols);
+    rb_obj_hide(vals);
+
+    for (size_t r = 0; r < nrows; r++, row = unsafe_yyjson_get_next(row)) {
+        if (RB_UNLIKELY(!yyjson_is_obj(row))) not_an_object(r);
+
+        for (long c = 0; c < ncols; c++) rb_ary_store(vals, c, Qnil);
+
+        yyjson_val *key = unsafe_yyjson_get_first(row);
+        size_t n = unsafe_yyjson_get_len(row);
+        for (size_t i = 0; i < n; i++) {
+            long c = find_col(t, key, i);
+            if (RB_UNLIKELY(c < 0)) {
+                rb_raise(eParseError, "load_table: element %zu has key \"%.*s\" not in the first record",
+                         r, (int)unsafe_yyjson_get_len(key), unsafe_yyjson_get_str(key));
+            }
+            rb_ary_store(vals, c, yyjson_build_ruby_value_cached(key + 1, &t->opts, t->values));
+            key = unsafe_yyjson_get_next(key + 1);
+        }
+
+        /* The shape classes are ours: skip #initialize (Data's builds a
+         * keyword Hash per record) and assign the members directly;
+         * rb_struct_initialize also freezes Data instances */
+        VALUE obj = rb_struct_alloc_noinit(klass);
+        rb_struct_initialize(obj, vals);
+        if (t->opts.freeze) rb_obj_freeze(obj);
+        rb_ary_push(result, obj);
+    }
+
+    RB_GC_GUARD(vals);
+    if (t->opts.freeze) rb_obj_freeze(result);
+    return result;
+}
+
+static VALUE
+table_body(VALUE ptr)
+{
+    table_args *t = (table_args *)ptr;
+
+    t->doc = yyjson_read_string_doc(t->source, &t->opts, yyjson_read_flags(&t->opts), NULL);
+
+    yyjson_val *root = t->doc->root;
+    if (!yyjson_is_arr(root)) {
+        rb_raise(eParseError, "load_table expects an array of objects");
+    }
+
+    size_t nrows = unsafe_yyjson_get_len(root);
+    yyjson_val *first = unsafe_yyjson_get_first(root);
+    if (nrows > 0) {
+        if (!yyjson_is_obj(first)) not_an_object(0);
+        read_shape(t, first, nrows);
+    }
+
+    return t->as == TABLE_COLUMNS ? build_columns(t, first, nrows) : build_rows(t, first, nrows);
+}
+
+static VALUE
+table_ensure(VALUE ptr)
+{
+    table_args *t = (table_args *)ptr;
+    if (t->doc) yyjson_doc_free(t->doc);
+    xfree(t->keys);
+    return Qnil;
+}
+
+/*
+ * YYJson.load_table(source, opts = {})
+ *
+ * Parse a JSON array of objects (records) column-wise. The first record's
+ * keys give the columns; each key is converted once for the whole table.
+ *
+ * Options (plus the YYJson.load options):
+ *   :as - :columns (default) returns a Hash of column name => Array, with
+ *         nil where a record lacks a key (keys first seen in later records
+ *         are added as columns); :struct / :data return an Array of Struct
+ *         / Data instances, whose class is cached per key shape. With
+ *         :struct / :data every record may only use the first record's keys.
+ *
+ * Raises ParseError unless the document is an array of objects.
+ */
+static VALUE
+yyjson_load_table(int argc, VALUE *argv, VALUE self)
+{
+    VALUE source, opts;
+    rb_scan_args(argc, argv, "11", &source, &opts);
+    if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+
+    table_args t = {
+        .source = source,
+        .as = table_as_value(opts),
+        .doc = NULL,
+        .keys = NULL,
+        .ncols = 0,
+        .capa = 0,
+        .names = rb_ary_new(),
+        .cols = rb_ary_new()
+    };
+    yyjson_extract_parse_options(opts, &t.opts);
+    t.values = yyjson_value_cache_init(&t.values_buf, &t.opts);
+
+    VALUE result = rb_ensure(table_body, (VALUE)&t, table_ensure, (VALUE)&t);
+    RB_GC_GUARD(t.names);
+    RB_GC_GUARD(t.cols);
+    return result;
+}
+
+void
+yyjson_table_init(void)
+{
+    id_columns = rb_intern("columns");
+    id_struct = rb_intern("struct");
+    id_data = rb_intern("data");
+
+    rb_global_variable(&struct_shapes);
+    rb_global_variable(&data_shapes);
+    struct_shapes = rb_hash_new();
+    data_shapes = rb_hash_new();
+    rb_obj_hide(struct_shapes);
+    rb_obj_hide(data_shapes);
+
+    rb_define_singleton_method(mYYJson, "load_table", yyjson_load_table, -1);
+}
@@ -0,0 +1,15 @@
+/*
+ * table.h - Columnar decoding of arrays of objects (YYJson.load_table)
+ */
+
+#ifndef YYJSON_RUBY_TABLE_H
+#define YYJSON_RUBY_TABLE_H
+
+#include "common.h"
+
+/*
+ * Define YYJson.load_table (called from Init_yyjson)
+ */
+void yyjson_table_init(void);
+
+#endif /* YYJSON_RUBY_TABLE_H */
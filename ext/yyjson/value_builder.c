@@ -7,12 +7,15 @@
  * 3. rb_ary_new_from_values() for single-call array creation
  * 4. rb_hash_bulk_insert() for batch hash insertion
  * 5. Custom fast memcmp using 64-bit comparisons
- * 6. Stack allocation for small collections
+ * 6. Iterative build: explicit frame stack plus one shared arena of pending
+ *    values (bounded C stack use, max_nesting enforced)
  * 7. Hash+length sorted cache for O(log n) lookups
+ * 8. Optional persistent key cache (key_cache.c) behind the per-document one
  */
 
 #include "common.h"
 #include "value_builder.h"
+#include "stats.h"
 #include <string.h>
 #include <ctype.h>
 
@@ -70,6 +73,8 @@ typedef struct {
 typedef struct {
     cache_entry_t entries[CACHE_SIZE];
     int len;
+    size_t hits;       /* Lookups served from the cache (YYJson.stats) */
+    size_t misses;
 } string_cache_t;
 
 /*
@@ -160,6 +165,15 @@ make_fstr(const char *s, size_t len)
 #endif
 }
 
+/*
+ * Create a UTF-8 symbol (rb_intern2 would tag non-ASCII keys US-ASCII)
+ */
+YY_INLINE VALUE
+make_sym(const char *s, size_t len)
+{
+    return ID2SYM(rb_intern3(s, (long)len, utf8_enc));
+}
+
 /*
  * Binary search in sorted cache (sorted by hash, then length)
  */
@@ -201,22 +215,52 @@ cache_insert(string_cache_t *c, int pos, const char *s, size_t len, uint32_t h,
     c->len++;
 }
 
+/*
+ * Create a string key the per-document cache can't hold
+ */
+static VALUE
+get_uncached_str_key(key_cache_t *kc, const char *s, size_t len)
+{
+    if (kc && len > 0 && len <= KEY_CACHE_MAX_LEN) {
+        return yyjson_key_cache_fetch_str(kc, s, len, fnv1a(s, len));
+    }
+    return make_fstr(s, len);
+}
+
+/*
+ * Create a symbol key the per-document cache can't hold
+ */
+static VALUE
+get_uncached_sym_key(key_cache_t *kc, const char *s, size_t len)
+{
+    if (kc && len > 0 && len <= KEY_CACHE_MAX_LEN) {
+        return yyjson_key_cache_fetch_sym(kc, s, len, fnv1a(s, len));
+    }
+    return make_sym(s, len);
+}
+
 /*
  * Get or create cached string key
  */
 YY_INLINE VALUE
-get_str_key(string_cache_t *c, const char *s, size_t len)
+get_str_key(string_cache_t *c, key_cache_t *kc, const char *s, size_t len)
 {
     if (RB_UNLIKELY(len > CACHE_MAX_LEN || len == 0 || !isalpha((unsigned char)s[0]))) {
-        return make_fstr(s, len);
+        c->misses++;
+        return get_uncached_str_key(kc, s, len);
     }
 
     uint32_t h = fnv1a(s, len);
     int idx = cache_search(c, s, len, h);
 
-    if (idx >= 0) return c->entries[idx].val;  /* Hit */
+    if (idx >= 0) {
+        c->hits++;
+        return c->entries[idx].val;
+    }
+
+    c->misses++;
 
-    VALUE v = make_fstr(s, len);
+    VALUE v = kc ? yyjson_key_cache_fetch_str(kc, s, len, h) : make_fstr(s, len);
     cache_insert(c, -(idx + 1), s, len, h, v);
     return v;
 }
@@ -225,18 +269,24 @@ get_str_key(string_cache_t *c, const char *s, size_t len)
  * Get or create cached symbol key
  */
 YY_INLINE VALUE
-get_sym_key(string_cache_t *c, const char *s, size_t len)
+get_sym_key(string_cache_t *c, key_cache_t *kc, const char *s, size_t len)
 {
     if (RB_UNLIKELY(len > CACHE_MAX_LEN || len == 0 || !isalpha((unsigned char)s[0]))) {
-        return ID2SYM(rb_intern2(s, len));
+        c->misses++;
+        return get_uncached_sym_key(kc, s, len);
     }
 
     uint32_t h = fnv1a(s, len);
     int idx = cache_search(c, s, len, h);
 
-    if (idx >= 0) return c->entries[idx].val;  /* Hit */
+    if (idx >= 0) {
+        c->hits++;
+        return c->entries[idx].val;
+    }
+
+    c->misses++;
 
-    VALUE v = ID2SYM(rb_intern2(s, len));
+    VALUE v = kc ? yyjson_key_cache_fetch_sym(kc, s, len, h) : make_sym(s, len);
     cache_insert(c, -(idx + 1), s, len, h, v);
     return v;
 }
@@ -279,168 +329,421 @@ build_num(yyjson_val *v)
     return DBL2NUM(unsafe_yyjson_get_real(v));
 }
 
-/* Forward declaration */
-typedef struct parse_ctx {
-    const yyjson_parse_options *opts;
-    string_cache_t *str_cache;
-    string_cache_t *sym_cache;
-} parse_ctx_t;
+/*
+ * Freeze a built String/Array/Hash; with opts->shareable also mark it
+ * Ractor-shareable, which holds as values are built bottom-up, so its
+ * contents already are
+ */
+YY_INLINE VALUE
+seal(VALUE obj, const yyjson_parse_options *opts)
+{
+    rb_obj_freeze(obj);
+    if (opts->shareable) RB_FL_SET_RAW(obj, RUBY_FL_SHAREABLE);
+    return obj;
+}
 
-static VALUE build_val(yyjson_val *v, parse_ctx_t *ctx);
+yyjson_value_cache_t *
+yyjson_value_cache_init(yyjson_value_cache_t *cache, const yyjson_parse_options *opts)
+{
+    if (!opts->dedup_values && !opts->freeze) return NULL;
+    memset(cache->slots, 0, sizeof(cache->slots));
+    cache->hits = 0;
+    cache->misses = 0;
+    return cache;
+}
 
 /*
- * Build array using rb_ary_new_from_values
+ * Shared frozen String for a short string value
+ *
+ * A slot holds the latest value hashed to it, so a few recurring values
+ * ("active", "USD") stay cached among many distinct ones.
  */
 static VALUE
-build_arr(yyjson_val *v, parse_ctx_t *ctx)
+get_str_value(yyjson_value_cache_t *vc, const char *s, size_t len, const yyjson_parse_options *opts)
 {
-    size_t len = yyjson_arr_size(v);
+    uint32_t h = fnv1a(s, len);
+    /* FNV-1a's low bits mix poorly for short strings: take the top ones */
+    value_cache_entry_t *e = &vc->slots[(uint32_t)(h * 2654435769u) >> (32 - VALUE_CACHE_BITS)];
 
-    if (RB_UNLIKELY(len == 0)) {
-        VALUE arr = rb_ary_new();
-        if (ctx->opts->freeze) rb_ary_freeze(arr);
-        return arr;
+    if (e->hash == h && e->len == len && memcmp(RSTRING_PTR(e->val), s, len) == 0) {
+        vc->hits++;
+        return e->val;
     }
 
-    /* Stack or heap allocation */
-    VALUE stack_buf[128];
-    VALUE *vals = (len <= 128) ? stack_buf : ALLOC_N(VALUE, len);
+    vc->misses++;
+    /* A plain frozen String: interning every distinct value in the
+     * fstring table would cost more than the hits save */
+    VALUE v = seal(make_str(s, len), opts);
+    *e = (value_cache_entry_t){ .val = v, .len = (uint32_t)len, .hash = h };
+    return v;
+}
 
-    /* Use yyjson iterator for safe traversal */
-    yyjson_arr_iter iter;
-    yyjson_arr_iter_init(v, &iter);
+/*
+ * Build a scalar (or nothing for containers, which need build_container)
+ *
+ * freeze and dedup (values non-NULL) are constants in the specialized
+ * builders, so their branches fold away.
+ */
+YY_INLINE VALUE
+build_scalar_as(yyjson_val *v, const yyjson_parse_options *opts, yyjson_value_cache_t *values,
+                bool freeze, bool dedup)
+{
+    uint8_t tag = unsafe_yyjson_get_tag(v);
+    uint8_t type = tag & YYJSON_TYPE_MASK;
 
-    size_t i = 0;
-    yyjson_val *item;
-    while ((item = yyjson_arr_iter_next(&iter))) {
-        vals[i++] = build_val(item, ctx);
+    switch (type) {
+        case YYJSON_TYPE_NULL:
+            return Qnil;
+        case YYJSON_TYPE_BOOL:
+            return (tag & YYJSON_SUBTYPE_MASK) ? Qtrue : Qfalse;
+        case YYJSON_TYPE_NUM:
+            return build_num(v);
+        case YYJSON_TYPE_STR: {
+            const char *s = unsafe_yyjson_get_str(v);
+            size_t len = unsafe_yyjson_get_len(v);
+            if (dedup && len - 1 < VALUE_CACHE_MAX_LEN) return get_str_value(values, s, len, opts);
+            if (!freeze) return make_str(s, len);
+            /* Shareable values skip the (VM-locked) fstring table */
+            if (RB_UNLIKELY(opts->shareable)) return seal(make_str(s, len), opts);
+            return make_fstr(s, len);
+        }
+        case YYJSON_TYPE_RAW: {
+            /* Only from YYJson.load_msgpack: bin data */
+            VALUE bin = rb_str_new(unsafe_yyjson_get_str(v), (long)unsafe_yyjson_get_len(v));
+            return freeze ? seal(bin, opts) : bin;
+        }
+        default:
+            return Qnil;
     }
+}
 
-    VALUE arr = rb_ary_new_from_values(len, vals);
+YY_INLINE VALUE
+build_scalar(yyjson_val *v, const yyjson_parse_options *opts, yyjson_value_cache_t *values)
+{
+    return build_scalar_as(v, opts, values, opts->freeze, values != NULL);
+}
 
-    if (vals != stack_buf) xfree(vals);
-    if (ctx->opts->freeze) rb_ary_freeze(arr);
+typedef struct parse_ctx {
+    const yyjson_parse_options *opts;
+    string_cache_t *str_cache;
+    string_cache_t *sym_cache;
+    yyjson_value_cache_t *values;  /* Short string values (NULL = not deduplicated) */
+    yyjson_file_map_t *map;  /* Insitu source mapping (NULL unless load_file mmap: true) */
+    size_t heap_fallbacks;   /* Build stack growths onto the heap (YYJson.stats) */
+} parse_ctx_t;
 
-    return arr;
-}
+/* Check for releasable mapped input every this many container elements */
+#define RELEASE_INTERVAL 4096
 
 /*
- * Build hash using rb_hash_bulk_insert
+ * First string (or object key) inside a value, as a position in the input
  */
-static VALUE
-build_obj(yyjson_val *v, parse_ctx_t *ctx)
+static const char *
+first_str(yyjson_val *v)
 {
-    size_t len = yyjson_obj_size(v);
+    for (int depth = 0; depth < 8; depth++) {
+        uint8_t type = unsafe_yyjson_get_tag(v) & YYJSON_TYPE_MASK;
+        if (type == YYJSON_TYPE_STR) return unsafe_yyjson_get_str(v);
+        if (type != YYJSON_TYPE_ARR && type != YYJSON_TYPE_OBJ) return NULL;
+        if (unsafe_yyjson_get_len(v) == 0) return NULL;
+        v = unsafe_yyjson_get_first(v);  /* First element, or first key */
+    }
+    return NULL;
+}
 
-    if (RB_UNLIKELY(len == 0)) {
-        VALUE hash = rb_hash_new();
-        if (ctx->opts->freeze) rb_hash_freeze(hash);
-        return hash;
+/*
+ * Release mapped input before `next` (the next value to be built)
+ *
+ * Insitu strings live at their position in the input, and values are
+ * built in document order, so nothing before `next` is read again. The
+ * per-document key caches hold pointers into the input and are reset.
+ */
+static void
+release_consumed(parse_ctx_t *ctx, yyjson_val *next)
+{
+    const char *upto = first_str(next);
+    if (!upto) return;
+
+    size_t before = ctx->map->released;
+    yyjson_file_map_release(ctx->map, upto);
+    if (ctx->map->released != before) {
+        ctx->str_cache->len = 0;
+        ctx->sym_cache->len = 0;
     }
+}
 
-#ifdef HAVE_RB_HASH_NEW_CAPA
-    VALUE hash = rb_hash_new_capa(len);
-#else
-    VALUE hash = rb_hash_new();
-#endif
+/*
+ * Explicit build stack
+ *
+ * Each open array/object is a frame; the elements (or key/value pairs)
+ * built so far for all open containers sit in one shared arena, and a
+ * container is created from its slice of the arena once it is complete.
+ * Both start in fixed buffers on the C stack and move to ALLOCV memory
+ * when they outgrow them: GC-visible, and freed by the GC if building
+ * raises.
+ */
+#define BUILD_STACK_FRAMES 64
+#define BUILD_STACK_VALUES 256
 
-    /* Stack or heap allocation for pairs */
-    VALUE stack_buf[256];
-    size_t pairs_len = len * 2;
-    VALUE *pairs = (pairs_len <= 256) ? stack_buf : ALLOC_N(VALUE, pairs_len);
+typedef struct {
+    yyjson_val *next;        /* Next element (key, for objects) to build */
+    size_t left;             /* Elements (pairs) not built yet */
+    size_t base;             /* Arena offset of the container's first value */
+    bool obj;
+} build_frame_t;
 
-    bool sym = ctx->opts->symbolize_names;
-    string_cache_t *cache = sym ? ctx->sym_cache : ctx->str_cache;
+typedef struct {
+    build_frame_t *frames;
+    int depth;               /* Open containers */
+    int frames_capa;
+    VALUE frames_heap;       /* ALLOCV holder once frames left the C stack */
+    VALUE *vals;             /* Arena of pending values */
+    size_t len;
+    size_t capa;
+    VALUE vals_heap;         /* ALLOCV holder once the arena left the C stack */
+    size_t grows;            /* Times frames or arena moved to larger memory */
+} build_stack_t;
+
+static void
+grow_frames(build_stack_t *st)
+{
+    int capa = st->frames_capa * 2;
+    VALUE heap = 0;
+    build_frame_t *frames = ALLOCV_N(build_frame_t, heap, capa);
+
+    MEMCPY(frames, st->frames, build_frame_t, st->depth);
+    if (st->frames_heap) ALLOCV_END(st->frames_heap);
+    st->frames = frames;
+    st->frames_capa = capa;
+    st->frames_heap = heap;
+    st->grows++;
+}
 
-    /* Use yyjson iterator for safe traversal */
-    yyjson_obj_iter iter;
-    yyjson_obj_iter_init(v, &iter);
+static void
+grow_vals(build_stack_t *st)
+{
+    size_t capa = st->capa * 2;
+    VALUE heap = 0;
+    VALUE *vals = ALLOCV_N(VALUE, heap, capa);
+
+    /* The old buffer stays reachable (and marked) until the copy is done */
+    MEMCPY(vals, st->vals, VALUE, st->len);
+    if (st->vals_heap) ALLOCV_END(st->vals_heap);
+    st->vals = vals;
+    st->capa = capa;
+    st->vals_heap = heap;
+    st->grows++;
+}
 
-    size_t pi = 0;
-    yyjson_val *key;
-    while ((key = yyjson_obj_iter_next(&iter))) {
-        yyjson_val *val = yyjson_obj_iter_get_val(key);
+YY_INLINE void
+push_val(build_stack_t *st, VALUE v)
+{
+    if (RB_UNLIKELY(st->len == st->capa)) grow_vals(st);
+    st->vals[st->len++] = v;
+}
 
-        const char *ks = unsafe_yyjson_get_str(key);
-        size_t klen = unsafe_yyjson_get_len(key);
-        pairs[pi++] = sym ? get_sym_key(cache, ks, klen) : get_str_key(cache, ks, klen);
-        pairs[pi++] = build_val(val, ctx);
+static VALUE
+empty_container(bool obj, const yyjson_parse_options *opts)
+{
+    VALUE c = obj ? rb_hash_new() : rb_ary_new();
+    if (opts->freeze) seal(c, opts);
+    return c;
+}
+
+/*
+ * Open an array/object: push a frame, or return it directly if empty
+ *
+ * Returns Qundef when a frame was pushed.
+ */
+static VALUE
+open_container(build_stack_t *st, yyjson_val *v, parse_ctx_t *ctx)
+{
+    int max_nesting = ctx->opts->max_nesting;
+    if (RB_UNLIKELY(max_nesting > 0 && st->depth >= max_nesting)) {
+        rb_raise(eParseError, "nesting of %d is too deep", st->depth + 1);
     }
 
+    bool obj = (unsafe_yyjson_get_tag(v) & YYJSON_TYPE_MASK) == YYJSON_TYPE_OBJ;
+    size_t len = unsafe_yyjson_get_len(v);
+    if (RB_UNLIKELY(len == 0)) return empty_container(obj, ctx->opts);
+
+    if (RB_UNLIKELY(st->depth == st->frames_capa)) grow_frames(st);
+    st->frames[st->depth++] = (build_frame_t){
+        .next = unsafe_yyjson_get_first(v),
+        .left = len,
+        .base = st->len,
+        .obj = obj
+    };
+    return Qundef;
+}
+
+/*
+ * Create the completed top container from its arena slice and pop it
+ */
+YY_INLINE VALUE
+close_container(build_stack_t *st, parse_ctx_t *ctx, bool freeze)
+{
+    build_frame_t *f = &st->frames[--st->depth];
+    VALUE *vals = st->vals + f->base;
+    size_t n = st->len - f->base;
+    VALUE c;
+
+    if (f->obj) {
+#ifdef HAVE_RB_HASH_NEW_CAPA
+        c = rb_hash_new_capa((long)(n / 2));
+#else
+        c = rb_hash_new();
+#endif
 #ifdef HAVE_RB_HASH_BULK_INSERT
-    rb_hash_bulk_insert(pairs_len, pairs, hash);
+        rb_hash_bulk_insert((long)n, vals, c);
 #else
-    for (size_t i = 0; i < pairs_len; i += 2) {
-        rb_hash_aset(hash, pairs[i], pairs[i + 1]);
-    }
+        for (size_t i = 0; i < n; i += 2) {
+            rb_hash_aset(c, vals[i], vals[i + 1]);
+        }
 #endif
+    } else {
+        c = rb_ary_new_from_values((long)n, vals);
+    }
 
-    if (pairs != stack_buf) xfree(pairs);
-    if (ctx->opts->freeze) rb_hash_freeze(hash);
-
-    return hash;
+    st->len = f->base;
+    if (freeze) seal(c, ctx->opts);
+    return c;
 }
 
 /*
- * Build Ruby value from yyjson value
+ * Build an array or object iteratively
+ *
+ * C stack use is fixed however deep the document is (safe on small fiber
+ * stacks), and nesting beyond opts->max_nesting raises ParseError. With
+ * root NULL, builds an Array of the n sibling values from `first` instead.
+ *
+ * A template: sym / freeze / dedup are compile-time constants in each of
+ * the builders below, so the loop has no option branches and calls the
+ * right key function directly.
  */
-static VALUE
-build_val(yyjson_val *v, parse_ctx_t *ctx)
+YY_INLINE VALUE
+build_container_as(yyjson_val *root, yyjson_val *first, size_t n, parse_ctx_t *ctx,
+                   bool sym, bool freeze, bool dedup)
 {
-    uint8_t tag = unsafe_yyjson_get_tag(v);
-    uint8_t type = tag & YYJSON_TYPE_MASK;
+    build_frame_t frames_buf[BUILD_STACK_FRAMES];
+    VALUE vals_buf[BUILD_STACK_VALUES];
+    build_stack_t st = {
+        .frames = frames_buf, .depth = 0, .frames_capa = BUILD_STACK_FRAMES, .frames_heap = 0,
+        .vals = vals_buf, .len = 0, .capa = BUILD_STACK_VALUES, .vals_heap = 0,
+        .grows = 0
+    };
 
-    switch (type) {
-        case YYJSON_TYPE_NULL:
-            return Qnil;
+    string_cache_t *cache = sym ? ctx->sym_cache : ctx->str_cache;
+    key_cache_t *kc = ctx->opts->key_cache;
+    size_t since_release = 0;
+
+    VALUE result;
+    if (root) {
+        result = open_container(&st, root, ctx);
+    } else if (n == 0) {
+        result = empty_container(false, ctx->opts);
+    } else {
+        st.frames[st.depth++] = (build_frame_t){ .next = first, .left = n, .base = 0, .obj = false };
+        result = Qundef;
+    }
+    if (result != Qundef) return result;
+
+    for (;;) {
+        build_frame_t *f = &st.frames[st.depth - 1];
+
+        if (f->left == 0) {
+            VALUE c = close_container(&st, ctx, freeze);
+            if (st.depth == 0) {
+                result = c;
+                break;
+            }
+            push_val(&st, c);
+            continue;
+        }
 
-        case YYJSON_TYPE_BOOL:
-            return (tag & YYJSON_SUBTYPE_MASK) ? Qtrue : Qfalse;
+        yyjson_val *v = f->next;
+        if (f->obj) {
+            const char *ks = unsafe_yyjson_get_str(v);
+            size_t klen = unsafe_yyjson_get_len(v);
+            push_val(&st, sym ? get_sym_key(cache, kc, ks, klen) : get_str_key(cache, kc, ks, klen));
+            v++;  /* The value follows its key */
+        }
+        f->next = unsafe_yyjson_get_next(v);
+        f->left--;
 
-        case YYJSON_TYPE_NUM:
-            return build_num(v);
+        if (RB_UNLIKELY(ctx->map != NULL) && ++since_release == RELEASE_INTERVAL) {
+            since_release = 0;
+            release_consumed(ctx, v);
+        }
 
-        case YYJSON_TYPE_STR: {
-            const char *s = unsafe_yyjson_get_str(v);
-            size_t len = unsafe_yyjson_get_len(v);
-            return ctx->opts->freeze ? make_fstr(s, len) : make_str(s, len);
+        uint8_t type = unsafe_yyjson_get_tag(v) & YYJSON_TYPE_MASK;
+        if (type == YYJSON_TYPE_ARR || type == YYJSON_TYPE_OBJ) {
+            /* May move the frames: f is not used again this iteration */
+            VALUE c = open_container(&st, v, ctx);
+            if (c != Qundef) push_val(&st, c);
+        } else {
+            push_val(&st, build_scalar_as(v, ctx->opts, ctx->values, freeze, dedup));
         }
+    }
 
-        case YYJSON_TYPE_ARR:
-            return build_arr(v, ctx);
+    if (st.frames_heap) ALLOCV_END(st.frames_heap);
+    if (st.vals_heap) ALLOCV_END(st.vals_heap);
+    ctx->heap_fallbacks += st.grows;
+    RB_GC_GUARD(result);
+    return result;
+}
 
-        case YYJSON_TYPE_OBJ:
-            return build_obj(v, ctx);
+typedef VALUE (*build_fn)(yyjson_val *root, yyjson_val *first, size_t n, parse_ctx_t *ctx);
 
-        default:
-            return Qnil;
+#define DEFINE_BUILDER(name, sym, freeze, dedup) \
+    static VALUE \
+    name(yyjson_val *root, yyjson_val *first, size_t n, parse_ctx_t *ctx) \
+    { \
+        return build_container_as(root, first, n, ctx, sym, freeze, dedup); \
     }
-}
+
+/* freeze always deduplicates (see yyjson_value_cache_init) */
+DEFINE_BUILDER(build_str_keys, false, false, false)
+DEFINE_BUILDER(build_str_keys_dedup, false, false, true)
+DEFINE_BUILDER(build_str_keys_frozen, false, true, true)
+DEFINE_BUILDER(build_sym_keys, true, false, false)
+DEFINE_BUILDER(build_sym_keys_dedup, true, false, true)
+DEFINE_BUILDER(build_sym_keys_frozen, true, true, true)
 
 /*
- * Build value without cache (for primitives and small docs)
+ * The builder specialized for a build's options, chosen once per call
+ * (mode only sets these defaults, when options are extracted)
  */
-YY_INLINE VALUE
-build_val_simple(yyjson_val *v, bool freeze)
+static build_fn
+select_builder(const parse_ctx_t *ctx)
 {
-    uint8_t tag = unsafe_yyjson_get_tag(v);
-    uint8_t type = tag & YYJSON_TYPE_MASK;
+    bool sym = ctx->opts->symbolize_names;
+    if (ctx->opts->freeze) return sym ? build_sym_keys_frozen : build_str_keys_frozen;
+    if (ctx->values) return sym ? build_sym_keys_dedup : build_str_keys_dedup;
+    return sym ? build_sym_keys : build_str_keys;
+}
 
-    switch (type) {
-        case YYJSON_TYPE_NULL:
-            return Qnil;
-        case YYJSON_TYPE_BOOL:
-            return (tag & YYJSON_SUBTYPE_MASK) ? Qtrue : Qfalse;
-        case YYJSON_TYPE_NUM:
-            return build_num(v);
-        case YYJSON_TYPE_STR: {
-            const char *s = unsafe_yyjson_get_str(v);
-            size_t len = unsafe_yyjson_get_len(v);
-            return freeze ? make_fstr(s, len) : make_str(s, len);
+/*
+ * Build with the specialized builder, counted in YYJson.stats when enabled
+ */
+static VALUE
+build_counted(yyjson_val *root, yyjson_val *first, size_t n, parse_ctx_t *ctx)
+{
+    uint64_t start = YYJSON_STATS_START();
+    VALUE result = select_builder(ctx)(root, first, n, ctx);
+
+    if (RB_UNLIKELY(start)) {
+        yyjson_stats_t *s = yyjson_stats_local();
+        s->build_ns += yyjson_stats_now() - start;
+        s->key_cache_hits += ctx->str_cache->hits + ctx->sym_cache->hits;
+        s->key_cache_misses += ctx->str_cache->misses + ctx->sym_cache->misses;
+        s->heap_fallbacks += ctx->heap_fallbacks;
+        if (ctx->values) {
+            s->value_cache_hits += ctx->values->hits;
+            s->value_cache_misses += ctx->values->misses;
         }
-        default:
-            return Qnil;  /* Arrays/objects need full path */
     }
+    return result;
 }
 
 /*
@@ -448,6 +751,52 @@ build_val_simple(yyjson_val *v, bool freeze)
  */
 VALUE
 yyjson_build_ruby_object(yyjson_doc *doc, const yyjson_parse_options *opts)
+{
+    return yyjson_build_ruby_object_mapped(doc, opts, NULL);
+}
+
+typedef struct {
+    yyjson_doc *doc;
+    const yyjson_parse_options *opts;
+} build_free_args_t;
+
+static VALUE
+build_free_body(VALUE arg)
+{
+    build_free_args_t *a = (build_free_args_t *)arg;
+    return yyjson_build_ruby_object(a->doc, a->opts);
+}
+
+static VALUE
+build_free_ensure(VALUE arg)
+{
+    yyjson_doc_free(((build_free_args_t *)arg)->doc);
+    return Qnil;
+}
+
+/*
+ * Public API: Build Ruby object from yyjson document, then free it
+ */
+VALUE
+yyjson_build_ruby_object_free(yyjson_doc *doc, const yyjson_parse_options *opts)
+{
+    /* Scalars can't raise mid-build: skip the ensure frame */
+    if (!doc->root || (unsafe_yyjson_get_tag(doc->root) & YYJSON_TYPE_MASK) < YYJSON_TYPE_ARR) {
+        VALUE result = yyjson_build_ruby_object(doc, opts);
+        yyjson_doc_free(doc);
+        return result;
+    }
+
+    build_free_args_t args = { doc, opts };
+    return rb_ensure(build_free_body, (VALUE)&args, build_free_ensure, (VALUE)&args);
+}
+
+/*
+ * Public API: Build Ruby object from a document parsed insitu from a mapping
+ */
+VALUE
+yyjson_build_ruby_object_mapped(yyjson_doc *doc, const yyjson_parse_options *opts,
+                                yyjson_file_map_t *map)
 {
     if (RB_UNLIKELY(!doc || !doc->root)) return Qnil;
 
@@ -456,18 +805,98 @@ yyjson_build_ruby_object(yyjson_doc *doc, const yyjson_parse_options *opts)
 
     /* Fast path for primitives (no cache needed) */
     if (type < YYJSON_TYPE_ARR) {
-        return build_val_simple(root, opts->freeze);
+        return build_scalar(root, opts, NULL);
     }
 
     /* Initialize caches only for containers */
     string_cache_t str_cache = { .len = 0 };
     string_cache_t sym_cache = { .len = 0 };
+    yyjson_value_cache_t values;
+
+    parse_ctx_t ctx = {
+        .opts = opts,
+        .str_cache = &str_cache,
+        .sym_cache = &sym_cache,
+        .values = yyjson_value_cache_init(&values, opts),
+        .map = map,
+        .heap_fallbacks = 0
+    };
+
+    return build_counted(root, NULL, 0, &ctx);
+}
+
+/*
+ * Public API: Build Ruby object from one value of a document
+ */
+VALUE
+yyjson_build_ruby_value(yyjson_val *val, const yyjson_parse_options *opts)
+{
+    uint8_t type = unsafe_yyjson_get_tag(val) & YYJSON_TYPE_MASK;
+    if (type < YYJSON_TYPE_ARR) {
+        return build_scalar(val, opts, NULL);
+    }
+
+    yyjson_value_cache_t values;
+    return yyjson_build_ruby_value_cached(val, opts, yyjson_value_cache_init(&values, opts));
+}
+
+/*
+ * Public API: Build one value of a document with a caller's value cache
+ */
+VALUE
+yyjson_build_ruby_value_cached(yyjson_val *val, const yyjson_parse_options *opts,
+                               yyjson_value_cache_t *values)
+{
+    uint8_t type = unsafe_yyjson_get_tag(val) & YYJSON_TYPE_MASK;
+    if (type < YYJSON_TYPE_ARR) {
+        return build_scalar(val, opts, values);
+    }
+
+    string_cache_t str_cache = { .len = 0 };
+    string_cache_t sym_cache = { .len = 0 };
+
+    parse_ctx_t ctx = {
+        .opts = opts,
+        .str_cache = &str_cache,
+        .sym_cache = &sym_cache,
+        .values = values,
+        .map = NULL,
+        .heap_fallbacks = 0
+    };
+
+    return build_counted(val, NULL, 0, &ctx);
+}
+
+/*
+ * Public API: Build an Array of consecutive values of a document
+ */
+VALUE
+yyjson_build_ruby_elements(yyjson_val *first, size_t n, const yyjson_parse_options *opts)
+{
+    string_cache_t str_cache = { .len = 0 };
+    string_cache_t sym_cache = { .len = 0 };
+    yyjson_value_cache_t values;
 
     parse_ctx_t ctx = {
         .opts = opts,
         .str_cache = &str_cache,
-        .sym_cache = &sym_cache
+        .sym_cache = &sym_cache,
+        .values = yyjson_value_cache_init(&values, opts),
+        .map = NULL,
+        .heap_fallbacks = 0
     };
 
-    return build_val(root, &ctx);
+    return build_counted(NULL, first, n, &ctx);
+}
+
+/*
+ * Public API: Build a Hash key (String or Symbol) from an object key
+ */
+VALUE
+yyjson_build_ruby_key(yyjson_val *key, const yyjson_parse_options *opts)
+{
+    const char *s = unsafe_yyjson_get_str(key);
+    size_t len = unsafe_yyjson_get_len(key);
+    if (opts->symbolize_names) return get_uncached_sym_key(opts->key_cache, s, len);
+    return get_uncached_str_key(opts->key_cache, s, len);
 }
@@ -6,6 +6,8 @@
 #define YYJSON_RUBY_VALUE_BUILDER_H
 
 #include "common.h"
+#include "key_cache.h"
+#include "file_map.h"
 
 /*
  * Parse options for controlling how JSON is converted to Ruby objects
@@ -17,8 +19,40 @@ typedef struct {
     bool allow_comments;     /* Allow C-style comments in JSON */
     int max_nesting;         /* Maximum nesting depth (0 = unlimited) */
     yyjson_mode_t mode;      /* Parsing mode (strict, compat, rails, object) */
+    size_t gvl_release_threshold; /* Release the GVL while reading inputs of at least this size (0 = never) */
+    key_cache_t *key_cache;  /* Persistent key cache shared across parses (NULL = per-document only) */
+    bool mmap;               /* load_file: parse insitu from a memory-mapped file */
+    bool shareable;          /* Mark frozen output Ractor-shareable (load_parallel; needs freeze) */
+    bool dedup_values;       /* Share frozen Strings among equal short string values */
 } yyjson_parse_options;
 
+/*
+ * Short string values (dedup_values: true, or freeze: true) are looked up
+ * in a direct-mapped cache before a String is made for them
+ */
+#define VALUE_CACHE_BITS 8
+#define VALUE_CACHE_SLOTS (1 << VALUE_CACHE_BITS)
+#define VALUE_CACHE_MAX_LEN 32
+
+typedef struct {
+    VALUE val;               /* Frozen String (its bytes are compared) */
+    uint32_t len;            /* 0 = empty slot */
+    uint32_t hash;
+} value_cache_entry_t;
+
+/*
+ * Deduplicated string values of one build
+ *
+ * Lives on the C stack, where the GC sees the cached Strings. Entries
+ * compare against the Strings themselves, never the document, so they
+ * stay valid after the document (or its mmap pages) is released.
+ */
+typedef struct {
+    value_cache_entry_t slots[VALUE_CACHE_SLOTS];
+    size_t hits;             /* Values served from the cache (YYJson.stats) */
+    size_t misses;
+} yyjson_value_cache_t;
+
 /*
  * Initialize the value builder module
  */
@@ -33,4 +67,74 @@ void yyjson_value_builder_init(void);
  */
 VALUE yyjson_build_ruby_object(yyjson_doc *doc, const yyjson_parse_options *opts);
 
+/*
+ * Build a Ruby object from a yyjson document, then free the document
+ *
+ * The document is freed even if building raises (e.g. max_nesting).
+ *
+ * @param doc The yyjson document to convert (freed on return)
+ * @param opts Parse options controlling the conversion
+ * @return A Ruby object representing the JSON data
+ */
+VALUE yyjson_build_ruby_object_free(yyjson_doc *doc, const yyjson_parse_options *opts);
+
+/*
+ * Build a Ruby object from a document parsed insitu from a file mapping
+ *
+ * Releases the mapping's pages behind the build cursor as it goes
+ * (see yyjson_file_map_release).
+ *
+ * @param doc The yyjson document (read with YYJSON_READ_INSITU from map)
+ * @param opts Parse options controlling the conversion
+ * @param map The mapping the document points into
+ * @return A Ruby object representing the JSON data
+ */
+VALUE yyjson_build_ruby_object_mapped(yyjson_doc *doc, const yyjson_parse_options *opts,
+                                      yyjson_file_map_t *map);
+
+/*
+ * Build a Ruby object from one value (and its children) of a document
+ *
+ * @param val The yyjson value to convert
+ * @param opts Parse options controlling the conversion
+ * @return A Ruby object representing the value
+ */
+VALUE yyjson_build_ruby_value(yyjson_val *val, const yyjson_parse_options *opts);
+
+/*
+ * yyjson_build_ruby_value sharing a value cache across calls (load_table
+ * cells); values is NULL or set up with yyjson_value_cache_init
+ */
+VALUE yyjson_build_ruby_value_cached(yyjson_val *val, const yyjson_parse_options *opts,
+                                     yyjson_value_cache_t *values);
+
+/*
+ * The value cache to use for opts, initialized in *cache: NULL unless
+ * opts->dedup_values or opts->freeze
+ */
+yyjson_value_cache_t *yyjson_value_cache_init(yyjson_value_cache_t *cache, const yyjson_parse_options *opts);
+
+/*
+ * Build an Array of n consecutive values (e.g. a slice of an array's
+ * elements), sharing the key caches across them
+ *
+ * The Array counts as one nesting level and is frozen with opts->freeze.
+ *
+ * @param first The first value
+ * @param n Number of values (first and its next n - 1 siblings)
+ * @param opts Parse options controlling the conversion
+ * @return Array of the values
+ */
+VALUE yyjson_build_ruby_elements(yyjson_val *first, size_t n, const yyjson_parse_options *opts);
+
+/*
+ * Build a Hash key from an object key (a frozen String, or a Symbol with
+ * symbolize_names; uses opts->key_cache when set)
+ *
+ * @param key A string value that is an object key
+ * @param opts Parse options controlling the conversion
+ * @return The key as a Ruby object
+ */
+VALUE yyjson_build_ruby_key(yyjson_val *key, const yyjson_parse_options *opts);
+
 #endif /* YYJSON_RUBY_VALUE_BUILDER_H */
@@ -1,170 +1,214 @@
 /*
  * writer.c - JSON document writer
  *
- * Handles writing yyjson mutable documents to JSON strings.
+ * Handles writing Ruby objects to JSON strings and files.
  */
 
 #include "common.h"
 #include "object_dumper.h"
 #include "writer.h"
+#include "sha256.h"
 #include <string.h>
+#include <errno.h>
+
+/* Starting capacity of the output buffer */
+#define WRITER_INITIAL_CAPA 256
+
+/* Default and smallest :buffer_size of streaming writes */
+#define WRITER_STREAM_CAPA (64 * 1024)
+#define WRITER_STREAM_MIN 64
+
+/* A streaming write: the buffer drains into io, the block, file, or sha */
+typedef struct {
+    VALUE obj;
+    const yyjson_dump_options *opts;
+    json_buf_t buf;
+    VALUE io;
+    FILE *file;
+    const char *path;
+    yyjson_sha256_ctx *sha;
+} stream_args;
 
 /*
- * Escape HTML entities in a JSON string
- *
- * Replaces:
- *   < with \u003c
- *   > with \u003e
- *   & with \u0026
- *   ' with \u0027 (for attribute safety)
- *
- * This prevents XSS when JSON is embedded in HTML.
+ * Write a Ruby object to a JSON string
  *
- * @param json The JSON string to escape
- * @param len Length of the JSON string
- * @param out_len Output parameter for escaped string length
- * @return Newly allocated escaped string (caller must free)
+ * @param obj The Ruby object to serialize
+ * @param opts Dump options
+ * @return Ruby string containing JSON
  */
-static char *
-escape_html_entities(const char *json, size_t len, size_t *out_len)
+VALUE
+yyjson_ruby_write_string(VALUE obj, const yyjson_dump_options *opts)
 {
-    size_t escape_count = 0;
-    const char *p = json;
-    const char *end = json + len;
-
-    /* First pass: count characters that need escaping */
-    while (p < end) {
-        char c = *p;
-        if (c == '<' || c == '>' || c == '&' || c == '\'') {
-            escape_count++;
-        }
-        p++;
-    }
-
-    /* If nothing to escape, return copy */
-    if (escape_count == 0) {
-        char *result = (char *)malloc(len);
-        if (result) {
-            memcpy(result, json, len);
-            *out_len = len;
-        }
-        return result;
-    }
-
-    /* Allocate new string: each escaped char becomes \uXXXX (6 bytes instead of 1) */
-    size_t new_len = len + (escape_count * 5);  /* 5 extra bytes per escaped char */
-    char *result = (char *)malloc(new_len);
-    if (!result) {
-        return NULL;
-    }
-
-    /* Second pass: copy and escape */
-    const char *src = json;
-    char *dst = result;
-    while (src < end) {
-        char c = *src;
-        if (c == '<') {
-            memcpy(dst, "\\u003c", 6);
-            dst += 6;
-        } else if (c == '>') {
-            memcpy(dst, "\\u003e", 6);
-            dst += 6;
-        } else if (c == '&') {
-            memcpy(dst, "\\u0026", 6);
-            dst += 6;
-        } else if (c == '\'') {
-            memcpy(dst, "\\u0027", 6);
-            dst += 6;
-        } else {
-            *dst++ = c;
-        }
-        src++;
-    }
-
-    *out_len = dst - result;
-    return result;
+    /* Dump Ruby object straight into the result string */
+    json_buf_t buf;
+    json_buf_init(&buf, WRITER_INITIAL_CAPA);
+    return yyjson_ruby_write_buf(obj, &buf, opts);
 }
 
 /*
- * Write a Ruby object to a JSON string
+ * Write a Ruby object into an initialized output buffer
  *
  * @param obj The Ruby object to serialize
+ * @param buf Output buffer (String-backed or scratch)
  * @param opts Dump options
  * @return Ruby string containing JSON
  */
 VALUE
-yyjson_ruby_write_string(VALUE obj, const yyjson_dump_options *opts)
+yyjson_ruby_write_buf(VALUE obj, json_buf_t *buf, const yyjson_dump_options *opts)
 {
-    /* Create mutable document */
-    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
-    if (!doc) {
-        RAISE_GENERATE_ERROR("Failed to create JSON document");
-    }
+    /* escape_html is applied to each string as it is written */
+    yyjson_dump_ruby_object(obj, buf, opts);
+    return json_buf_finish(buf);
+}
+
+static void
+flush_to_io(json_buf_t *buf, const char *data, size_t len)
+{
+    stream_args *a = buf->flush_arg;
+    /* A new String each time: #write may keep it (even a File's can be
+     * overridden), so the GC reclaims it rather than us */
+    rb_io_write(a->io, rb_utf8_str_new(data, (long)len));
+}
+
+static void
+flush_to_block(json_buf_t *buf, const char *data, size_t len)
+{
+    rb_yield(rb_utf8_str_new(data, (long)len));
+}
 
-    /* Dump Ruby object to yyjson mutable value */
-    yyjson_mut_val *root = yyjson_dump_ruby_object(obj, doc, opts);
-    if (!root) {
-        yyjson_mut_doc_free(doc);
-        RAISE_GENERATE_ERROR("Failed to convert Ruby object to JSON");
+static void
+flush_to_file(json_buf_t *buf, const char *data, size_t len)
+{
+    stream_args *a = buf->flush_arg;
+    if (fwrite(data, 1, len, a->file) != len) {
+        rb_raise(eGenerateError, "Failed to write JSON to file %s: %s", a->path, strerror(errno));
     }
+}
 
-    /* Set document root */
-    yyjson_mut_doc_set_root(doc, root);
+static void
+flush_to_digest(json_buf_t *buf, const char *data, size_t len)
+{
+    stream_args *a = buf->flush_arg;
+    yyjson_sha256_update(a->sha, data, len);
+}
 
-    /* Configure write flags */
-    yyjson_write_flag flg = 0;
+static VALUE
+stream_body(VALUE ptr)
+{
+    stream_args *a = (stream_args *)ptr;
+    yyjson_dump_ruby_object(a->obj, &a->buf, a->opts);
+    json_buf_flush(&a->buf);
+    return Qnil;
+}
 
-    if (opts->pretty) {
-        flg |= YYJSON_WRITE_PRETTY;
-        flg |= YYJSON_WRITE_PRETTY_TWO_SPACES; /* Use 2-space indent by default */
-    }
+static VALUE
+stream_ensure(VALUE ptr)
+{
+    stream_args *a = (stream_args *)ptr;
+    json_buf_free_stream(&a->buf);
+    return Qnil;
+}
 
-    if (opts->escape_slash) {
-        flg |= YYJSON_WRITE_ESCAPE_SLASHES;
-    }
+/*
+ * Dump through a streaming buffer of opts->buffer_size bytes
+ */
+static void
+write_stream(stream_args *a, json_buf_flush_fn flush)
+{
+    json_buf_init_stream(&a->buf, a->opts->buffer_size, flush, a);
+    rb_ensure(stream_body, (VALUE)a, stream_ensure, (VALUE)a);
+}
 
-    if (opts->allow_nan) {
-        flg |= YYJSON_WRITE_ALLOW_INF_AND_NAN;
-    }
+/*
+ * Write a Ruby object as JSON to an IO, opts->buffer_size bytes at a time
+ *
+ * @param obj The Ruby object to serialize
+ * @param io Object responding to #write
+ * @param opts Dump options
+ * @return io
+ */
+VALUE
+yyjson_ruby_write_io(VALUE obj, VALUE io, const yyjson_dump_options *opts)
+{
+    stream_args a = { .obj = obj, .opts = opts, .io = io };
+    write_stream(&a, flush_to_io);
+    return io;
+}
+
+/*
+ * Write a Ruby object as JSON, yielding chunks of at most opts->buffer_size
+ * bytes (larger only for a single longer token)
+ *
+ * @param obj The Ruby object to serialize
+ * @param opts Dump options
+ * @return Qnil
+ */
+VALUE
+yyjson_ruby_write_chunks(VALUE obj, const yyjson_dump_options *opts)
+{
+    stream_args a = { .obj = obj, .opts = opts, .io = Qnil };
+    write_stream(&a, flush_to_block);
+    return Qnil;
+}
 
-    /* Write to string */
-    size_t len;
-    char *json = yyjson_mut_write_opts(doc, flg, NULL, &len, NULL);
+/*
+ * Hash a Ruby object's JSON with SHA-256 as it is written, opts->buffer_size
+ * bytes at a time, without building the JSON String
+ *
+ * @param obj The Ruby object to serialize
+ * @param opts Dump options
+ * @return The digest as a 64-character lowercase hex String
+ */
+VALUE
+yyjson_ruby_write_sha256(VALUE obj, const yyjson_dump_options *opts)
+{
+    yyjson_sha256_ctx sha;
+    yyjson_sha256_init(&sha);
 
-    if (!json) {
-        yyjson_mut_doc_free(doc);
-        RAISE_GENERATE_ERROR("Failed to write JSON");
-    }
+    stream_args a = { .obj = obj, .opts = opts, .io = Qnil, .sha = &sha };
+    write_stream(&a, flush_to_digest);
 
-    /* Apply HTML entity escaping if requested */
-    char *final_json = json;
-    size_t final_len = len;
+    uint8_t digest[YYJSON_SHA256_SIZE];
+    yyjson_sha256_final(&sha, digest);
 
-    if (opts->escape_html) {
-        char *escaped = escape_html_entities(json, len, &final_len);
-        if (!escaped) {
-            free(json);
-            yyjson_mut_doc_free(doc);
-            RAISE_GENERATE_ERROR("Failed to escape HTML entities");
-        }
-        free(json);  /* Free original JSON */
-        final_json = escaped;
+    static const char hex[] = "0123456789abcdef";
+    char out[YYJSON_SHA256_SIZE * 2];
+    for (int i = 0; i < YYJSON_SHA256_SIZE; i++) {
+        out[i * 2] = hex[digest[i] >> 4];
+        out[i * 2 + 1] = hex[digest[i] & 0xF];
     }
+    return rb_usascii_str_new(out, sizeof(out));
+}
 
-    /* Create Ruby string */
-    VALUE rb_json = rb_str_new(final_json, final_len);
-    rb_enc_associate(rb_json, rb_utf8_encoding());
-
-    /* Clean up */
-    free(final_json);
-    yyjson_mut_doc_free(doc);
+static VALUE
+file_body(VALUE ptr)
+{
+    stream_args *a = (stream_args *)ptr;
+    write_stream(a, flush_to_file);
+
+    /* Closed here on success, to report errors flushing stdio's buffer */
+    FILE *file = a->file;
+    a->file = NULL;
+    if (fclose(file) != 0) {
+        rb_raise(eGenerateError, "Failed to write JSON to file %s: %s", a->path, strerror(errno));
+    }
+    return Qnil;
+}
 
-    return rb_json;
+static VALUE
+file_ensure(VALUE ptr)
+{
+    stream_args *a = (stream_args *)ptr;
+    if (a->file) fclose(a->file);
+    return Qnil;
 }
 
 /*
  * Write a Ruby object to a JSON file
  *
+ * The output is streamed through opts->buffer_size bytes of memory; a dump
+ * that raises part-way leaves the output written so far.
+ *
  * @param obj The Ruby object to serialize
  * @param file_path Path to output file
  * @param opts Dump options
@@ -179,55 +223,45 @@ yyjson_ruby_write_file(VALUE obj, VALUE file_path, const yyjson_dump_options *op
 
     const char *path = RSTRING_PTR(file_path);
 
-    /* Create mutable document */
-    yyjson_mut_doc *doc = yyjson_mut_doc_new(NULL);
-    if (!doc) {
-        RAISE_GENERATE_ERROR("Failed to create JSON document");
-    }
-
-    /* Dump Ruby object to yyjson mutable value */
-    yyjson_mut_val *root = yyjson_dump_ruby_object(obj, doc, opts);
-    if (!root) {
-        yyjson_mut_doc_free(doc);
-        RAISE_GENERATE_ERROR("Failed to convert Ruby object to JSON");
-    }
-
-    /* Set document root */
-    yyjson_mut_doc_set_root(doc, root);
-
-    /* Configure write flags */
-    yyjson_write_flag flg = 0;
-
-    if (opts->pretty) {
-        flg |= YYJSON_WRITE_PRETTY;
-        flg |= YYJSON_WRITE_PRETTY_TWO_SPACES;
+    /* Write to file */
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        rb_raise(eGenerateError, "Failed to write JSON to file %s: %s", path, strerror(errno));
     }
 
-    if (opts->escape_slash) {
-        flg |= YYJSON_WRITE_ESCAPE_SLASHES;
-    }
+    stream_args a = { .obj = obj, .opts = opts, .io = Qnil, .file = file, .path = path };
+    rb_ensure(file_body, (VALUE)&a, file_ensure, (VALUE)&a);
 
-    if (opts->allow_nan) {
-        flg |= YYJSON_WRITE_ALLOW_INF_AND_NAN;
-    }
+    RB_GC_GUARD(file_path);
+    return Qnil;
+}
 
-    /* Write to file */
-    yyjson_write_err err;
-    bool success = yyjson_mut_write_file(path, doc, flg, NULL, &err);
-
-    if (!success) {
-        yyjson_mut_doc_free(doc);
-        char error_msg[256];
-        snprintf(error_msg, sizeof(error_msg),
-                 "Failed to write JSON to file %s: %s (code: %u)",
-                 path, err.msg, err.code);
-        RAISE_GENERATE_ERROR(error_msg);
+/*
+ * Validate a time_precision value (Integer 0-9)
+ */
+static int
+time_precision_value(VALUE val)
+{
+    int prec = NUM2INT(val);
+    if (prec < 0 || prec > 9) {
+        rb_raise(rb_eArgError, "time_precision must be between 0 and 9 (got %d)", prec);
     }
+    return prec;
+}
 
-    /* Clean up */
-    yyjson_mut_doc_free(doc);
+/*
+ * YYJson::Rails.time_precision, or 0 if yyjson/rails isn't loaded or it
+ * is unset
+ */
+static int
+rails_time_precision(void)
+{
+    ID id_Rails = rb_intern("Rails");
+    if (!rb_const_defined_at(mYYJson, id_Rails)) return 0;
 
-    return Qnil;
+    VALUE mod = rb_const_get_at(mYYJson, id_Rails);
+    VALUE val = rb_attr_get(mod, rb_intern("@time_precision"));
+    return NIL_P(val) ? 0 : time_precision_value(val);
 }
 
 /*
@@ -246,9 +280,13 @@ yyjson_extract_dump_options(VALUE opts_hash, yyjson_dump_options *opts)
     opts->escape_slash = false;
     opts->allow_nan = true;
     opts->escape_html = false;
+    opts->check_circular = true;
+    opts->time_precision = 0;
     opts->indent = 2;
     opts->mode = MODE_COMPAT;
-    opts->temp_obj = NULL;
+    opts->buffer_size = WRITER_STREAM_CAPA;
+    opts->msgpack = false;
+    opts->canonical = false;
 
     /* If no options hash provided, use defaults */
     if (NIL_P(opts_hash)) {
@@ -256,13 +294,13 @@ yyjson_extract_dump_options(VALUE opts_hash, yyjson_dump_options *opts)
     }
 
     /* Extract pretty option */
-    val = rb_hash_aref(opts_hash, ID2SYM(rb_intern("pretty")));
+    val = rb_hash_aref(opts_hash, ID2SYM(id_pretty));
     if (!NIL_P(val)) {
         opts->pretty = RTEST(val);
     }
 
     /* Extract indent option */
-    val = rb_hash_aref(opts_hash, ID2SYM(rb_intern("indent")));
+    val = rb_hash_aref(opts_hash, ID2SYM(id_indent));
     if (!NIL_P(val)) {
         opts->indent = NUM2INT(val);
         if (opts->indent > 0) {
@@ -271,13 +309,13 @@ yyjson_extract_dump_options(VALUE opts_hash, yyjson_dump_options *opts)
     }
 
     /* Extract escape_slash option */
-    val = rb_hash_aref(opts_hash, ID2SYM(rb_intern("escape_slash")));
+    val = rb_hash_aref(opts_hash, ID2SYM(id_escape_slash));
     if (!NIL_P(val)) {
         opts->escape_slash = RTEST(val);
     }
 
     /* Extract allow_nan option */
-    val = rb_hash_aref(opts_hash, ID2SYM(rb_intern("allow_nan")));
+    val = rb_hash_aref(opts_hash, ID2SYM(id_allow_nan));
     if (!NIL_P(val)) {
         opts->allow_nan = RTEST(val);
     }
@@ -295,14 +333,47 @@ yyjson_extract_dump_options(VALUE opts_hash, yyjson_dump_options *opts)
         } else if (mode_id == rb_intern("rails")) {
             opts->mode = MODE_RAILS;
             opts->escape_html = true;  /* Rails mode escapes HTML by default */
+            opts->time_precision = rails_time_precision();
         } else if (mode_id == rb_intern("object")) {
             opts->mode = MODE_OBJECT;
         }
     }
 
     /* Allow explicit option overrides after mode defaults */
-    val = rb_hash_aref(opts_hash, ID2SYM(rb_intern("escape_html")));
+    val = rb_hash_aref(opts_hash, ID2SYM(id_escape_html));
     if (!NIL_P(val)) {
         opts->escape_html = RTEST(val);
     }
+
+    /* Extract check_circular option */
+    val = rb_hash_aref(opts_hash, ID2SYM(id_check_circular));
+    if (!NIL_P(val)) {
+        opts->check_circular = RTEST(val);
+    }
+
+    /* Extract time_precision option */
+    val = rb_hash_aref(opts_hash, ID2SYM(id_time_precision));
+    if (!NIL_P(val)) {
+        opts->time_precision = time_precision_value(val);
+    }
+
+    /* Extract buffer_size option (streaming only) */
+    val = rb_hash_aref(opts_hash, ID2SYM(id_buffer_size));
+    if (!NIL_P(val)) {
+        long size = NUM2LONG(val);
+        if (size < WRITER_STREAM_MIN) {
+            rb_raise(rb_eArgError, "buffer_size must be at least %d (got %ld)", WRITER_STREAM_MIN, size);
+        }
+        opts->buffer_size = (size_t)size;
+    }
+
+    /* Extract canonical option: fixes the formatting options above */
+    val = rb_hash_aref(opts_hash, ID2SYM(id_canonical));
+    if (RTEST(val)) {
+        opts->canonical = true;
+        opts->pretty = false;
+        opts->escape_slash = false;
+        opts->escape_html = false;
+        opts->allow_nan = false;  /* RFC 8785 has no NaN or Infinity */
+    }
 }
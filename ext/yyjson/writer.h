@@ -17,6 +17,48 @@
  */
 VALUE yyjson_ruby_write_string(VALUE obj, const yyjson_dump_options *opts);
 
+/*
+ * Write a Ruby object into an initialized output buffer
+ *
+ * Finishes the buffer (see json_buf_finish) and applies :escape_html.
+ *
+ * @param obj The Ruby object to serialize
+ * @param buf Output buffer (String-backed or scratch)
+ * @param opts Dump options
+ * @return Ruby string containing JSON
+ */
+VALUE yyjson_ruby_write_buf(VALUE obj, json_buf_t *buf, const yyjson_dump_options *opts);
+
+/*
+ * Write a Ruby object as JSON to an IO (#write), opts->buffer_size bytes
+ * at a time
+ *
+ * @param obj The Ruby object to serialize
+ * @param io Object responding to #write
+ * @param opts Dump options
+ * @return io
+ */
+VALUE yyjson_ruby_write_io(VALUE obj, VALUE io, const yyjson_dump_options *opts);
+
+/*
+ * Write a Ruby object as JSON, yielding String chunks of about
+ * opts->buffer_size bytes to the block
+ *
+ * @param obj The Ruby object to serialize
+ * @param opts Dump options
+ * @return Qnil
+ */
+VALUE yyjson_ruby_write_chunks(VALUE obj, const yyjson_dump_options *opts);
+
+/*
+ * SHA-256 of a Ruby object's JSON, hashed as it streams (dump digest:)
+ *
+ * @param obj The Ruby object to serialize
+ * @param opts Dump options
+ * @return The lowercase hex digest
+ */
+VALUE yyjson_ruby_write_sha256(VALUE obj, const yyjson_dump_options *opts);
+
 /*
  * Write a Ruby object to a JSON file
  *
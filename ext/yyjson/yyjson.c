@@ -3,6 +3,160 @@
  *
  * This file simply includes the yyjson library source from the vendor directory.
  * This allows mkmf to properly compile it as part of the extension.
+ *
+ * It also exports a few of yyjson's internal token writers (see emit.h) so the
+ * direct writer produces byte-for-byte the same output as yyjson_mut_write.
  */
 
 #include "vendor/yyjson-0.10.0/src/yyjson.c"
+#include "emit.h"
+
+#if defined(__SSE4_2__)
+#   include <nmmintrin.h>
+#elif defined(__SSE2__)
+#   include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#   include <arm_neon.h>
+#endif
+
+char *
+yyjson_emit_sint(char *cur, int64_t num)
+{
+    u64 pos = (u64)num;
+    u64 neg = ~pos + 1;
+    usize sgn = num < 0;
+    *cur = '-';
+    return (char *)write_u64(sgn ? neg : pos, (u8 *)cur + sgn);
+}
+
+char *
+yyjson_emit_uint(char *cur, uint64_t num)
+{
+    return (char *)write_u64(num, (u8 *)cur);
+}
+
+char *
+yyjson_emit_f64(char *cur, double num, yyjson_write_flag flg)
+{
+    u64 raw;
+    memcpy(&raw, &num, sizeof(raw));
+    return (char *)write_f64_raw((u8 *)cur, raw, flg);
+}
+
+static_inline bool
+is_html_char(u8 c)
+{
+    return c == '<' || c == '>' || c == '&' || c == '\'';
+}
+
+/*
+ * Offset of the first '<', '>', '&' or '\'' in s, or len if there is none
+ */
+static_inline usize
+html_scan(const u8 *s, usize len)
+{
+    usize i = 0;
+
+#if defined(__SSE4_2__)
+    /* Byte ranges '&'-'\'', '<'-'<', '>'-'>' */
+    const __m128i ranges = _mm_setr_epi8('&', '\'', '<', '<', '>', '>',
+                                         0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        int idx = _mm_cmpestri(ranges, 6, v, 16,
+                               _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+        if (idx < 16) return i + (usize)idx;
+    }
+#elif defined(__SSE2__)
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i apos = _mm_set1_epi8('\'');
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, gt)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, apos)));
+        int mask = _mm_movemask_epi8(m);
+        if (mask) return i + (usize)__builtin_ctz((unsigned)mask);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8(s + i);
+        uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('<')), vceqq_u8(v, vdupq_n_u8('>'))),
+                                vorrq_u8(vceqq_u8(v, vdupq_n_u8('&')), vceqq_u8(v, vdupq_n_u8('\''))));
+        if (vmaxvq_u8(m)) break;  /* located by the scalar loop below */
+    }
+#endif
+
+    for (; i < len; i++) {
+        if (is_html_char(s[i])) return i;
+    }
+    return len;
+}
+
+/*
+ * Rewrite '<', '>', '&' and '\'' as \u003c, \u003e, \u0026 and \u0027
+ * in a string just written by write_string, in place
+ *
+ * Each input byte is written as at most 6 bytes and these are written as 1,
+ * so the expansion stays within the YYJSON_EMIT_STR_MAX the caller reserved.
+ * Escapes written by yyjson are hex digits and never match.
+ *
+ * @param start First byte after the opening quote
+ * @param end Cursor after the closing quote
+ * @return New cursor after the closing quote
+ */
+static u8 *
+escape_html(u8 *start, u8 *end)
+{
+    usize len = (usize)(end - start);
+    usize first = html_scan(start, len);
+    if (likely(first == len)) return end;
+
+    usize count = 0;
+    for (u8 *p = start + first; p < end; p++) count += is_html_char(*p);
+
+    /* Expand back to front */
+    u8 *src = end;
+    u8 *dst = end + count * 5;
+    u8 *stop = start + first;
+    while (src > stop) {
+        u8 c = *--src;
+        if (is_html_char(c)) {
+            dst -= 6;
+            memcpy(dst, "\\u00", 4);
+            dst[4] = (u8)"0123456789abcdef"[c >> 4];
+            dst[5] = (u8)"0123456789abcdef"[c & 0xF];
+        } else {
+            *--dst = c;
+        }
+    }
+    return end + count * 5;
+}
+
+char *
+yyjson_emit_str(char *cur, const char *str, size_t len, yyjson_write_flag flg)
+{
+    const char_enc_type *enc_table = get_enc_table_with_flag(flg);
+    bool esc = has_write_flag(ESCAPE_UNICODE) != 0;
+    bool inv = has_write_flag(ALLOW_INVALID_UNICODE) != 0;
+    u8 *start = (u8 *)cur;
+    u8 *end = write_string(start, esc, inv, (const u8 *)str, len, enc_table);
+
+    if (end && (flg & YYJSON_EMIT_ESCAPE_HTML)) {
+        end = escape_html(start + 1, end);
+    }
+    return (char *)end;
+}
+
+char *
+yyjson_emit_str_part(char *cur, const char *str, size_t len, yyjson_write_flag flg)
+{
+    /* write_string() quotes its output: let the opening quote land on the
+     * byte before cur, then put that byte back and drop the closing quote */
+    u8 *start = (u8 *)cur - 1;
+    u8 saved = *start;
+    char *end = yyjson_emit_str((char *)start, str, len, flg);
+    *start = saved;
+    return end ? end - 1 : NULL;
+}
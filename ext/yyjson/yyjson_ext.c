@@ -8,10 +8,26 @@
 #include "parser.h"
 #include "object_dumper.h"
 #include "writer.h"
+#include "parser_class.h"
+#include "generator_class.h"
+#include "lines.h"
+#include "feed.h"
+#include "lazy.h"
+#include "pointer.h"
+#include "dispatch.h"
+#include "class_registry.h"
+#include "table.h"
+#include "parallel.h"
+#include "stats.h"
+#include "fragment.h"
+#include "schema.h"
+#include "msgpack.h"
+#include "patch.h"
 
 /* Module and class definitions */
 VALUE mYYJson = Qnil;
 VALUE cParser = Qnil;
+VALUE cGenerator = Qnil;
 VALUE eYYJsonError = Qnil;
 VALUE eParseError = Qnil;
 VALUE eGenerateError = Qnil;
@@ -31,6 +47,24 @@ ID id_max_nesting;
 ID id_allow_nan;
 ID id_allow_comments;
 ID id_create_additions;
+ID id_gvl_release_threshold;
+ID id_key_cache;
+ID id_key_cache_capacity;
+ID id_pretty;
+ID id_indent;
+ID id_escape_slash;
+ID id_escape_html;
+ID id_mmap;
+ID id_batch_size;
+ID id_unwrap_array;
+ID id_max_buffer_size;
+ID id_check_circular;
+ID id_time_precision;
+ID id_as;
+ID id_buffer_size;
+ID id_dedup_values;
+ID id_canonical;
+ID id_digest;
 
 /* Default parse options (initialized once) */
 static yyjson_parse_options default_parse_opts = {
@@ -39,7 +73,12 @@ static yyjson_parse_options default_parse_opts = {
     .allow_nan = true,
     .allow_comments = true,
     .max_nesting = 100,
-    .mode = MODE_COMPAT
+    .mode = MODE_COMPAT,
+    .gvl_release_threshold = 0,
+    .key_cache = NULL,
+    .mmap = false,
+    .shareable = false,
+    .dedup_values = false
 };
 
 /*
@@ -54,6 +93,12 @@ static yyjson_parse_options default_parse_opts = {
  *   :max_nesting - Maximum nesting depth (default: 100)
  *   :allow_nan - Allow NaN and Infinity (default: true)
  *   :allow_comments - Allow C-style comments (default: true)
+ *   :gvl_release_threshold - Read inputs of at least this many bytes without
+ *                            holding the GVL (default: YYJson.gvl_release_threshold)
+ *   :key_cache - Intern object keys in the process-wide key cache
+ *                (default: YYJson.key_cache)
+ *   :dedup_values - Share one frozen String among equal string values of
+ *                   up to 32 bytes (default: false; on with :freeze)
  *
  * Returns the parsed Ruby object.
  */
@@ -77,7 +122,7 @@ yyjson_load(int argc, VALUE *argv, VALUE self)
 }
 
 /*
- * YYJson.dump(obj, opts = {})
+ * YYJson.dump(obj, io = nil, opts = {})
  *
  * Generate JSON from a Ruby object.
  *
@@ -86,14 +131,27 @@ yyjson_load(int argc, VALUE *argv, VALUE self)
  *   :indent - Indentation string or number of spaces (default: nil for compact)
  *   :pretty - Pretty print (default: false)
  *   :escape_slash - Escape forward slashes (default: false)
+ *   :buffer_size - With io or digest: bytes buffered per write (default: 64 KiB)
+ *   :canonical - RFC 8785 output: keys sorted, ECMAScript number forms,
+ *                compact, no NaN / Infinity or duplicate keys (default: false)
+ *   :digest - :sha256 to return the SHA-256 hex digest of the JSON instead,
+ *             hashed as it is written so the JSON String is never built
  *
- * Returns a JSON string.
+ * Returns a JSON string. Given an io (anything responding to #write), the
+ * JSON is written to it in pieces of :buffer_size bytes instead, without
+ * building the whole document in memory, and io is returned.
  */
 static VALUE
 yyjson_dump(int argc, VALUE *argv, VALUE self)
 {
-    VALUE obj, opts;
-    rb_scan_args(argc, argv, "11", &obj, &opts);
+    VALUE obj, io, opts;
+    rb_scan_args(argc, argv, "12", &obj, &io, &opts);
+
+    /* dump(obj, opts) */
+    if (argc == 2 && (NIL_P(io) || RB_TYPE_P(io, T_HASH))) {
+        opts = io;
+        io = Qnil;
+    }
 
     if (NIL_P(opts)) {
         opts = rb_hash_new();
@@ -103,10 +161,45 @@ yyjson_dump(int argc, VALUE *argv, VALUE self)
     yyjson_dump_options dump_opts;
     yyjson_extract_dump_options(opts, &dump_opts);
 
+    VALUE digest = rb_hash_aref(opts, ID2SYM(id_digest));
+    if (!NIL_P(digest)) {
+        if (digest != ID2SYM(rb_intern("sha256"))) {
+            rb_raise(rb_eArgError, "unsupported digest: %+"PRIsVALUE" (only :sha256)", digest);
+        }
+        if (!NIL_P(io)) rb_raise(rb_eArgError, "digest: can't be combined with an io");
+        return yyjson_ruby_write_sha256(obj, &dump_opts);
+    }
+
+    if (!NIL_P(io)) {
+        return yyjson_ruby_write_io(obj, io, &dump_opts);
+    }
+
     /* Generate JSON string */
     return yyjson_ruby_write_string(obj, &dump_opts);
 }
 
+/*
+ * YYJson.dump_chunks(obj, opts = {}) { |chunk| ... }
+ *
+ * Generate JSON, yielding it as UTF-8 Strings of about :buffer_size bytes
+ * (default: 64 KiB) as they fill. Accepts the YYJson.dump options.
+ *
+ * Returns nil, or an Enumerator without a block.
+ */
+static VALUE
+yyjson_dump_chunks(int argc, VALUE *argv, VALUE self)
+{
+    RETURN_ENUMERATOR(self, argc, argv);
+
+    VALUE obj, opts;
+    rb_scan_args(argc, argv, "11", &obj, &opts);
+
+    yyjson_dump_options dump_opts;
+    yyjson_extract_dump_options(opts, &dump_opts);
+
+    return yyjson_ruby_write_chunks(obj, &dump_opts);
+}
+
 /*
  * YYJson.parse(source, opts = {})
  *
@@ -132,7 +225,11 @@ yyjson_generate(int argc, VALUE *argv, VALUE self)
 /*
  * YYJson.load_file(path, opts = {})
  *
- * Parse JSON from a file.
+ * Parse JSON from a file. Accepts the YYJson.load options plus:
+ *
+ *   :mmap - Map the file and parse it in place instead of reading it into
+ *           a buffer first (default: false; falls back to reading when the
+ *           platform or file doesn't support mapping)
  */
 static VALUE
 yyjson_load_file(int argc, VALUE *argv, VALUE self)
@@ -157,7 +254,8 @@ yyjson_load_file(int argc, VALUE *argv, VALUE self)
 /*
  * YYJson.dump_file(obj, path, opts = {})
  *
- * Generate JSON and write to a file.
+ * Generate JSON and write to a file, :buffer_size bytes at a time
+ * (default: 64 KiB).
  */
 static VALUE
 yyjson_dump_file(int argc, VALUE *argv, VALUE self)
@@ -179,6 +277,101 @@ yyjson_dump_file(int argc, VALUE *argv, VALUE self)
     return yyjson_ruby_write_file(obj, path, &dump_opts);
 }
 
+/*
+ * YYJson.gvl_release_threshold
+ *
+ * Returns the default :gvl_release_threshold in bytes (0 = never release).
+ */
+static VALUE
+yyjson_get_gvl_release_threshold(VALUE self)
+{
+    return SIZET2NUM(yyjson_gvl_release_threshold);
+}
+
+/*
+ * YYJson.gvl_release_threshold = bytes
+ *
+ * Set the default :gvl_release_threshold. Strings of at least this size are
+ * parsed by yyjson without holding the GVL, so other threads keep running
+ * while a large payload is read. Pass nil or 0 to disable.
+ */
+static VALUE
+yyjson_set_gvl_release_threshold(VALUE self, VALUE bytes)
+{
+    size_t threshold = NIL_P(bytes) ? 0 : NUM2SIZET(bytes);
+    yyjson_gvl_release_threshold = threshold;
+    default_parse_opts.gvl_release_threshold = threshold;
+    return bytes;
+}
+
+/*
+ * YYJson.key_cache
+ *
+ * Returns true if parses use the process-wide key cache by default.
+ */
+static VALUE
+yyjson_get_key_cache(VALUE self)
+{
+    return yyjson_key_cache_default ? Qtrue : Qfalse;
+}
+
+/*
+ * YYJson.key_cache = enabled
+ *
+ * Enable or disable the process-wide key cache for parses that don't pass
+ * :key_cache. Cached keys are reused across calls, so documents sharing the
+ * same keys skip re-interning them.
+ */
+static VALUE
+yyjson_set_key_cache(VALUE self, VALUE enabled)
+{
+    yyjson_key_cache_default = RTEST(enabled);
+    default_parse_opts.key_cache = yyjson_key_cache_default ? &yyjson_global_key_cache : NULL;
+    return enabled;
+}
+
+/*
+ * YYJson.key_cache_capacity = entries
+ *
+ * Resize the process-wide key cache (rounded up to a whole number of sets).
+ * Resizing drops all cached keys and resets the counters.
+ */
+static VALUE
+yyjson_set_key_cache_capacity(VALUE self, VALUE entries)
+{
+    size_t capacity = NUM2SIZET(entries);
+    if (capacity == 0) {
+        rb_raise(rb_eArgError, "key cache capacity must be positive");
+    }
+    yyjson_key_cache_free(&yyjson_global_key_cache);
+    yyjson_key_cache_init(&yyjson_global_key_cache, capacity);
+    return entries;
+}
+
+/*
+ * YYJson.key_cache_stats
+ *
+ * Returns a Hash with :hits, :misses, :evictions, :size and :capacity for the
+ * process-wide key cache.
+ */
+static VALUE
+yyjson_key_cache_stats_m(VALUE self)
+{
+    return yyjson_key_cache_stats(&yyjson_global_key_cache);
+}
+
+/*
+ * YYJson.clear_key_cache
+ *
+ * Drop all cached keys and reset the counters.
+ */
+static VALUE
+yyjson_clear_key_cache(VALUE self)
+{
+    yyjson_key_cache_clear(&yyjson_global_key_cache);
+    return Qnil;
+}
+
 /*
  * Initialize the YYJson extension.
  */
@@ -200,6 +393,14 @@ Init_yyjson(void)
     rb_define_singleton_method(mYYJson, "generate", yyjson_generate, -1);
     rb_define_singleton_method(mYYJson, "load_file", yyjson_load_file, -1);
     rb_define_singleton_method(mYYJson, "dump_file", yyjson_dump_file, -1);
+    rb_define_singleton_method(mYYJson, "dump_chunks", yyjson_dump_chunks, -1);
+    rb_define_singleton_method(mYYJson, "gvl_release_threshold", yyjson_get_gvl_release_threshold, 0);
+    rb_define_singleton_method(mYYJson, "gvl_release_threshold=", yyjson_set_gvl_release_threshold, 1);
+    rb_define_singleton_method(mYYJson, "key_cache", yyjson_get_key_cache, 0);
+    rb_define_singleton_method(mYYJson, "key_cache=", yyjson_set_key_cache, 1);
+    rb_define_singleton_method(mYYJson, "key_cache_capacity=", yyjson_set_key_cache_capacity, 1);
+    rb_define_singleton_method(mYYJson, "key_cache_stats", yyjson_key_cache_stats_m, 0);
+    rb_define_singleton_method(mYYJson, "clear_key_cache", yyjson_clear_key_cache, 0);
 
     /* Initialize symbol IDs for common operations */
     id_to_json = rb_intern("to_json");
@@ -218,10 +419,45 @@ Init_yyjson(void)
     id_allow_nan = rb_intern("allow_nan");
     id_allow_comments = rb_intern("allow_comments");
     id_create_additions = rb_intern("create_additions");
+    id_gvl_release_threshold = rb_intern("gvl_release_threshold");
+    id_key_cache = rb_intern("key_cache");
+    id_key_cache_capacity = rb_intern("key_cache_capacity");
+    id_pretty = rb_intern("pretty");
+    id_indent = rb_intern("indent");
+    id_escape_slash = rb_intern("escape_slash");
+    id_escape_html = rb_intern("escape_html");
+    id_mmap = rb_intern("mmap");
+    id_batch_size = rb_intern("batch_size");
+    id_unwrap_array = rb_intern("unwrap_array");
+    id_max_buffer_size = rb_intern("max_buffer_size");
+    id_check_circular = rb_intern("check_circular");
+    id_time_precision = rb_intern("time_precision");
+    id_as = rb_intern("as");
+    id_buffer_size = rb_intern("buffer_size");
+    id_dedup_values = rb_intern("dedup_values");
+    id_canonical = rb_intern("canonical");
+    id_digest = rb_intern("digest");
 
-    /* Initialize value builder */
+    /* Initialize value builder and the process-wide key cache */
     yyjson_value_builder_init();
+    yyjson_key_cache_init_global();
+
+    /* Initialize Parser and Generator classes */
+    yyjson_parser_class_init();
+    yyjson_generator_class_init();
 
-    /* TODO: Initialize Parser class */
-    /* cParser = rb_define_class_under(mYYJson, "Parser", rb_cObject); */
+    /* NDJSON reader (YYJson.each_line/load_lines, Parser#each_line/load_lines) */
+    yyjson_lines_init();
+    yyjson_feed_init();
+    yyjson_lazy_init();
+    yyjson_pointer_init();
+    yyjson_dispatch_init();
+    yyjson_class_registry_init();
+    yyjson_table_init();
+    yyjson_parallel_init();
+    yyjson_stats_init();
+    yyjson_fragment_init();
+    yyjson_schema_init();
+    yyjson_msgpack_init();
+    yyjson_patch_init();
 }
@@ -33,4 +33,8 @@ module YYJson
   class Error < StandardError; end
   class ParseError < Error; end
   class GenerateError < Error; end
+  class PatchError < Error; end
 end
+
+require_relative 'yyjson/parallel'
+require_relative 'yyjson/stream_body'
@@ -44,14 +44,11 @@ module JSON
     end
 
     def dump(obj, anIO = nil, limit = nil, opts = {})
-      # Handle the various argument patterns
-      json = YYJson.dump(obj, opts)
-      if anIO
-        anIO.write(json)
-        anIO
-      else
-        json
-      end
+      # JSON.dump(obj, limit): no IO given
+      anIO = nil if anIO && !anIO.respond_to?(:write)
+
+      # Streams to the IO instead of building the whole string first
+      anIO ? YYJson.dump(obj, anIO, opts) : YYJson.dump(obj, opts)
     end
 
     def pretty_generate(obj, opts = {})
@@ -0,0 +1,59 @@
+# frozen_string_literal: true
+
+require 'etc'
+
+module YYJson
+  class << self
+    # Parse JSON, building the elements of a large top-level array in
+    # parallel Ractors.
+    #
+    # The document is parsed once; its root array is split into up to
+    # +threads+ shards (at least 4096 elements each), every shard but the
+    # first is built by its own Ractor and the first by the caller. The
+    # result is deep-frozen and Ractor-shareable (as with <tt>freeze:
+    # true</tt>). Smaller arrays and other documents are built in the
+    # calling Ractor.
+    #
+    # Accepts the YYJson.load options plus:
+    #   :threads - Number of shards (default: Etc.nprocessors)
+    #
+    # The process-wide key cache (:key_cache) is not used.
+    def load_parallel(source, opts = nil)
+      opts = opts ? opts.dup : {}
+      threads = opts.delete(:threads) || Etc.nprocessors
+      doc = ShardedDocument.new(source, threads, opts)
+      return doc.value if doc.shards.zero?
+
+      # Errors come back as values: a worker whose result is never taken
+      # (the caller raised first) must not report an exception
+      workers = without_ractor_warning do
+        (1...doc.shards).map do |i|
+          Ractor.new(doc, i) do |d, n|
+            d.shard(n)
+          rescue StandardError => e
+            e
+          end
+        end
+      end
+
+      result = doc.shard(0).dup
+      workers.each do |worker|
+        part = worker.take
+        raise part if part.is_a?(Exception)
+
+        result.concat(part)
+      end
+      Ractor.make_shareable(result)
+    end
+
+    private
+
+    def without_ractor_warning
+      experimental = Warning[:experimental]
+      Warning[:experimental] = false
+      yield
+    ensure
+      Warning[:experimental] = experimental
+    end
+  end
+end
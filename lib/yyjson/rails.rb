@@ -25,12 +25,54 @@ module YYJson
       end
     end
 
+    # ActiveSupport::Notifications events for every YYJson.load / YYJson.dump
+    # (enable with YYJson::Rails.instrument!):
+    #
+    #   'load.yyjson' - payload :bytes (size of the source)
+    #   'dump.yyjson' - payload :bytes (size of the output, once dumped)
+    #
+    #   ActiveSupport::Notifications.subscribe('dump.yyjson') do |event|
+    #     Rails.logger.debug "JSON dump: #{event.payload[:bytes]} bytes in #{event.duration}ms"
+    #   end
+    module Instrumentation
+      def load(source, *args)
+        notifier = YYJson::Rails.notifier
+        return super unless notifier
+
+        bytes = source.bytesize if source.is_a?(String)
+        notifier.instrument('load.yyjson', bytes: bytes) { super }
+      end
+
+      def dump(obj, *args)
+        notifier = YYJson::Rails.notifier
+        return super unless notifier
+
+        notifier.instrument('dump.yyjson') do |payload|
+          json = super
+          payload[:bytes] = json.bytesize if json.is_a?(String)
+          json
+        end
+      end
+    end
+
     # Rails configuration accessor
     class << self
       attr_accessor :time_precision
       attr_accessor :use_standard_json_time_format
       attr_accessor :escape_html_entities_in_json
 
+      # Where Instrumentation events go (nil: not instrumented)
+      attr_accessor :notifier
+
+      # Publish 'load.yyjson' / 'dump.yyjson' events to notifier (see
+      # Instrumentation). YYJson.stats_enabled = true additionally counts
+      # where the time goes inside each call.
+      def instrument!(notifier = ::ActiveSupport::Notifications)
+        @notifier = notifier
+        YYJson.singleton_class.prepend(Instrumentation) unless YYJson.singleton_class.include?(Instrumentation)
+        true
+      end
+
       def reset_config!
         @time_precision = nil
         @use_standard_json_time_format = true
@@ -74,6 +116,9 @@ module YYJson
       setup_multi_json
     end
 
+    # ActiveSupport defines as_json on Object: re-resolve classes dumped so far
+    clear_dispatch_cache
+
     true
   end
 
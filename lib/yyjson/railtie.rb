@@ -20,6 +20,9 @@ module YYJson
     config.yyjson.mode = :rails
     config.yyjson.auto_optimize = true
     config.yyjson.symbolize_names = nil  # Let mode decide
+    config.yyjson.instrument = false     # 'load.yyjson' / 'dump.yyjson' notifications
+    config.yyjson.stats = false          # YYJson.stats counters
+    config.yyjson.validate_fragments = nil # YYJson::Fragment checks (nil: outside production)
 
     # Initialize YYJson after Rails initialization
     initializer 'yyjson.configure', after: :load_config_initializers do |app|
@@ -32,6 +35,10 @@ module YYJson
         options[:symbolize_names] = app.config.yyjson.symbolize_names if app.config.yyjson.symbolize_names
 
         YYJson.optimize_rails(options)
+        YYJson::Rails.instrument! if app.config.yyjson.instrument
+        YYJson.stats_enabled = true if app.config.yyjson.stats
+        validate = app.config.yyjson.validate_fragments
+        YYJson::Fragment.validate = validate.nil? ? !::Rails.env.production? : validate
 
         # Log activation
         if ::Rails.logger
@@ -40,6 +47,11 @@ module YYJson
       end
     end
 
+    # Reloaded classes are new objects; drop strategies cached for the old ones
+    config.to_prepare do
+      YYJson.clear_dispatch_cache
+    end
+
     # Add generator for initializer
     generators do
       require 'generators/yyjson/install_generator'
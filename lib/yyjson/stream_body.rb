@@ -0,0 +1,22 @@
+# frozen_string_literal: true
+
+module YYJson
+  # A Rack response body that generates JSON while the server writes it,
+  # in chunks of :buffer_size bytes (see YYJson.dump_chunks):
+  #
+  #   [200, { 'content-type' => 'application/json' }, YYJson::StreamBody.new(records)]
+  #
+  # The object is serialized again on every #each.
+  class StreamBody
+    def initialize(obj, opts = nil)
+      @obj = obj
+      @opts = opts
+    end
+
+    def each(&block)
+      return enum_for(:each) unless block
+
+      YYJson.dump_chunks(@obj, @opts, &block)
+    end
+  end
+end
@@ -63,6 +63,15 @@ class TestBasicParsing < Minitest::Test
     assert_equal({name: "John", age: 30}, result)
   end
 
+  def test_symbolize_names_non_ascii_keys
+    json = '{"café": 1, "\u6771\u4eac": {"ключ": 2}}'
+    [{}, { freeze: true }, { key_cache: true }].each do |opts|
+      result = YYJson.load(json, symbolize_names: true, **opts)
+      assert_equal({ "café": 1, "東京": { "ключ": 2 } }, result)
+      assert_equal Encoding::UTF_8, result.keys.first.encoding
+    end
+  end
+
   def test_freeze_option
     result = YYJson.load('{"name": "John"}', freeze: true)
     assert(result.frozen?, "Result should be frozen")
@@ -0,0 +1,140 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+require 'digest'
+require 'bigdecimal'
+
+class TestCanonical < Minitest::Test
+  def canonical(obj, opts = {})
+    YYJson.dump(obj, opts.merge(canonical: true))
+  end
+
+  # RFC 8785, section 3.2.2
+  def test_rfc_example
+    input = <<~'JSON'
+      {
+        "numbers": [333333333.33333329, 1E30, 4.50, 2e-3, 0.000000000000000000000000001],
+        "string": "\u20ac$\u000F\u000aA'\u0042\u0022\u005c\\\"\/",
+        "literals": [null, true, false]
+      }
+    JSON
+    assert_equal '{"literals":[null,true,false],"numbers":[333333333.3333333,1e+30,4.5,0.002,1e-27],' \
+                 '"string":"€$\u000f\nA\'B\"\\\\\\\\\"/"}',
+                 canonical(YYJson.load(input))
+  end
+
+  # RFC 8785, section 3.2.3: UTF-16 code unit order, not code point order
+  def test_keys_sort_by_utf16_code_units
+    obj = { "€" => 1, "\r" => 2, "דּ" => 3, "1" => 4, "\u{1F600}" => 5, "\u0080" => 6, "ö" => 7 }
+    assert_equal ["\r", "1", "\u0080", "ö", "€", "\u{1F600}", "דּ"], YYJson.load(canonical(obj)).keys
+  end
+
+  def test_numbers_use_ecmascript_forms
+    {
+      1.0 => "1", -0.0 => "0", 100.0 => "100", 1e20 => "100000000000000000000", 1e21 => "1e+21",
+      1.5e300 => "1.5e+300", 0.000001 => "0.000001", 1e-7 => "1e-7", 1.2345e-7 => "1.2345e-7",
+      123.456 => "123.456", 5e-324 => "5e-324", 2.0**53 => "9007199254740992", -2.5 => "-2.5"
+    }.each do |value, expected|
+      assert_equal expected, canonical(value), value.inspect
+    end
+
+    # Integers keep their digits; BigDecimal keeps its digits in the Float layout
+    assert_equal "[12,-3,123456789012345678901234567890]", canonical([12, -3, 123_456_789_012_345_678_901_234_567_890])
+    assert_equal "[1.5,0,1.25e-9,100]", canonical([BigDecimal("0.15e1"), BigDecimal("-0"), BigDecimal("12.5e-10"), BigDecimal("1e2")])
+
+    assert_raises(YYJson::GenerateError) { canonical([Float::NAN]) }
+    assert_raises(YYJson::GenerateError) { canonical([BigDecimal("Infinity")]) }
+  end
+
+  def test_overrides_formatting_options
+    obj = { "b" => "</a>", :a => [1, { "y" => 2, "x" => 1 }] }
+    expected = '{"a":[1,{"x":1,"y":2}],"b":"</a>"}'
+    assert_equal expected, canonical(obj)
+    assert_equal expected, canonical(obj, pretty: true, escape_slash: true, mode: :rails)
+    assert_equal expected, YYJson::Generator.new(canonical: true).generate(obj)
+    assert_equal '{"b":"</a>","a":[1,{"y":2,"x":1}]}', YYJson.dump(obj)
+  end
+
+  def test_keys_are_compared_as_written
+    assert_equal '{"1":"int","10":"a","2":"b","a":"sym"}', canonical({ 10 => "a", :a => "sym", "2" => "b", 1 => "int" })
+    # Keys equal once converted would be written twice
+    error = assert_raises(YYJson::GenerateError) { canonical({ :a => 1, "a" => 2 }) }
+    assert_match(/duplicate key "a"/, error.message)
+    assert_raises(YYJson::GenerateError) { canonical({ "b" => 0, 1 => 2, "1" => 1 }) }
+    assert_raises(YYJson::GenerateError) { YYJson.dump_msgpack({ :a => 1, "a" => 2 }, canonical: true) }
+    assert_equal '{"a":1,"b":2}', canonical({ :a => 1, "b" => 2 })
+  end
+
+  def test_fragments_are_rewritten
+    fragment = YYJson::Fragment.new('{"z":1,"y":2.50,"s":"\\u001F","n":[1E30,-0.0,123456789012345678901234567890]}')
+    expected = '{"a":{"n":[1e+30,0,123456789012345678901234567890],"s":"\\u001f","y":2.5,"z":1},"b":1}'
+    assert_equal expected, canonical({ "b" => 1, "a" => fragment })
+    assert_equal Digest::SHA256.hexdigest(expected),
+                 YYJson.dump({ "b" => 1, "a" => fragment }, canonical: true, digest: :sha256)
+    assert_equal '{"a":1}', YYJson.dump(YYJson::Fragment.new('{"a":1}'), pretty: true, canonical: true)
+
+    assert_raises(YYJson::GenerateError) { canonical(YYJson::Fragment.new('{"a":1,"a":2}')) }
+    assert_raises(YYJson::GenerateError) { canonical(YYJson::Fragment.new('[1e400]')) }
+    assert_raises(YYJson::GenerateError) { canonical([YYJson::Fragment.new('{"a":')]) }
+  end
+
+  def test_repeated_shapes_and_custom_objects
+    klass = Struct.new(:zeta, :alpha)
+    YYJson.register_class(klass, attrs: { "zeta" => :zeta, "alpha" => :alpha })
+    rows = Array.new(50) { |i| { "name" => "n#{i}", "id" => i, "meta" => { "z" => klass.new(i, nil), "a" => 1 } } }
+    rows << { "id" => 1, "name" => "other order" } << { "x" => 1 }
+
+    expected = YYJson.dump(deep_sort(YYJson.load(YYJson.dump(rows))))
+    YYJson.stats_enabled = true
+    YYJson.reset_stats
+    assert_equal expected, canonical(rows)
+    assert_operator YYJson.stats[:sort_cache_hits], :>=, 90
+  ensure
+    YYJson.stats_enabled = false
+    YYJson.unregister_class(klass)
+  end
+
+  def test_memoized_json_depends_on_canonical
+    klass = Struct.new(:id, :b, :a) do
+      def as_json(*) = { "b" => b, "a" => a }
+    end
+    YYJson.memoize(klass, &:id)
+    obj = klass.new(1, 2, 3)
+    assert_equal '[{"b":2,"a":3}]', YYJson.dump([obj])
+    assert_equal '[{"a":3,"b":2}]', canonical([obj])
+    assert_equal '[{"b":2,"a":3}]', YYJson.dump([obj])
+  ensure
+    YYJson.unmemoize(klass)
+  end
+
+  def test_digest_streams_sha256
+    obj = Array.new(20_000) { |i| { "v" => i * 0.5, "k" => "key #{i}" } }
+    [{}, { canonical: true }, { buffer_size: 64 }].each do |opts|
+      assert_equal Digest::SHA256.hexdigest(YYJson.dump(obj, opts)), YYJson.dump(obj, opts.merge(digest: :sha256)), opts.inspect
+    end
+    assert_equal Digest::SHA256.hexdigest("null"), YYJson.dump(nil, digest: :sha256)
+    assert_equal Digest::SHA256.hexdigest('{"a":1,"b":2}'), YYJson.dump({ b: 2, a: 1 }, canonical: true, digest: :sha256)
+
+    allocations = 2.times.map do
+      before = GC.stat(:total_allocated_objects)
+      YYJson.dump(obj, canonical: true, digest: :sha256)
+      GC.stat(:total_allocated_objects) - before
+    end
+    assert_operator allocations.last, :<, 10
+
+    assert_raises(ArgumentError) { YYJson.dump(1, digest: :md5) }
+    assert_raises(ArgumentError) { YYJson.dump(1, StringIO.new, digest: :sha256) }
+  end
+
+  private
+
+  def deep_sort(obj)
+    case obj
+    when Hash then obj.sort.to_h { |k, v| [k, deep_sort(v)] }
+    when Array then obj.map { |v| deep_sort(v) }
+    else obj
+    end
+  end
+end
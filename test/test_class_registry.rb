@@ -0,0 +1,100 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+
+class TestClassRegistry < Minitest::Test
+  class User
+    attr_reader :id, :name
+
+    def initialize(id, name, tags = [])
+      @id = id
+      @name = name
+      @tags = tags
+    end
+
+    def display_name = name.upcase
+    def as_json(*) = { "as_json" => true }
+  end
+
+  class Admin < User; end
+
+  class Plain
+    def initialize(v) = @v = v
+    def to_s = "plain"
+  end
+
+  def teardown
+    [User, Admin, Plain].each { |k| YYJson.unregister_class(k) }
+  end
+
+  def test_attrs_readers_and_ivars
+    YYJson.register_class(User, attrs: [:id, :name, :@tags])
+    assert_equal '{"id":1,"name":"Ann","tags":["a"]}', YYJson.dump(User.new(1, "Ann", ["a"]))
+  end
+
+  def test_attrs_hash_renames_keys
+    YYJson.register_class(User, attrs: { "userId" => :id, display: :display_name })
+    assert_equal '[{"userId":2,"display":"BOB"}]', YYJson.dump([User.new(2, "Bob")])
+  end
+
+  def test_block_form
+    YYJson.register_class(Plain) { |o| { "v" => o.instance_variable_get(:@v) } }
+    assert_equal '{"v":[1,2]}', YYJson.dump(Plain.new([1, 2]))
+  end
+
+  def test_takes_precedence_over_as_json_and_applies_to_subclasses
+    assert_equal '{"as_json":true}', YYJson.dump(User.new(1, "a"))
+    YYJson.register_class(User, attrs: [:id])
+    assert_equal '[{"id":1},{"id":2}]', YYJson.dump([User.new(1, "a"), Admin.new(2, "b")])
+
+    # Nearest registered ancestor wins
+    YYJson.register_class(Admin, attrs: [:name])
+    assert_equal '{"name":"b"}', YYJson.dump(Admin.new(2, "b"))
+  end
+
+  def test_unregister_restores_default
+    YYJson.register_class(Plain, attrs: [:@v])
+    assert_equal '{"v":1}', YYJson.dump(Plain.new(1))
+    assert YYJson.registered_class?(Plain)
+    assert_equal true, YYJson.unregister_class(Plain)
+    assert_equal false, YYJson.unregister_class(Plain)
+    refute YYJson.registered_class?(Plain)
+    assert_equal '"plain"', YYJson.dump(Plain.new(1))
+  end
+
+  def test_keys_are_escaped
+    YYJson.register_class(User, attrs: { "a\"b" => :id, "x/y" => :name })
+    user = User.new(1, "n")
+    assert_equal '{"a\"b":1,"x/y":"n"}', YYJson.dump(user)
+    assert_equal '{"a\"b":1,"x\/y":"n"}', YYJson.dump(user, escape_slash: true)
+  end
+
+  def test_pretty_matches_hash_output
+    YYJson.register_class(User, attrs: [:id, :name])
+    user = User.new(1, "n")
+    assert_equal YYJson.dump({ "id" => 1, "name" => "n" }, pretty: true), YYJson.dump(user, pretty: true)
+  end
+
+  def test_circular_reference_detected
+    YYJson.register_class(Plain, attrs: [:@v])
+    obj = Plain.new(nil)
+    obj.instance_variable_set(:@v, obj)
+    assert_raises(YYJson::GenerateError) { YYJson.dump(obj) }
+  end
+
+  def test_invalid_arguments
+    assert_raises(ArgumentError) { YYJson.register_class(User) }
+    assert_raises(ArgumentError) { YYJson.register_class(User, attrs: [:id]) { |o| o } }
+    assert_raises(TypeError) { YYJson.register_class(Comparable, attrs: [:id]) }
+    assert_raises(TypeError) { YYJson.register_class(User, attrs: :id) }
+
+    # Keys given twice, directly or once the '@' is dropped
+    error = assert_raises(ArgumentError) { YYJson.register_class(User, attrs: [:name, :id, :name]) }
+    assert_match(/duplicate attribute key "name"/, error.message)
+    assert_raises(ArgumentError) { YYJson.register_class(User, attrs: [:id, :@id]) }
+    assert_raises(ArgumentError) { YYJson.register_class(User, attrs: { "name" => :id, :name => :name }) }
+    refute YYJson.registered_class?(User)
+  end
+end
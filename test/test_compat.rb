@@ -2,6 +2,7 @@
 
 $LOAD_PATH.unshift File.expand_path('../lib', __dir__)
 require 'minitest/autorun'
+require 'stringio'
 require 'yyjson'
 require 'yyjson/mimic'
 
@@ -16,6 +17,12 @@ class TestCompat < Minitest::Test
     assert_equal('{"key":"value"}', result)
   end
 
+  def test_json_generate_embeds_lazy_nodes
+    doc = YYJson.load_lazy('{"meta": {"ok": true}, "tags": ["a"]}')
+    assert_equal '{"m":{"ok":true},"t":["a"]}', JSON.generate({ "m" => doc["meta"], "t" => doc["tags"] })
+    assert_equal '[{"meta":{"ok":true},"tags":["a"]}]', [doc].to_json
+  end
+
   def test_json_load_works_after_mimic
     result = JSON.load('{"key": "value"}')
     assert_equal({"key" => "value"}, result)
@@ -26,6 +33,16 @@ class TestCompat < Minitest::Test
     assert_equal('{"key":"value"}', result)
   end
 
+  def test_json_dump_to_io_after_mimic
+    io = StringIO.new
+    assert_same io, JSON.dump({key: "value"}, io)
+    assert_equal('{"key":"value"}', io.string)
+  end
+
+  def test_json_dump_with_limit_after_mimic
+    assert_equal('{"key":"value"}', JSON.dump({key: "value"}, 10))
+  end
+
   def test_json_pretty_generate_works
     result = JSON.pretty_generate({key: "value", nested: {deep: "data"}})
     assert_match(/\n/, result) # Has newlines
@@ -0,0 +1,77 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'json'
+require 'yyjson'
+
+class TestConcurrency < Minitest::Test
+  def setup
+    @saved_threshold = YYJson.gvl_release_threshold
+  end
+
+  def teardown
+    YYJson.gvl_release_threshold = @saved_threshold
+  end
+
+  def large_json
+    { "items" => (1..2000).map { |i| { "id" => i, "name" => "item_#{i}", "tags" => %w[a b c] } } }.to_json
+  end
+
+  def test_gvl_release_threshold_defaults_to_disabled
+    assert_equal 0, YYJson.gvl_release_threshold
+  end
+
+  def test_gvl_release_threshold_setter
+    YYJson.gvl_release_threshold = 1024
+    assert_equal 1024, YYJson.gvl_release_threshold
+
+    YYJson.gvl_release_threshold = nil
+    assert_equal 0, YYJson.gvl_release_threshold
+  end
+
+  def test_parse_with_per_call_threshold
+    json = large_json
+    result = YYJson.load(json, gvl_release_threshold: 1)
+    assert_equal JSON.parse(json), result
+  end
+
+  def test_parse_with_global_threshold
+    YYJson.gvl_release_threshold = 1
+    json = large_json
+
+    assert_equal JSON.parse(json), YYJson.load(json)
+    assert_equal JSON.parse(json, symbolize_names: true), YYJson.load(json, symbolize_names: true)
+  end
+
+  def test_per_call_threshold_can_disable_global
+    YYJson.gvl_release_threshold = 1
+    assert_equal [1, 2, 3], YYJson.load('[1,2,3]', gvl_release_threshold: false)
+  end
+
+  def test_parse_error_without_gvl
+    error = assert_raises(YYJson::ParseError) do
+      YYJson.load('{"key": [1, 2, ' + ('3, ' * 1000), gvl_release_threshold: 1)
+    end
+    assert_match(/position/, error.message)
+  end
+
+  def test_threaded_parse_while_source_is_mutated
+    json = large_json
+    expected = JSON.parse(json)
+
+    threads = 4.times.map do
+      Thread.new do
+        source = json.dup
+        mutator = Thread.new { 50.times { source << " " } }
+        results = 10.times.map { YYJson.load(source, gvl_release_threshold: 1) }
+        mutator.join
+        results
+      end
+    end
+
+    threads.each do |t|
+      t.value.each { |result| assert_equal expected, result }
+    end
+  end
+end
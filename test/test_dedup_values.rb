@@ -0,0 +1,94 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+require 'tempfile'
+
+class TestDedupValues < Minitest::Test
+  EVENTS = '[{"status":"active","currency":"USD","id":"a1"},' \
+           '{"status":"active","currency":"USD","id":"a2"},' \
+           '{"status":"closed","currency":"USD","id":"a3"}]'
+
+  def test_equal_short_values_are_shared_and_frozen
+    events = YYJson.load(EVENTS, dedup_values: true)
+    assert_equal YYJson.load(EVENTS), events
+
+    assert_same events[0]["status"], events[1]["status"]
+    assert_same events[0]["currency"], events[2]["currency"]
+    refute_same events[0]["id"], events[1]["id"]
+    assert events[0]["status"].frozen?
+    assert_equal Encoding::UTF_8, events[0]["status"].encoding
+
+    # Only the strings: containers stay mutable
+    refute events.frozen?
+    refute events[0].frozen?
+  end
+
+  def test_off_by_default
+    events = YYJson.load(EVENTS)
+    refute_same events[0]["status"], events[1]["status"]
+    refute events[0]["status"].frozen?
+  end
+
+  def test_long_values_are_not_deduplicated
+    long = "x" * 33
+    limit = "y" * 32
+    values = YYJson.load(YYJson.dump([long, long, limit, limit, "", ""]), dedup_values: true)
+    refute_same values[0], values[1]
+    refute values[0].frozen?
+    assert_same values[2], values[3]
+    assert_equal ["", ""], values[4, 2]
+  end
+
+  def test_escaped_and_multibyte_values
+    json = '["café","café","a\"b","a\"b","東京","東京"]'
+    values = YYJson.load(json, dedup_values: true)
+    assert_equal ["café", "café", 'a"b', 'a"b', "東京", "東京"], values
+    assert_same values[0], values[1]
+    assert_same values[2], values[3]
+    assert_same values[4], values[5]
+  end
+
+  def test_freeze_deduplicates_too
+    events = YYJson.load(EVENTS, freeze: true)
+    assert_same events[0]["status"], events[1]["status"]
+    assert events.frozen?
+  end
+
+  def test_many_distinct_values
+    values = Array.new(2000) { |i| "v#{i % 700}" }
+    loaded = YYJson.load(YYJson.dump(values), dedup_values: true)
+    assert_equal values, loaded
+    assert loaded.all?(&:frozen?)
+  end
+
+  def test_parser_load_table_and_files
+    parser = YYJson::Parser.new(dedup_values: true)
+    events = parser.parse(EVENTS)
+    assert_same events[0]["status"], events[1]["status"]
+
+    table = YYJson.load_table(EVENTS, dedup_values: true)
+    assert_same table["currency"][0], table["currency"][2]
+
+    Tempfile.create(['dedup', '.json']) do |f|
+      f.write(YYJson.dump(Array.new(20_000) { |i| { "status" => i.even? ? "on" : "off", "i" => i } }))
+      f.flush
+      loaded = YYJson.load_file(f.path, mmap: true, dedup_values: true)
+      assert_equal 20_000, loaded.size
+      assert_same loaded[0]["status"], loaded[19_998]["status"]
+      assert_equal "off", loaded[19_999]["status"]
+    end
+  end
+
+  def test_stats_count_cache_hits
+    YYJson.reset_stats
+    YYJson.stats_enabled = true
+    YYJson.load(EVENTS, dedup_values: true)
+    stats = YYJson.stats
+    assert_equal 3, stats[:value_cache_hits]
+    assert_equal 6, stats[:value_cache_misses]
+  ensure
+    YYJson.stats_enabled = false
+  end
+end
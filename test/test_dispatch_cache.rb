@@ -0,0 +1,81 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+require 'date'
+require 'time'
+
+class TestDispatchCache < Minitest::Test
+  class Point
+    def initialize(x, y)
+      @x = x
+      @y = y
+    end
+
+    def to_s = "(#{@x}, #{@y})"
+  end
+
+  class Model
+    def initialize(id) = @id = id
+    def as_json(*) = { "id" => @id }
+  end
+
+  class NilModel
+    def as_json(*) = nil
+    def to_s = "nil model"
+  end
+
+  def setup
+    YYJson.clear_dispatch_cache
+  end
+
+  def teardown
+    YYJson.clear_dispatch_cache
+  end
+
+  def test_strategies
+    assert_equal '["(1, 2)"]', YYJson.dump([Point.new(1, 2)])
+    assert_equal '[{"id":1},{"id":2}]', YYJson.dump([Model.new(1), Model.new(2)])
+    assert_equal '["2024-01-02"]', YYJson.dump([Date.new(2024, 1, 2)])
+    assert_equal '["1970-01-01T00:00:00Z"]', YYJson.dump([Time.at(0).utc])
+  end
+
+  def test_as_json_returning_nil_falls_back_to_to_s
+    assert_equal '["nil model"]', YYJson.dump([NilModel.new])
+  end
+
+  def test_repeated_objects_use_the_same_strategy
+    models = Array.new(1_000) { |i| Model.new(i) }
+    assert_equal models.map { |m| m.as_json }, YYJson.load(YYJson.dump(models))
+  end
+
+  def test_subclasses_resolve_separately
+    sub = Class.new(Point) { def as_json(*) = "sub" }
+    assert_equal '["(1, 2)","sub"]', YYJson.dump([Point.new(1, 2), sub.new(3, 4)])
+  end
+
+  def test_singleton_methods_are_honored
+    plain = Point.new(0, 0)
+    special = Point.new(0, 0)
+    def special.as_json(*) = "special"
+    assert_equal '["(0, 0)","special","(0, 0)"]', YYJson.dump([plain, special, plain])
+  end
+
+  def test_clear_after_defining_as_json
+    klass = Class.new { def to_s = "before" }
+    obj = klass.new
+    assert_equal '["before"]', YYJson.dump([obj])
+
+    klass.define_method(:as_json) { |*| "after" }
+    YYJson.clear_dispatch_cache
+    assert_equal '["after"]', YYJson.dump([obj])
+  end
+
+  def test_gc_safety
+    50.times { YYJson.dump([Class.new(Point).new(1, 1)]) }
+    GC.start
+    GC.compact if GC.respond_to?(:compact)
+    assert_equal '["(5, 6)"]', YYJson.dump([Point.new(5, 6)])
+  end
+end
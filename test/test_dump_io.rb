@@ -0,0 +1,133 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'stringio'
+require 'tempfile'
+require 'yyjson'
+
+class TestDumpIO < Minitest::Test
+  # Records whose output spans many small buffers
+  def records(n = 500)
+    Array.new(n) do |i|
+      { id: i, name: "user #{i} ✓", tags: %w[a b c], 'score' => i * 1.5, nested: { ok: i.even? } }
+    end
+  end
+
+  class ChunkIO
+    attr_reader :chunks
+
+    def initialize
+      @chunks = []
+    end
+
+    def write(str)
+      @chunks << str.dup
+      str.bytesize
+    end
+  end
+
+  def test_dump_to_io_matches_dump
+    data = records
+    io = StringIO.new
+    assert_same io, YYJson.dump(data, io)
+    assert_equal YYJson.dump(data), io.string
+  end
+
+  def test_dump_to_io_with_options
+    data = records(50)
+    io = StringIO.new
+    YYJson.dump(data, io, pretty: true, buffer_size: 64)
+    assert_equal YYJson.dump(data, pretty: true), io.string
+  end
+
+  def test_dump_opts_as_second_argument
+    assert_equal %({\n  "a": 1\n}), YYJson.dump({ a: 1 }, pretty: true)
+    assert_equal '[1]', YYJson.dump([1], nil)
+  end
+
+  def test_dump_to_io_writes_bounded_chunks
+    data = records
+    io = ChunkIO.new
+    YYJson.dump(data, io, buffer_size: 1024)
+
+    assert_operator io.chunks.size, :>, 10
+    assert(io.chunks.all? { |c| c.bytesize <= 1024 })
+    assert(io.chunks.all? { |c| c.encoding == Encoding::UTF_8 })
+    assert_equal YYJson.dump(data), io.chunks.join
+  end
+
+  def test_io_may_keep_written_strings
+    data = records(100)
+    kept = []
+    Tempfile.create('dump', encoding: Encoding::UTF_8) do |file|
+      file.define_singleton_method(:write) { |str| kept << str; super(str) }
+      YYJson.dump(data, file, buffer_size: 1024)
+      file.rewind
+      assert_equal YYJson.dump(data), file.read
+    end
+    assert_operator kept.size, :>, 1
+    assert_equal YYJson.dump(data), kept.join
+  end
+
+  def test_long_string_larger_than_buffer
+    data = { 'text' => 'é' * 100_000, 'quoted' => '"\\' * 50_000 }
+    io = StringIO.new
+    YYJson.dump(data, io, buffer_size: 100)
+    assert_equal YYJson.dump(data), io.string
+  end
+
+  def test_key_cache_across_flushes
+    # Every buffer boundary lands somewhere inside the repeated keys
+    data = Array.new(300) { |i| { alpha: i, beta_key: 'x' * (i % 7), 'gamma' => nil } }
+    [64, 65, 77, 100, 129].each do |size|
+      io = StringIO.new
+      YYJson.dump(data, io, buffer_size: size)
+      assert_equal YYJson.dump(data), io.string, "buffer_size: #{size}"
+    end
+  end
+
+  def test_invalid_buffer_size
+    assert_raises(ArgumentError) { YYJson.dump([1], StringIO.new, buffer_size: 0) }
+  end
+
+  def test_dump_chunks
+    data = records
+    chunks = []
+    assert_nil YYJson.dump_chunks(data, buffer_size: 512) { |c| chunks << c.dup }
+    assert(chunks.all? { |c| c.bytesize <= 512 })
+    assert_equal YYJson.dump(data), chunks.join
+  end
+
+  def test_dump_chunks_enumerator
+    data = records(20)
+    assert_equal YYJson.dump(data), YYJson.dump_chunks(data).to_a.join
+  end
+
+  def test_stream_body
+    data = records
+    body = YYJson::StreamBody.new(data, buffer_size: 4096)
+    out = +''
+    body.each { |c| out << c }
+    assert_equal YYJson.dump(data), out
+    assert_equal out, body.each.to_a.join
+  end
+
+  def test_error_mid_stream
+    data = [1, 2, Float::NAN]
+    io = StringIO.new
+    assert_raises(YYJson::GenerateError) { YYJson.dump(data, io, mode: :strict) }
+  end
+
+  def test_exception_from_io_propagates
+    io = Object.new
+    def io.write(_str) = raise(IOError, 'closed stream')
+    assert_raises(IOError) { YYJson.dump(records, io, buffer_size: 64) }
+  end
+
+  def test_break_from_dump_chunks
+    first = YYJson.dump_chunks(records, buffer_size: 64) { |c| break c }
+    assert_operator first.bytesize, :<=, 64
+    assert YYJson.dump(records).start_with?(first)
+  end
+end
@@ -0,0 +1,60 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+
+class TestExtract < Minitest::Test
+  JSON_TEXT = '{"header": {"type": "order", "region": "eu"}, "users": [{"name": "ann"}, {"name": "bob"}], ' \
+              '"a/b": 1, "m~n": 2, "": 3}'
+
+  def test_scalar
+    assert_equal "order", YYJson.extract(JSON_TEXT, "/header/type")
+    assert_equal "bob", YYJson.extract(JSON_TEXT, "/users/1/name")
+  end
+
+  def test_container
+    assert_equal({ "type" => "order", "region" => "eu" }, YYJson.extract(JSON_TEXT, "/header"))
+    assert_equal YYJson.load(JSON_TEXT), YYJson.extract(JSON_TEXT, "")
+  end
+
+  def test_missing_is_nil
+    assert_nil YYJson.extract(JSON_TEXT, "/header/missing")
+    assert_nil YYJson.extract(JSON_TEXT, "/users/5/name")
+    assert_nil YYJson.extract(JSON_TEXT, "/header/type/deeper")
+  end
+
+  def test_escaped_tokens
+    assert_equal 1, YYJson.extract(JSON_TEXT, "/a~1b")
+    assert_equal 2, YYJson.extract(JSON_TEXT, "/m~0n")
+    assert_equal 3, YYJson.extract(JSON_TEXT, "/")
+  end
+
+  def test_invalid_pointer
+    assert_raises(ArgumentError) { YYJson.extract(JSON_TEXT, "header") }
+    assert_raises(TypeError) { YYJson.extract(JSON_TEXT, 1) }
+  end
+
+  def test_parse_error
+    assert_raises(YYJson::ParseError) { YYJson.extract('{"a": ', "/a") }
+  end
+
+  def test_options
+    assert_equal({ type: "order", region: "eu" }, YYJson.extract(JSON_TEXT, "/header", symbolize_names: true))
+    assert YYJson.extract(JSON_TEXT, "/header/type", freeze: true).frozen?
+  end
+
+  def test_extract_many
+    assert_equal ["order", "eu", nil, "ann"],
+                 YYJson.extract_many(JSON_TEXT, ["/header/type", "/header/region", "/nope", "/users/0/name"])
+    assert_equal [], YYJson.extract_many(JSON_TEXT, [])
+  end
+
+  def test_extract_many_converts_paths
+    path = Object.new
+    def path.to_str = "/header/type"
+    assert_equal ["order"], YYJson.extract_many(JSON_TEXT, [path])
+    assert_raises(TypeError) { YYJson.extract_many(JSON_TEXT, [1]) }
+    assert_raises(TypeError) { YYJson.extract_many(JSON_TEXT, "/header") }
+  end
+end
@@ -0,0 +1,150 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+
+class TestFeed < Minitest::Test
+  def feed_bytes(parser, json, step)
+    out = []
+    json.bytes.each_slice(step) { |b| out.concat(parser.feed(b.pack('C*'))) }
+    out.concat(parser.finish)
+  end
+
+  def test_top_level_values
+    parser = YYJson::Parser.new
+    assert_equal [{ "a" => 1 }, [1, 2]], parser.feed('{"a": 1} [1, 2] ')
+    assert_equal [], parser.finish
+  end
+
+  def test_value_split_across_chunks
+    parser = YYJson::Parser.new
+    assert_equal [], parser.feed('{"name": "al')
+    assert_equal [], parser.feed('ice", "tags": [1, ')
+    assert_equal [{ "name" => "alice", "tags" => [1, 2] }], parser.feed('2]}')
+  end
+
+  def test_every_split_point
+    json = '{"s": "a\\"b]}", "n": [1, {"x": null}], "e": "\\\\"} "t" 12 true [] {}'
+    expected = [{ "s" => "a\"b]}", "n" => [1, { "x" => nil }], "e" => "\\" }, "t", 12, true, [], {}]
+    (1..json.bytesize).each do |step|
+      assert_equal expected, feed_bytes(YYJson::Parser.new, json, step), "chunk size #{step}"
+    end
+  end
+
+  def test_trailing_scalar_needs_finish
+    parser = YYJson::Parser.new
+    assert_equal [1], parser.feed('1 4')
+    assert_equal [], parser.feed('2')
+    assert_equal [42], parser.finish
+  end
+
+  def test_unwrap_array
+    parser = YYJson::Parser.new(unwrap_array: true)
+    json = '[{"id": 1}, 2, "three", [4], null]'
+    expected = [{ "id" => 1 }, 2, "three", [4], nil]
+    (1..json.bytesize).each do |step|
+      assert_equal expected, feed_bytes(parser, json, step), "chunk size #{step}"
+    end
+  end
+
+  def test_unwrap_array_emits_elements_early
+    parser = YYJson::Parser.new(unwrap_array: true)
+    assert_equal [{ "id" => 1 }], parser.feed('[{"id": 1}, {"id"')
+    assert_equal 5, parser.feed_buffered
+    assert_equal [{ "id" => 2 }], parser.feed(': 2}]')
+    assert_equal [[]], YYJson::Parser.new.feed('[]')
+  end
+
+  def test_unwrap_array_passes_other_values_through
+    parser = YYJson::Parser.new(unwrap_array: true)
+    assert_equal [{ "a" => 1 }, 1, 2], parser.feed('{"a": 1} [1, 2] []')
+    assert_equal [], parser.finish
+  end
+
+  def test_unwrap_array_separators
+    assert_raises(YYJson::ParseError) { YYJson::Parser.new(unwrap_array: true).feed('[1 2]') }
+    assert_raises(YYJson::ParseError) { YYJson::Parser.new(unwrap_array: true).feed('[1,]') }
+    assert_raises(YYJson::ParseError) { YYJson::Parser.new(unwrap_array: true).feed('[,1]') }
+  end
+
+  def test_block_form
+    parser = YYJson::Parser.new(symbolize_names: true)
+    seen = []
+    assert_same parser, parser.feed('{"a": 1}{"b"') { |v| seen << v }
+    parser.feed(': 2}') { |v| seen << v }
+    assert_equal [{ a: 1 }, { b: 2 }], seen
+  end
+
+  def test_unexpected_end_of_input
+    parser = YYJson::Parser.new
+    parser.feed('{"a": [1, 2')
+    error = assert_raises(YYJson::ParseError) { parser.finish }
+    assert_match(/unexpected end of input/, error.message)
+
+    # The stream was reset
+    assert_equal [1], parser.feed('1 ')
+  end
+
+  def test_parse_error_reports_stream_offset
+    parser = YYJson::Parser.new
+    parser.feed('{"a": 1}   ')
+    error = assert_raises(YYJson::ParseError) { parser.feed('{"b": tru}') }
+    assert_match(/at byte 17/, error.message)
+  end
+
+  def test_comments
+    parser = YYJson::Parser.new(allow_comments: true, unwrap_array: true)
+    json = "// header\n[1, /* two */ 2, {\"a\": \"//\"} // tail\n, 3/**/]"
+    (1..json.bytesize).each do |step|
+      assert_equal [1, 2, { "a" => "//" }, 3], feed_bytes(parser, json, step), "chunk size #{step}"
+    end
+  end
+
+  def test_max_buffer_size
+    parser = YYJson::Parser.new(max_buffer_size: 16)
+    parser.feed('["0123456789')
+    error = assert_raises(YYJson::ParseError) { parser.feed('0123456789') }
+    assert_match(/max_buffer_size/, error.message)
+
+    # Values below the cap pass however much input a chunk holds
+    assert_equal Array.new(1000, [1]), parser.feed('[1]' * 1000)
+    assert_raises(ArgumentError) { YYJson::Parser.new(max_buffer_size: 0) }
+  end
+
+  def test_large_chunk
+    rows = Array.new(20_000) { |i| { "id" => i, "name" => "row #{i}" } }
+    json = YYJson.dump(rows)
+    parser = YYJson::Parser.new(unwrap_array: true)
+    count = 0
+    parser.feed(json) { |row| assert_equal rows[count], row; count += 1 }
+    assert_equal rows.size, count
+    assert_equal 0, parser.feed_buffered
+  end
+
+  def test_reentrant_feed_raises
+    parser = YYJson::Parser.new
+    assert_raises(RuntimeError) { parser.feed('1 ') { parser.feed('2 ') } }
+    assert_equal [3], parser.feed('3 ')
+  end
+
+  def test_reset_feed
+    parser = YYJson::Parser.new
+    parser.feed('{"a": ')
+    parser.reset_feed
+    assert_equal 0, parser.feed_buffered
+    assert_equal [true], parser.feed('true ')
+  end
+
+  def test_gc_safety
+    parser = YYJson::Parser.new(unwrap_array: true)
+    json = '[{"alpha": [1, 2, "three"]}, {"beta": {"gamma": null}}]'
+    expected = YYJson.load(json)
+    GC.stress = true
+    begin
+      assert_equal expected, feed_bytes(parser, json, 7)
+    ensure
+      GC.stress = false
+    end
+  end
+end
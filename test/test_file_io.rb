@@ -179,6 +179,14 @@ class TestFileIO < YYJsonTestCase
     assert_equal data, result
   end
 
+  def test_dump_file_larger_than_buffer
+    path = File.join(@temp_dir, 'large.json')
+    data = Array.new(2000) { |i| { 'id' => i, 'name' => "item #{i}" } }
+    YYJson.dump_file(data, path, buffer_size: 256)
+
+    assert_equal YYJson.dump(data), File.read(path)
+  end
+
   def test_dump_file_returns_nil_on_success
     path = File.join(@temp_dir, 'return.json')
     result = YYJson.dump_file({ 'test' => true }, path)
@@ -223,4 +231,78 @@ class TestFileIO < YYJsonTestCase
     loaded = YYJson.load_file(path)
     assert_equal original, loaded
   end
+
+  # load_file mmap: true tests
+
+  def test_load_file_mmap
+    path = File.join(@temp_dir, 'mmap.json')
+    original = sample_api_response
+    YYJson.dump_file(original, path)
+    assert_equal original, YYJson.load_file(path, mmap: true)
+  end
+
+  def test_load_file_mmap_does_not_modify_file
+    path = File.join(@temp_dir, 'escapes.json')
+    json = '{"text": "line\\nbreak \\u00e9 \\"quoted\\"", "list": ["a\\tb"]}'
+    File.write(path, json)
+
+    result = YYJson.load_file(path, mmap: true, symbolize_names: true)
+    assert_equal({ text: "line\nbreak \u00e9 \"quoted\"", list: ["a\tb"] }, result)
+    assert_equal json, File.read(path)
+  end
+
+  def test_load_file_mmap_at_page_boundaries
+    [4093, 4094, 4095, 4096, 4097, 8192].each do |size|
+      path = File.join(@temp_dir, "page_#{size}.json")
+      body = '["' + ('x' * (size - 4)) + '"]'
+      File.write(path, body)
+      assert_equal size, File.size(path)
+      assert_equal ['x' * (size - 4)], YYJson.load_file(path, mmap: true), "size #{size}"
+    end
+  end
+
+  def test_load_file_mmap_parse_error
+    path = File.join(@temp_dir, 'bad.json')
+    File.write(path, '{"a": [1, 2')
+    error = assert_raises(YYJson::ParseError) { YYJson.load_file(path, mmap: true) }
+    assert_match(/bad\.json/, error.message)
+  end
+
+  def test_load_file_mmap_empty_file_falls_back
+    path = File.join(@temp_dir, 'empty.json')
+    File.write(path, '')
+    assert_raises(YYJson::ParseError) { YYJson.load_file(path, mmap: true) }
+  end
+
+  def test_load_file_mmap_missing_file
+    assert_raises(IOError) { YYJson.load_file(File.join(@temp_dir, 'missing.json'), mmap: true) }
+  end
+
+  def test_load_file_mmap_without_gvl
+    path = File.join(@temp_dir, 'large.json')
+    data = { 'items' => (1..2000).map { |i| { 'id' => i, 'name' => "item_#{i}" } } }
+    YYJson.dump_file(data, path)
+    assert_equal data, YYJson.load_file(path, mmap: true, gvl_release_threshold: 1)
+  end
+
+  def test_parser_parse_file_mmap
+    path = File.join(@temp_dir, 'parser.json')
+    File.write(path, '{"ok": [true]}')
+    parser = YYJson::Parser.new(mmap: true)
+    3.times { assert_equal({ 'ok' => [true] }, parser.parse_file(path)) }
+  end
+
+  def test_load_file_mmap_large_document_releases_input
+    path = File.join(@temp_dir, 'large_mmap.json')
+    data = {
+      'records' => (1..20_000).map { |i| { 'id' => i, 'na\u00efve' => "value \"#{i}\"\n", 'tags' => ["t#{i % 7}"] } },
+      'index' => (1..10_000).to_h { |i| ["k#{i}", i] }
+    }
+    YYJson.dump_file(data, path)
+
+    assert_equal data, YYJson.load_file(path, mmap: true)
+    assert_equal YYJson.load_file(path, symbolize_names: true),
+                 YYJson.load_file(path, mmap: true, symbolize_names: true)
+  end
 end
+
@@ -0,0 +1,182 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+require 'stringio'
+
+class TestFragment < Minitest::Test
+  class Product
+    attr_reader :id, :version
+
+    class << self
+      attr_accessor :renders
+    end
+    self.renders = 0
+
+    def initialize(id, version = 1)
+      @id = id
+      @version = version
+    end
+
+    def as_json(*)
+      Product.renders += 1
+      { "id" => @id, "url" => "/products/#{@id}", "rev" => @version }
+    end
+  end
+
+  class Special < Product; end
+
+  class Cached
+    def as_json(*) = YYJson::Fragment.new('{"cached":true}')
+  end
+
+  # Minimal ActiveSupport::Cache::Store stand-in
+  class Store
+    attr_reader :data
+
+    def initialize = @data = {}
+    def fetch(key) = @data.fetch(key) { @data[key] = yield }
+  end
+
+  def setup
+    Product.renders = 0
+  end
+
+  def teardown
+    [Product, Special].each { |k| YYJson.unmemoize(k) }
+    YYJson.unregister_class(Product)
+    YYJson::Fragment.validate = false
+  end
+
+  def test_fragment_is_spliced_verbatim
+    f = YYJson::Fragment.new('{"a": [1, 2.50]}')
+    assert_equal '[{"a": [1, 2.50]},{"k":{"a": [1, 2.50]}}]', YYJson.dump([f, { k: f }])
+    assert_equal '{"a": [1, 2.50]}', YYJson.dump(f)
+  end
+
+  def test_fragment_from_as_json_and_register_class
+    assert_equal '[{"cached":true}]', YYJson.dump([Cached.new])
+    assert_equal '[{"cached":true}]', YYJson.dump([Cached.new], mode: :rails)
+
+    YYJson.register_class(Product) { |p| YYJson::Fragment.new("\"p#{p.id}\"") }
+    assert_equal '["p1"]', YYJson.dump([Product.new(1)])
+  end
+
+  def test_fragment_accessors
+    f = YYJson::Fragment.new('[1]')
+    assert_equal '[1]', f.to_s
+    assert_equal '[1]', f.json
+    assert_equal '[1]', f.to_json
+    assert_same f, f.as_json
+    assert f.frozen?
+    assert f.to_s.frozen?
+    assert_equal Encoding::UTF_8, f.to_s.encoding
+    assert_equal YYJson::Fragment.new('[1]'), f
+    assert_equal 1, { f => 1, YYJson::Fragment.new('[1]') => 1 }.size
+    assert_equal '#<YYJson::Fragment [1]>', f.inspect
+  end
+
+  def test_validation
+    assert_equal '{', YYJson::Fragment.new('{').to_s
+    assert_raises(YYJson::ParseError) { YYJson::Fragment.new('{', validate: true) }
+    assert_raises(YYJson::ParseError) { YYJson::Fragment.new('NaN', validate: true) }
+
+    YYJson::Fragment.validate = true
+    assert YYJson::Fragment.validate
+    error = assert_raises(YYJson::ParseError) { YYJson::Fragment.new('[1,]') }
+    assert_match(/Invalid JSON fragment/, error.message)
+    assert_equal '[1,]', YYJson::Fragment.new('[1,]', validate: false).to_s
+    assert_equal '[1]', YYJson::Fragment.new('[1]').to_s
+  end
+
+  def test_fragment_in_streamed_dump
+    f = YYJson::Fragment.new(%("#{'x' * 100_000}"))
+    io = StringIO.new
+    YYJson.dump([f, f], io)
+    assert_equal YYJson.dump([f, f]), io.string
+    assert_equal 200_007, io.string.bytesize
+  end
+
+  def test_memoize_serializes_each_key_once
+    YYJson.memoize(Product) { |p| [p.id, p.version] }
+    list = [Product.new(1), Product.new(2), Product.new(1)]
+
+    expected = '[{"id":1,"url":"/products/1","rev":1},{"id":2,"url":"/products/2","rev":1},{"id":1,"url":"/products/1","rev":1}]'
+    assert_equal expected, YYJson.dump(list)
+    assert_equal expected, YYJson.dump(list)
+    assert_equal 2, Product.renders
+
+    # A new version is a new key
+    YYJson.dump([Product.new(1, 2)])
+    assert_equal 3, Product.renders
+  end
+
+  def test_memoize_keeps_entries_per_dump_options
+    YYJson.memoize(Product, &:id)
+    assert_equal '{"id":1,"url":"/products/1","rev":1}', YYJson.dump(Product.new(1))
+    assert_equal '{"id":1,"url":"\/products\/1","rev":1}', YYJson.dump(Product.new(1), escape_slash: true)
+    YYJson.dump(Product.new(1), escape_slash: true)
+    assert_equal 2, Product.renders
+  end
+
+  def test_memoize_skips_pretty_and_nil_keys
+    YYJson.memoize(Product) { |p| p.id.odd? ? p.id : nil }
+    YYJson.dump([Product.new(1), Product.new(2), Product.new(2)])
+    assert_equal 3, Product.renders
+
+    assert_equal YYJson.dump([Product.new(1)]).then { |s| YYJson.dump(YYJson.load(s), pretty: true) },
+                 YYJson.dump([Product.new(1)], pretty: true)
+  end
+
+  def test_memoize_applies_to_subclasses_and_registered_classes
+    YYJson.register_class(Product, attrs: [:id])
+    YYJson.memoize(Product, &:id)
+    assert_equal '[{"id":3},{"id":3}]', YYJson.dump([Special.new(3), Special.new(3)])
+
+    YYJson.unregister_class(Product)
+    assert_equal '{"id":3}', YYJson.dump(Special.new(3)) # still memoized
+    YYJson.clear_memos
+    assert_equal '{"id":3,"url":"/products/3","rev":1}', YYJson.dump(Special.new(3))
+  end
+
+  def test_memoize_with_external_store
+    store = Store.new
+    YYJson.memoize(Product, store: store, &:id)
+    YYJson.dump([Product.new(1), Product.new(1)])
+    assert_equal 1, Product.renders
+    assert_equal [[1, store.data.keys.first[1]]], store.data.keys
+    assert_equal ['{"id":1,"url":"/products/1","rev":1}'], store.data.values
+
+    # Entries written by another process
+    store.data[store.data.keys.first] = YYJson::Fragment.new('"stored"')
+    assert_equal '["stored"]', YYJson.dump([Product.new(1)])
+  end
+
+  def test_memoize_capacity_and_unmemoize
+    YYJson.memoize(Product, capacity: 2, &:id)
+    3.times { |i| YYJson.dump(Product.new(i)) }
+    YYJson.dump(Product.new(2))
+    assert_equal 3, Product.renders
+
+    assert YYJson.unmemoize(Product)
+    refute YYJson.unmemoize(Product)
+    YYJson.dump(Product.new(2))
+    assert_equal 4, Product.renders
+  end
+
+  def test_memoize_errors
+    assert_raises(ArgumentError) { YYJson.memoize(Product) }
+    assert_raises(ArgumentError) { YYJson.memoize(Product, store: Object.new, &:id) }
+    assert_raises(ArgumentError) { YYJson.memoize(Product, capacity: 0, &:id) }
+  end
+
+  def test_memoized_self_reference_hits_depth_limit
+    YYJson.memoize(Product, &:id)
+    looped = Class.new(Product) { def as_json(*) = [self] }
+    assert_raises(YYJson::GenerateError) { YYJson.dump(looped.new(1)) }
+
+    # The dump context is restored: the next dump is unaffected
+    assert_equal '[1]', YYJson.dump([1])
+  end
+end
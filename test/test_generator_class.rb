@@ -0,0 +1,94 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'json'
+require 'yyjson'
+
+class TestGeneratorClass < Minitest::Test
+  def test_generate_with_defaults
+    gen = YYJson::Generator.new
+    assert_equal '{"a":[1,2.5,null,true]}', gen.generate({ "a" => [1, 2.5, nil, true] })
+    assert_equal '[1]', gen.dump([1])
+  end
+
+  def test_matches_yyjson_dump
+    obj = { "name" => "x/y", "list" => [1, { "k" => "<b>" }], sym: :val }
+    [{}, { pretty: true }, { escape_slash: true }, { escape_html: true }, { mode: :strict }].each do |opts|
+      gen = YYJson::Generator.new(opts)
+      assert_equal YYJson.dump(obj, opts), gen.generate(obj), "opts: #{opts.inspect}"
+    end
+  end
+
+  def test_results_are_independent_strings
+    gen = YYJson::Generator.new
+    a = gen.generate([1, 2])
+    b = gen.generate({ "x" => "y" })
+    assert_equal '[1,2]', a
+    assert_equal '{"x":"y"}', b
+    assert_equal Encoding::UTF_8, a.encoding
+    refute a.frozen?
+  end
+
+  def test_output_larger_than_scratch_buffer
+    gen = YYJson::Generator.new
+    big = { "items" => (1..5000).map { |i| { "id" => i, "name" => "item_#{i}" } } }
+    expected = JSON.generate(big)
+    assert_equal expected, gen.generate(big)
+    assert_equal '[]', gen.generate([])
+    assert_equal expected, gen.generate(big)
+  end
+
+  def test_error_leaves_generator_usable
+    gen = YYJson::Generator.new(allow_nan: false)
+    assert_raises(YYJson::GenerateError) { gen.generate([Float::NAN]) }
+    assert_equal '[1]', gen.generate([1])
+  end
+
+  def test_reentrant_generate
+    gen = YYJson::Generator.new
+    klass = Class.new do
+      define_method(:initialize) { |g| @g = g }
+      define_method(:as_json) { |*| @g.generate([1, 2]) }
+    end
+    assert_equal '{"a":"[1,2]"}', gen.generate({ "a" => klass.new(gen) })
+    assert_equal '[3]', gen.generate([3])
+  end
+
+  def test_reset
+    gen = YYJson::Generator.new
+    gen.generate({ "a" => "b" * 10_000 })
+    assert_same gen, gen.reset
+    assert_equal '{"a":1}', gen.generate({ "a" => 1 })
+  end
+
+  def test_invalid_options
+    assert_raises(TypeError) { YYJson::Generator.new("nope") }
+  end
+
+  def test_per_thread_generators
+    obj = { "items" => (1..500).map { |i| { "id" => i } } }
+    expected = JSON.generate(obj)
+
+    threads = 4.times.map do
+      Thread.new do
+        gen = YYJson::Generator.new
+        20.times.map { gen.generate(obj) }
+      end
+    end
+    threads.each { |t| t.value.each { |json| assert_equal expected, json } }
+  end
+
+  def test_gc_stress
+    gen = YYJson::Generator.new(pretty: true)
+    obj = { "alpha" => [1, { "beta" => "gamma" * 100 }], delta: "x" }
+    expected = YYJson.dump(obj, pretty: true)
+
+    GC.stress = true
+    begin
+      3.times { assert_equal expected, gen.generate(obj) }
+    ensure
+      GC.stress = false
+    end
+  end
+end
@@ -233,6 +233,34 @@ class TestJSONGeneration < Minitest::Test
     end
   end
 
+  def test_indirect_circular_reference_detection
+    h = { "list" => [] }
+    h["list"] << { "back" => h }
+
+    error = assert_raises(YYJson::GenerateError) { YYJson.dump(h) }
+    assert_match(/circular/, error.message)
+  end
+
+  def test_shared_objects_are_not_circular
+    shared = { "x" => [1] }
+    assert_equal '[{"x":[1]},{"x":[1]},[{"x":[1]}]]', YYJson.dump([shared, shared, [shared]])
+  end
+
+  def test_check_circular_false_relies_on_depth_limit
+    a = []
+    a << a
+
+    error = assert_raises(YYJson::GenerateError) { YYJson.dump(a, check_circular: false) }
+    assert_match(/too deep/, error.message)
+    assert_equal '[[1],{"a":[]}]', YYJson.dump([[1], { "a" => [] }], check_circular: false)
+  end
+
+  def test_nesting_limit
+    deep = 100.times.reduce([]) { |inner, _| [inner] }
+    assert_equal "[" * 101 + "]" * 101, YYJson.dump(deep)
+    assert_raises(YYJson::GenerateError) { YYJson.dump([deep]) }
+  end
+
   def test_deep_nesting
     obj = {a: {b: {c: {d: {e: {f: {g: "deep"}}}}}}}
     result = YYJson.dump(obj)
@@ -250,4 +278,134 @@ class TestJSONGeneration < Minitest::Test
     result = YYJson.dump(obj)
     assert_equal('"custom object"', result)
   end
+
+  def test_dump_pretty_nested_format
+    obj = {a: [1, {b: []}, {}], c: "x"}
+    expected = "{\n  \"a\": [\n    1,\n    {\n      \"b\": []\n    },\n    {}\n  ],\n  \"c\": \"x\"\n}"
+    assert_equal(expected, YYJson.dump(obj, pretty: true))
+  end
+
+  def test_dump_escapes_keys
+    assert_equal('{"a\"b\nc":1}', YYJson.dump({"a\"b\nc" => 1}))
+  end
+
+  def test_dump_int64_bounds
+    assert_equal("[9223372036854775807,-9223372036854775808]", YYJson.dump([2**63 - 1, -2**63]))
+  end
+
+  def test_dump_result_is_utf8
+    result = YYJson.dump({"key" => "世界"})
+    assert_equal(Encoding::UTF_8, result.encoding)
+    refute result.frozen?
+  end
+
+  def test_dump_large_output_grows_buffer
+    obj = (1..20_000).map { |i| {"id" => i, "name" => "name_#{i}" * 3} }
+    result = YYJson.dump(obj)
+
+    assert_operator result.bytesize, :>, 1_000_000
+    assert_equal(obj, YYJson.load(result))
+  end
+
+  def test_dump_large_string
+    str = "<p>" + ("x" * 200_000) + "\u00e9</p>"
+    assert_equal("\"#{str}\"", YYJson.dump(str))
+  end
+
+  def test_dump_under_gc_stress
+    obj = {"data" => (1..50).map { |i| {"id" => i, "name" => "item_#{i}", "tags" => ["t#{i}"]} }}
+    expected = YYJson.dump(obj)
+
+    original_stress = GC.stress
+    GC.stress = true
+    begin
+      3.times { assert_equal(expected, YYJson.dump(obj)) }
+    ensure
+      GC.stress = original_stress
+    end
+  end
+
+  def test_dump_raise_in_as_json_leaves_no_state
+    bad = Object.new
+    def bad.as_json(*)
+      raise ArgumentError, "boom"
+    end
+
+    assert_raises(ArgumentError) { YYJson.dump(["x" * 1000, bad], mode: :rails) }
+    assert_equal('["ok"]', YYJson.dump(["ok"]))
+  end
+
+  def test_dump_small_result_after_buffer_growth
+    # Reserving room for escapes grows the buffer past the embedded String
+    # size; the short result must survive being shrunk back
+    [10, 40, 52, 100, 300].each do |n|
+      assert_equal(%(["ab","#{'y' * n}"]), YYJson.dump(["ab", "y" * n]))
+    end
+  end
+
+  def test_escape_html_every_position
+    # Covers the vectorized scan (16-byte blocks) and the scalar tail
+    (0..40).each do |i|
+      s = ("a" * i) + "<" + ("b" * (40 - i))
+      expected = %(["#{'a' * i}\\u003c#{'b' * (40 - i)}"])
+      assert_equal(expected, YYJson.dump([s], escape_html: true))
+    end
+  end
+
+  def test_escape_html_keys_and_multibyte
+    s = "\u00e9<&>'" * 10
+    json = YYJson.dump({ "<key>" => s }, escape_html: true)
+    refute_match(/[<>&']/, json)
+    assert_equal({ "<key>" => s }, YYJson.load(json))
+  end
+
+  def test_escape_html_with_escape_slash
+    assert_equal('["\\/\\u003c\\/script\\u003e"]', YYJson.dump(["/</script>"], escape_html: true, escape_slash: true))
+  end
+
+  def test_dump_rows_with_repeated_keys
+    rows = Array.new(3) { |i| { "id" => i, :name => "n", "a\"b" => [{ "x/y" => i }], "<" => nil } }
+    expected = (0..2).map { |i| %({"id":#{i},"name":"n","a\\"b":[{"x/y":#{i}}],"<":null}) }.join(",")
+    assert_equal("[#{expected}]", YYJson.dump(rows))
+
+    # Cached keys carry the escaping of the dump they were written by
+    [{ escape_slash: true }, { escape_html: true }, { mode: :strict }].each do |opts|
+      assert_equal("[#{rows.map { |r| YYJson.dump(r, opts) }.join(',')}]", YYJson.dump(rows, opts))
+    end
+    assert_equal(YYJson.dump(rows.map { |r| r.transform_keys(&:to_s) }, pretty: true), YYJson.dump(rows, pretty: true))
+  end
+
+  def test_dump_rows_with_many_distinct_keys
+    # More keys than the per-dump key cache holds
+    rows = Array.new(300) { |i| (0...50).to_h { |k| ["key_#{k}_#{i % 7}_#{'z' * (i % 30)}", k] } }
+    assert_equal(rows, YYJson.load(YYJson.dump(rows)))
+  end
+
+  def test_dump_rows_with_unfrozen_identity_keys
+    key = +"before"
+    row = {}.compare_by_identity
+    row[key] = 1
+    assert_equal('[{"before":1},{"before":1}]', YYJson.dump([row, row]))
+    key.replace("after")
+    assert_equal('[{"after":1},{"after":1}]', YYJson.dump([row, row]))
+  end
+
+  def test_dump_long_strings_split_at_characters
+    # Long strings are escaped in pieces; none may split a UTF-8 sequence
+    [65_535, 65_536, 65_537, 200_003].each do |n|
+      ["\u00e9", "\u20ac", "\u{1F600}", "<\"\n"].each do |ch|
+        s = ("x" * (n % 5)) + (ch * (n / ch.bytesize))
+        assert_equal([s], YYJson.load(YYJson.dump([s])))
+        refute_match(/[<>]/, YYJson.dump(s, escape_html: true))
+      end
+    end
+    assert_raises(YYJson::GenerateError) { YYJson.dump(("a" * 70_000) + "\xff".b.force_encoding("UTF-8")) }
+  end
+
+  def test_dump_strings_in_other_encodings
+    assert_equal(%("\u00e9"), YYJson.dump("\u00e9".encode("ISO-8859-1")))
+    assert_equal('"abc"', YYJson.dump("abc".b))
+    assert_equal(%({"k\u00e9":"\u00e9"}),
+                 YYJson.dump({ "k\u00e9".encode("UTF-16LE") => "\u00e9".encode("Windows-1252") }))
+  end
 end
@@ -0,0 +1,116 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+
+class TestKeyCache < Minitest::Test
+  def setup
+    @saved_default = YYJson.key_cache
+    YYJson.clear_key_cache
+  end
+
+  def teardown
+    YYJson.key_cache = @saved_default
+    YYJson.key_cache_capacity = 1024
+  end
+
+  def test_disabled_by_default
+    refute YYJson.key_cache
+    YYJson.load('{"a": 1, "b": 2}')
+    assert_equal 0, YYJson.key_cache_stats[:misses]
+  end
+
+  def test_hits_across_calls
+    YYJson.load('{"id": 1, "name": "x"}', key_cache: true)
+    stats = YYJson.key_cache_stats
+    assert_equal 2, stats[:misses]
+    assert_equal 0, stats[:hits]
+    assert_equal 2, stats[:size]
+
+    YYJson.load('{"id": 2, "name": "y"}', key_cache: true)
+    stats = YYJson.key_cache_stats
+    assert_equal 2, stats[:misses]
+    assert_equal 2, stats[:hits]
+  end
+
+  def test_keys_are_shared_across_calls
+    a = YYJson.load('{"user_id": 1}', key_cache: true)
+    b = YYJson.load('{"user_id": 2}', key_cache: true)
+    assert_same a.keys.first, b.keys.first
+    assert a.keys.first.frozen?
+  end
+
+  def test_symbolize_names
+    YYJson.load('{"id": 1}', key_cache: true)
+    result = YYJson.load('{"id": 1}', key_cache: true, symbolize_names: true)
+    assert_equal({ id: 1 }, result)
+    assert_equal 1, YYJson.key_cache_stats[:hits]
+  end
+
+  def test_keys_outside_the_per_document_cache
+    json = '{"_id": 1, "123": 2, "": 3}'
+    expected = { "_id" => 1, "123" => 2, "" => 3 }
+    assert_equal expected, YYJson.load(json, key_cache: true)
+    assert_equal expected, YYJson.load(json, key_cache: true)
+    assert_equal 2, YYJson.key_cache_stats[:hits]
+  end
+
+  def test_long_keys_are_not_cached
+    key = "k" * 100
+    assert_equal({ key => 1 }, YYJson.load(%({"#{key}": 1}), key_cache: true))
+    assert_equal 0, YYJson.key_cache_stats[:size]
+  end
+
+  def test_global_default
+    YYJson.key_cache = true
+    assert YYJson.key_cache
+    YYJson.load('{"a": 1}')
+    YYJson.load('{"a": 1}')
+    assert_equal 1, YYJson.key_cache_stats[:hits]
+
+    YYJson.load('{"a": 1}', key_cache: false)
+    assert_equal 1, YYJson.key_cache_stats[:hits]
+  end
+
+  def test_bounded_with_eviction
+    YYJson.key_cache_capacity = 16
+    assert_equal 16, YYJson.key_cache_stats[:capacity]
+
+    200.times { |i| YYJson.load(%({"key_#{i}": #{i}}), key_cache: true) }
+    stats = YYJson.key_cache_stats
+    assert_operator stats[:size], :<=, 16
+    assert_operator stats[:evictions], :>, 0
+    assert_equal 200, stats[:misses]
+  end
+
+  def test_capacity_must_be_positive
+    assert_raises(ArgumentError) { YYJson.key_cache_capacity = 0 }
+  end
+
+  def test_clear_resets_entries_and_counters
+    YYJson.load('{"a": 1}', key_cache: true)
+    YYJson.clear_key_cache
+    stats = YYJson.key_cache_stats
+    assert_equal 0, stats[:size]
+    assert_equal 0, stats[:misses]
+  end
+
+  def test_gc_safety
+    YYJson.key_cache_capacity = 64
+    json = '{"alpha": 1, "beta": {"gamma": [1, 2]}, "_delta": true}'
+    expected = YYJson.load(json)
+
+    GC.stress = true
+    begin
+      5.times { assert_equal expected, YYJson.load(json, key_cache: true) }
+    ensure
+      GC.stress = false
+    end
+
+    GC.compact if GC.respond_to?(:compact)
+    GC.start
+    assert_equal expected, YYJson.load(json, key_cache: true)
+    assert_equal expected.keys, YYJson.load(json, key_cache: true).keys
+  end
+end
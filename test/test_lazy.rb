@@ -0,0 +1,128 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+
+class TestLazy < Minitest::Test
+  JSON_TEXT = '{"id": 7, "name": "alice", "tags": ["a", "b"], "meta": {"score": 1.5, "ok": true, "none": null}}'
+
+  def setup
+    @doc = YYJson.load_lazy(JSON_TEXT)
+  end
+
+  def test_returns_document
+    assert_instance_of YYJson::Document, @doc
+    assert_kind_of YYJson::Node, @doc
+    assert @doc.object?
+    refute @doc.array?
+    assert_equal 4, @doc.size
+  end
+
+  def test_scalar_access
+    assert_equal 7, @doc["id"]
+    assert_equal "alice", @doc[:name]
+    assert_nil @doc["missing"]
+    assert_nil @doc[1]
+  end
+
+  def test_containers_are_nodes
+    tags = @doc["tags"]
+    assert_instance_of YYJson::Node, tags
+    assert tags.array?
+    assert_equal "a", tags[0]
+    assert_equal "b", tags[-1]
+    assert_nil tags[2]
+    assert_raises(TypeError) { tags["x"] }
+  end
+
+  def test_dig
+    assert_equal 1.5, @doc.dig("meta", "score")
+    assert_equal "b", @doc.dig(:tags, 1)
+    assert_nil @doc.dig("meta", "none", "deeper")
+    assert_nil @doc.dig("nope", "x")
+    assert_raises(TypeError) { @doc.dig("name", "x") }
+  end
+
+  def test_each_and_enumerable
+    assert_equal %w[id name tags meta], @doc.map { |k, _v| k }
+    assert_equal %w[a b], @doc["tags"].to_a
+    assert_equal %w[a b], @doc["tags"].each.to_a
+    assert_equal %w[id name tags meta], @doc.keys
+    assert @doc.key?("meta")
+    refute @doc.key?("other")
+  end
+
+  def test_to_h_matches_load
+    assert_equal YYJson.load(JSON_TEXT), @doc.to_h
+    assert_equal YYJson.load(JSON_TEXT)["meta"], @doc["meta"].to_h
+    assert_raises(TypeError) { @doc["tags"].to_h }
+  end
+
+  def test_options
+    doc = YYJson.load_lazy(JSON_TEXT, symbolize_names: true, freeze: true)
+    assert_equal %i[id name tags meta], doc.keys
+    assert_equal({ score: 1.5, ok: true, none: nil }, doc[:meta].to_h)
+    assert doc["name"].frozen?
+  end
+
+  def test_scalar_root
+    doc = YYJson.load_lazy('"text"')
+    assert_equal "text", doc.to_ruby
+    assert_raises(TypeError) { doc["x"] }
+  end
+
+  def test_to_json
+    assert_equal '{"score":1.5,"ok":true,"none":null}', @doc["meta"].to_json
+    assert_equal YYJson.load(JSON_TEXT), YYJson.load(@doc.to_json)
+  end
+
+  def test_dump_embeds_nodes
+    assert_equal '{"x":{"score":1.5,"ok":true,"none":null},"t":["a","b"]}',
+                 YYJson.dump({ "x" => @doc["meta"], "t" => @doc["tags"] })
+    assert_equal YYJson.dump(YYJson.load(JSON_TEXT), canonical: true), YYJson.dump(@doc, canonical: true)
+    assert_equal({ "meta" => { "score" => 1.5, "ok" => true, "none" => nil } },
+                 YYJson.load_msgpack(YYJson.dump_msgpack({ "meta" => @doc["meta"] })))
+    assert_instance_of YYJson::Fragment, @doc["meta"].as_json
+  end
+
+  def test_to_json_options
+    meta = @doc["meta"]
+    assert_equal YYJson.dump(meta.to_ruby, pretty: true), meta.to_json(pretty: true)
+    assert_equal '["a\\/b"]', YYJson.load_lazy('["a/b"]').to_json(escape_slash: true)
+    assert_equal meta.to_json, meta.to_json(Object.new)
+    assert_raises(ArgumentError) { meta.to_json({}, {}) }
+
+    nan = YYJson.load_lazy('[NaN]', allow_nan: true)
+    assert_equal '[NaN]', nan.to_json
+    assert_raises(YYJson::GenerateError) { nan.to_json(allow_nan: false) }
+  end
+
+  def test_parse_error
+    assert_raises(YYJson::ParseError) { YYJson.load_lazy('{"a": ') }
+    assert_raises(TypeError) { YYJson.load_lazy(nil) }
+  end
+
+  def test_not_instantiable
+    assert_raises(NoMethodError, TypeError) { YYJson::Node.new }
+    assert_raises(NoMethodError, TypeError) { YYJson::Document.new }
+  end
+
+  def test_nodes_keep_document_alive
+    nodes = Array.new(20) { YYJson.load_lazy(JSON_TEXT)["meta"] }
+    GC.start
+    GC.compact if GC.respond_to?(:compact)
+    nodes.each { |n| assert_equal 1.5, n["score"] }
+  end
+
+  def test_gc_safety
+    GC.stress = true
+    begin
+      doc = YYJson.load_lazy(JSON_TEXT)
+      assert_equal "b", doc.dig("tags", 1)
+      assert_equal YYJson.load(JSON_TEXT), doc.to_h
+    ensure
+      GC.stress = false
+    end
+  end
+end
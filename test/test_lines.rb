@@ -0,0 +1,133 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'json'
+require 'stringio'
+require 'yyjson'
+
+class TestLines < Minitest::Test
+  NDJSON = %({"id":1,"name":"a"}\n{"id":2,"name":"b"}\n[3]\n"four"\n)
+
+  def test_load_lines
+    assert_equal [{ "id" => 1, "name" => "a" }, { "id" => 2, "name" => "b" }, [3], "four"],
+                 YYJson.load_lines(NDJSON)
+  end
+
+  def test_blank_lines_and_crlf
+    input = %({"a":1}\r\n\r\n   \n{"b":2}\n\n)
+    assert_equal [{ "a" => 1 }, { "b" => 2 }], YYJson.load_lines(input)
+  end
+
+  def test_last_line_without_newline
+    assert_equal [1, 2], YYJson.load_lines("1\n2")
+    assert_equal [], YYJson.load_lines("")
+  end
+
+  def test_each_line_yields_records
+    records = []
+    result = YYJson.each_line(NDJSON) { |obj| records << obj }
+    assert_equal NDJSON, result
+    assert_equal 4, records.size
+  end
+
+  def test_each_line_enumerator
+    enum = YYJson.each_line(NDJSON)
+    assert_kind_of Enumerator, enum
+    assert_equal [1, 2], enum.first(2).map { |r| r["id"] }
+  end
+
+  def test_each_line_batches
+    batches = YYJson.each_line(NDJSON, batch_size: 3).to_a
+    assert_equal [3, 1], batches.map(&:size)
+    assert_equal "four", batches.last.first
+    assert_raises(ArgumentError) { YYJson.each_line(NDJSON, batch_size: 0) { } }
+  end
+
+  def test_parse_options
+    result = YYJson.load_lines(%({"a":{"b":1}}\n), symbolize_names: true, freeze: true)
+    assert_equal [{ a: { b: 1 } }], result
+    assert result.first.frozen?
+  end
+
+  def test_keys_shared_across_records
+    a, b = YYJson.load_lines(%({"user_id":1}\n{"user_id":2}\n))
+    assert_same a.keys.first, b.keys.first
+  end
+
+  def test_io_source
+    io = StringIO.new(NDJSON)
+    assert_equal YYJson.load_lines(NDJSON), YYJson.load_lines(io)
+  end
+
+  def test_io_records_spanning_read_chunks
+    lines = (1..5000).map { |i| JSON.generate("id" => i, "pad" => "x" * (i % 97)) }
+    io = StringIO.new(lines.join("\n") + "\n")
+    records = []
+    YYJson.each_line(io) { |r| records << r }
+    assert_equal lines.map { |l| JSON.parse(l) }, records
+  end
+
+  def test_file_io_source
+    path = File.join(Dir.tmpdir, "yyjson_lines_#{Process.pid}.ndjson")
+    File.write(path, NDJSON)
+    File.open(path) { |f| assert_equal 4, YYJson.load_lines(f).size }
+  ensure
+    File.delete(path) if path && File.exist?(path)
+  end
+
+  def test_parse_error_reports_line
+    error = assert_raises(YYJson::ParseError) { YYJson.load_lines(%({"a":1}\n\n{"a":\n)) }
+    assert_match(/line 3/, error.message)
+  end
+
+  def test_invalid_source
+    assert_raises(TypeError) { YYJson.load_lines(42) }
+    assert_raises(TypeError) { YYJson.load_lines(NDJSON, "opts") }
+  end
+
+  def test_break_from_block
+    seen = []
+    YYJson.each_line(NDJSON) do |r|
+      seen << r
+      break if seen.size == 2
+    end
+    assert_equal 2, seen.size
+  end
+
+  def test_block_may_mutate_source
+    source = +NDJSON
+    records = []
+    YYJson.each_line(source) do |r|
+      source.replace("garbage")
+      records << r
+    end
+    assert_equal 4, records.size
+  end
+
+  def test_parser_each_line
+    parser = YYJson::Parser.new(symbolize_names: true)
+    assert_equal [{ id: 1, name: "a" }, { id: 2, name: "b" }], parser.each_line(NDJSON).first(2)
+    assert_equal 4, parser.load_lines(NDJSON).size
+    assert_equal [[{ id: 1, name: "a" }]], parser.each_line(NDJSON, batch_size: 1).first(1)
+  end
+
+  def test_nested_parse_inside_block
+    parser = YYJson::Parser.new
+    inner = []
+    parser.each_line(NDJSON) { |_| inner << parser.parse('[1]') }
+    assert_equal [[1]] * 4, inner
+  end
+
+  def test_gc_stress
+    input = (1..20).map { |i| JSON.generate("id" => i, "tags" => ["t#{i}"]) }.join("\n")
+    expected = input.lines.map { |l| JSON.parse(l) }
+
+    GC.stress = true
+    begin
+      assert_equal expected, YYJson.load_lines(input)
+    ensure
+      GC.stress = false
+    end
+  end
+end
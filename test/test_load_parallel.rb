@@ -0,0 +1,49 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+
+class TestLoadParallel < Minitest::Test
+  ROWS = Array.new(10_000) { |i| { "id" => i, "name" => "user #{i}", "tags" => ["a", { "n" => [i, i / 4.0] }] } }
+  JSON_TEXT = YYJson.dump(ROWS)
+
+  def test_matches_load
+    assert_equal ROWS, YYJson.load_parallel(JSON_TEXT, threads: 2)
+    assert_equal YYJson.load(JSON_TEXT, symbolize_names: true),
+                 YYJson.load_parallel(JSON_TEXT, threads: 2, symbolize_names: true)
+  end
+
+  def test_output_is_frozen_and_shareable
+    result = YYJson.load_parallel(JSON_TEXT, threads: 2)
+    assert result.frozen?
+    assert Ractor.shareable?(result)
+    assert result.last["tags"][1]["n"].frozen?
+    assert result.last["name"].frozen?
+  end
+
+  def test_small_and_non_array_documents
+    doc = YYJson::ShardedDocument.new('[1,2,3]', 4)
+    assert_equal 0, doc.shards
+    assert_equal [1, 2, 3], YYJson.load_parallel('[1,2,3]', threads: 4)
+    assert Ractor.shareable?(YYJson.load_parallel('{"a":["b"]}'))
+    assert_equal "x", YYJson.load_parallel('"x"')
+  end
+
+  def test_shards
+    doc = YYJson::ShardedDocument.new(JSON_TEXT, 8)
+    assert_equal 2, doc.shards # at least 4096 elements each
+    assert Ractor.shareable?(doc)
+    assert_equal ROWS, doc.shard(0) + doc.shard(1)
+    assert_raises(IndexError) { doc.shard(2) }
+  end
+
+  def test_errors_raise_in_caller
+    assert_raises(YYJson::ParseError) { YYJson.load_parallel('[1,', threads: 2) }
+
+    deep = "[#{([1] * 9000 + ["[" * 120 + "]" * 120]).join(',')}]"
+    error = assert_raises(YYJson::ParseError) { YYJson.load_parallel(deep, threads: 2) }
+    assert_match(/too deep/, error.message)
+    assert_equal 9001, YYJson.load_parallel(deep, threads: 2, max_nesting: false).size
+  end
+end
@@ -0,0 +1,65 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+
+class TestLoadTable < Minitest::Test
+  ROWS = '[{"id":1,"name":"a","tags":["x"]},{"name":"b","id":2},{"id":3,"name":"c","extra":true}]'
+
+  def test_columns
+    table = YYJson.load_table(ROWS)
+    assert_equal({
+      "id" => [1, 2, 3],
+      "name" => ["a", "b", "c"],
+      "tags" => [["x"], nil, nil],
+      "extra" => [nil, nil, true]
+    }, table)
+  end
+
+  def test_columns_match_load
+    records = Array.new(50) { |i| { "id" => i, "v" => { "n" => [i, i.to_s] }, "f" => i / 3.0 } }
+    table = YYJson.load_table(YYJson.dump(records))
+    assert_equal records.map { |r| r["v"] }, table["v"]
+    assert_equal records.map { |r| r["f"] }, table["f"]
+  end
+
+  def test_load_options_apply
+    table = YYJson.load_table('[{"a":"x"},{"a":"y"}]', symbolize_names: true, freeze: true)
+    assert_equal({ a: ["x", "y"] }, table)
+    assert table.frozen?
+    assert table[:a].frozen?
+    assert table[:a][0].frozen?
+  end
+
+  def test_struct_rows
+    rows = YYJson.load_table(ROWS.sub(',"extra":true', ''), as: :struct)
+    assert_equal 3, rows.size
+    assert_kind_of Struct, rows[0]
+    assert_equal [:id, :name, :tags], rows[0].members
+    assert_equal [2, "b", nil], rows[1].to_a
+
+    # One class per key shape
+    assert_same rows[0].class, YYJson.load_table('[{"id":9,"name":"z","tags":[]}]', as: :struct)[0].class
+  end
+
+  def test_data_rows
+    rows = YYJson.load_table('[{"x":1,"y":2},{"y":4,"x":3}]', as: :data)
+    assert_equal [[1, 2], [3, 4]], rows.map { |r| [r.x, r.y] }
+    assert rows[0].frozen?
+    assert_equal({ x: 3, y: 4 }, rows[1].to_h)
+  end
+
+  def test_empty_array
+    assert_equal({}, YYJson.load_table('[]'))
+    assert_equal [], YYJson.load_table('[]', as: :struct)
+  end
+
+  def test_errors
+    assert_raises(YYJson::ParseError) { YYJson.load_table('{"a":1}') }
+    assert_raises(YYJson::ParseError) { YYJson.load_table('[{"a":1},2]') }
+    assert_raises(YYJson::ParseError) { YYJson.load_table('[{"a":1},{"b":2}]', as: :struct) }
+    assert_raises(YYJson::ParseError) { YYJson.load_table('[{"a":1}') }
+    assert_raises(ArgumentError) { YYJson.load_table('[]', as: :rows) }
+  end
+end
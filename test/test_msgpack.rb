@@ -0,0 +1,156 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+require 'time'
+require 'date'
+require 'bigdecimal'
+
+class TestMsgpack < Minitest::Test
+  class Point
+    def initialize(x, y)
+      @x = x
+      @y = y
+    end
+
+    def as_json(*)
+      { "x" => @x, "y" => @y }
+    end
+  end
+
+  def hex(obj, opts = {})
+    YYJson.dump_msgpack(obj, opts).unpack1('H*')
+  end
+
+  def round_trip(obj, opts = {})
+    YYJson.load_msgpack(YYJson.dump_msgpack(obj, opts))
+  end
+
+  def test_wire_format
+    assert_equal Encoding::BINARY, YYJson.dump_msgpack(nil).encoding
+    assert_equal "c0c3c2", hex(nil) + hex(true) + hex(false)
+    assert_equal "007fcc80ccffcd0100ce00010000cf0000000100000000", [0, 127, 128, 255, 256, 65_536, 2**32].map { |i| hex(i) }.join
+    assert_equal "ffe0d0dfd080d1ff7fd2ffff7fffd38000000000000000", [-1, -32, -33, -128, -129, -32_769, -2**63].map { |i| hex(i) }.join
+    assert_equal "cb3ff8000000000000", hex(1.5)
+    assert_equal "a3616263", hex("abc")
+    assert_equal "d920#{'78' * 32}", hex("x" * 32)
+    assert_equal "da0100", hex("x" * 256)[0, 6]
+    assert_equal "c403010203", hex("\x01\x02\x03".b)
+    assert_equal "92a1610f", hex([:a, 15])
+    assert_equal "dc0010", hex(Array.new(16, 0))[0, 6]
+    assert_equal "81a16bc0", hex({ "k" => nil })
+  end
+
+  def test_round_trips_like_json
+    obj = {
+      "ints" => [0, -1, 100, 101, 2**62, -2**63, 2**64 - 1],
+      "floats" => [0.0, -2.5, 1e300],
+      "strings" => ["", "é", "東京", "a\"b\\c\n"],
+      "nested" => { "a" => [[], {}, [nil, true, false]] },
+      :sym => :value,
+      1 => "integer key",
+      "time" => Time.utc(2024, 1, 2, 3, 4, 5, 123_456.789),
+      "date" => Date.new(2024, 2, 29),
+      "big" => 2**70,
+      "decimal" => BigDecimal("1.25"),
+      "point" => Point.new(1, 2)
+    }
+    assert_equal YYJson.load(YYJson.dump(obj)), round_trip(obj)
+    assert_equal YYJson.load(YYJson.dump(obj, time_precision: 3)), round_trip(obj, time_precision: 3)
+    assert_equal YYJson.load(YYJson.dump(obj, mode: :rails)), round_trip(obj, mode: :rails)
+  end
+
+  def test_registered_classes_fragments_and_memoized
+    klass = Struct.new(:id, :name)
+    YYJson.register_class(klass, attrs: { "id" => :id, "user\"name" => :name })
+    rows = [klass.new(1, "a"), klass.new(2, "b"), YYJson::Fragment.new('{"raw":[1,-2,3.5,"s",null,true]}')]
+    assert_equal YYJson.load(YYJson.dump(rows)), round_trip(rows)
+
+    YYJson.memoize(klass) { |r| r.id }
+    assert_equal YYJson.load(YYJson.dump(rows)), round_trip(rows)
+    assert_equal YYJson.load(YYJson.dump(rows)), round_trip(rows)
+  ensure
+    YYJson.unmemoize(klass)
+    YYJson.unregister_class(klass)
+  end
+
+  def test_binary_strings_round_trip_as_bin
+    bin = "\xFF\x00\xFE".b
+    loaded = round_trip([bin, "text"])
+    assert_equal [bin, "text"], loaded
+    assert_equal Encoding::BINARY, loaded[0].encoding
+    assert_equal Encoding::UTF_8, loaded[1].encoding
+  end
+
+  def test_load_options
+    packed = YYJson.dump_msgpack([{ "name" => "a", "tags" => ["x"] }, { "name" => "b", "tags" => [] }])
+    rows = YYJson.load_msgpack(packed, symbolize_names: true, freeze: true)
+    assert_equal [{ name: "a", tags: ["x"] }, { name: "b", tags: [] }], rows
+    assert rows.frozen?
+    assert rows[0][:tags][0].frozen?
+
+    values = YYJson.load_msgpack(YYJson.dump_msgpack(%w[active active]), dedup_values: true)
+    assert_same values[0], values[1]
+
+    assert_raises(YYJson::ParseError) { YYJson.load_msgpack(YYJson.dump_msgpack([[1]]), max_nesting: 1) }
+    deep = "\x91" * 100 + "\x90"
+    assert_raises(YYJson::ParseError) { YYJson.load_msgpack(deep) }
+    assert_equal [], YYJson.load_msgpack(deep, max_nesting: false).flatten
+
+    nan = YYJson.dump_msgpack(Float::NAN)
+    assert YYJson.load_msgpack(nan).nan?
+    assert_raises(YYJson::ParseError) { YYJson.load_msgpack(nan, mode: :strict) }
+  end
+
+  def test_decodes_every_wire_form
+    {
+      "ccff" => 255, "cd0100" => 256, "ce00010000" => 65_536, "cf0000000100000000" => 2**32,
+      "d0df" => -33, "d1ff7f" => -129, "d2ffff7fff" => -32_769, "d38000000000000000" => -2**63,
+      "ca3fc00000" => 1.5, "d903616263" => "abc", "da0003616263" => "abc", "db00000003616263" => "abc",
+      "c50002abcd" => "\xAB\xCD".b, "c600000002abcd" => "\xAB\xCD".b,
+      "dc000201c0" => [1, nil], "dd0000000201c0" => [1, nil],
+      "de0001a16101" => { "a" => 1 }, "df00000001a16101" => { "a" => 1 }
+    }.each do |wire, expected|
+      assert_equal expected, YYJson.load_msgpack([wire].pack('H*')), wire
+    end
+  end
+
+  def test_invalid_input
+    {
+      "" => "position 0: unexpected end of data",
+      "92" "01" => "position 2: unexpected end of data",
+      "a3" "6162" => "position 0: unexpected end of data",
+      "c1" => "position 0: invalid type byte 0xc1",
+      "81" "01" "02" => "position 1: map keys must be strings",
+      "81" "90" "02" => "position 1: map keys must be strings",
+      "d4" "01" "02" => "position 0: unsupported extension type",
+      "01" "02" => "position 1: unexpected data after the value",
+      "a2" "fffe" => "position 0: invalid UTF-8 in string",
+      "a3" "eda080" => "position 0: invalid UTF-8 in string"
+    }.each do |wire, message|
+      error = assert_raises(YYJson::ParseError, wire) { YYJson.load_msgpack([wire].pack('H*')) }
+      assert_includes error.message, message
+    end
+    assert_raises(TypeError) { YYJson.load_msgpack(nil) }
+  end
+
+  def test_dump_errors
+    assert_raises(YYJson::GenerateError) { YYJson.dump_msgpack("\xFF".dup.force_encoding(Encoding::UTF_8)) }
+    assert_raises(YYJson::GenerateError) { YYJson.dump_msgpack({ "\xFF".b => 1 }) }
+    assert_raises(YYJson::GenerateError) { YYJson.dump_msgpack([Float::INFINITY], allow_nan: false) }
+    assert_raises(YYJson::GenerateError) { YYJson.dump_msgpack([YYJson::Fragment.new('{"a":')]) }
+
+    cycle = []
+    cycle << cycle
+    assert_raises(YYJson::GenerateError) { YYJson.dump_msgpack(cycle) }
+  end
+
+  def test_large_documents
+    rows = Array.new(20_000) { |i| { "id" => i, "name" => "n#{i}", "score" => i * 0.5, "tags" => ["t#{i % 7}"] } }
+    assert_equal rows, round_trip(rows)
+
+    long = "é" * 100_000
+    assert_equal [long, "x" * 70_000], round_trip([long, "x" * 70_000])
+  end
+end
@@ -0,0 +1,70 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+require 'yyjson/rails'
+require 'bigdecimal'
+require 'date'
+require 'time'
+
+class TestNativeFormatting < Minitest::Test
+  TIME = Time.at(1_700_000_000, 123_456_789, :nsec)
+
+  def teardown
+    YYJson::Rails.reset_config!
+  end
+
+  def test_time_matches_iso8601
+    [TIME.utc, TIME.getlocal("+05:30"), TIME.getlocal("-00:30"), Time.at(-1, 500, :millisecond).utc].each do |t|
+      assert_equal %("#{t.iso8601}"), YYJson.dump(t)
+      [1, 3, 6, 9].each do |n|
+        assert_equal %("#{t.iso8601(n)}"), YYJson.dump(t, time_precision: n)
+      end
+    end
+  end
+
+  def test_time_outside_four_digit_years
+    t = Time.utc(12_000, 1, 1)
+    assert_equal %("#{t.iso8601(3)}"), YYJson.dump(t, time_precision: 3)
+  end
+
+  def test_time_precision_validation
+    assert_raises(ArgumentError) { YYJson.dump(TIME, time_precision: 10) }
+    assert_raises(ArgumentError) { YYJson.dump(TIME, time_precision: -1) }
+  end
+
+  def test_rails_time_precision
+    assert_equal %("#{TIME.utc.iso8601}"), YYJson.dump(TIME.utc, mode: :rails)
+    YYJson::Rails.time_precision = 3
+    assert_equal %("#{TIME.utc.iso8601(3)}"), YYJson.dump(TIME.utc, mode: :rails)
+    assert_equal %("#{TIME.utc.iso8601}"), YYJson.dump(TIME.utc)
+    assert_equal %("#{TIME.utc.iso8601(6)}"), YYJson.dump(TIME.utc, mode: :rails, time_precision: 6)
+  end
+
+  def test_date_and_datetime
+    assert_equal '["2024-02-29","1500-01-01","0001-01-01"]',
+                 YYJson.dump([Date.new(2024, 2, 29), Date.new(1500, 1, 1), Date.new(1, 1, 1)])
+    julian = Date.new(2024, 1, 1, Date::JULIAN)
+    assert_equal %("#{julian.iso8601}"), YYJson.dump(julian)
+
+    dt = DateTime.new(2024, 1, 2, 3, 4, 5.5r)
+    assert_equal %("#{dt.iso8601(2)}"), YYJson.dump(dt, time_precision: 2)
+  end
+
+  def test_bignum_exact
+    ints = [2**62, 2**63, 2**64 - 1, -2**63, -2**63 - 1, 2**100, -2**100]
+    assert_equal "[#{ints.join(',')}]", YYJson.dump(ints)
+  end
+
+  def test_bigdecimal_raw_number
+    assert_equal '[0.15e1,-0.1e-2,0.1e401]',
+                 YYJson.dump([BigDecimal("1.5"), BigDecimal("-0.001"), BigDecimal("1e400")])
+    assert_equal 'NaN', YYJson.dump(BigDecimal("NaN"))
+    assert_raises(YYJson::GenerateError) { YYJson.dump(BigDecimal("Infinity"), allow_nan: false) }
+  end
+
+  def test_bigdecimal_string_in_rails_mode
+    assert_equal '"0.15e1"', YYJson.dump(BigDecimal("1.5"), mode: :rails)
+  end
+end
@@ -170,4 +170,32 @@ class TestParseErrors < YYJsonTestCase
     assert_kind_of YYJson::Error, error
     assert_kind_of StandardError, error
   end
+
+  def test_max_nesting_exceeded
+    assert_equal [[[]]], YYJson.load("[[[]]]", max_nesting: 3)
+    error = assert_raises(YYJson::ParseError) { YYJson.load("[[[]]]", max_nesting: 2) }
+    assert_equal "nesting of 3 is too deep", error.message
+    assert_raises(YYJson::ParseError) { YYJson.load('{"a":{"b":{}}}', max_nesting: 2) }
+  end
+
+  def test_max_nesting_default
+    assert_equal [], YYJson.load("[" * 100 + "]" * 100).flatten
+    assert_raises(YYJson::ParseError) { YYJson.load("[" * 101 + "]" * 101) }
+    assert_raises(YYJson::ParseError) { YYJson::Parser.new.parse("[" * 101 + "]" * 101) }
+    assert_raises(YYJson::ParseError) { YYJson.load_lines("[1]\n" + "[" * 101 + "]" * 101) }
+  end
+
+  def test_max_nesting_unlimited
+    deep = "[" * 100_000 + "]" * 100_000
+    [0, false].each do |limit|
+      result = YYJson.load(deep, max_nesting: limit)
+      assert_equal 1, result.size
+    end
+  end
+
+  def test_deep_document_on_fiber_stack
+    deep = '{"a":' * 20_000 + "1" + "}" * 20_000
+    result = Fiber.new { YYJson.load(deep, max_nesting: false) }.resume
+    assert_equal 1, result.dig(*["a"] * 20_000)
+  end
 end
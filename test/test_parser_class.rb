@@ -0,0 +1,123 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'json'
+require 'tempfile'
+require 'yyjson'
+
+class TestParserClass < Minitest::Test
+  def test_parse_with_defaults
+    parser = YYJson::Parser.new
+    assert_equal({ "a" => [1, 2.5, nil, true] }, parser.parse('{"a": [1, 2.5, null, true]}'))
+    assert_equal [1], parser.load('[1]')
+  end
+
+  def test_options_are_fixed_at_construction
+    parser = YYJson::Parser.new(symbolize_names: true, freeze: true)
+    result = parser.parse('{"name": "x", "list": [1]}')
+    assert_equal({ name: "x", list: [1] }, result)
+    assert result.frozen?
+    assert result[:list].frozen?
+  end
+
+  def test_strict_mode
+    parser = YYJson::Parser.new(mode: :strict)
+    assert_raises(YYJson::ParseError) { parser.parse('[NaN]') }
+    assert_raises(YYJson::ParseError) { parser.parse('[1] // comment') }
+  end
+
+  def test_repeated_parses_reuse_allocator
+    parser = YYJson::Parser.new
+    small = '{"id": 1, "tags": ["a", "b"]}'
+    large = JSON.generate("items" => (1..5000).map { |i| { "id" => i, "name" => "n#{i}" } })
+
+    100.times do
+      assert_equal JSON.parse(small), parser.parse(small)
+    end
+    assert_equal JSON.parse(large), parser.parse(large)
+    assert_equal JSON.parse(small), parser.parse(small)
+  end
+
+  def test_parse_error_leaves_parser_usable
+    parser = YYJson::Parser.new
+    error = assert_raises(YYJson::ParseError) { parser.parse('{"a": ') }
+    assert_match(/position/, error.message)
+    assert_equal({ "a" => 1 }, parser.parse('{"a": 1}'))
+  end
+
+  def test_type_error_for_non_string
+    parser = YYJson::Parser.new
+    assert_raises(TypeError) { parser.parse(123) }
+    assert_equal [1], parser.parse('[1]')
+  end
+
+  def test_parse_file
+    parser = YYJson::Parser.new(symbolize_names: true)
+    Tempfile.create(['parser', '.json']) do |f|
+      f.write('{"ok": true}')
+      f.flush
+      assert_equal({ ok: true }, parser.parse_file(f.path))
+    end
+    assert_raises(IOError) { parser.parse_file('/nonexistent/file.json') }
+  end
+
+  def test_reset
+    parser = YYJson::Parser.new
+    parser.parse('[1, 2, 3]')
+    assert_same parser, parser.reset
+    assert_equal [1, 2, 3], parser.parse('[1, 2, 3]')
+  end
+
+  def test_private_key_cache
+    parser = YYJson::Parser.new(key_cache: true, key_cache_capacity: 64)
+    parser.parse('{"id": 1}')
+    parser.parse('{"id": 2}')
+    stats = parser.key_cache_stats
+    assert_equal 1, stats[:misses]
+    assert_equal 1, stats[:hits]
+    assert_equal 64, stats[:capacity]
+  end
+
+  def test_global_key_cache
+    YYJson.clear_key_cache
+    parser = YYJson::Parser.new(key_cache: :global)
+    parser.parse('{"id": 1}')
+    assert_equal YYJson.key_cache_stats, parser.key_cache_stats
+  end
+
+  def test_no_key_cache
+    assert_nil YYJson::Parser.new.key_cache_stats
+  end
+
+  def test_invalid_options
+    assert_raises(TypeError) { YYJson::Parser.new("nope") }
+    assert_raises(ArgumentError) { YYJson::Parser.new(key_cache: true, key_cache_capacity: 0) }
+  end
+
+  def test_shared_between_threads
+    parser = YYJson::Parser.new(gvl_release_threshold: 1)
+    json = JSON.generate("items" => (1..2000).map { |i| { "id" => i } })
+    expected = JSON.parse(json)
+
+    threads = 4.times.map do
+      Thread.new { 10.times.map { parser.parse(json) } }
+    end
+    threads.each { |t| t.value.each { |result| assert_equal expected, result } }
+  end
+
+  def test_gc_stress
+    parser = YYJson::Parser.new(key_cache: true)
+    json = '{"alpha": [1, {"beta": "gamma"}], "delta": "x"}'
+    expected = JSON.parse(json)
+
+    GC.stress = true
+    begin
+      3.times { assert_equal expected, parser.parse(json) }
+    ensure
+      GC.stress = false
+    end
+    GC.compact if GC.respond_to?(:compact)
+    assert_equal expected, parser.parse(json)
+  end
+end
@@ -0,0 +1,133 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+
+class TestPatch < Minitest::Test
+  def merge(target, patch)
+    YYJson.load(YYJson.merge_patch(target, patch))
+  end
+
+  def patch(doc, ops)
+    YYJson.load(YYJson.patch(doc, ops))
+  end
+
+  # RFC 7386, Appendix A
+  def test_merge_patch_rfc_examples
+    [
+      ['{"a":"b"}', '{"a":"c"}', { "a" => "c" }],
+      ['{"a":"b"}', '{"b":"c"}', { "a" => "b", "b" => "c" }],
+      ['{"a":"b"}', '{"a":null}', {}],
+      ['{"a":"b","b":"c"}', '{"a":null}', { "b" => "c" }],
+      ['{"a":["b"]}', '{"a":"c"}', { "a" => "c" }],
+      ['{"a":"c"}', '{"a":["b"]}', { "a" => ["b"] }],
+      ['{"a":{"b":"c"}}', '{"a":{"b":"d","c":null}}', { "a" => { "b" => "d" } }],
+      ['{"a":[{"b":"c"}]}', '{"a":[1]}', { "a" => [1] }],
+      ['["a","b"]', '["c","d"]', ["c", "d"]],
+      ['{"a":"b"}', '["c"]', ["c"]],
+      ['{"a":"foo"}', '"bar"', "bar"],
+      ['{"e":null}', '{"a":1}', { "e" => nil, "a" => 1 }],
+      ['[1,2]', '{"a":"b","c":null}', { "a" => "b" }],
+      ['{}', '{"a":{"bb":{"ccc":null}}}', { "a" => { "bb" => {} } }]
+    ].each do |target, patch, expected|
+      assert_equal expected, merge(target, patch), "#{target} + #{patch}"
+    end
+    assert_equal 'null', YYJson.merge_patch('{"a":"foo"}', 'null')
+  end
+
+  def test_merge_patch_from_ruby_objects
+    json = '{"title":"Goodbye!","author":{"givenName":"John","familyName":"Doe"},"tags":["example","sample"]}'
+    result = YYJson.merge_patch(json, { "title" => "Hello!", "author" => { "familyName" => nil }, "tags" => ["example"] })
+    assert_equal '{"title":"Hello!","author":{"givenName":"John"},"tags":["example"]}', result
+    assert_equal Encoding::UTF_8, result.encoding
+    assert_equal "{\n  \"a\": 1\n}", YYJson.merge_patch('{}', '{"a":1}', pretty: true)
+  end
+
+  def test_untouched_values_are_kept_as_written
+    big = '{"id":123456789012345678901234567890,"n":1.5e300,"s":"é😀"}'
+    assert_equal '{"id":123456789012345678901234567890,"n":1.5e300,"s":"é😀","x":1}',
+                 YYJson.merge_patch(big, '{"x":1}')
+    assert_equal '[NaN,1]', YYJson.patch('[NaN]', '[{"op":"add","path":"/-","value":1}]')
+  end
+
+  # RFC 6902, Appendix A
+  def test_patch_operations
+    assert_equal({ "baz" => "qux", "foo" => "bar" }, patch('{"foo":"bar"}', '[{"op":"add","path":"/baz","value":"qux"}]'))
+    assert_equal({ "foo" => ["bar", "qux", "baz"] },
+                 patch('{"foo":["bar","baz"]}', '[{"op":"add","path":"/foo/1","value":"qux"}]'))
+    assert_equal({ "foo" => ["bar", "baz"] }, patch('{"foo":["bar"]}', '[{"op":"add","path":"/foo/-","value":"baz"}]'))
+    assert_equal({ "foo" => "bar" }, patch('{"baz":"qux","foo":"bar"}', '[{"op":"remove","path":"/baz"}]'))
+    assert_equal({ "foo" => ["bar", "baz"] },
+                 patch('{"foo":["bar","qux","baz"]}', '[{"op":"remove","path":"/foo/1"}]'))
+    assert_equal({ "baz" => "boo", "foo" => "bar" },
+                 patch('{"baz":"qux","foo":"bar"}', '[{"op":"replace","path":"/baz","value":"boo"}]'))
+    assert_equal({ "foo" => { "bar" => "baz" }, "qux" => { "corge" => "grault", "thud" => "fred" } },
+                 patch('{"foo":{"bar":"baz","waldo":"fred"},"qux":{"corge":"grault"}}',
+                       '[{"op":"move","from":"/foo/waldo","path":"/qux/thud"}]'))
+    assert_equal({ "a" => [1, 2], "b" => [1, 2] }, patch('{"a":[1,2]}', '[{"op":"copy","from":"/a","path":"/b"}]'))
+    assert_equal({ "a~b" => 1, "c/d" => 2 }, patch('{"a~b":0,"c/d":2}', '[{"op":"replace","path":"/a~0b","value":1}]'))
+    assert_equal({ "foo" => "bar" }, patch('{"foo":"bar"}', '[{"op":"test","path":"/foo","value":"bar"}]'))
+    assert_equal 7, patch('{"a":1}', '[{"op":"replace","path":"","value":7}]')
+  end
+
+  def test_patch_applies_operations_in_order
+    ops = [
+      { "op" => "add", "path" => "/items", "value" => [] },
+      { "op" => "add", "path" => "/items/-", "value" => { "id" => 1 } },
+      { "op" => "copy", "from" => "/items/0", "path" => "/items/-" },
+      { "op" => "replace", "path" => "/items/1/id", "value" => 2 },
+      { "op" => "test", "path" => "/items/0", "value" => { "id" => 1 } }
+    ]
+    assert_equal '{"v":1,"items":[{"id":1},{"id":2}]}', YYJson.patch('{"v":1}', ops)
+  end
+
+  def test_patch_failures
+    {
+      '[{"op":"test","path":"/a","value":2}]' => "operation 0 failed",
+      '[{"op":"add","path":"/b","value":1},{"op":"remove","path":"/zz"}]' => "operation 1 failed",
+      '[{"op":"replace","path":"/a/b/c","value":1}]' => "operation 0 failed",
+      '[{"op":"frobnicate","path":"/a"}]' => "operation 0 failed",
+      '[{"op":"add","value":1}]' => "operation 0 failed",
+      '[{"op":"move","from":"/a","path":"/a/b"}]' => "operation 0 failed"
+    }.each do |ops, message|
+      error = assert_raises(YYJson::PatchError, ops) { YYJson.patch('{"a":1}', ops) }
+      assert_includes error.message, message
+    end
+    assert_kind_of YYJson::Error, YYJson::PatchError.new
+    assert_raises(ArgumentError) { YYJson.patch('{}', '{"op":"add"}') }
+  end
+
+  def test_invalid_input
+    assert_raises(YYJson::ParseError) { YYJson.merge_patch('{"a":', '{}') }
+    assert_raises(YYJson::ParseError) { YYJson.merge_patch('{}', '{"a":') }
+    assert_raises(YYJson::ParseError) { YYJson.patch('[1] // c', '[]', mode: :strict) }
+    assert_raises(TypeError) { YYJson.merge_patch(nil, '{}') }
+    assert_raises(TypeError) { YYJson.merge_patch('{}', '{}', 1) }
+  end
+
+  def test_nesting_limits
+    deep = '[' * 101 + ']' * 101
+    assert_raises(YYJson::ParseError) { YYJson.merge_patch(deep, '{}') }
+    assert_raises(YYJson::ParseError) { YYJson.merge_patch('{}', '{"a":' + deep + '}') }
+    assert_equal '{}', YYJson.merge_patch(deep, '{}', max_nesting: false)
+    assert_equal '{"a":1}', YYJson.merge_patch('{}', '{"a":1}', max_nesting: 2**31 - 1)
+
+    # The patch functions recurse: without a limit, input too deep is still rejected
+    deeper = '[' * 200_000 + ']' * 200_000
+    assert_raises(YYJson::ParseError) { YYJson.patch(deeper, '[]', max_nesting: false) }
+  end
+
+  def test_builds_no_ruby_objects_for_the_document
+    json = YYJson.dump(Array.new(1000) { |i| { "id" => i, "name" => "n#{i}", "tags" => ["a", "b"] } })
+    patch = '{"0":1}'
+    ops = '[{"op":"replace","path":"/0/name","value":"x"}]'
+    allocations = 2.times.map do
+      before = GC.stat(:total_allocated_objects)
+      YYJson.merge_patch(json, patch)
+      YYJson.patch(json, ops)
+      GC.stat(:total_allocated_objects) - before
+    end
+    assert_operator allocations.last, :<=, 4
+  end
+end
@@ -1,6 +1,7 @@
 # frozen_string_literal: true
 
 require_relative 'test_helper'
+require 'stringio'
 
 # Add lib to load path for mimic/rails requires
 $LOAD_PATH.unshift File.expand_path('../lib', __dir__)
@@ -227,4 +228,50 @@ class TestRailsIntegration < YYJsonTestCase
       ::JSON.generate(data)
     end
   end
+
+  # Test ActiveSupport::Notifications instrumentation
+
+  class FakeNotifier
+    attr_reader :events
+
+    def initialize
+      @events = []
+    end
+
+    def instrument(name, payload = {})
+      result = yield payload
+      @events << [name, payload]
+      result
+    end
+  end
+
+  def test_instrument_publishes_load_and_dump_events
+    notifier = FakeNotifier.new
+    YYJson::Rails.instrument!(notifier)
+
+    json = YYJson.dump({ 'a' => [1, 2] })
+    assert_equal({ 'a' => [1, 2] }, YYJson.load(json))
+    assert_equal [['dump.yyjson', { bytes: json.bytesize }], ['load.yyjson', { bytes: json.bytesize }]],
+                 notifier.events
+  ensure
+    YYJson::Rails.notifier = nil
+  end
+
+  def test_instrument_passes_dump_arguments_through
+    notifier = FakeNotifier.new
+    YYJson::Rails.instrument!(notifier)
+
+    io = StringIO.new
+    assert_same io, YYJson.dump([1], io, buffer_size: 64)
+    assert_equal '[1]', io.string
+    assert_equal [['dump.yyjson', {}]], notifier.events
+  ensure
+    YYJson::Rails.notifier = nil
+  end
+
+  def test_no_events_without_notifier
+    YYJson::Rails.notifier = nil
+    assert_equal '[1]', YYJson.dump([1])
+    assert_equal [1], YYJson.load('[1]')
+  end
 end
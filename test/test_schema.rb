@@ -0,0 +1,215 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+
+class TestSchema < Minitest::Test
+  USER = {
+    "type" => "object",
+    "required" => ["id", "name"],
+    "properties" => {
+      "id" => { "type" => "integer", "minimum" => 1 },
+      "name" => { "type" => "string", "minLength" => 2, "pattern" => "^[a-z]+$" },
+      "tags" => { "type" => "array", "items" => { "type" => "string" }, "uniqueItems" => true, "maxItems" => 3 },
+      "a/b" => { "enum" => [1, "x", nil] },
+      "score" => { "type" => ["number", "null"], "multipleOf" => 0.1, "exclusiveMaximum" => 10 },
+      "friend" => { "$ref" => "#" }
+    },
+    "additionalProperties" => false
+  }.freeze
+
+  def errors(schema, json)
+    YYJson::Schema.compile(schema).validate(json).map { |e| [e[:pointer], e[:keyword]] }
+  end
+
+  def test_valid_p_checks_syntax_only
+    assert YYJson.valid?('{"a": [1, 2.5, "x", null]}')
+    refute YYJson.valid?('{"a": ')
+    refute YYJson.valid?('[1,]')
+    refute YYJson.valid?('')
+
+    # The YYJson.load parse options apply
+    assert YYJson.valid?('[1] // comment')
+    refute YYJson.valid?('[1] // comment', mode: :strict)
+    refute YYJson.valid?('[NaN]', allow_nan: false)
+    assert_raises(TypeError) { YYJson.valid?(nil) }
+  end
+
+  def test_valid_p_respects_max_nesting
+    assert YYJson.valid?('[' * 100 + ']' * 100)
+    refute YYJson.valid?('[' * 101 + ']' * 101)
+    refute YYJson.valid?('[' * 5 + '{}' + ']' * 5, max_nesting: 5)
+    assert YYJson.valid?('[' * 101 + ']' * 101, max_nesting: false)
+    # The depth check's stack is sized by the document, not the limit
+    assert YYJson.valid?('1', max_nesting: 2**31 - 1)
+    assert YYJson::Schema.compile('{}').valid?('[[1]]', max_nesting: 2**31 - 1)
+    refute YYJson.valid?('[' * 300 + ']' * 300, max_nesting: 200)
+  end
+
+  def test_valid_p_builds_no_objects
+    json = YYJson.dump(Array.new(1000) { |i| { "id" => i, "name" => "n#{i}" } })
+    schema = YYJson::Schema.compile({ "type" => "array", "items" => {
+      "required" => ["id"], "properties" => { "id" => { "minimum" => 0 }, "name" => { "maxLength" => 8 } } } })
+    allocations = 2.times.map do
+      before = GC.stat(:total_allocated_objects)
+      assert YYJson.valid?(json)
+      assert schema.valid?(json)
+      GC.stat(:total_allocated_objects) - before
+    end
+    assert_equal 0, allocations.last
+  end
+
+  def test_errors_carry_json_pointers
+    json = '{"id":0,"name":"A","tags":["x","x",3,"y"],"a/b":2,"score":10,"zz":1,"friend":{"id":"7"}}'
+    assert_equal [
+      ["/id", "minimum"], ["/name", "minLength"], ["/name", "pattern"],
+      ["/tags", "maxItems"], ["/tags", "uniqueItems"], ["/tags/2", "type"],
+      ["/a~1b", "enum"], ["/score", "exclusiveMaximum"], ["/zz", "additionalProperties"],
+      ["/friend", "required"], ["/friend/id", "type"]
+    ], errors(USER, json)
+
+    schema = YYJson::Schema.compile(USER)
+    assert_equal [], schema.validate('{"id":1.0,"name":"ab","score":0.3,"friend":{"id":2,"name":"cd"}}')
+    assert schema.valid?('{"id":1,"name":"ab"}')
+    refute schema.valid?('{"id":1}')
+
+    error = schema.validate('{"id":"1","name":"ab"}').first
+    assert_equal({ pointer: "/id", keyword: "type", message: "expected integer, got string" }, error)
+    assert_equal "must be >= 1", schema.validate('{"id":-3,"name":"ab"}').first[:message]
+    assert_equal [["", "type"]], errors(USER, '[]')
+  end
+
+  def test_types_and_values
+    assert_equal [], errors({ "type" => "integer" }, '2.0')
+    assert_equal [["", "type"]], errors({ "type" => "integer" }, '2.5')
+    assert_equal [], errors({ "type" => "number" }, '2')
+    assert_equal [], errors({ "const" => { "a" => [1, 2] } }, '{"a":[1.0,2]}')
+    assert_equal [["", "const"]], errors({ "const" => { "a" => [1, 2] } }, '{"a":[2,1]}')
+    assert_equal [], errors({ "enum" => [{ "b" => 1, "a" => 2 }] }, '{"a":2,"b":1}')
+    assert_equal [], errors({ "multipleOf" => 3 }, '-9')
+    assert_equal [["", "multipleOf"]], errors({ "multipleOf" => 3 }, '10')
+    assert_equal [], errors({ "maxLength" => 2 }, '"東京"')
+    assert_equal [["", "maxLength"]], errors({ "maxLength" => 2 }, '"東京都"')
+  end
+
+  def test_combinators
+    one_of = { "oneOf" => [{ "type" => "integer" }, { "minimum" => 0 }] }
+    assert_equal [["", "oneOf"]], errors(one_of, '5')
+    assert_equal [], errors(one_of, '-1')
+    assert_equal [], errors({ "anyOf" => [{ "type" => "string" }, { "type" => "null" }] }, 'null')
+    assert_equal [["", "anyOf"]], errors({ "anyOf" => [{ "type" => "string" }, { "type" => "null" }] }, '1')
+    assert_equal [["", "not"]], errors({ "not" => { "type" => "array" } }, '[]')
+    assert_equal [["/a", "type"], ["/a", "minimum"]],
+                 errors({ "allOf" => [{ "properties" => { "a" => { "type" => "string" } } },
+                                      { "properties" => { "a" => { "minimum" => 5 } } }] }, '{"a":1}')
+
+    conditional = { "if" => { "properties" => { "kind" => { "const" => "a" } } },
+                    "then" => { "required" => ["a"] }, "else" => { "required" => ["b"] } }
+    assert_equal [["", "required"]], errors(conditional, '{"kind":"a"}')
+    assert_equal [], errors(conditional, '{"kind":"c","b":1}')
+  end
+
+  def test_arrays_and_objects
+    tuple = { "items" => [{ "type" => "string" }], "additionalItems" => { "type" => "number" },
+              "contains" => { "const" => 1 } }
+    assert_equal [], errors(tuple, '["a",2,1]')
+    assert_equal [["/0", "type"], ["/1", "type"]], errors(tuple, '[1,"x"]')
+    assert_equal [["", "contains"]], errors(tuple, '["a"]')
+
+    object = { "patternProperties" => { "^x-" => { "type" => "string" } },
+               "propertyNames" => { "maxLength" => 4 },
+               "additionalProperties" => { "type" => "integer" },
+               "minProperties" => 1 }
+    assert_equal [], errors(object, '{"x-a":"s","b":1}')
+    assert_equal [["/x-a", "type"], ["/long_name", "maxLength"], ["/long_name", "type"]],
+                 errors(object, '{"x-a":1,"long_name":"n"}')
+    assert_equal [["", "minProperties"]], errors(object, '{}')
+  end
+
+  def test_boolean_schemas_and_refs
+    assert_equal [], errors(true, '{"anything":1}')
+    assert_equal [["", "false"]], errors(false, '1')
+
+    tree = { "definitions" => { "node" => { "type" => "object", "properties" => {
+      "children" => { "type" => "array", "items" => { "$ref" => "#/definitions/node" } } } } },
+             "$ref" => "#/definitions/node" }
+    assert_equal [["/children/0/children/0", "type"]],
+                 errors(tree, '{"children":[{"children":[3]}]}')
+
+    # Recursing through a combinator is fine once it descends into the value
+    nested = YYJson::Schema.compile({ "anyOf" => [{ "type" => "integer" },
+                                                  { "type" => "array", "items" => { "$ref" => "#" } }] })
+    assert nested.valid?('[1,[2,[]]]')
+    refute nested.valid?('[1,["a"]]')
+  end
+
+  def test_compile_accepts_json_text
+    schema = YYJson::Schema.compile('{"type": "string"}')
+    assert schema.frozen?
+    assert schema.valid?('"x"')
+    refute schema.valid?('1')
+    assert YYJson.valid?('"x"', schema: schema)
+    refute YYJson.valid?('1', schema: { "type" => "string" })
+    refute YYJson.valid?('"x', schema: schema)
+    assert_raises(NoMethodError) { YYJson::Schema.new }
+  end
+
+  def test_malformed_schemas
+    [
+      { "type" => "foo" }, { "minLength" => -1 }, { "allOf" => [] }, { "multipleOf" => 0 },
+      { "$ref" => "http://example.com/schema" }, { "$ref" => "#/nope" },
+      { "a" => { "$ref" => "#/a" }, "$ref" => "#/a" }, { "properties" => { "a" => 3 } },
+      # $ref cycles that never move into the instance
+      { "allOf" => [{ "$ref" => "#" }] }, { "not" => { "anyOf" => [true, { "$ref" => "#" }] } },
+      { "d" => { "if" => { "$ref" => "#/e" } }, "e" => { "oneOf" => [{ "$ref" => "#/d" }] }, "$ref" => "#/d" }
+    ].each do |schema|
+      assert_raises(ArgumentError, schema.inspect) { YYJson::Schema.compile(schema) }
+    end
+    assert_raises(YYJson::ParseError) { YYJson::Schema.compile('{"type":') }
+    assert_raises(RegexpError) { YYJson::Schema.compile({ "pattern" => "(" }) }
+  end
+
+  def test_validate_raises_for_invalid_json
+    schema = YYJson::Schema.compile({ "items" => { "$ref" => "#" } })
+    assert_raises(YYJson::ParseError) { schema.validate('[') }
+    assert_raises(YYJson::ParseError) { schema.validate('[' * 101 + ']' * 101) }
+
+    # Without a nesting limit, input too deep for the C stack is rejected
+    deep = '[' * 200_000 + ']' * 200_000
+    refute schema.valid?(deep, max_nesting: false)
+    assert_raises(YYJson::ParseError) { schema.validate(deep, max_nesting: false) }
+  end
+
+  def test_deep_values_and_schemas_stay_on_the_stack
+    deep = '[' * 200_000 + ']' * 200_000
+    { "const" => ["{\"const\":#{deep}}", deep], "enum" => ["{\"enum\":[#{deep}]}", deep],
+      "uniqueItems" => ['{"uniqueItems":true}', "[#{deep},#{deep}]"] }.each do |keyword, (text, source)|
+      schema = YYJson::Schema.compile(text)
+      refute schema.valid?(source, max_nesting: false), keyword
+      assert_raises(YYJson::ParseError, keyword) { schema.validate(source, max_nesting: false) }
+    end
+
+    assert_raises(ArgumentError) { YYJson::Schema.compile('{"not":' * 200_000 + '{}' + '}' * 200_000) }
+  end
+
+  def test_repeated_keywords_use_the_last
+    schema = YYJson::Schema.compile('{"required":["a"],"required":["b"],' \
+                                    '"properties":{"a":{"type":"string"}},"properties":{"b":{"type":"integer"}},' \
+                                    '"allOf":[false],"allOf":[true]}')
+    assert schema.valid?('{"a":1,"b":2}')
+    refute schema.valid?('{"a":"s"}')
+    refute schema.valid?('{"b":"s"}')
+  end
+
+  def test_ractors_share_compiled_schemas
+    schema = YYJson::Schema.compile({ "type" => "string", "pattern" => "b" })
+    assert Ractor.shareable?(schema)
+
+    _, warn = capture_io do
+      ractor = Ractor.new(schema) { |s| [s.valid?('"abc"'), s.validate('"zzz"').size, YYJson.valid?('[1')] }
+      assert_equal [true, 1, false], ractor.take
+    end
+    assert_match(/Ractor is experimental/, warn) unless warn.empty?
+  end
+end
@@ -0,0 +1,86 @@
+# frozen_string_literal: true
+
+$LOAD_PATH.unshift File.expand_path('../lib', __dir__)
+require 'minitest/autorun'
+require 'yyjson'
+
+class TestStats < Minitest::Test
+  def setup
+    @was_enabled = YYJson.stats_enabled
+    YYJson.stats_enabled = true
+    YYJson.reset_stats
+  end
+
+  def teardown
+    YYJson.stats_enabled = @was_enabled
+    YYJson.reset_stats
+  end
+
+  def test_nothing_counted_when_disabled
+    YYJson.stats_enabled = false
+    YYJson.load('[1, 2]')
+    YYJson.dump([1, 2])
+    assert(YYJson.stats.values.all?(&:zero?))
+  end
+
+  def test_parse_counters
+    json = '[{"id": 1, "name": "a"}, {"id": 2, "name": "b"}]'
+    YYJson.load(json)
+
+    stats = YYJson.stats
+    assert_equal 1, stats[:parses]
+    assert_equal json.bytesize, stats[:bytes_parsed]
+    assert_operator stats[:read_time_ns], :>, 0
+    assert_operator stats[:build_time_ns], :>, 0
+    assert_equal 2, stats[:key_cache_misses]
+    assert_equal 2, stats[:key_cache_hits]
+  end
+
+  def test_heap_fallbacks
+    YYJson.load('[1, 2, 3]')
+    assert_equal 0, YYJson.stats[:heap_fallbacks]
+
+    YYJson.load(YYJson.dump(Array.new(1000) { |i| i }))
+    assert_operator YYJson.stats[:heap_fallbacks], :>, 0
+  end
+
+  def test_dump_counters
+    json = YYJson.dump({ 'a' => '<b>' }, escape_html: true)
+    YYJson.dump([1, 2, 3])
+
+    stats = YYJson.stats
+    assert_equal 2, stats[:dumps]
+    assert_equal json.bytesize + '[1,2,3]'.bytesize, stats[:bytes_emitted]
+    assert_equal 1, stats[:escape_html_dumps]
+  end
+
+  def test_as_json_calls
+    klass = Class.new do
+      def as_json(*) = { 'ok' => true }
+    end
+    YYJson.dump([klass.new, klass.new], mode: :rails)
+    assert_equal 2, YYJson.stats[:as_json_calls]
+  end
+
+  def test_counts_are_aggregated_across_threads
+    threads = Array.new(4) { Thread.new { 5.times { YYJson.load('{"a": 1}') } } }
+    threads.each(&:join)
+    YYJson.load('[]')
+
+    # Includes threads that have already exited
+    assert_equal 21, YYJson.stats[:parses]
+  end
+
+  def test_reset_stats
+    YYJson.load('[1]')
+    assert_nil YYJson.reset_stats
+    assert(YYJson.stats.values.all?(&:zero?))
+  end
+
+  def test_streaming_dump_counts_all_bytes
+    data = Array.new(500) { |i| { 'id' => i } }
+    YYJson.dump_chunks(data, buffer_size: 64) { |_| }
+    emitted = YYJson.stats[:bytes_emitted]
+    assert_equal YYJson.dump(data).bytesize, emitted
+  end
+end